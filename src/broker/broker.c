@@ -87,8 +87,12 @@ static void broker_request_sendmsg (broker_ctx_t *ctx, const flux_msg_t *msg);
 static int broker_request_sendmsg_internal (broker_ctx_t *ctx,
                                             const flux_msg_t *msg);
 
-static void parent_cb (struct overlay *ov, void *sock, void *arg);
-static void child_cb (struct overlay *ov, void *sock, void *arg);
+static void parent_cb (struct overlay *ov, flux_msg_t *msg, void *arg);
+static void child_cb (struct overlay *ov, flux_msg_t *msg, void *arg);
+static void child_error_cb (struct overlay *ov,
+                            flux_msg_t *msg,
+                            int errnum,
+                            void *arg);
 static void module_cb (module_t *p, void *arg);
 static void module_status_cb (module_t *p, int prev_state, void *arg);
 static void hello_cb (struct hello *h, void *arg);
@@ -377,6 +381,18 @@ int main (int argc, char *argv[])
     }
     overlay_set_parent_cb (ctx.overlay, parent_cb, &ctx);
     overlay_set_child_cb (ctx.overlay, child_cb, &ctx);
+    overlay_set_child_error_cb (ctx.overlay, child_error_cb, &ctx);
+
+    /* If broker.iothreads is set to a nonzero value, service overlay and
+     * module sockets on I/O threads so that their socket I/O proceeds in
+     * parallel with routing on the reactor thread.
+     */
+    const char *iothreads;
+    if (attr_get (ctx.attrs, "broker.iothreads", &iothreads, NULL) == 0
+        && strtol (iothreads, NULL, 10) != 0) {
+        overlay_set_iothreads (ctx.overlay, true);
+        modhash_set_iothreads (ctx.modhash, true);
+    }
 
     /* Arrange for the publisher to route event messages.
      * handle_event - local subscribers (ctx.h)
@@ -1555,15 +1571,12 @@ static void broker_remove_services (flux_msg_handler_t *handlers[])
 
 /* Handle requests from overlay peers.
  */
-static void child_cb (struct overlay *ov, void *sock, void *arg)
+static void child_cb (struct overlay *ov, flux_msg_t *msg, void *arg)
 {
     broker_ctx_t *ctx = arg;
     int type;
     char *uuid = NULL;
-    flux_msg_t *msg = flux_msg_recvzsock (sock);
 
-    if (!msg)
-        goto done;
     if (flux_msg_get_type (msg, &type) < 0)
         goto done;
     if (flux_msg_get_route_last (msg, &uuid) < 0)
@@ -1598,7 +1611,28 @@ static void child_cb (struct overlay *ov, void *sock, void *arg)
 done:
     if (uuid)
         free (uuid);
-    flux_msg_destroy (msg);
+}
+
+/* Handle a message that the child I/O thread could not send.
+ * A request was routed down by sendmsg_child_request(), so pop the two
+ * routes it pushed and respond with the error, as if routing had failed
+ * synchronously.  Other messages are dropped.
+ */
+static void child_error_cb (struct overlay *ov,
+                            flux_msg_t *msg,
+                            int errnum,
+                            void *arg)
+{
+    broker_ctx_t *ctx = arg;
+    int type;
+
+    if (flux_msg_get_type (msg, &type) < 0 || type != FLUX_MSGTYPE_REQUEST)
+        return;
+    if (flux_msg_pop_route (msg, NULL) < 0
+        || flux_msg_pop_route (msg, NULL) < 0)
+        return;
+    if (flux_respond_error (ctx->h, msg, errnum, NULL) < 0)
+        flux_log_error (ctx->h, "flux_respond");
 }
 
 /* Handle events received by parent_cb.
@@ -1651,28 +1685,23 @@ static int handle_event (broker_ctx_t *ctx, const flux_msg_t *msg)
 
 /* Handle messages from one or more parents.
  */
-static void parent_cb (struct overlay *ov, void *sock, void *arg)
+static void parent_cb (struct overlay *ov, flux_msg_t *msg, void *arg)
 {
     broker_ctx_t *ctx = arg;
-    flux_msg_t *msg = flux_msg_recvzsock (sock);
     int type;
 
-    if (!msg)
-        goto done;
     if (flux_msg_get_type (msg, &type) < 0)
-        goto done;
+        return;
     switch (type) {
         case FLUX_MSGTYPE_RESPONSE:
-            if (broker_response_sendmsg (ctx, msg) < 0)
-                goto done;
+            (void)broker_response_sendmsg (ctx, msg);
             break;
         case FLUX_MSGTYPE_EVENT:
             if (flux_msg_clear_route (msg) < 0) {
                 flux_log (ctx->h, LOG_ERR, "dropping malformed event");
-                goto done;
+                break;
             }
-            if (handle_event (ctx, msg) < 0)
-                goto done;
+            (void)handle_event (ctx, msg);
             break;
         case FLUX_MSGTYPE_REQUEST:
             broker_request_sendmsg (ctx, msg);
@@ -1682,8 +1711,6 @@ static void parent_cb (struct overlay *ov, void *sock, void *arg)
                       flux_msg_typestr (type));
             break;
     }
-done:
-    flux_msg_destroy (msg);
 }
 
 /* Callback to send disconnect messages on behalf of unloading module.
@@ -14,6 +14,7 @@
 #include "config.h"
 #endif
 #include <inttypes.h>
+#include <arpa/inet.h>
 #include <czmq.h>
 #include <flux/core.h>
 #include "src/common/libutil/errno_safe.h"
@@ -39,6 +40,11 @@ static const uint32_t default_blob_size_limit = 1048576*1024;
 
 static const uint32_t default_flush_batch_limit = 256;
 
+/* Stop adding entries to a content-backing.store-batch request once
+ * its payload reaches this size.
+ */
+static const size_t flush_batch_maxsize = 1048576*16;
+
 struct cache_entry {
     flux_t *h;
     void *data;
@@ -52,6 +58,7 @@ struct cache_entry {
     zlist_t *load_requests;
     zlist_t *store_requests;
     int lastused;
+    void *lru_handle;               /* handle in cache->lru, if any */
 };
 
 struct content_cache {
@@ -59,7 +66,9 @@ struct content_cache {
     flux_msg_handler_t **handlers;
     uint32_t rank;
     zhash_t *entries;
+    zlistx_t *lru;                  /* valid, clean entries, LRU first */
     uint8_t backing:1;              /* 'content.backing' service available */
+    uint8_t backing_nobatch:1;      /* backing lacks store-batch method */
     char *backing_name;
     char hash_name[BLOBREF_MAX_STRING_SIZE];
     zlist_t *flush_requests;
@@ -253,6 +262,10 @@ static void remove_entry (content_cache_t *cache, struct cache_entry *e)
 {
     assert (!e->load_requests || zlist_size (e->load_requests) == 0);
     assert (!e->store_requests || zlist_size (e->store_requests) == 0);
+    if (e->lru_handle) {
+        zlistx_delete (cache->lru, e->lru_handle);
+        e->lru_handle = NULL;
+    }
     if (e->valid) {
         cache->acct_size -= e->len;
         cache->acct_valid--;
@@ -262,6 +275,44 @@ static void remove_entry (content_cache_t *cache, struct cache_entry *e)
     zhash_delete (cache->entries, e->blobref);
 }
 
+/* Only valid, clean entries may be purged.  They are kept on cache->lru
+ * in order of last use, so purge can evict from the front without
+ * scanning the whole cache.  Call lru_update() after changing e->valid
+ * or e->dirty, and lru_touch() when an entry is used.
+ */
+static void lru_update (content_cache_t *cache, struct cache_entry *e)
+{
+    if (e->valid && !e->dirty) {
+        if (!e->lru_handle)
+            e->lru_handle = zlistx_add_end (cache->lru, e);
+    }
+    else if (e->lru_handle) {
+        zlistx_delete (cache->lru, e->lru_handle);
+        e->lru_handle = NULL;
+    }
+}
+
+static void lru_touch (content_cache_t *cache, struct cache_entry *e)
+{
+    e->lastused = cache->epoch;
+    if (e->lru_handle)
+        zlistx_move_end (cache->lru, e->lru_handle);
+    else
+        lru_update (cache, e);
+}
+
+/* Evict least recently used entries, regardless of age, until the cache
+ * size is within purge_target_size.
+ */
+static void cache_purge_size (content_cache_t *cache)
+{
+    struct cache_entry *e;
+
+    while (cache->acct_size > cache->purge_target_size
+                            && (e = zlistx_first (cache->lru)))
+        remove_entry (cache, e);
+}
+
 /* Load operation
  *
  * If a cache entry is already present and valid, response is immediate.
@@ -297,13 +348,14 @@ static void cache_load_continuation (flux_future_t *f, void *arg)
         cache->acct_valid++;
         cache->acct_size += len;
     }
-    e->lastused = cache->epoch;
+    lru_touch (cache, e);
     request_list_respond_raw (&e->load_requests,
                               cache->h,
                               e->data,
                               e->len,
                               "load");
     flux_future_destroy (f);
+    cache_purge_size (cache);
     return;
 error:
     request_list_respond_error (&e->load_requests,
@@ -389,7 +441,7 @@ void content_load_request (flux_t *h, flux_msg_handler_t *mh,
         }
         return; /* RPC continuation will respond to msg */
     }
-    e->lastused = cache->epoch;
+    lru_touch (cache, e);
     data = e->data;
     len = e->len;
     if (flux_respond_raw (h, msg, data, len) < 0)
@@ -460,6 +512,7 @@ static void cache_store_continuation (flux_future_t *f, void *arg)
     if (e->dirty) {
         cache->acct_dirty--;
         e->dirty = 0;
+        lru_update (cache, e);
     }
     request_list_respond_raw (&e->store_requests,
                               cache->h,
@@ -468,6 +521,7 @@ static void cache_store_continuation (flux_future_t *f, void *arg)
                               "store");
     flux_future_destroy (f);
     cache_resume_flush (cache);
+    cache_purge_size (cache);
     return;
 error:
     request_list_respond_error (&e->store_requests,
@@ -477,6 +531,7 @@ error:
                                 "store");
     flux_future_destroy (f);
     cache_resume_flush (cache);
+    cache_purge_size (cache);
 }
 
 static int cache_store (content_cache_t *cache, struct cache_entry *e)
@@ -519,6 +574,153 @@ done:
     return rc;
 }
 
+/* Rank 0 may store dirty entries to the backing store in batches, using
+ * one content-backing.store-batch request per batch.  Its payload is each
+ * blob preceded by its length as a 4 byte integer in network byte order.
+ * The response is the resulting NULL-terminated blobrefs, in order.
+ */
+static bool cache_store_batch_enabled (content_cache_t *cache)
+{
+    return (cache->rank == 0 && cache->backing && !cache->backing_nobatch);
+}
+
+static void entry_list_destroy (void *arg)
+{
+    zlist_t *l = arg;
+    zlist_destroy (&l);
+}
+
+static void cache_store_batch_continuation (flux_future_t *f, void *arg)
+{
+    content_cache_t *cache = arg;
+    zlist_t *entries = flux_future_aux_get (f, "entries");
+    struct cache_entry *e;
+    const char *refs = NULL;
+    int len = 0;
+    int errnum = 0;
+
+    if (flux_rpc_get_raw (f, (const void **)&refs, &len) < 0) {
+        errnum = errno;
+        if (errno == ENOSYS) {
+            flux_log (cache->h, LOG_DEBUG, "content store-batch: %s",
+                      "unsupported by backing store, disabling");
+            cache->backing_nobatch = 1;
+        }
+        else
+            flux_log_error (cache->h, "content store-batch");
+    }
+    FOREACH_ZLIST (entries, e) {
+        e->store_pending = 0;
+        assert (cache->flush_batch_count > 0);
+        cache->flush_batch_count--;
+        if (errnum == 0) {
+            size_t n = refs ? strnlen (refs, len) : 0;
+            if (n == (size_t)len) {
+                flux_log (cache->h, LOG_ERR, "content store-batch: %s",
+                          "short response");
+                errnum = EPROTO;
+            }
+            else {
+                if (strcmp (refs, e->blobref) != 0)
+                    flux_log (cache->h, LOG_ERR, "content store-batch: %s",
+                              "wrong blobref");
+                else if (e->dirty) {
+                    cache->acct_dirty--;
+                    e->dirty = 0;
+                    lru_update (cache, e);
+                }
+                refs += n + 1;
+                len -= n + 1;
+            }
+        }
+        if (e->dirty)
+            request_list_respond_error (&e->store_requests,
+                                        cache->h,
+                                        errnum ? errnum : EIO,
+                                        NULL,
+                                        "store");
+        else
+            request_list_respond_raw (&e->store_requests,
+                                      cache->h,
+                                      e->blobref,
+                                      strlen (e->blobref) + 1,
+                                      "store");
+    }
+    flux_future_destroy (f);
+    cache_resume_flush (cache);
+    cache_purge_size (cache);
+}
+
+/* Send dirty entries that are not already being stored to the backing
+ * store in one batch, up to the flush_batch_limit on outstanding stores.
+ */
+static int cache_store_batch (content_cache_t *cache)
+{
+    zlist_t *entries;
+    struct cache_entry *e;
+    const char *key;
+    size_t size = 0;
+    uint8_t *buf = NULL;
+    uint8_t *p;
+    flux_future_t *f = NULL;
+
+    if (!(entries = zlist_new ()))
+        goto nomem;
+    FOREACH_ZHASH (cache->entries, key, e) {
+        if (!e->dirty || e->store_pending)
+            continue;
+        if (zlist_append (entries, e) < 0)
+            goto nomem;
+        size += sizeof (uint32_t) + e->len;
+        if (cache->flush_batch_count + zlist_size (entries)
+                                    >= cache->flush_batch_limit
+                                    || size >= flush_batch_maxsize)
+            break;
+    }
+    if (zlist_size (entries) == 0) {
+        zlist_destroy (&entries);
+        return 0;
+    }
+    if (!(buf = malloc (size)))
+        goto nomem;
+    p = buf;
+    FOREACH_ZLIST (entries, e) {
+        uint32_t len = htonl (e->len);
+        memcpy (p, &len, sizeof (len));
+        p += sizeof (len);
+        if (e->len > 0)
+            memcpy (p, e->data, e->len);
+        p += e->len;
+    }
+    if (!(f = flux_rpc_raw (cache->h,
+                            "content-backing.store-batch",
+                            buf,
+                            size,
+                            0,
+                            0)))
+        goto error;
+    if (flux_future_aux_set (f, "entries", entries, entry_list_destroy) < 0)
+        goto error;
+    entries = NULL; // now owned by 'f'
+    if (flux_future_then (f, -1., cache_store_batch_continuation, cache) < 0)
+        goto error;
+    free (buf);
+    entries = flux_future_aux_get (f, "entries");
+    FOREACH_ZLIST (entries, e) {
+        e->store_pending = 1;
+        cache->flush_batch_count++;
+    }
+    return 0;
+nomem:
+    errno = ENOMEM;
+error:
+    flux_log_error (cache->h, "content store-batch");
+    ERRNO_SAFE_WRAP (flux_future_destroy, f);
+    ERRNO_SAFE_WRAP (free, buf);
+    ERRNO_SAFE_WRAP (entry_list_destroy, entries);
+    return -1;
+}
+
 static void content_store_request (flux_t *h, flux_msg_handler_t *mh,
                                    const flux_msg_t *msg, void *arg)
 {
@@ -562,9 +764,15 @@ static void content_store_request (flux_t *h, flux_msg_handler_t *mh,
             cache->acct_dirty++;
         }
     }
-    e->lastused = cache->epoch;
+    lru_touch (cache, e);
     if (e->dirty) {
-        if (cache->rank > 0 || cache->backing) {
+        /* On rank 0, if stores to the backing store are in flight, leave
+         * the entry dirty.  cache_resume_flush() picks it up in the next
+         * batch when they complete.
+         */
+        if (cache_store_batch_enabled (cache) && cache->flush_batch_count > 0)
+            ;
+        else if (cache->rank > 0 || cache->backing) {
             if (cache_store (cache, e) < 0)
                 goto error;
             if (cache->rank > 0) {  /* write-through */
@@ -581,6 +789,7 @@ static void content_store_request (flux_t *h, flux_msg_handler_t *mh,
         if (cache->rank == 0 && !cache->backing) {
             e->dirty = 1;
             cache->acct_dirty++;
+            lru_update (cache, e);
         }
     }
     if (flux_respond_raw (h, msg, blobref, strlen (blobref) + 1) < 0)
@@ -609,6 +818,8 @@ static int cache_flush (content_cache_t *cache)
     if (cache->acct_dirty - cache->flush_batch_count == 0
             || cache->flush_batch_count >= cache->flush_batch_limit)
         return 0;
+    if (cache_store_batch_enabled (cache))
+        return cache_store_batch (cache);
 
     flux_log (cache->h, LOG_DEBUG, "content flush begin");
     FOREACH_ZHASH (cache->entries, key, e) {
@@ -646,6 +857,7 @@ static void content_register_backing_request (flux_t *h,
     if (!(cache->backing_name = strdup (name)))
         goto error;
     cache->backing = 1;
+    cache->backing_nobatch = 0;
     flux_log (h, LOG_DEBUG, "content backing store: enabled %s", name);
     if (flux_respond (h, msg, NULL) < 0)
         flux_log_error (h, "content backing");
@@ -811,45 +1023,29 @@ error:
 
 static int cache_purge (content_cache_t *cache)
 {
-    int after_entries = zhash_size (cache->entries);
-    int after_size = cache->acct_size;
     struct cache_entry *e;
-    zlist_t *purge = NULL;
-    int rc = -1;
-    const char *key;
-
-    if (cache->acct_dirty == zhash_size (cache->entries))
-        return 0;
+    struct cache_entry *next;
+    int count = 0;
 
-    FOREACH_ZHASH (cache->entries, key, e) {
-        if (after_size <= cache->purge_target_size
-                        && after_entries <= cache->purge_target_entries)
+    e = zlistx_first (cache->lru);
+    while (e) {
+        if (cache->acct_size <= cache->purge_target_size
+                && zhash_size (cache->entries) <= cache->purge_target_entries)
             break;
-        if (!e->valid || e->dirty)
-            continue;
         if (cache->epoch - e->lastused < cache->purge_old_entry)
-            continue;
-        if (after_entries <= cache->purge_target_entries
-                    && e->len < cache->purge_large_entry)
-            continue;
-        if ((!purge && !(purge = zlist_new ()))
-                    || zlist_append (purge, e) < 0) {
-            errno = ENOMEM;
-            goto done;
-        }
-        after_size -= e->len;
-        after_entries--;
-    }
-    if (purge) {
-        flux_log (cache->h, LOG_DEBUG, "content purge: %d entries",
-                  (int)zlist_size (purge));
-        while ((e = zlist_pop (purge)))
+            break; // remaining entries were used more recently
+        next = zlistx_next (cache->lru);
+        if (zhash_size (cache->entries) > cache->purge_target_entries
+                    || e->len >= cache->purge_large_entry) {
             remove_entry (cache, e);
+            count++;
+        }
+        e = next;
     }
-    rc = 0;
-done:
-    zlist_destroy (&purge);
-    return rc;
+    if (count > 0)
+        flux_log (cache->h, LOG_DEBUG, "content purge: %d entries", count);
+    cache_purge_size (cache);
+    return 0;
 }
 
 static void heartbeat_event (flux_t *h, flux_msg_handler_t *mh,
@@ -1027,6 +1223,7 @@ void content_cache_destroy (content_cache_t *cache)
         if (cache->backing_name)
             free (cache->backing_name);
         zhash_destroy (&cache->entries);
+        zlistx_destroy (&cache->lru);
         request_list_destroy (&cache->flush_requests);
         free (cache);
     }
@@ -1039,7 +1236,8 @@ content_cache_t *content_cache_create (void)
         errno = ENOMEM;
         return NULL;
     }
-    if (!(cache->entries = zhash_new ())) {
+    if (!(cache->entries = zhash_new ())
+        || !(cache->lru = zlistx_new ())) {
         content_cache_destroy (cache);
         errno = ENOMEM;
         return NULL;
@@ -0,0 +1,490 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* iothread.c - service a zmq socket on a dedicated thread
+ *
+ * Each direction has a queue of message pointers built from fixed size
+ * chunks, so it can grow without bound and without locks.  Only the
+ * producer advances the tail, only the consumer advances the head, and
+ * an atomic count of queued entries publishes entries from one thread
+ * to the other.  The producer signals the consumer's eventfd when it
+ * adds an entry to an empty queue, and the consumer keeps taking
+ * entries until the count drops to zero, so no entry is left behind
+ * without a wakeup.
+ *
+ * The reactor thread reads the receive queue from an fd watcher on its
+ * eventfd.  The I/O thread waits on the socket and the send queue's
+ * eventfd with zmq_poll().  Sends that fail on the I/O thread are
+ * returned to the reactor on the receive queue with their errno value.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <czmq.h>
+#include <zmq.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/iterators.h"
+
+#include "iothread.h"
+
+#define MSGQ_CHUNK 256
+
+/* Messages handled per wakeup on either thread before yielding,
+ * so that one busy socket or queue cannot starve the others.
+ */
+#define IOTHREAD_BATCH 64
+
+enum {
+    IOTHREAD_OP_SEND = 0,
+    IOTHREAD_OP_MCAST = 1,
+};
+
+struct msgq_entry {
+    flux_msg_t *msg;
+    int op;                     /* send queue */
+    int errnum;                 /* receive queue: nonzero if send failed */
+};
+
+struct msgq_chunk {
+    struct msgq_entry entry[MSGQ_CHUNK];
+    struct msgq_chunk *next;
+};
+
+struct msgq {
+    struct msgq_chunk *tail;    /* producer only */
+    int tail_pos;
+    struct msgq_chunk *head;    /* consumer only */
+    int head_pos;
+    int count;                  /* atomic: number of queued entries */
+    struct msgq_chunk *spare;   /* atomic: a retired chunk for reuse */
+    int efd;                    /* consumer's doorbell */
+};
+
+struct iothread {
+    zsock_t *sock;
+    int flags;
+    struct msgq tx;             /* reactor -> I/O thread */
+    struct msgq rx;             /* I/O thread -> reactor */
+    flux_watcher_t *w;
+    iothread_recv_f cb;
+    void *cb_arg;
+    iothread_error_f error_cb;
+    void *error_arg;
+    pthread_t t;
+    bool started;
+    int shutdown;               /* atomic */
+    zhash_t *peers;             /* I/O thread only: ROUTER identities */
+    bool in_callback;
+    bool destroyed;
+};
+
+/* The eventfd counter cannot realistically overflow, so a failed write
+ * means a wakeup is already pending.
+ */
+static void msgq_signal (struct msgq *q)
+{
+    uint64_t one = 1;
+    ssize_t n;
+
+    n = write (q->efd, &one, sizeof (one));
+    (void)n;
+}
+
+static void msgq_clear (struct msgq *q)
+{
+    uint64_t count;
+    ssize_t n;
+
+    n = read (q->efd, &count, sizeof (count));
+    (void)n;
+}
+
+static int msgq_count (struct msgq *q)
+{
+    return __atomic_load_n (&q->count, __ATOMIC_SEQ_CST);
+}
+
+static int msgq_push (struct msgq *q, flux_msg_t *msg, int op, int errnum)
+{
+    struct msgq_entry *e;
+
+    if (q->tail_pos == MSGQ_CHUNK) {
+        struct msgq_chunk *c;
+
+        if (!(c = __atomic_exchange_n (&q->spare, NULL, __ATOMIC_ACQ_REL))
+            && !(c = malloc (sizeof (*c))))
+            return -1;
+        c->next = NULL;
+        q->tail->next = c;
+        q->tail = c;
+        q->tail_pos = 0;
+    }
+    e = &q->tail->entry[q->tail_pos++];
+    e->msg = msg;
+    e->op = op;
+    e->errnum = errnum;
+    if (__atomic_fetch_add (&q->count, 1, __ATOMIC_SEQ_CST) == 0)
+        msgq_signal (q);
+    return 0;
+}
+
+/* Return the entry at the head of the queue without removing it,
+ * or NULL if the queue is empty.
+ */
+static struct msgq_entry *msgq_peek (struct msgq *q)
+{
+    if (msgq_count (q) == 0)
+        return NULL;
+    if (q->head_pos == MSGQ_CHUNK) {
+        struct msgq_chunk *old = q->head;
+
+        q->head = old->next;
+        q->head_pos = 0;
+        free (__atomic_exchange_n (&q->spare, old, __ATOMIC_ACQ_REL));
+    }
+    return &q->head->entry[q->head_pos];
+}
+
+static void msgq_drop (struct msgq *q)
+{
+    q->head_pos++;
+    __atomic_fetch_sub (&q->count, 1, __ATOMIC_SEQ_CST);
+}
+
+static bool msgq_pop (struct msgq *q, struct msgq_entry *ep)
+{
+    struct msgq_entry *e;
+
+    if (!(e = msgq_peek (q)))
+        return false;
+    *ep = *e;
+    msgq_drop (q);
+    return true;
+}
+
+static int msgq_init (struct msgq *q)
+{
+    if (!(q->head = calloc (1, sizeof (*q->head))))
+        return -1;
+    q->tail = q->head;
+    if ((q->efd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0)
+        return -1;
+    return 0;
+}
+
+/* Call only when neither thread is using the queue.
+ */
+static void msgq_clean (struct msgq *q)
+{
+    struct msgq_entry e;
+
+    if (q->head) {
+        while (msgq_pop (q, &e))
+            flux_msg_destroy (e.msg);
+        free (q->head);
+        q->head = q->tail = NULL;
+    }
+    free (q->spare);
+    q->spare = NULL;
+    if (q->efd >= 0)
+        close (q->efd);
+    q->efd = -1;
+}
+
+/* I/O thread: return a message that could not be sent to the reactor.
+ */
+static void iothread_return (struct iothread *io, flux_msg_t *msg, int errnum)
+{
+    if (msgq_push (&io->rx, msg, 0, errnum ? errnum : EIO) < 0)
+        flux_msg_destroy (msg);
+}
+
+/* I/O thread: send to each peer in turn.  A peer that has disconnected
+ * (EHOSTUNREACH from a ROUTER in mandatory mode) is skipped, and may be
+ * reached again if it reconnects with the same identity.
+ */
+static void iothread_mcast_peers (struct iothread *io, flux_msg_t *msg)
+{
+    const char *uuid;
+    void *item;
+
+    FOREACH_ZHASH (io->peers, uuid, item) {
+        if (zstr_sendm (io->sock, uuid) < 0)
+            continue;
+        (void)flux_msg_sendzsock (io->sock, msg);
+    }
+    flux_msg_destroy (msg);
+}
+
+static void iothread_checkin (struct iothread *io, const flux_msg_t *msg)
+{
+    char *uuid = NULL;
+
+    if (flux_msg_get_route_last (msg, &uuid) == 0 && uuid) {
+        if (!zhash_lookup (io->peers, uuid))
+            (void)zhash_insert (io->peers, uuid, io);
+    }
+    free (uuid);
+}
+
+static void iothread_flush (struct iothread *io)
+{
+    struct msgq_entry e;
+
+    for (int i = 0; i < IOTHREAD_BATCH; i++) {
+        if (!msgq_pop (&io->tx, &e))
+            return;
+        if (e.op == IOTHREAD_OP_MCAST)
+            iothread_mcast_peers (io, e.msg);
+        else if (flux_msg_sendzsock (io->sock, e.msg) < 0)
+            iothread_return (io, e.msg, errno);
+        else
+            flux_msg_destroy (e.msg);
+    }
+    if (msgq_count (&io->tx) > 0)
+        msgq_signal (&io->tx);
+}
+
+static void iothread_recv (struct iothread *io)
+{
+    flux_msg_t *msg;
+
+    for (int i = 0; i < IOTHREAD_BATCH; i++) {
+        if (!(zsock_events (io->sock) & ZMQ_POLLIN))
+            break;
+        if (!(msg = flux_msg_recvzsock (io->sock)))
+            break;
+        if (io->peers)
+            iothread_checkin (io, msg);
+        if (msgq_push (&io->rx, msg, 0, 0) < 0) {
+            log_err ("iothread: dropping received message");
+            flux_msg_destroy (msg);
+        }
+    }
+}
+
+static void *iothread_main (void *arg)
+{
+    struct iothread *io = arg;
+    zmq_pollitem_t items[] = {
+        { .socket = zsock_resolve (io->sock), .events = ZMQ_POLLIN },
+        { .fd = io->tx.efd, .events = ZMQ_POLLIN },
+    };
+    sigset_t signal_set;
+
+    sigfillset (&signal_set);
+    pthread_sigmask (SIG_BLOCK, &signal_set, NULL);
+
+    while (!__atomic_load_n (&io->shutdown, __ATOMIC_SEQ_CST)) {
+        if (zmq_poll (items, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            log_err ("iothread: zmq_poll");
+            break;
+        }
+        if ((items[1].revents & ZMQ_POLLIN)) {
+            msgq_clear (&io->tx);
+            iothread_flush (io);
+        }
+        if ((items[0].revents & ZMQ_POLLIN))
+            iothread_recv (io);
+    }
+    /* Send what the reactor queued before shutdown, but like socket
+     * linger, don't wait on a peer that is not reading.
+     */
+    zsock_set_sndtimeo (io->sock, 0);
+    while (msgq_count (&io->tx) > 0)
+        iothread_flush (io);
+    return NULL;
+}
+
+static void iothread_senderr (struct iothread *io, flux_msg_t *msg, int errnum)
+{
+    if (io->error_cb)
+        io->error_cb (io, msg, errnum, io->error_arg);
+    else {
+        int type = 0;
+        (void)flux_msg_get_type (msg, &type);
+        log_msg ("iothread: dropped %s: %s",
+                 flux_msg_typestr (type),
+                 strerror (errnum));
+    }
+    flux_msg_destroy (msg);
+}
+
+/* Reactor thread: hand received messages to the callback and failed
+ * sends to the error callback.  Either may destroy the iothread, so
+ * the final free is deferred until they return.
+ */
+static void rx_cb (flux_reactor_t *r, flux_watcher_t *w,
+                   int revents, void *arg)
+{
+    struct iothread *io = arg;
+    struct msgq_entry *e;
+
+    msgq_clear (&io->rx);
+    io->in_callback = true;
+    for (int i = 0; i < IOTHREAD_BATCH && !io->destroyed; i++) {
+        if (!(e = msgq_peek (&io->rx)))
+            break;
+        if (e->errnum != 0) {
+            flux_msg_t *msg = e->msg;
+            int errnum = e->errnum;
+            msgq_drop (&io->rx);
+            iothread_senderr (io, msg, errnum);
+        }
+        else
+            io->cb (io, io->cb_arg);
+    }
+    io->in_callback = false;
+    if (io->destroyed) {
+        free (io);
+        return;
+    }
+    if (msgq_count (&io->rx) > 0)
+        msgq_signal (&io->rx);
+}
+
+flux_msg_t *iothread_recvmsg (struct iothread *io)
+{
+    struct msgq_entry *e;
+    flux_msg_t *msg;
+
+    if (!io || io->destroyed) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(e = msgq_peek (&io->rx)) || e->errnum != 0) {
+        errno = EWOULDBLOCK;
+        return NULL;
+    }
+    msg = e->msg;
+    msgq_drop (&io->rx);
+    return msg;
+}
+
+int iothread_sendmsg (struct iothread *io, flux_msg_t *msg)
+{
+    if (!io || !msg || io->destroyed) {
+        errno = EINVAL;
+        return -1;
+    }
+    return msgq_push (&io->tx, msg, IOTHREAD_OP_SEND, 0);
+}
+
+int iothread_mcast (struct iothread *io, flux_msg_t *msg)
+{
+    if (!io || !msg || io->destroyed || !(io->flags & IOTHREAD_MCAST)) {
+        errno = EINVAL;
+        return -1;
+    }
+    return msgq_push (&io->tx, msg, IOTHREAD_OP_MCAST, 0);
+}
+
+void iothread_set_error_cb (struct iothread *io,
+                            iothread_error_f cb,
+                            void *arg)
+{
+    if (io) {
+        io->error_cb = cb;
+        io->error_arg = arg;
+    }
+}
+
+int iothread_start (struct iothread *io)
+{
+    int e;
+
+    if (!io || io->started) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((e = pthread_create (&io->t, NULL, iothread_main, io))) {
+        errno = e;
+        return -1;
+    }
+    io->started = true;
+    return 0;
+}
+
+void iothread_destroy (struct iothread *io)
+{
+    if (io && !io->destroyed) {
+        int saved_errno = errno;
+        int e;
+
+        if (io->started) {
+            __atomic_store_n (&io->shutdown, 1, __ATOMIC_SEQ_CST);
+            msgq_signal (&io->tx);
+            if ((e = pthread_join (io->t, NULL)) != 0)
+                log_errn (e, "iothread: pthread_join");
+        }
+        flux_watcher_destroy (io->w);
+        io->w = NULL;
+        msgq_clean (&io->tx);
+        msgq_clean (&io->rx);
+        zhash_destroy (&io->peers);
+        io->destroyed = true;
+        if (!io->in_callback)
+            free (io);
+        errno = saved_errno;
+    }
+}
+
+struct iothread *iothread_create (flux_reactor_t *r,
+                                  zsock_t *sock,
+                                  int flags,
+                                  iothread_recv_f cb,
+                                  void *arg)
+{
+    struct iothread *io;
+
+    if (!r || !sock || !cb || (flags & ~IOTHREAD_MCAST)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(io = calloc (1, sizeof (*io))))
+        return NULL;
+    io->sock = sock;
+    io->flags = flags;
+    io->cb = cb;
+    io->cb_arg = arg;
+    io->tx.efd = io->rx.efd = -1;
+    if (msgq_init (&io->tx) < 0 || msgq_init (&io->rx) < 0)
+        goto error;
+    if ((flags & IOTHREAD_MCAST) && !(io->peers = zhash_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (!(io->w = flux_fd_watcher_create (r, io->rx.efd, FLUX_POLLIN,
+                                          rx_cb, io)))
+        goto error;
+    flux_watcher_start (io->w);
+    return io;
+error:
+    iothread_destroy (io);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,92 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _BROKER_IOTHREAD_H
+#define _BROKER_IOTHREAD_H
+
+#include <czmq.h>
+#include <flux/core.h>
+
+/* An iothread services a zmq socket on a dedicated thread, so that
+ * socket I/O and message encoding for that socket run in parallel with
+ * routing on the broker's reactor thread.  Once started, the thread
+ * owns the socket.  Messages are handed between the two threads through
+ * lock-free single-producer, single-consumer queues, and an eventfd
+ * wakes the other side only when a queue goes from empty to non-empty.
+ */
+struct iothread;
+
+/* Called on the reactor thread when a received message may be ready.
+ * The callback should call iothread_recvmsg() once.  It is called
+ * repeatedly while messages remain, up to a limit per reactor loop.
+ */
+typedef void (*iothread_recv_f)(struct iothread *io, void *arg);
+
+/* Called on the reactor thread with a message that the I/O thread
+ * failed to send, and the errno value from the failed send.
+ * The message is destroyed when the callback returns.
+ */
+typedef void (*iothread_error_f)(struct iothread *io,
+                                 flux_msg_t *msg,
+                                 int errnum,
+                                 void *arg);
+
+enum {
+    /* Track the ROUTER identity of each peer that sends a message,
+     * for iothread_mcast().
+     */
+    IOTHREAD_MCAST = 1,
+};
+
+/* Create an iothread for 'sock', with receive notification on reactor 'r'.
+ * 'sock' must not be used by the caller once the iothread is started,
+ * and must not be destroyed until the iothread is.
+ */
+struct iothread *iothread_create (flux_reactor_t *r,
+                                  zsock_t *sock,
+                                  int flags,
+                                  iothread_recv_f cb,
+                                  void *arg);
+
+/* Stop and join the thread.  Queued messages are sent if that can be
+ * done without blocking.  Unsent and unreceived messages are dropped.
+ * Safe to call from the iothread's own callbacks.
+ */
+void iothread_destroy (struct iothread *io);
+
+/* Without an error callback, failed sends are logged and dropped.
+ */
+void iothread_set_error_cb (struct iothread *io,
+                            iothread_error_f cb,
+                            void *arg);
+
+int iothread_start (struct iothread *io);
+
+/* Take the next received message.
+ * Returns NULL with errno = EWOULDBLOCK if none is ready.
+ */
+flux_msg_t *iothread_recvmsg (struct iothread *io);
+
+/* Queue 'msg' to be sent by the I/O thread.
+ * On success, the iothread takes ownership of 'msg'.
+ */
+int iothread_sendmsg (struct iothread *io, flux_msg_t *msg);
+
+/* Queue 'msg' to be sent to every peer that has sent a message on the
+ * socket (IOTHREAD_MCAST only), prefixed with the peer's identity frame.
+ * On success, the iothread takes ownership of 'msg'.
+ */
+int iothread_mcast (struct iothread *io, flux_msg_t *msg);
+
+#endif /* !_BROKER_IOTHREAD_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -41,6 +41,7 @@
 #include "heartbeat.h"
 #include "module.h"
 #include "modservice.h"
+#include "iothread.h"
 
 #ifndef UUID_STR_LEN
 #define UUID_STR_LEN 37     // defined in later libuuid headers
@@ -54,6 +55,7 @@ struct broker_module {
     uint32_t rank;
     flux_t *broker_h;
     flux_watcher_t *broker_w;
+    struct iothread *io;    /* services sock instead of broker_w if set */
 
     int lastseen;
     heartbeat_t *heartbeat;
@@ -95,6 +97,7 @@ struct modhash {
     uint32_t rank;
     flux_t *broker_h;
     heartbeat_t *heartbeat;
+    bool iothreads;
 };
 
 static int setup_module_profiling (module_t *p)
@@ -278,7 +281,11 @@ flux_msg_t *module_recvmsg (module_t *p)
 
     assert (p->magic == MODULE_MAGIC);
 
-    if (!(msg = flux_msg_recvzsock (p->sock)))
+    if (p->io)
+        msg = iothread_recvmsg (p->io);
+    else
+        msg = flux_msg_recvzsock (p->sock);
+    if (!msg)
         goto error;
     if (flux_msg_get_type (msg, &type) < 0)
         goto error;
@@ -341,8 +348,6 @@ int module_sendmsg (module_t *p, const flux_msg_t *msg)
                 goto done;
             if (flux_msg_push_route (cpy, uuid) < 0)
                 goto done;
-            if (flux_msg_sendzsock (p->sock, cpy) < 0)
-                goto done;
             break;
         }
         case FLUX_MSGTYPE_RESPONSE: { /* simulate ROUTER socket */
@@ -350,15 +355,22 @@ int module_sendmsg (module_t *p, const flux_msg_t *msg)
                 goto done;
             if (flux_msg_pop_route (cpy, NULL) < 0)
                 goto done;
-            if (flux_msg_sendzsock (p->sock, cpy) < 0)
-                goto done;
             break;
         }
         default:
-            if (flux_msg_sendzsock (p->sock, msg) < 0)
-                goto done;
             break;
     }
+    /* The I/O thread takes ownership of the message it sends.
+     */
+    if (p->io) {
+        if (!cpy && !(cpy = flux_msg_copy (msg, true)))
+            goto done;
+        if (iothread_sendmsg (p->io, cpy) < 0)
+            goto done;
+        cpy = NULL;
+    }
+    else if (flux_msg_sendzsock (p->sock, cpy ? cpy : msg) < 0)
+        goto done;
     rc = 0;
 done:
     flux_msg_destroy (cpy);
@@ -425,6 +437,7 @@ static void module_destroy (module_t *p)
 
     flux_watcher_stop (p->broker_w);
     flux_watcher_destroy (p->broker_w);
+    iothread_destroy (p->io);
     zsock_destroy (&p->sock);
 
 #ifndef __SANITIZE_ADDRESS__
@@ -476,23 +489,37 @@ void module_mute (module_t *p)
     p->muted = true;
 }
 
-static void module_cb (flux_reactor_t *r, flux_watcher_t *w,
-                       int revents, void *arg)
+static void module_ready (module_t *p)
 {
-    module_t *p = arg;
     assert (p->magic == MODULE_MAGIC);
     p->lastseen = heartbeat_get_epoch (p->heartbeat);
     if (p->poller_cb)
         p->poller_cb (p, p->poller_arg);
 }
 
+static void module_cb (flux_reactor_t *r, flux_watcher_t *w,
+                       int revents, void *arg)
+{
+    module_ready (arg);
+}
+
+static void module_io_cb (struct iothread *io, void *arg)
+{
+    module_ready (arg);
+}
+
 int module_start (module_t *p)
 {
     assert (p->magic == MODULE_MAGIC);
     int errnum;
     int rc = -1;
 
-    flux_watcher_start (p->broker_w);
+    if (p->io) {
+        if (iothread_start (p->io) < 0)
+            goto done;
+    }
+    else
+        flux_watcher_start (p->broker_w);
     if ((errnum = pthread_create (&p->t, NULL, module_thread, p))) {
         errno = errnum;
         goto done;
@@ -673,9 +700,18 @@ module_t *module_add (modhash_t *mh, const char *path)
         log_err ("zsock_bind inproc://%s", module_get_uuid (p));
         goto cleanup;
     }
-    if (!(p->broker_w = flux_zmq_watcher_create (flux_get_reactor (p->broker_h),
-                                                 p->sock, FLUX_POLLIN,
-                                                 module_cb, p))) {
+    if (mh->iothreads) {
+        if (!(p->io = iothread_create (flux_get_reactor (p->broker_h),
+                                       p->sock, 0,
+                                       module_io_cb, p))) {
+            log_err ("iothread_create");
+            goto cleanup;
+        }
+    }
+    else if (!(p->broker_w = flux_zmq_watcher_create (
+                                            flux_get_reactor (p->broker_h),
+                                            p->sock, FLUX_POLLIN,
+                                            module_cb, p))) {
         log_err ("flux_zmq_watcher_create");
         goto cleanup;
     }
@@ -755,6 +791,11 @@ void modhash_set_heartbeat (modhash_t *mh, heartbeat_t *hb)
     mh->heartbeat = hb;
 }
 
+void modhash_set_iothreads (modhash_t *mh, bool enable)
+{
+    mh->iothreads = enable;
+}
+
 json_t *module_get_modlist (modhash_t *mh, struct service_switch *sw)
 {
     json_t *mods = NULL;
@@ -32,6 +32,11 @@ void modhash_set_rank (modhash_t *mh, uint32_t rank);
 void modhash_set_flux (modhash_t *mh, flux_t *h);
 void modhash_set_heartbeat (modhash_t *mh, heartbeat_t *hb);
 
+/* Service the broker end of each module's socket on a dedicated I/O thread
+ * rather than the reactor thread.  Applies to modules added after the call.
+ */
+void modhash_set_iothreads (modhash_t *mh, bool enable);
+
 /* Prepare module at 'path' for starting.
  */
 module_t *module_add (modhash_t *mh, const char *path);
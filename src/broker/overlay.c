@@ -23,16 +23,19 @@
 #include "src/common/libutil/iterators.h"
 #include "src/common/libutil/kary.h"
 #include "src/common/libutil/cleanup.h"
+#include "src/common/libutil/errno_safe.h"
 #include "src/common/libutil/zsecurity.h"
 
 #include "heartbeat.h"
 #include "overlay.h"
+#include "iothread.h"
 #include "attr.h"
 
 struct endpoint {
     zsock_t *zs;
     char *uri;
     flux_watcher_t *w;
+    struct iothread *io;
 };
 
 struct overlay {
@@ -42,6 +45,7 @@ struct overlay {
     zhash_t *children;          /* child_t - by uuid */
     flux_msg_handler_t **handlers;
     int epoch;
+    bool iothreads;             /* service sockets on I/O threads */
 
     uint32_t size;
     uint32_t rank;
@@ -51,13 +55,15 @@ struct overlay {
     int tbon_descendants;
 
     struct endpoint *parent;    /* DEALER - requests to parent */
-    overlay_sock_cb_f parent_cb;
+    overlay_msg_cb_f parent_cb;
     void *parent_arg;
     int parent_lastsent;
 
     struct endpoint *child;     /* ROUTER - requests from children */
-    overlay_sock_cb_f child_cb;
+    overlay_msg_cb_f child_cb;
     void *child_arg;
+    overlay_error_cb_f child_error_cb;
+    void *child_error_arg;
 
     zsock_t *child_monitor_sock;
     flux_watcher_t *child_monitor_w;
@@ -80,6 +86,7 @@ static void endpoint_destroy (struct endpoint *ep)
     if (ep) {
         free (ep->uri);
         flux_watcher_destroy (ep->w);
+        iothread_destroy (ep->io);
         zsock_destroy (&ep->zs);
         free (ep);
     }
@@ -140,6 +147,29 @@ void overlay_set_idle_warning (struct overlay *ov, int heartbeats)
     ov->idle_warning = heartbeats;
 }
 
+void overlay_set_iothreads (struct overlay *ov, bool enable)
+{
+    ov->iothreads = enable;
+}
+
+/* Send a copy of 'msg' on the endpoint's I/O thread if it has one,
+ * otherwise send 'msg' directly on its socket.
+ */
+static int endpoint_sendmsg (struct endpoint *ep, const flux_msg_t *msg)
+{
+    flux_msg_t *cpy;
+
+    if (!ep->io)
+        return flux_msg_sendzsock (ep->zs, msg);
+    if (!(cpy = flux_msg_copy (msg, true)))
+        return -1;
+    if (iothread_sendmsg (ep->io, cpy) < 0) {
+        ERRNO_SAFE_WRAP (flux_msg_destroy, cpy);
+        return -1;
+    }
+    return 0;
+}
+
 void overlay_log_idle_children (struct overlay *ov)
 {
     const char *uuid;
@@ -195,7 +225,7 @@ int overlay_sendmsg_parent (struct overlay *ov, const flux_msg_t *msg)
         errno = EHOSTUNREACH;
         goto done;
     }
-    rc = flux_msg_sendzsock (ov->parent->zs, msg);
+    rc = endpoint_sendmsg (ov->parent, msg);
     if (rc == 0)
         ov->parent_lastsent = ov->epoch;
 done:
@@ -214,7 +244,7 @@ static int overlay_keepalive_parent (struct overlay *ov)
         goto done;
     if (flux_msg_enable_route (msg) < 0)
         goto done;
-    rc = flux_msg_sendzsock (ov->parent->zs, msg);
+    rc = endpoint_sendmsg (ov->parent, msg);
 done:
     flux_msg_destroy (msg);
     return rc;
@@ -233,7 +263,7 @@ static void heartbeat_cb (flux_t *h,
     overlay_log_idle_children (ov);
 }
 
-void overlay_set_parent_cb (struct overlay *ov, overlay_sock_cb_f cb, void *arg)
+void overlay_set_parent_cb (struct overlay *ov, overlay_msg_cb_f cb, void *arg)
 {
     ov->parent_cb = cb;
     ov->parent_arg = arg;
@@ -259,12 +289,20 @@ const char *overlay_get_child (struct overlay *ov)
     return ov->child->uri;
 }
 
-void overlay_set_child_cb (struct overlay *ov, overlay_sock_cb_f cb, void *arg)
+void overlay_set_child_cb (struct overlay *ov, overlay_msg_cb_f cb, void *arg)
 {
     ov->child_cb = cb;
     ov->child_arg = arg;
 }
 
+void overlay_set_child_error_cb (struct overlay *ov,
+                                 overlay_error_cb_f cb,
+                                 void *arg)
+{
+    ov->child_error_cb = cb;
+    ov->child_error_arg = arg;
+}
+
 int overlay_sendmsg_child (struct overlay *ov, const flux_msg_t *msg)
 {
     int rc = -1;
@@ -273,11 +311,19 @@ int overlay_sendmsg_child (struct overlay *ov, const flux_msg_t *msg)
         errno = EINVAL;
         goto done;
     }
-    rc = flux_msg_sendzsock (ov->child->zs, msg);
+    rc = endpoint_sendmsg (ov->child, msg);
 done:
     return rc;
 }
 
+/* Make one routable copy of 'msg' and send it to each child, prefixed
+ * with the child's uuid as the ROUTER identity frame.  The copy's frames
+ * are sent with ZFRAME_REUSE, which hands libzmq a zmq_msg_copy() of each
+ * frame.  For all but very small frames that is a reference on the same
+ * refcounted buffer, so the payload is shared by all children rather than
+ * duplicated per child.  With I/O threads, the copy is handed to the child
+ * I/O thread, which sends it to the peers it has received messages from.
+ */
 int overlay_mcast_child (struct overlay *ov, const flux_msg_t *msg)
 {
     flux_msg_t *cpy = NULL;
@@ -287,17 +333,22 @@ int overlay_mcast_child (struct overlay *ov, const flux_msg_t *msg)
 
     if (!ov->child || !ov->child->zs || !ov->children)
         return 0;
-    FOREACH_ZHASH (ov->children, uuid, child) {
-        if (!(cpy = flux_msg_copy (msg, true)))
-            goto done;
-        if (flux_msg_enable_route (cpy) < 0)
+    if (zhash_size (ov->children) == 0)
+        return 0;
+    if (!(cpy = flux_msg_copy (msg, true)))
+        goto done;
+    if (flux_msg_enable_route (cpy) < 0)
+        goto done;
+    if (ov->child->io) {
+        if (iothread_mcast (ov->child->io, cpy) < 0)
             goto done;
-        if (flux_msg_push_route (cpy, uuid) < 0)
+        return 0;
+    }
+    FOREACH_ZHASH (ov->children, uuid, child) {
+        if (zstr_sendm (ov->child->zs, uuid) < 0)
             goto done;
         if (flux_msg_sendzsock (ov->child->zs, cpy) < 0)
             goto done;
-        flux_msg_destroy (cpy);
-        cpy = NULL;
     }
     rc = 0;
 done:
@@ -374,8 +425,52 @@ static void child_cb (flux_reactor_t *r, flux_watcher_t *w,
 {
     void *zsock = flux_zmq_watcher_get_zsock (w);
     struct overlay *ov = arg;
+    flux_msg_t *msg;
+
+    if (!(msg = flux_msg_recvzsock (zsock)))
+        return;
+    if (ov->child_cb)
+        ov->child_cb (ov, msg, ov->child_arg);
+    flux_msg_destroy (msg);
+}
+
+static void child_io_cb (struct iothread *io, void *arg)
+{
+    struct overlay *ov = arg;
+    flux_msg_t *msg;
+
+    if (!(msg = iothread_recvmsg (io)))
+        return;
     if (ov->child_cb)
-        ov->child_cb (ov, zsock, ov->child_arg);
+        ov->child_cb (ov, msg, ov->child_arg);
+    flux_msg_destroy (msg);
+}
+
+static void child_error_cb (struct iothread *io,
+                            flux_msg_t *msg,
+                            int errnum,
+                            void *arg)
+{
+    struct overlay *ov = arg;
+
+    if (ov->child_error_cb)
+        ov->child_error_cb (ov, msg, errnum, ov->child_error_arg);
+}
+
+/* Service endpoint socket on a new I/O thread instead of a reactor watcher.
+ */
+static int endpoint_start_iothread (struct overlay *ov,
+                                    struct endpoint *ep,
+                                    int flags,
+                                    iothread_recv_f cb)
+{
+    if (!(ep->io = iothread_create (flux_get_reactor (ov->h),
+                                    ep->zs,
+                                    flags,
+                                    cb,
+                                    ov)))
+        return -1;
+    return 0;
 }
 
 /* Cleanup not done in this function, responsibiility of caller to
@@ -401,12 +496,28 @@ static int bind_child (struct overlay *ov, struct endpoint *ep)
         free (ep->uri);
         ep->uri = zsock_last_endpoint (ep->zs);
     }
-    if (!(ep->w = flux_zmq_watcher_create (flux_get_reactor (ov->h),
-                                           ep->zs, FLUX_POLLIN, child_cb, ov))) {
-        log_err ("flux_zmq_watcher_create");
-        return -1;
+    if (ov->iothreads) {
+        if (endpoint_start_iothread (ov, ep, IOTHREAD_MCAST, child_io_cb) < 0) {
+            log_err ("iothread_create");
+            return -1;
+        }
+        iothread_set_error_cb (ep->io, child_error_cb, ov);
+        if (iothread_start (ep->io) < 0) {
+            log_err ("iothread_start");
+            return -1;
+        }
+    }
+    else {
+        if (!(ep->w = flux_zmq_watcher_create (flux_get_reactor (ov->h),
+                                               ep->zs,
+                                               FLUX_POLLIN,
+                                               child_cb,
+                                               ov))) {
+            log_err ("flux_zmq_watcher_create");
+            return -1;
+        }
+        flux_watcher_start (ep->w);
     }
-    flux_watcher_start (ep->w);
     /* Ensure that ipc files are removed when the broker exits.
      */
     char *ipc_path = strstr (ep->uri, "ipc://");
@@ -420,8 +531,25 @@ static void parent_cb (flux_reactor_t *r, flux_watcher_t *w,
 {
     void *zsock = flux_zmq_watcher_get_zsock (w);
     struct overlay *ov = arg;
+    flux_msg_t *msg;
+
+    if (!(msg = flux_msg_recvzsock (zsock)))
+        return;
+    if (ov->parent_cb)
+        ov->parent_cb (ov, msg, ov->parent_arg);
+    flux_msg_destroy (msg);
+}
+
+static void parent_io_cb (struct iothread *io, void *arg)
+{
+    struct overlay *ov = arg;
+    flux_msg_t *msg;
+
+    if (!(msg = iothread_recvmsg (io)))
+        return;
     if (ov->parent_cb)
-        ov->parent_cb (ov, zsock, ov->parent_arg);
+        ov->parent_cb (ov, msg, ov->parent_arg);
+    flux_msg_destroy (msg);
 }
 
 static int connect_parent (struct overlay *ov, struct endpoint *ep)
@@ -441,17 +569,27 @@ static int connect_parent (struct overlay *ov, struct endpoint *ep)
     zsock_set_identity (ep->zs, rankstr);
     if (zsock_connect (ep->zs, "%s", ep->uri) < 0)
         goto error;
-    if (!(ep->w = flux_zmq_watcher_create (flux_get_reactor (ov->h),
-                                           ep->zs, FLUX_POLLIN, parent_cb, ov)))
-        goto error;
-    flux_watcher_start (ep->w);
+    if (ov->iothreads) {
+        if (endpoint_start_iothread (ov, ep, 0, parent_io_cb) < 0
+            || iothread_start (ep->io) < 0)
+            goto error;
+    }
+    else {
+        if (!(ep->w = flux_zmq_watcher_create (flux_get_reactor (ov->h),
+                                               ep->zs,
+                                               FLUX_POLLIN,
+                                               parent_cb,
+                                               ov)))
+            goto error;
+        flux_watcher_start (ep->w);
+    }
     return 0;
 error:
-    if (ep->zs) {
-        savederr = errno;
-        zsock_destroy (&ep->zs);
-        errno = savederr;
-    }
+    savederr = errno;
+    iothread_destroy (ep->io);
+    ep->io = NULL;
+    zsock_destroy (&ep->zs);
+    errno = savederr;
     return -1;
 }
 
@@ -16,7 +16,16 @@
 
 struct overlay;
 
-typedef void (*overlay_sock_cb_f)(struct overlay *ov, void *sock, void *arg);
+/* Called with each message received on the parent or child socket.
+ * The callback may modify 'msg', which is destroyed when it returns.
+ */
+typedef void (*overlay_msg_cb_f)(struct overlay *ov,
+                                 flux_msg_t *msg,
+                                 void *arg);
+typedef void (*overlay_error_cb_f)(struct overlay *ov,
+                                   flux_msg_t *msg,
+                                   int errnum,
+                                   void *arg);
 typedef int (*overlay_init_cb_f)(struct overlay *ov, void *arg);
 typedef void (*overlay_monitor_cb_f)(struct overlay *ov, void *arg);
 
@@ -39,6 +48,12 @@ int overlay_init (struct overlay *ov,
                   int tbon_k);
 void overlay_set_idle_warning (struct overlay *ov, int heartbeats);
 
+/* Service the parent and child sockets on dedicated I/O threads rather
+ * than the reactor thread.  Sends are then queued, and a send that later
+ * fails on the child socket is reported to the child error callback.
+ */
+void overlay_set_iothreads (struct overlay *ov, bool enable);
+
 /* Accessors
  */
 uint32_t overlay_get_rank (struct overlay *ov);
@@ -50,7 +65,7 @@ int overlay_get_child_peer_count (struct overlay *ov);
 int overlay_set_parent (struct overlay *ov, const char *fmt, ...);
 const char *overlay_get_parent (struct overlay *ov);
 void overlay_set_parent_cb (struct overlay *ov,
-                            overlay_sock_cb_f cb,
+                            overlay_msg_cb_f cb,
                             void *arg);
 int overlay_sendmsg_parent (struct overlay *ov, const flux_msg_t *msg);
 
@@ -59,7 +74,10 @@ int overlay_sendmsg_parent (struct overlay *ov, const flux_msg_t *msg);
  */
 int overlay_set_child (struct overlay *ov, const char *fmt, ...);
 const char *overlay_get_child (struct overlay *ov);
-void overlay_set_child_cb (struct overlay *ov, overlay_sock_cb_f cb, void *arg);
+void overlay_set_child_cb (struct overlay *ov, overlay_msg_cb_f cb, void *arg);
+void overlay_set_child_error_cb (struct overlay *ov,
+                                 overlay_error_cb_f cb,
+                                 void *arg);
 int overlay_sendmsg_child (struct overlay *ov, const flux_msg_t *msg);
 /* We can "multicast" events to all child peers using mcast_child().
  * It walks the 'children' hash, finding peers and routeing them a copy of msg.
@@ -0,0 +1,314 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <czmq.h>
+#include <flux/core.h>
+
+#include "iothread.h"
+
+#include "src/common/libtap/tap.h"
+
+struct test_ctx {
+    flux_reactor_t *r;
+    struct iothread *io;
+    int count;
+    int expected;
+    int errors;
+    int senderr;
+    bool destroy;
+};
+
+static void timeout_cb (flux_reactor_t *r, flux_watcher_t *w,
+                        int revents, void *arg)
+{
+    BAIL_OUT ("timed out waiting for iothread");
+}
+
+/* Run the reactor until a callback stops it.
+ */
+static void run_reactor (flux_reactor_t *r)
+{
+    flux_watcher_t *w;
+
+    if (!(w = flux_timer_watcher_create (r, 30., 0., timeout_cb, NULL)))
+        BAIL_OUT ("flux_timer_watcher_create failed");
+    flux_watcher_start (w);
+    if (flux_reactor_run (r, 0) < 0)
+        BAIL_OUT ("flux_reactor_run failed");
+    flux_watcher_destroy (w);
+}
+
+static void recv_cb (struct iothread *io, void *arg)
+{
+    struct test_ctx *ctx = arg;
+    flux_msg_t *msg;
+    uint32_t matchtag;
+
+    if (!(msg = iothread_recvmsg (io)))
+        return;
+    if (flux_msg_get_matchtag (msg, &matchtag) < 0 || matchtag != ctx->count)
+        ctx->errors++;
+    flux_msg_destroy (msg);
+    if (ctx->destroy) {
+        iothread_destroy (io);
+        ctx->io = NULL;
+    }
+    if (++ctx->count == ctx->expected || !ctx->io)
+        flux_reactor_stop (ctx->r);
+}
+
+static void error_cb (struct iothread *io,
+                      flux_msg_t *msg,
+                      int errnum,
+                      void *arg)
+{
+    struct test_ctx *ctx = arg;
+
+    ctx->senderr = errnum;
+    flux_reactor_stop (ctx->r);
+}
+
+static flux_msg_t *request_create (int matchtag)
+{
+    flux_msg_t *msg;
+
+    if (!(msg = flux_request_encode ("a", NULL))
+        || flux_msg_set_matchtag (msg, matchtag) < 0)
+        BAIL_OUT ("error creating request");
+    return msg;
+}
+
+/* Pass 'count' messages each way over a PAIR socket pair.
+ */
+static void test_pair (flux_reactor_t *r, int count)
+{
+    struct test_ctx ctx = { .r = r, .expected = count };
+    zsock_t *sock;
+    zsock_t *peer;
+    int errors = 0;
+
+    if (!(sock = zsock_new_pair ("@inproc://iothread-pair"))
+        || !(peer = zsock_new_pair (">inproc://iothread-pair")))
+        BAIL_OUT ("error creating PAIR sockets");
+    zsock_set_rcvtimeo (peer, 30000);
+
+    ctx.io = iothread_create (r, sock, 0, recv_cb, &ctx);
+    ok (ctx.io != NULL,
+        "iothread_create works");
+    ok (iothread_start (ctx.io) == 0,
+        "iothread_start works");
+
+    for (int i = 0; i < count; i++) {
+        flux_msg_t *msg = request_create (i);
+        if (flux_msg_sendzsock (peer, msg) < 0)
+            BAIL_OUT ("flux_msg_sendzsock failed");
+        flux_msg_destroy (msg);
+    }
+    run_reactor (r);
+    ok (ctx.count == count && ctx.errors == 0,
+        "received %d messages in order", count);
+
+    for (int i = 0; i < count; i++) {
+        if (iothread_sendmsg (ctx.io, request_create (i)) < 0)
+            BAIL_OUT ("iothread_sendmsg failed");
+    }
+    for (int i = 0; i < count; i++) {
+        flux_msg_t *msg;
+        uint32_t matchtag;
+
+        if (!(msg = flux_msg_recvzsock (peer)))
+            BAIL_OUT ("flux_msg_recvzsock failed");
+        if (flux_msg_get_matchtag (msg, &matchtag) < 0 || matchtag != i)
+            errors++;
+        flux_msg_destroy (msg);
+    }
+    ok (errors == 0,
+        "sent %d messages in order", count);
+
+    errno = 0;
+    ok (iothread_recvmsg (ctx.io) == NULL && errno == EWOULDBLOCK,
+        "iothread_recvmsg fails with EWOULDBLOCK when queue is empty");
+    errno = 0;
+    ok (iothread_mcast (ctx.io, NULL) < 0 && errno == EINVAL,
+        "iothread_mcast fails with EINVAL without IOTHREAD_MCAST");
+    errno = 0;
+    ok (iothread_start (ctx.io) < 0 && errno == EINVAL,
+        "iothread_start fails with EINVAL when already started");
+
+    iothread_destroy (ctx.io);
+    zsock_destroy (&peer);
+    zsock_destroy (&sock);
+}
+
+/* Multicast to ROUTER peers that have checked in, and get a send error
+ * back for a message addressed to an unknown peer.
+ */
+static void test_router (flux_reactor_t *r, int npeers)
+{
+    struct test_ctx ctx = { .r = r, .expected = npeers };
+    zsock_t *sock;
+    zsock_t *peers[npeers];
+    flux_msg_t *msg;
+    int received = 0;
+
+    if (!(sock = zsock_new_router ("@inproc://iothread-router")))
+        BAIL_OUT ("error creating ROUTER socket");
+    zsock_set_router_mandatory (sock, 1);
+    for (int i = 0; i < npeers; i++) {
+        char identity[16];
+
+        if (!(peers[i] = zsock_new_dealer (NULL)))
+            BAIL_OUT ("error creating DEALER socket");
+        snprintf (identity, sizeof (identity), "%d", i);
+        zsock_set_identity (peers[i], identity);
+        zsock_set_rcvtimeo (peers[i], 30000);
+        if (zsock_connect (peers[i], "inproc://iothread-router") < 0)
+            BAIL_OUT ("zsock_connect failed");
+    }
+    ctx.io = iothread_create (r, sock, IOTHREAD_MCAST, recv_cb, &ctx);
+    ok (ctx.io != NULL,
+        "iothread_create IOTHREAD_MCAST works");
+    iothread_set_error_cb (ctx.io, error_cb, &ctx);
+    if (iothread_start (ctx.io) < 0)
+        BAIL_OUT ("iothread_start failed");
+
+    for (int i = 0; i < npeers; i++) {
+        msg = request_create (i);
+        if (flux_msg_enable_route (msg) < 0
+            || flux_msg_sendzsock (peers[i], msg) < 0)
+            BAIL_OUT ("error sending from peer");
+        flux_msg_destroy (msg);
+    }
+    run_reactor (r);
+    ok (ctx.count == npeers,
+        "received a message from each of %d peers", npeers);
+
+    if (!(msg = flux_event_encode ("test.event", NULL))
+        || flux_msg_enable_route (msg) < 0)
+        BAIL_OUT ("error creating event");
+    ok (iothread_mcast (ctx.io, msg) == 0,
+        "iothread_mcast works");
+    for (int i = 0; i < npeers; i++) {
+        const char *topic;
+        if ((msg = flux_msg_recvzsock (peers[i]))
+            && flux_msg_get_topic (msg, &topic) == 0
+            && !strcmp (topic, "test.event"))
+            received++;
+        flux_msg_destroy (msg);
+    }
+    ok (received == npeers,
+        "each peer received the event");
+
+    msg = request_create (0);
+    if (flux_msg_enable_route (msg) < 0
+        || flux_msg_push_route (msg, "nosuchpeer") < 0)
+        BAIL_OUT ("error creating request");
+    ok (iothread_sendmsg (ctx.io, msg) == 0,
+        "iothread_sendmsg to unknown peer is queued");
+    run_reactor (r);
+    ok (ctx.senderr == EHOSTUNREACH,
+        "error callback was called with EHOSTUNREACH");
+
+    iothread_destroy (ctx.io);
+    for (int i = 0; i < npeers; i++)
+        zsock_destroy (&peers[i]);
+    zsock_destroy (&sock);
+}
+
+static void test_destroy_in_callback (flux_reactor_t *r)
+{
+    struct test_ctx ctx = { .r = r, .expected = 3, .destroy = true };
+    zsock_t *sock;
+    zsock_t *peer;
+
+    if (!(sock = zsock_new_pair ("@inproc://iothread-destroy"))
+        || !(peer = zsock_new_pair (">inproc://iothread-destroy")))
+        BAIL_OUT ("error creating PAIR sockets");
+    if (!(ctx.io = iothread_create (r, sock, 0, recv_cb, &ctx))
+        || iothread_start (ctx.io) < 0)
+        BAIL_OUT ("error starting iothread");
+    for (int i = 0; i < 3; i++) {
+        flux_msg_t *msg = request_create (i);
+        if (flux_msg_sendzsock (peer, msg) < 0)
+            BAIL_OUT ("flux_msg_sendzsock failed");
+        flux_msg_destroy (msg);
+    }
+    run_reactor (r);
+    ok (ctx.count == 1 && ctx.io == NULL,
+        "iothread_destroy works from the receive callback");
+    zsock_destroy (&peer);
+    zsock_destroy (&sock);
+}
+
+static void test_inval (flux_reactor_t *r)
+{
+    zsock_t *sock;
+
+    if (!(sock = zsock_new_pair (NULL)))
+        BAIL_OUT ("zsock_new_pair failed");
+    errno = 0;
+    ok (iothread_create (NULL, sock, 0, recv_cb, NULL) == NULL
+        && errno == EINVAL,
+        "iothread_create r=NULL fails with EINVAL");
+    errno = 0;
+    ok (iothread_create (r, NULL, 0, recv_cb, NULL) == NULL
+        && errno == EINVAL,
+        "iothread_create sock=NULL fails with EINVAL");
+    errno = 0;
+    ok (iothread_create (r, sock, 0, NULL, NULL) == NULL
+        && errno == EINVAL,
+        "iothread_create cb=NULL fails with EINVAL");
+    errno = 0;
+    ok (iothread_create (r, sock, 0x100, recv_cb, NULL) == NULL
+        && errno == EINVAL,
+        "iothread_create flags=0x100 fails with EINVAL");
+    errno = 0;
+    ok (iothread_start (NULL) < 0 && errno == EINVAL,
+        "iothread_start io=NULL fails with EINVAL");
+    errno = 0;
+    ok (iothread_recvmsg (NULL) == NULL && errno == EINVAL,
+        "iothread_recvmsg io=NULL fails with EINVAL");
+    errno = 0;
+    ok (iothread_sendmsg (NULL, NULL) < 0 && errno == EINVAL,
+        "iothread_sendmsg io=NULL fails with EINVAL");
+    lives_ok ({iothread_destroy (NULL);},
+        "iothread_destroy io=NULL doesn't crash");
+    zsock_destroy (&sock);
+}
+
+int main (int argc, char *argv[])
+{
+    flux_reactor_t *r;
+
+    plan (NO_PLAN);
+
+    if (!(r = flux_reactor_create (0)))
+        BAIL_OUT ("flux_reactor_create failed");
+
+    test_pair (r, 1000);
+    test_router (r, 3);
+    test_destroy_in_callback (r);
+    test_inval (r);
+
+    flux_reactor_destroy (r);
+
+    done_testing();
+    return (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
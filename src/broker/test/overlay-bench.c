@@ -0,0 +1,178 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* overlay-bench - time overlay_mcast_child() event distribution
+ *  as the number of child peers grows.
+ *
+ * Usage: overlay-bench [PAYLOAD_SIZE] [ITERATIONS]
+ *
+ * For fan-out 2, 16, and 256, a ROUTER child endpoint is bound on inproc://
+ *  and one DEALER per child connects to it.  An event with a PAYLOAD_SIZE
+ *  byte payload is multicast ITERATIONS times, and each child receives
+ *  its copy before the next event is sent.  Events per second are reported,
+ *  with the child socket serviced by the reactor, and by an I/O thread.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <czmq.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+
+#include "overlay.h"
+
+static const int fanouts[] = { 2, 16, 256, -1 };
+
+static int checkins;
+
+static void child_cb (struct overlay *ov, flux_msg_t *msg, void *arg)
+{
+    checkins++;
+}
+
+static void drain_children (zsock_t **children, int fanout)
+{
+    for (int i = 0; i < fanout; i++) {
+        zmsg_t *zmsg;
+        if (!(zmsg = zmsg_recv (children[i])))
+            log_err_exit ("zmsg_recv");
+        zmsg_destroy (&zmsg);
+    }
+}
+
+static double bench_fanout (flux_t *h, const flux_msg_t *msg,
+                            int fanout, int iter, bool iothreads)
+{
+    struct overlay *ov;
+    zsock_t **children;
+    struct timespec t0;
+    double elapsed;
+    int tries = 0;
+
+    if (!(ov = overlay_create (h, 0, NULL)))
+        log_err_exit ("overlay_create");
+    if (overlay_init (ov, fanout + 1, 0, fanout) < 0)
+        log_err_exit ("overlay_init");
+    overlay_set_child_cb (ov, child_cb, NULL);
+    overlay_set_iothreads (ov, iothreads);
+    if (overlay_set_child (ov, "inproc://overlay-bench-%d-%d",
+                           fanout, iothreads) < 0)
+        log_err_exit ("overlay_set_child");
+    if (overlay_bind (ov) < 0)
+        log_err_exit ("overlay_bind");
+
+    if (!(children = calloc (fanout, sizeof (children[0]))))
+        log_err_exit ("calloc");
+    for (int i = 0; i < fanout; i++) {
+        zuuid_t *uuid;
+
+        if (!(uuid = zuuid_new ()))
+            log_err_exit ("zuuid_new");
+        if (!(children[i] = zsock_new_dealer (NULL)))
+            log_err_exit ("zsock_new_dealer");
+        zsock_set_identity (children[i], zuuid_str (uuid));
+        if (zsock_connect (children[i], "%s", overlay_get_child (ov)) < 0)
+            log_err_exit ("zsock_connect");
+        overlay_checkin_child (ov, zuuid_str (uuid));
+        zuuid_destroy (&uuid);
+    }
+
+    /*  An I/O thread only sends events to peers it has heard from,
+     *   so have each child check in, and wait for all of them.
+     */
+    if (iothreads) {
+        checkins = 0;
+        for (int i = 0; i < fanout; i++) {
+            flux_msg_t *ka;
+            if (!(ka = flux_keepalive_encode (0, 0))
+                || flux_msg_enable_route (ka) < 0
+                || flux_msg_sendzsock (children[i], ka) < 0)
+                log_err_exit ("error sending keepalive");
+            flux_msg_destroy (ka);
+        }
+        while (checkins < fanout) {
+            if (flux_reactor_run (flux_get_reactor (h), FLUX_REACTOR_ONCE) < 0)
+                log_err_exit ("flux_reactor_run");
+        }
+    }
+
+    /*  The ROUTER is in mandatory mode, so wait until all children
+     *   are routable before starting the clock.
+     */
+    while (overlay_mcast_child (ov, msg) < 0) {
+        if (errno != EHOSTUNREACH || ++tries == 1000)
+            log_err_exit ("overlay_mcast_child");
+        usleep (1000);
+    }
+    drain_children (children, fanout);
+
+    monotime (&t0);
+    for (int i = 0; i < iter; i++) {
+        if (overlay_mcast_child (ov, msg) < 0)
+            log_err_exit ("overlay_mcast_child");
+        drain_children (children, fanout);
+    }
+    elapsed = monotime_since (t0);
+
+    for (int i = 0; i < fanout; i++)
+        zsock_destroy (&children[i]);
+    free (children);
+    overlay_destroy (ov);
+
+    return (iter * 1000.) / elapsed;
+}
+
+int main (int argc, char *argv[])
+{
+    int size = argc > 1 ? strtol (argv[1], NULL, 10) : 65536;
+    int iter = argc > 2 ? strtol (argv[2], NULL, 10) : 1000;
+    flux_msg_t *msg;
+    flux_t *h;
+    char *data;
+
+    log_init ("overlay-bench");
+
+    if (size < 0 || iter <= 0)
+        log_msg_exit ("Usage: overlay-bench [PAYLOAD_SIZE] [ITERATIONS]");
+    if (!(h = flux_open ("loop://", 0)))
+        log_err_exit ("flux_open loop://");
+    if (!(data = calloc (1, size > 0 ? size : 1)))
+        log_err_exit ("calloc");
+    if (!(msg = flux_event_encode_raw ("overlay-bench", data, size)))
+        log_err_exit ("flux_event_encode_raw");
+
+    printf ("%8s %12s %12s  (payload %d bytes)\n",
+            "FANOUT", "EVENTS/S", "IOTHREAD", size);
+    for (int i = 0; fanouts[i] > 0; i++) {
+        printf ("%8d %12.0f", fanouts[i],
+                bench_fanout (h, msg, fanouts[i], iter, false));
+        printf (" %12.0f\n",
+                bench_fanout (h, msg, fanouts[i], iter, true));
+        fflush (stdout);
+    }
+
+    flux_msg_destroy (msg);
+    free (data);
+    flux_close (h);
+    log_fini ();
+    return 0;
+}
+
+/* vi: ts=4 sw=4 expandtab
+ */
@@ -1318,9 +1318,22 @@ static void handle_output_data (struct attach_ctx *ctx, json_t *context)
     else
         fp = stderr;
     if (len > 0) {
-        if (optparse_hasopt (ctx->p, "label-io"))
-            fprintf (fp, "%s: ", rank);
-        fwrite (data, len, 1, fp);
+        if (optparse_hasopt (ctx->p, "label-io")) {
+            /* The shell may merge several lines into one event,
+             * so label each line.
+             */
+            const char *p = data;
+            const char *end = data + len;
+            while (p < end) {
+                const char *nl = memchr (p, '\n', end - p);
+                const char *next = nl ? nl + 1 : end;
+                fprintf (fp, "%s: ", rank);
+                fwrite (p, next - p, 1, fp);
+                p = next;
+            }
+        }
+        else
+            fwrite (data, len, 1, fp);
     }
     free (data);
 }
@@ -643,45 +643,61 @@ struct lookup_ctx {
 };
 
 
-void lookup_continuation (flux_future_t *f, void *arg)
+/* Print the value of 'key' from lookup 'f' in the form selected by
+ * --treeobj, --raw, and --label.  If 'index' is >= 0, 'f' is a batch
+ * lookup and the value is that of its index'th key.
+ */
+static void print_lookup (optparse_t *p, flux_future_t *f, int index,
+                          const char *key)
 {
-    struct lookup_ctx *ctx = arg;
-    const char *key = flux_kvs_lookup_get_key (f);
-
-    if (optparse_hasopt (ctx->p, "watch") && flux_rpc_get (f, NULL) < 0
-                                          && errno == ENODATA) {
-        flux_future_destroy (f);
-        return; // EOF
-    }
-
-    if (optparse_hasopt (ctx->p, "treeobj")) {
+    if (optparse_hasopt (p, "treeobj")) {
         const char *treeobj;
-        if (flux_kvs_lookup_get_treeobj (f, &treeobj) < 0)
+        if ((index < 0
+             ? flux_kvs_lookup_get_treeobj (f, &treeobj)
+             : flux_kvs_lookup_batch_get_treeobj (f, index, &treeobj)) < 0)
             log_err_exit ("%s", key);
-        if (optparse_hasopt (ctx->p, "label"))
+        if (optparse_hasopt (p, "label"))
             printf ("%s=", key);
         printf ("%s\n", treeobj);
     }
-    else if (optparse_hasopt (ctx->p, "raw")) {
+    else if (optparse_hasopt (p, "raw")) {
         const void *data;
         int len;
-        if (flux_kvs_lookup_get_raw (f, &data, &len) < 0)
+        if ((index < 0
+             ? flux_kvs_lookup_get_raw (f, &data, &len)
+             : flux_kvs_lookup_batch_get_raw (f, index, &data, &len)) < 0)
             log_err_exit ("%s", key);
-        if (optparse_hasopt (ctx->p, "label"))
+        if (optparse_hasopt (p, "label"))
             printf ("%s=", key);
+        fflush (stdout);
         if (write_all (STDOUT_FILENO, data, len) < 0)
             log_err_exit ("%s", key);
     }
     else {
         const char *value;
-        if (flux_kvs_lookup_get (f, &value) < 0)
+        if ((index < 0
+             ? flux_kvs_lookup_get (f, &value)
+             : flux_kvs_lookup_batch_get (f, index, &value)) < 0)
             log_err_exit ("%s", key);
-        if (optparse_hasopt (ctx->p, "label"))
+        if (optparse_hasopt (p, "label"))
             printf ("%s=", key);
         if (value)
             printf ("%s\n", value);
     }
     fflush (stdout);
+}
+
+void lookup_continuation (flux_future_t *f, void *arg)
+{
+    struct lookup_ctx *ctx = arg;
+    const char *key = flux_kvs_lookup_get_key (f);
+
+    if (optparse_hasopt (ctx->p, "watch") && flux_rpc_get (f, NULL) < 0
+                                          && errno == ENODATA) {
+        flux_future_destroy (f);
+        return; // EOF
+    }
+    print_lookup (ctx->p, f, -1, key);
     if (optparse_hasopt (ctx->p, "watch")) {
         flux_future_reset (f);
         if (ctx->maxcount > 0 && ++ctx->count == ctx->maxcount) {
@@ -728,6 +744,26 @@ void cmd_get_one (flux_t *h, const char *key, struct lookup_ctx *ctx)
     }
 }
 
+/* Look up several keys in one request, against one root snapshot.
+ * Values are output in command line order, and the first key that
+ * fails is fatal, as with individual lookups.
+ */
+static void cmd_get_batch (flux_t *h, const char **keys, int count,
+                           struct lookup_ctx *ctx)
+{
+    flux_future_t *f;
+    int flags = 0;
+    int i;
+
+    if (optparse_hasopt (ctx->p, "treeobj"))
+        flags |= FLUX_KVS_TREEOBJ;
+    if (!(f = flux_kvs_lookup_batch (h, ctx->ns, flags, keys, count)))
+        log_err_exit ("flux_kvs_lookup_batch");
+    for (i = 0; i < count; i++)
+        print_lookup (ctx->p, f, i, keys[i]);
+    flux_future_destroy (f);
+}
+
 int cmd_get (optparse_t *p, int argc, char **argv)
 {
     flux_t *h = (flux_t *)optparse_get_data (p, "flux_handle");
@@ -744,6 +780,16 @@ int cmd_get (optparse_t *p, int argc, char **argv)
     ctx.maxcount = optparse_get_int (p, "count", 0);
     ctx.ns = optparse_get_str (p, "namespace", NULL);
 
+    /* Plain lookups of several keys are made in one batch request.
+     */
+    if (argc - optindex > 1
+        && !optparse_hasopt (p, "watch")
+        && !optparse_hasopt (p, "waitcreate")
+        && !optparse_hasopt (p, "at")) {
+        cmd_get_batch (h, (const char **)&argv[optindex], argc - optindex,
+                       &ctx);
+        return (0);
+    }
     for (i = optindex; i < argc; i++)
         cmd_get_one (h, argv[i], &ctx);
     /* Unless --watch is specified, cmd_get_one() starts the reactor and
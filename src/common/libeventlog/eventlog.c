@@ -192,6 +192,220 @@ json_t *eventlog_entry_decode (const char *entry)
     return eventlog_entry_decode_common (entry, true);
 }
 
+bool eventlog_next (const char *s,
+                    size_t len,
+                    size_t *offset,
+                    const char **entry,
+                    size_t *entrylen)
+{
+    const char *start;
+    const char *term;
+
+    if (!s || !offset || *offset >= len)
+        return false;
+    start = s + *offset;
+    if (!(term = memchr (start, '\n', len - *offset)))
+        return false;
+    if (entry)
+        *entry = start;
+    if (entrylen)
+        *entrylen = term - start + 1;
+    *offset = term - s + 1;
+    return true;
+}
+
+static const char *skip_ws (const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        p++;
+    return p;
+}
+
+/* Skip a JSON string, where 'p' points to the opening quote.
+ * Return a pointer past the closing quote, or NULL if unterminated.
+ */
+static const char *skip_string (const char *p, const char *end)
+{
+    for (p++; p < end; p++) {
+        if (*p == '\\')
+            p++;
+        else if (*p == '"')
+            return p + 1;
+    }
+    return NULL;
+}
+
+/* Skip a JSON value within an object, returning a pointer to the
+ * ',' or '}' that follows a scalar, or past the end of a string,
+ * object, or array.  Nested values are skipped by tracking depth
+ * outside of strings and are not otherwise validated.
+ */
+static const char *skip_value (const char *p, const char *end)
+{
+    int depth = 0;
+
+    while (p < end) {
+        switch (*p) {
+            case '"':
+                if (!(p = skip_string (p, end)))
+                    return NULL;
+                if (depth == 0)
+                    return p;
+                continue;
+            case '{':
+            case '[':
+                depth++;
+                break;
+            case '}':
+            case ']':
+                if (depth == 0)
+                    return p;
+                if (--depth == 0)
+                    return p + 1;
+                break;
+            case ',':
+                if (depth == 0)
+                    return p;
+                break;
+        }
+        p++;
+    }
+    return NULL;
+}
+
+static bool key_match (const char *key, size_t keylen, const char *s)
+{
+    return strlen (s) == keylen && !strncmp (key, s, keylen);
+}
+
+static int scan_timestamp (const char *val, const char *vend, double *tp)
+{
+    const char *p;
+    char *endptr;
+    double t;
+
+    for (p = val; p < vend && strchr ("0123456789+-.eE", *p); p++)
+        ;
+    if (p == val || skip_ws (p, vend) != vend)
+        return -1;
+    errno = 0;
+    t = strtod (val, &endptr);
+    if (errno != 0 || endptr != p)
+        return -1;
+    if (tp)
+        *tp = t;
+    return 0;
+}
+
+/* The name is returned in place, without its quotes.
+ */
+static int scan_name (const char *val, const char *vend,
+                      const char **name, size_t *namelen)
+{
+    if (*val != '"')
+        return -1;
+    if (name)
+        *name = val + 1;
+    if (namelen)
+        *namelen = vend - val - 2;
+    return 0;
+}
+
+bool eventlog_entry_name_is (const char *name, size_t namelen, const char *s)
+{
+    return name && s && key_match (name, namelen, s);
+}
+
+int eventlog_entry_scan (const char *entry,
+                         size_t len,
+                         double *timestamp,
+                         const char **name,
+                         size_t *namelen,
+                         json_t **context)
+{
+    const char *end;
+    const char *p;
+    const char *ctx = NULL;
+    size_t ctxlen = 0;
+    bool have_timestamp = false;
+    bool have_name = false;
+    json_t *o = NULL;
+
+    if (!entry || len == 0)
+        goto einval;
+    end = entry + len;
+    if (end[-1] == '\n')
+        end--;
+    if (memchr (entry, '\n', end - entry))
+        goto einval;
+
+    p = skip_ws (entry, end);
+    if (p == end || *p++ != '{')
+        goto einval;
+    for (;;) {
+        const char *key;
+        size_t keylen;
+        const char *val;
+        const char *vend;
+
+        p = skip_ws (p, end);
+        if (p == end || *p != '"')
+            goto einval;
+        key = p + 1;
+        if (!(p = skip_string (p, end)))
+            goto einval;
+        keylen = p - key - 1;
+        p = skip_ws (p, end);
+        if (p == end || *p++ != ':')
+            goto einval;
+        val = skip_ws (p, end);
+        if (!(vend = skip_value (val, end)) || vend == val)
+            goto einval;
+
+        if (key_match (key, keylen, "timestamp")) {
+            if (scan_timestamp (val, vend, timestamp) < 0)
+                goto einval;
+            have_timestamp = true;
+        }
+        else if (key_match (key, keylen, "name")) {
+            if (scan_name (val, vend, name, namelen) < 0)
+                goto einval;
+            have_name = true;
+        }
+        else if (key_match (key, keylen, "context")) {
+            if (*val != '{')
+                goto einval;
+            ctx = val;
+            ctxlen = vend - val;
+        }
+
+        p = skip_ws (vend, end);
+        if (p == end)
+            goto einval;
+        if (*p == '}')
+            break;
+        if (*p++ != ',')
+            goto einval;
+    }
+    if (skip_ws (p + 1, end) != end || !have_timestamp || !have_name)
+        goto einval;
+
+    if (context) {
+        if (ctx) {
+            if (!(o = json_loadb (ctx, ctxlen, 0, NULL))
+                || !json_is_object (o)) {
+                json_decref (o);
+                goto einval;
+            }
+        }
+        *context = o;
+    }
+    return 0;
+einval:
+    errno = EINVAL;
+    return -1;
+}
+
 static int get_timestamp_now (double *timestamp)
 {
     struct timespec ts;
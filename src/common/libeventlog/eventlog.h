@@ -12,6 +12,8 @@
 #define _EVENTLOG_H
 
 #include <jansson.h>
+#include <stdbool.h>
+#include <stddef.h>
 
 /* convenience function to extract timestamp, name, and optional
  * context from an event entry */
@@ -29,6 +31,39 @@ char *eventlog_encode (json_t *o);
 /* decode a single eventlog entry into a json object */
 json_t *eventlog_entry_decode (const char *entry);
 
+/* find the next complete entry in eventlog 's' of length 'len',
+ * starting at byte '*offset'.  On success, set 'entry' and 'entrylen'
+ * to the entry text including its trailing newline, advance '*offset'
+ * past it, and return true.  Return false if no complete entry remains,
+ * leaving any partial entry for a later call.  The entry is not
+ * validated; use eventlog_entry_scan() to extract fields.  */
+bool eventlog_next (const char *s,
+                    size_t len,
+                    size_t *offset,
+                    const char **entry,
+                    size_t *entrylen);
+
+/* extract fields from the text of a single eventlog entry of length
+ * 'len' (trailing newline optional) without decoding it into a json
+ * object.  Any of timestamp, name, or context may be NULL to skip that
+ * field.  'name' is set to point to the name within 'entry', and
+ * 'namelen' to its length.  It is not NUL terminated, and escape
+ * sequences are left as is, so compare it with eventlog_entry_name_is().
+ * context is only decoded if requested, and is set to a new reference
+ * that the caller must json_decref(), or NULL if the entry has no
+ * context.  Keys are matched literally and values of unrequested fields
+ * are only checked for balanced nesting.  */
+int eventlog_entry_scan (const char *entry,
+                         size_t len,
+                         double *timestamp,
+                         const char **name,
+                         size_t *namelen,
+                         json_t **context);
+
+/* return true if 'name' of length 'namelen' from eventlog_entry_scan()
+ * is 's'.  's' must not need escaping in json.  */
+bool eventlog_entry_name_is (const char *name, size_t namelen, const char *s);
+
 /* build an eventlog entry.  Specify timestamp = 0.0 to get current
  * time. context must be a json object.  Set context to NULL if no
  * context necessary.  */
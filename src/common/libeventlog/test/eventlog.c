@@ -479,6 +479,149 @@ void eventlog_entry_encoding_errors (void)
         "eventlog_entry_vpack context=\"[\"foo\"]\" fails with EINVAL");
 }
 
+void eventlog_streaming (void)
+{
+    const char *log = "{\"timestamp\":1.0,\"name\":\"a\"}\n"
+                      "{\"timestamp\":2.5,\"name\":\"b\","
+                      "\"context\":{\"x\":1}}\n"
+                      "{\"timestamp\":3.0,\"name\":\"c\"}";
+    size_t len = strlen (log);
+    size_t offset = 0;
+    const char *entry;
+    size_t entrylen;
+    double timestamp;
+    const char *name;
+    size_t namelen;
+    json_t *context;
+
+    ok (eventlog_next (log, len, &offset, &entry, &entrylen) == true
+        && entry == log
+        && entry[entrylen - 1] == '\n'
+        && offset == entrylen,
+        "eventlog_next returns first entry");
+    ok (eventlog_entry_scan (entry, entrylen,
+                             &timestamp,
+                             &name, &namelen,
+                             &context) == 0
+        && timestamp == 1.0
+        && eventlog_entry_name_is (name, namelen, "a")
+        && context == NULL,
+        "eventlog_entry_scan works on entry w/o context");
+
+    ok (eventlog_next (log, len, &offset, &entry, &entrylen) == true
+        && entry[entrylen - 1] == '\n',
+        "eventlog_next returns second entry");
+    ok (eventlog_entry_scan (entry, entrylen, NULL, &name, &namelen, NULL)
+        == 0
+        && eventlog_entry_name_is (name, namelen, "b")
+        && !eventlog_entry_name_is (name, namelen, "bb")
+        && !eventlog_entry_name_is (name, namelen, ""),
+        "eventlog_entry_scan can extract name only");
+    ok (name > entry && name < entry + entrylen,
+        "eventlog_entry_scan returns name in place");
+    context = NULL;
+    ok (eventlog_entry_scan (entry, entrylen,
+                             &timestamp,
+                             NULL, NULL,
+                             &context) == 0
+        && timestamp == 2.5
+        && json_is_object (context)
+        && json_integer_value (json_object_get (context, "x")) == 1,
+        "eventlog_entry_scan can extract timestamp and context");
+    json_decref (context);
+
+    ok (eventlog_next (log, len, &offset, &entry, &entrylen) == false,
+        "eventlog_next returns false on partial entry");
+    ok (offset == strchr (strchr (log, '\n') + 1, '\n') - log + 1,
+        "eventlog_next leaves offset at start of partial entry");
+    ok (eventlog_next (log, len, &offset, NULL, NULL) == false,
+        "eventlog_next returns false again");
+
+    offset = len;
+    ok (eventlog_next (log, len, &offset, &entry, &entrylen) == false,
+        "eventlog_next returns false at end of eventlog");
+    offset = 0;
+    ok (eventlog_next (NULL, 0, &offset, &entry, &entrylen) == false
+        && eventlog_next (log, len, NULL, &entry, &entrylen) == false,
+        "eventlog_next returns false on bad input");
+
+    /* nested values and escapes */
+    entry = "{ \"timestamp\" : 1e2 , \"context\" : {\"a\":[1,{\"}\":\"]\"}],"
+            "\"b\":\"x\\\"y\"}, \"name\" : \"foo\\nbar\" }\n";
+    context = NULL;
+    ok (eventlog_entry_scan (entry, strlen (entry),
+                             &timestamp,
+                             &name, &namelen,
+                             &context) == 0
+        && timestamp == 100.
+        && namelen == 8
+        && !strncmp (name, "foo\\nbar", namelen)
+        && json_is_object (context)
+        && !strcmp (json_string_value (json_object_get (context, "b")),
+                    "x\"y"),
+        "eventlog_entry_scan handles whitespace, nesting, and escapes");
+    json_decref (context);
+
+    entry = "{\"timestamp\":1.0,"
+            "\"name\":\"a-name-much-longer-than-any-buffer-a-caller-might-"
+            "have-put-on-the-stack-for-it-in-the-past\"}\n";
+    ok (eventlog_entry_scan (entry, strlen (entry),
+                             NULL,
+                             &name, &namelen,
+                             NULL) == 0
+        && namelen == 90
+        && eventlog_entry_name_is (name, namelen,
+                                   "a-name-much-longer-than-any-buffer-"
+                                   "a-caller-might-have-put-on-the-stack-"
+                                   "for-it-in-the-past"),
+        "eventlog_entry_scan works on long name");
+}
+
+void eventlog_streaming_errors (void)
+{
+    const char *bad[] = {
+        "",
+        "\n",
+        "foo\n",
+        "[]\n",
+        "{}\n",
+        "{\"timestamp\":1.0}\n",
+        "{\"name\":\"foo\"}\n",
+        "{\"timestamp\":\"1.0\",\"name\":\"foo\"}\n",
+        "{\"timestamp\":1.0,\"name\":42}\n",
+        "{\"timestamp\":0x10,\"name\":\"foo\"}\n",
+        "{\"timestamp\":1.0,\"name\":\"foo\",\"context\":[]}\n",
+        "{\"timestamp\":1.0,\"name\":\"foo\",\"context\":{\"a\":}}\n",
+        "{\"timestamp\":1.0,\"name\":\"foo\"\n",
+        "{\"timestamp\":1.0,\"name\":\"foo}\n",
+        "{\"timestamp\":1.0,\"name\":\"foo\"}x\n",
+        "{\"timestamp\":1.0,\n\"name\":\"foo\"}\n",
+        "{\"timestamp\":1.0 \"name\":\"foo\"}\n",
+        "{\"timestamp\":,\"name\":\"foo\"}\n",
+        NULL,
+    };
+    const char *name;
+    size_t namelen;
+    json_t *context;
+    int i;
+
+    errno = 0;
+    ok (eventlog_entry_scan (NULL, 0, NULL, NULL, 0, NULL) < 0
+        && errno == EINVAL,
+        "eventlog_entry_scan fails with EINVAL on NULL input");
+
+    for (i = 0; bad[i] != NULL; i++) {
+        errno = 0;
+        context = NULL;
+        ok (eventlog_entry_scan (bad[i], strlen (bad[i]),
+                                 NULL,
+                                 &name, &namelen,
+                                 &context) < 0
+            && errno == EINVAL,
+            "eventlog_entry_scan fails with EINVAL on bad entry %d", i);
+    }
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -489,6 +632,8 @@ int main (int argc, char *argv[])
     eventlog_entry_decoding ();
     eventlog_entry_decoding_errors ();
     eventlog_entry_encoding ();
+    eventlog_streaming ();
+    eventlog_streaming_errors ();
     /* eventlog_entry_encoding_errors (); */
 
     done_testing ();
@@ -14,12 +14,15 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
 #include <czmq.h>
 
 #include "src/common/libutil/aux.h"
 
 #include "future.h"
+#include "future_private.h"
+#include "reactor_private.h"
 #include "flog.h"
 
 struct now_context {
@@ -33,8 +36,7 @@ struct now_context {
 struct then_context {
     flux_reactor_t *r;      // external reactor for then
     flux_watcher_t *timer;  // timer watcher (if timeout set)
-    flux_watcher_t *check;
-    flux_watcher_t *idle;
+    struct reactor_ready ready; // posted to run continuation
     bool init_called;
     flux_continuation_f continuation;
     void *continuation_arg;
@@ -60,14 +62,17 @@ struct flux_future {
     flux_future_init_f init;
     void *init_arg;
     struct now_context *now;
-    struct then_context *then;
+    struct then_context *then;  // points to then_ctx once set up
+    struct then_context then_ctx;
     zlist_t *queue;
     flux_future_t *embed;
     int refcount;
+    future_hook_f finalize;
+    future_hook_f recycle;
+    void *hook_arg;
 };
 
-static void check_cb (flux_reactor_t *r, flux_watcher_t *w,
-                      int revents, void *arg);
+static void ready_cb (void *arg);
 static void now_timer_cb (flux_reactor_t *r, flux_watcher_t *w,
                           int revents, void *arg);
 static void then_timer_cb (flux_reactor_t *r, flux_watcher_t *w,
@@ -133,47 +138,38 @@ static void now_context_clear_timer (struct now_context *now)
 
 /* "then" reactor context - used for continuation
  * This is set up lazily; wait until the user calls flux_future_then().
+ * It is stored in the future, and instead of watchers of its own, it
+ * posts to the reactor's shared ready queue when the future is fulfilled.
  * N.B. then() can only be called once.
  */
 
-static void then_context_destroy (struct then_context *then)
+static void then_context_fini (struct then_context *then)
 {
     if (then) {
         flux_watcher_destroy (then->timer);
-        flux_watcher_destroy (then->check);
-        flux_watcher_destroy (then->idle);
-        free (then);
+        reactor_ready_cancel (then->r, &then->ready);
+        flux_reactor_destroy (then->r); // drop reference
     }
 }
 
-static struct then_context *then_context_create (flux_reactor_t *r, void *arg)
+static struct then_context *then_context_init (struct then_context *then,
+                                               flux_reactor_t *r,
+                                               void *arg)
 {
-    struct then_context *then = calloc (1, sizeof (*then));
-    if (!then) {
-        errno = ENOMEM;
-        goto error;
-    }
-    then->r = r;
-    if (!(then->check = flux_check_watcher_create (r, check_cb, arg)))
-        goto error;
-    if (!(then->idle = flux_idle_watcher_create (r, NULL, NULL)))
-        goto error;
+    memset (then, 0, sizeof (*then));
+    then->r = reactor_incref (r);
+    reactor_ready_init (&then->ready, ready_cb, arg);
     return then;
-error:
-    then_context_destroy (then);
-    return NULL;
 }
 
 static void then_context_start (struct then_context *then)
 {
-    flux_watcher_start (then->idle); // prevent reactor from blocking
-    flux_watcher_start (then->check);
+    reactor_ready_post (then->r, &then->ready);
 }
 
 static void then_context_stop (struct then_context *then)
 {
-    flux_watcher_stop (then->idle);
-    flux_watcher_stop (then->check);
+    reactor_ready_cancel (then->r, &then->ready);
 }
 
 static int then_context_set_timeout (struct then_context *then,
@@ -296,19 +292,66 @@ void flux_future_destroy (flux_future_t *f)
 {
     if (f && (--f->refcount == 0)) {
         int saved_errno = errno;
+        flux_t *h = f->h;
+        if (f->finalize)
+            f->finalize (f, f->hook_arg);
         flux_future_destroy (f->embed);
         aux_destroy (&f->aux);
         clear_result (&f->result);
         free (f->fatal_errnum_string);
         now_context_destroy (f->now);
-        then_context_destroy (f->then);
+        then_context_fini (f->then);
         zlist_destroy (&f->queue);
-        flux_decref (f->h);
-        free (f);
+        if (f->recycle)
+            f->recycle (f, f->hook_arg);
+        else
+            free (f);
+        flux_decref (h);
         errno = saved_errno;
     }
 }
 
+void future_set_hooks (flux_future_t *f,
+                       future_hook_f finalize,
+                       future_hook_f recycle,
+                       void *arg)
+{
+    if (f) {
+        f->finalize = finalize;
+        f->recycle = recycle;
+        f->hook_arg = arg;
+    }
+}
+
+void *future_get_hook_arg (flux_future_t *f, future_hook_f finalize)
+{
+    if (!f)
+        return NULL;
+    if (f->finalize == finalize)
+        return f->hook_arg;
+    return future_get_hook_arg (f->embed, finalize);
+}
+
+void future_reuse (flux_future_t *f, flux_future_init_f cb, void *arg)
+{
+    future_hook_f finalize = f->finalize;
+    future_hook_f recycle = f->recycle;
+    void *hook_arg = f->hook_arg;
+
+    memset (f, 0, sizeof (*f));
+    f->init = cb;
+    f->init_arg = arg;
+    f->refcount = 1;
+    f->finalize = finalize;
+    f->recycle = recycle;
+    f->hook_arg = hook_arg;
+}
+
+void future_free (flux_future_t *f)
+{
+    free (f);
+}
+
 /* Create a future.
  */
 flux_future_t *flux_future_create (flux_future_init_f cb, void *arg)
@@ -543,10 +586,8 @@ int flux_future_then (flux_future_t *f, double timeout,
         errno = EINVAL;
         return -1;
     }
-    if (!f->then) {
-        if (!(f->then = then_context_create (f->r, f)))
-            return -1;
-    }
+    if (!f->then)
+        f->then = then_context_init (&f->then_ctx, f->r, f);
     if (future_is_ready (f))
         then_context_start (f->then);
     if (then_context_set_timeout (f->then, timeout, f) < 0)
@@ -783,10 +824,9 @@ static void now_timer_cb (flux_reactor_t *r, flux_watcher_t *w,
     flux_reactor_stop_error (r);
 }
 
-/* check - if results are ready, call the continuation
+/* ready queue - results are ready, call the continuation
  */
-static void check_cb (flux_reactor_t *r, flux_watcher_t *w,
-                      int revents, void *arg)
+static void ready_cb (void *arg)
 {
     flux_future_t *f = arg;
 
@@ -0,0 +1,48 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef FLUX_FUTURE_PRIVATE_H
+#define FLUX_FUTURE_PRIVATE_H
+
+#include "future.h"
+
+typedef void (*future_hook_f) (flux_future_t *f, void *arg);
+
+/* Set hooks for libflux code that keeps futures for reuse (see rpc.c).
+ * When the last reference to [f] is dropped, [finalize] is called before
+ * any results or aux items are released.  Once they are, [recycle] is
+ * called in place of freeing [f].  It may keep [f] to be reinitialized
+ * with future_reuse(), or release it with future_free().
+ */
+void future_set_hooks (flux_future_t *f,
+                       future_hook_f finalize,
+                       future_hook_f recycle,
+                       void *arg);
+
+/* Return the hook [arg] of [f] (or of a future embedded in [f] with
+ * flux_future_fulfill_with()) if its finalize hook is [finalize],
+ * else NULL.
+ */
+void *future_get_hook_arg (flux_future_t *f, future_hook_f finalize);
+
+/* Reinitialize a recycled future as if newly created with
+ * flux_future_create().  Hooks are preserved.
+ */
+void future_reuse (flux_future_t *f, flux_future_init_f cb, void *arg);
+
+/* Free a recycled future.
+ */
+void future_free (flux_future_t *f);
+
+#endif /* !FLUX_FUTURE_PRIVATE_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -20,18 +20,28 @@
 #include "message.h"
 #include "reactor.h"
 #include "msg_handler.h"
+#include "msg_handler_private.h"
 #include "response.h"
 #include "flog.h"
 
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/iterators.h"
 
+struct dispatch_rpc {
+    dispatch_rpc_f fn;
+    void *arg;
+};
+
 struct dispatch {
     flux_t *h;
     zlist_t *handlers;
     zlist_t *handlers_new;
     zhashx_t *handlers_rpc; // matchtag => response handler
+    struct dispatch_rpc *rpcv; // matchtag => response callback
+    uint32_t rpcv_size;
     zhashx_t *handlers_method; // topic => request handler (non-glob only)
+    zhashx_t *handlers_event; // topic => zlist of event handlers (non-glob)
+    zlist_t *event_bucket; // handlers_event entry being walked by dispatch
     flux_watcher_t *w;
     int running_count;
     int usecount;
@@ -73,6 +83,18 @@ static bool isa_multmatch (const char *s)
     return false;
 }
 
+/* Return true if handler with 'match' belongs in the handlers_event hash,
+ * e.g. it matches only events, on exactly one topic.
+ */
+static bool isa_event_topic (const struct flux_match match)
+{
+    if (match.typemask != FLUX_MSGTYPE_EVENT)
+        return false;
+    if (match.matchtag != FLUX_MATCHTAG_NONE)
+        return false;
+    return !isa_multmatch (match.topic_glob);
+}
+
 static void dispatch_requeue (struct dispatch *d)
 {
     if (d->unmatched) {
@@ -102,8 +124,10 @@ static void dispatch_usecount_decr (struct dispatch *d)
             zlist_destroy (&d->handlers_new);
         }
         flux_watcher_destroy (d->w);
+        free (d->rpcv);
         zhashx_destroy (&d->handlers_rpc);
         zhashx_destroy (&d->handlers_method);
+        zhashx_destroy (&d->handlers_event);
         free (d);
         errno = saved_errno;
     }
@@ -121,6 +145,17 @@ static void dispatch_destroy (void *arg)
     dispatch_usecount_decr (d);
 }
 
+/* zhashx_destructor_fn for handlers_event entries
+ */
+static void event_bucket_destroy (void **item)
+{
+    if (item) {
+        zlist_t *l = *item;
+        zlist_destroy (&l);
+        *item = NULL;
+    }
+}
+
 static struct dispatch *dispatch_get (flux_t *h)
 {
     struct dispatch *d = flux_aux_get (h, "flux::dispatch");
@@ -151,6 +186,13 @@ static struct dispatch *dispatch_get (flux_t *h)
             goto nomem;
         zhashx_set_key_destructor (d->handlers_method, NULL);
         zhashx_set_key_duplicator (d->handlers_method, NULL);
+        /* N.B. d->handlers_event values are lists of handlers, since an
+         * event is delivered to all matching handlers.  The key is
+         * duplicated as the list may outlive the handler that created it.
+         */
+        if (!(d->handlers_event = zhashx_new ()))
+            goto nomem;
+        zhashx_set_destructor (d->handlers_event, event_bucket_destroy);
 #if HAVE_CALIPER
         d->prof_msg_type = cali_create_attribute ("flux.message.type",
                                                   CALI_TYPE_STRING,
@@ -196,6 +238,46 @@ static size_t matchtag_hasher (const void *key)
     return matchtag;
 }
 
+/* Add 'mh' to the front of the handlers_event list for its topic,
+ * creating the list if necessary.
+ */
+static int event_bucket_push (struct dispatch *d, flux_msg_handler_t *mh)
+{
+    const char *topic = mh->match.topic_glob;
+    zlist_t *l;
+
+    if (!(l = zhashx_lookup (d->handlers_event, topic))) {
+        if (!(l = zlist_new ()))
+            goto nomem;
+        (void)zhashx_insert (d->handlers_event, topic, l);
+    }
+    if (zlist_push (l, mh) < 0) {
+        if (zlist_size (l) == 0 && l != d->event_bucket)
+            zhashx_delete (d->handlers_event, topic);
+        goto nomem;
+    }
+    return 0;
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
+/* Remove 'mh' from the handlers_event list for its topic.  If the list
+ * becomes empty, drop it, unless dispatch_message() is walking it, in
+ * which case dispatch_message() drops it when it is finished.
+ */
+static void event_bucket_remove (struct dispatch *d, flux_msg_handler_t *mh)
+{
+    const char *topic = mh->match.topic_glob;
+    zlist_t *l;
+
+    if ((l = zhashx_lookup (d->handlers_event, topic))) {
+        zlist_remove (l, mh);
+        if (zlist_size (l) == 0 && l != d->event_bucket)
+            zhashx_delete (d->handlers_event, topic);
+    }
+}
+
 static int copy_match (struct flux_match *dst,
                        const struct flux_match src)
 {
@@ -236,7 +318,8 @@ static void call_handler (flux_msg_handler_t *mh, const flux_msg_t *msg)
  * 2) RPC requests - lookup in handlers_method hash by topic string
  * 3) Requests and responses not matched above - sent to first match in
  *    list of handlers, where most recently registered handlers match first.
- * 4) Events - sent to all matches in list of handlers
+ * 4) Events - sent to all matches in the handlers_event hash entry for
+ *    the event topic, then to all matches in list of handlers
  */
 static bool dispatch_message (struct dispatch *d,
                               const flux_msg_t *msg,
@@ -250,12 +333,17 @@ static bool dispatch_message (struct dispatch *d,
         uint32_t matchtag;
         if (flux_msg_get_route_count (msg) == 0
                 && flux_msg_get_matchtag (msg, &matchtag) == 0
-                && matchtag != FLUX_MATCHTAG_NONE
-                && (mh = zhashx_lookup (d->handlers_rpc, &matchtag))
-                && mh->running
-                && flux_msg_cmp (msg, mh->match)) {
-            call_handler (mh, msg);
-            match = true;
+                && matchtag != FLUX_MATCHTAG_NONE) {
+            if (matchtag < d->rpcv_size && d->rpcv[matchtag].fn) {
+                d->rpcv[matchtag].fn (msg, d->rpcv[matchtag].arg);
+                match = true;
+            }
+            else if ((mh = zhashx_lookup (d->handlers_rpc, &matchtag))
+                    && mh->running
+                    && flux_msg_cmp (msg, mh->match)) {
+                call_handler (mh, msg);
+                match = true;
+            }
         }
     }
     /* rpc request */
@@ -268,6 +356,22 @@ static bool dispatch_message (struct dispatch *d,
             match = true;
         }
     }
+    /* event (non-glob handlers) */
+    else if (type == FLUX_MSGTYPE_EVENT) {
+        const char *topic;
+        zlist_t *l;
+        if (flux_msg_get_topic (msg, &topic) == 0
+                && (l = zhashx_lookup (d->handlers_event, topic))) {
+            d->event_bucket = l;
+            FOREACH_ZLIST (l, mh) {
+                if (mh->running && flux_msg_cmp (msg, mh->match))
+                    call_handler (mh, msg);
+            }
+            d->event_bucket = NULL;
+            if (zlist_size (l) == 0)
+                zhashx_delete (d->handlers_event, topic);
+        }
+    }
     /* other */
     if (!match) {
         FOREACH_ZLIST (d->handlers, mh) {
@@ -493,6 +597,9 @@ void flux_msg_handler_destroy (flux_msg_handler_t *mh)
                             && !isa_multmatch (mh->match.topic_glob)) {
             zhashx_delete (mh->d->handlers_method, mh->match.topic_glob);
         }
+        else if (isa_event_topic (mh->match)) {
+            event_bucket_remove (mh->d, mh);
+        }
         else {
             zlist_remove (mh->d->handlers_new, mh);
             zlist_remove (mh->d->handlers, mh);
@@ -532,7 +639,11 @@ flux_msg_handler_t *flux_msg_handler_create (flux_t *h,
      */
     if (mh->match.typemask == FLUX_MSGTYPE_RESPONSE
                             && mh->match.matchtag != FLUX_MATCHTAG_NONE) {
-        if (zhashx_insert (d->handlers_rpc, &mh->match.matchtag, mh) < 0) {
+        if ((mh->match.matchtag < d->rpcv_size
+                            && d->rpcv[mh->match.matchtag].fn)
+                || zhashx_insert (d->handlers_rpc,
+                                  &mh->match.matchtag,
+                                  mh) < 0) {
             errno = EEXIST;
             goto error;
         }
@@ -545,7 +656,15 @@ flux_msg_handler_t *flux_msg_handler_create (flux_t *h,
                             && !isa_multmatch (mh->match.topic_glob)) {
         zhashx_update (d->handlers_method, mh->match.topic_glob, mh);
     }
-    /* Request (glob), response (FLUX_MATCHTAG_NONE), events:
+    /* Event (non-glob):
+     * Message handler is pushed to the front of the handlers_event list
+     * for its topic.  Events are broadcast to all matching handlers.
+     */
+    else if (isa_event_topic (mh->match)) {
+        if (event_bucket_push (d, mh) < 0)
+            goto error;
+    }
+    /* Request (glob), response (FLUX_MATCHTAG_NONE), events (glob):
      * Message handler is pushed to the front of the handlers list,
      * and matches before older ones for requests and responses.
      * (Requests and responses in hashes above match first though).
@@ -626,6 +745,69 @@ void flux_msg_handler_delvec (flux_msg_handler_t *handlers[])
     }
 }
 
+/* Grow d->rpcv to include 'matchtag'.
+ */
+static int rpcv_grow (struct dispatch *d, uint32_t matchtag)
+{
+    uint32_t size = d->rpcv_size > 0 ? d->rpcv_size : 1024;
+    struct dispatch_rpc *v;
+
+    while (size <= matchtag)
+        size *= 2;
+    if (!(v = realloc (d->rpcv, size * sizeof (v[0])))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    memset (&v[d->rpcv_size], 0, (size - d->rpcv_size) * sizeof (v[0]));
+    d->rpcv = v;
+    d->rpcv_size = size;
+    return 0;
+}
+
+int dispatch_rpc_register (flux_t *h,
+                           uint32_t matchtag,
+                           dispatch_rpc_f fn,
+                           void *arg)
+{
+    struct dispatch *d;
+
+    if (!h || !fn || matchtag == FLUX_MATCHTAG_NONE) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(d = dispatch_get (h)))
+        return -1;
+    if (matchtag >= d->rpcv_size && rpcv_grow (d, matchtag) < 0)
+        return -1;
+    if (d->rpcv[matchtag].fn || zhashx_lookup (d->handlers_rpc, &matchtag)) {
+        errno = EEXIST;
+        return -1;
+    }
+    d->rpcv[matchtag].fn = fn;
+    d->rpcv[matchtag].arg = arg;
+    dispatch_usecount_incr (d);
+    if (d->running_count++ == 0)
+        flux_watcher_start (d->w);
+    return 0;
+}
+
+void dispatch_rpc_unregister (flux_t *h, uint32_t matchtag)
+{
+    struct dispatch *d;
+
+    if (h && (d = flux_aux_get (h, "flux::dispatch"))
+          && matchtag < d->rpcv_size
+          && d->rpcv[matchtag].fn) {
+        int saved_errno = errno;
+        d->rpcv[matchtag].fn = NULL;
+        d->rpcv[matchtag].arg = NULL;
+        if (--d->running_count == 0)
+            flux_watcher_stop (d->w);
+        dispatch_usecount_decr (d);
+        errno = saved_errno;
+    }
+}
+
 int flux_dispatch_requeue (flux_t *h)
 {
     struct dispatch *d;
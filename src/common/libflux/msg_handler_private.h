@@ -0,0 +1,36 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef FLUX_MSG_HANDLER_PRIVATE_H
+#define FLUX_MSG_HANDLER_PRIVATE_H
+
+#include "handle.h"
+#include "message.h"
+
+typedef void (*dispatch_rpc_f) (const flux_msg_t *msg, void *arg);
+
+/* Call [fn] for responses to [matchtag] received on [h], without
+ * creating a message handler.  Responses are looked up in a table
+ * indexed by matchtag, so that RPCs (see rpc.c) need no allocation
+ * per request once the table has grown to the number in flight.
+ * It is an error (EEXIST) to register a matchtag twice.
+ */
+int dispatch_rpc_register (flux_t *h,
+                           uint32_t matchtag,
+                           dispatch_rpc_f fn,
+                           void *arg);
+
+void dispatch_rpc_unregister (flux_t *h, uint32_t matchtag);
+
+#endif /* !FLUX_MSG_HANDLER_PRIVATE_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
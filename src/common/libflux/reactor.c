@@ -24,6 +24,7 @@
 #include "ev_buffer_write.h"
 #include "buffer.h"
 #include "buffer_private.h"
+#include "reactor_private.h"
 
 #include "src/common/libev/ev.h"
 #include "src/common/libutil/ev_zmq.h"
@@ -34,8 +35,14 @@ struct flux_reactor {
     struct ev_loop *loop;
     int usecount;
     unsigned int errflag:1;
+    struct reactor_ready ready;  // ready queue head
+    ev_check ready_check;
+    ev_idle ready_idle;
 };
 
+static void ready_check_cb (struct ev_loop *loop, ev_check *cw, int revents);
+static void ready_idle_cb (struct ev_loop *loop, ev_idle *iw, int revents);
+
 struct flux_watcher {
     flux_reactor_t *r;
     flux_watcher_f fn;
@@ -84,6 +91,10 @@ flux_reactor_t *flux_reactor_create (int flags)
         return NULL;
     }
     ev_set_userdata (r->loop, r);
+    r->ready.next = r->ready.prev = &r->ready;
+    ev_check_init (&r->ready_check, ready_check_cb);
+    r->ready_check.data = r;
+    ev_idle_init (&r->ready_idle, ready_idle_cb);
     r->usecount = 1;
     return r;
 }
@@ -166,6 +177,109 @@ void flux_reactor_active_decref (flux_reactor_t *r)
         ev_unref (r->loop);
 }
 
+flux_reactor_t *reactor_incref (flux_reactor_t *r)
+{
+    if (r)
+        reactor_usecount_incr (r);
+    return r;
+}
+
+/* Ready queue
+ */
+
+static bool ready_list_empty (struct reactor_ready *head)
+{
+    return head->next == head;
+}
+
+static void ready_list_remove (struct reactor_ready *e)
+{
+    e->prev->next = e->next;
+    e->next->prev = e->prev;
+    e->next = e->prev = NULL;
+}
+
+static void ready_list_append (struct reactor_ready *head,
+                               struct reactor_ready *e)
+{
+    e->prev = head->prev;
+    e->next = head;
+    head->prev->next = e;
+    head->prev = e;
+}
+
+/* Start the shared watchers when there are posted entries, and stop them
+ * when there are none.  The idle watcher keeps the reactor from blocking.
+ */
+static void ready_update (flux_reactor_t *r)
+{
+    if (ready_list_empty (&r->ready)) {
+        ev_check_stop (r->loop, &r->ready_check);
+        ev_idle_stop (r->loop, &r->ready_idle);
+    }
+    else {
+        ev_check_start (r->loop, &r->ready_check);
+        ev_idle_start (r->loop, &r->ready_idle);
+    }
+}
+
+static void ready_idle_cb (struct ev_loop *loop, ev_idle *iw, int revents)
+{
+}
+
+static void ready_check_cb (struct ev_loop *loop, ev_check *cw, int revents)
+{
+    flux_reactor_t *r = cw->data;
+    struct reactor_ready batch;
+
+    if (ready_list_empty (&r->ready))
+        return;
+
+    /* Run only the entries posted before this iteration.  Move them to
+     * a local list so that callbacks may post (to r->ready) or cancel
+     * (unlinking from the local list) any entry.
+     */
+    reactor_usecount_incr (r); // in case a callback drops the last ref
+    batch.next = r->ready.next;
+    batch.prev = r->ready.prev;
+    batch.next->prev = &batch;
+    batch.prev->next = &batch;
+    r->ready.next = r->ready.prev = &r->ready;
+
+    while (!ready_list_empty (&batch)) {
+        struct reactor_ready *e = batch.next;
+        ready_list_remove (e);
+        e->fn (e->arg); // N.B. callback might free 'e'
+    }
+    ready_update (r);
+    reactor_usecount_decr (r);
+}
+
+void reactor_ready_init (struct reactor_ready *e,
+                         reactor_ready_f fn,
+                         void *arg)
+{
+    e->next = e->prev = NULL;
+    e->fn = fn;
+    e->arg = arg;
+}
+
+void reactor_ready_post (flux_reactor_t *r, struct reactor_ready *e)
+{
+    if (r && e && !e->next) {
+        ready_list_append (&r->ready, e);
+        ready_update (r);
+    }
+}
+
+void reactor_ready_cancel (flux_reactor_t *r, struct reactor_ready *e)
+{
+    if (r && e && e->next) {
+        ready_list_remove (e);
+        ready_update (r);
+    }
+}
+
 static int events_to_libev (int events)
 {
     int e = 0;
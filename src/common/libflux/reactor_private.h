@@ -0,0 +1,56 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef FLUX_REACTOR_PRIVATE_H
+#define FLUX_REACTOR_PRIVATE_H
+
+#include "reactor.h"
+
+/* The reactor ready queue calls [fn] for each posted entry once, from a
+ * single check watcher shared by all entries, after the reactor has
+ * handled pending events.  While any entry is posted the reactor does
+ * not block.  Entries posted from a callback run on the next loop
+ * iteration.  It is used to run future continuations without creating
+ * watchers for each future.
+ *
+ * Entries are embedded in the caller's object.  A posted entry holds
+ * no reference on the reactor, so the caller must keep the reactor
+ * alive (see reactor_incref()) until the entry has been cancelled.
+ */
+typedef void (*reactor_ready_f) (void *arg);
+
+struct reactor_ready {
+    struct reactor_ready *next;
+    struct reactor_ready *prev;
+    reactor_ready_f fn;
+    void *arg;
+};
+
+void reactor_ready_init (struct reactor_ready *e,
+                         reactor_ready_f fn,
+                         void *arg);
+
+/* Post [e] to the ready queue of [r], if not already posted.
+ */
+void reactor_ready_post (flux_reactor_t *r, struct reactor_ready *e);
+
+/* Remove [e] from the ready queue of [r], if posted.
+ */
+void reactor_ready_cancel (flux_reactor_t *r, struct reactor_ready *e);
+
+/* Take a reference on [r].  Drop it with flux_reactor_destroy().
+ */
+flux_reactor_t *reactor_incref (flux_reactor_t *r);
+
+#endif /* !FLUX_REACTOR_PRIVATE_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -30,15 +30,34 @@
 #include "rpc.h"
 #include "reactor.h"
 #include "msg_handler.h"
+#include "msg_handler_private.h"
+#include "future_private.h"
 #include "flog.h"
 
+/* Completed RPCs are kept for reuse in a per-handle pool, up to this many.
+ */
+#define RPC_POOL_MAX 1024
+
+struct rpc_pool {
+    struct flux_rpc *free;
+    int count;
+};
+
+/* An RPC owns its future for the life of both.  When the future is
+ * destroyed, the pair is returned to the pool (see future_set_hooks()).
+ */
 struct flux_rpc {
     uint32_t matchtag;
     int flags;
     flux_future_t *f;
     bool sent;
+    bool registered;        // response callback registered with dispatch
+    struct rpc_pool *pool;
+    struct flux_rpc *next;  // pool free list
 };
 
+static void initialize_cb (flux_future_t *f, void *arg);
+
 static void log_matchtag_leak (flux_t *h, const char *msg, int matchtag)
 {
     if ((flux_flags_get (h) & FLUX_O_MATCHDEBUG))
@@ -77,42 +96,119 @@ out:
     return 0;
 }
 
-static void rpc_destroy (struct flux_rpc *rpc)
+/* Future finalize hook: the last reference to the future was dropped.
+ */
+static void rpc_finalize_hook (flux_future_t *f, void *arg)
 {
-    if (rpc) {
-        if (rpc_finalize (rpc) < 0)
-            log_matchtag_leak (flux_future_get_flux (rpc->f),
-                               (rpc->flags & FLUX_RPC_STREAMING)
-                                    ? "unterminated streaming RPC"
-                                    : "unfulfilled RPC",
-                               rpc->matchtag);
-        free (rpc);
+    struct flux_rpc *rpc = arg;
+    flux_t *h = flux_future_get_flux (f);
+
+    if (rpc->registered) {
+        dispatch_rpc_unregister (h, rpc->matchtag);
+        rpc->registered = false;
     }
+    if (rpc_finalize (rpc) < 0)
+        log_matchtag_leak (h,
+                           (rpc->flags & FLUX_RPC_STREAMING)
+                                ? "unterminated streaming RPC"
+                                : "unfulfilled RPC",
+                           rpc->matchtag);
 }
 
-static struct flux_rpc *rpc_create (flux_t *h, flux_future_t *f, int flags)
+static void rpc_free (struct flux_rpc *rpc)
 {
-    struct flux_rpc *rpc;
+    future_free (rpc->f);
+    free (rpc);
+}
 
-    if (!(rpc = calloc (1, sizeof (*rpc)))) {
-        errno = ENOMEM;
-        goto error;
+/* Future recycle hook: the future's state has been released.
+ */
+static void rpc_recycle_hook (flux_future_t *f, void *arg)
+{
+    struct flux_rpc *rpc = arg;
+    struct rpc_pool *pool = rpc->pool;
+
+    if (pool && pool->count < RPC_POOL_MAX) {
+        rpc->next = pool->free;
+        pool->free = rpc;
+        pool->count++;
     }
-    rpc->f = f;
-    rpc->flags = flags;
-    if ((flags & FLUX_RPC_NORESPONSE)) {
-        rpc->matchtag = FLUX_MATCHTAG_NONE;
+    else
+        rpc_free (rpc);
+}
+
+static void rpc_pool_destroy (struct rpc_pool *pool)
+{
+    if (pool) {
+        int saved_errno = errno;
+        struct flux_rpc *rpc;
+        while ((rpc = pool->free)) {
+            pool->free = rpc->next;
+            rpc_free (rpc);
+        }
+        free (pool);
+        errno = saved_errno;
+    }
+}
+
+static struct rpc_pool *rpc_pool_get (flux_t *h)
+{
+    struct rpc_pool *pool = flux_aux_get (h, "flux::rpc_pool");
+
+    if (!pool) {
+        if (!(pool = calloc (1, sizeof (*pool)))) {
+            errno = ENOMEM;
+            return NULL;
+        }
+        if (flux_aux_set (h, "flux::rpc_pool", pool,
+                          (flux_free_f)rpc_pool_destroy) < 0) {
+            rpc_pool_destroy (pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+/* Get an RPC and its future, from the pool if possible.
+ */
+static struct flux_rpc *rpc_create (flux_t *h, int flags)
+{
+    struct rpc_pool *pool;
+    struct flux_rpc *rpc;
+
+    if (!(pool = rpc_pool_get (h)))
+        return NULL;
+    if ((rpc = pool->free)) {
+        pool->free = rpc->next;
+        pool->count--;
+        future_reuse (rpc->f, initialize_cb, rpc);
     }
     else {
+        if (!(rpc = calloc (1, sizeof (*rpc)))) {
+            errno = ENOMEM;
+            return NULL;
+        }
+        if (!(rpc->f = flux_future_create (initialize_cb, rpc))) {
+            free (rpc);
+            return NULL;
+        }
+        future_set_hooks (rpc->f, rpc_finalize_hook, rpc_recycle_hook, rpc);
+    }
+    rpc->pool = pool;
+    rpc->next = NULL;
+    rpc->flags = flags;
+    rpc->sent = false;
+    rpc->registered = false;
+    rpc->matchtag = FLUX_MATCHTAG_NONE;
+    flux_future_set_flux (rpc->f, h);
+    if (!(flags & FLUX_RPC_NORESPONSE)) {
         rpc->matchtag = flux_matchtag_alloc (h);
-        if (rpc->matchtag == FLUX_MATCHTAG_NONE)
-            goto error;
+        if (rpc->matchtag == FLUX_MATCHTAG_NONE) {
+            flux_future_destroy (rpc->f);
+            return NULL;
+        }
     }
-    flux_future_set_flux (f, h);
     return rpc;
-error:
-    free (rpc);
-    return NULL;
 }
 
 int flux_rpc_get (flux_future_t *f, const char **s)
@@ -169,13 +265,12 @@ int flux_rpc_get_unpack (flux_future_t *f, const char *fmt, ...)
     return rc;
 }
 
-/* Message handler for response.
+/* Dispatch callback for response.
  * Parse the response message here so one could call flux_future_get()
  * instead of flux_rpc_get() to test result of RPC with no response payload.
  * Fulfill future.
 */
-static void response_cb (flux_t *h, flux_msg_handler_t *mh,
-                         const flux_msg_t *msg, void *arg)
+static void response_fulfill (const flux_msg_t *msg, void *arg)
 {
     flux_future_t *f = arg;
     flux_msg_t *cpy;
@@ -205,16 +300,34 @@ error:
         flux_future_fulfill_error (f, saved_errno, NULL);
 }
 
+/* Message handler for response.
+ */
+static void response_cb (flux_t *h, flux_msg_handler_t *mh,
+                         const flux_msg_t *msg, void *arg)
+{
+    response_fulfill (msg, arg);
+}
+
 /* Callback to initialize future in main or alternate reactor contexts.
- * Install a message handler for the response.
+ * In the main context, register for the response with the dispatcher.
+ * In the alternate context used by flux_future_get(), the handle is a
+ * short-lived clone, so install a message handler for the response
+ * that is destroyed with the future.
  */
 static void initialize_cb (flux_future_t *f, void *arg)
 {
-    struct flux_rpc *rpc = flux_future_aux_get (f, "flux::rpc");
+    struct flux_rpc *rpc = arg;
     flux_t *h = flux_future_get_flux (f);
     flux_msg_handler_t *mh;
     struct flux_match m = FLUX_MATCH_RESPONSE;
 
+    if (!(flux_flags_get (h) & FLUX_O_CLONE)
+        && rpc->matchtag != FLUX_MATCHTAG_NONE) {
+        if (dispatch_rpc_register (h, rpc->matchtag, response_fulfill, f) < 0)
+            goto error;
+        rpc->registered = true;
+        return;
+    }
     m.matchtag = rpc->matchtag;
     if (!(mh = flux_msg_handler_create (h, m, response_cb, f)))
         goto error;
@@ -235,19 +348,13 @@ static flux_future_t *flux_rpc_message_nocopy (flux_t *h,
                                                uint32_t nodeid,
                                                int flags)
 {
-    struct flux_rpc *rpc = NULL;
+    struct flux_rpc *rpc;
     flux_future_t *f;
     uint8_t msgflags;
 
-    if (!(f = flux_future_create (initialize_cb, NULL)))
-        goto error;
-    if (!(rpc = rpc_create (h, f, flags)))
-        goto error;
-    if (flux_future_aux_set (f, "flux::rpc", rpc,
-                             (flux_free_f)rpc_destroy) < 0) {
-        rpc_destroy (rpc);
-        goto error;
-    }
+    if (!(rpc = rpc_create (h, flags)))
+        return NULL;
+    f = rpc->f;
     if (flux_msg_set_matchtag (msg, rpc->matchtag) < 0)
         goto error;
     if (flux_msg_get_flags (msg, &msgflags) < 0)
@@ -408,7 +515,7 @@ flux_future_t *flux_rpc_pack (flux_t *h, const char *topic, uint32_t nodeid,
 
 uint32_t flux_rpc_get_matchtag (flux_future_t *f)
 {
-    struct flux_rpc *rpc = flux_future_aux_get (f, "flux::rpc");
+    struct flux_rpc *rpc = future_get_hook_arg (f, rpc_finalize_hook);
     return rpc ? rpc->matchtag : FLUX_MATCHTAG_NONE;
 }
 
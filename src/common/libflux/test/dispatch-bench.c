@@ -0,0 +1,126 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* dispatch-bench - time event dispatch as the number of registered
+ *  message handlers grows.
+ *
+ * Usage: dispatch-bench [MAX_HANDLERS] [MESSAGES]
+ *
+ * For each handler count from 10 up to MAX_HANDLERS (x10), that many
+ *  event handlers are registered on distinct topics, plus one glob
+ *  handler.  MESSAGES events are queued on a loopback handle for one of
+ *  the topics and the reactor is run until all have been dispatched.
+ *  Messages per second are reported.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libtestutil/util.h"
+
+static int count;
+static int messages;
+
+static void event_cb (flux_t *h, flux_msg_handler_t *mh,
+                      const flux_msg_t *msg, void *arg)
+{
+    if (++count == messages)
+        flux_reactor_stop (flux_get_reactor (h));
+}
+
+static void glob_cb (flux_t *h, flux_msg_handler_t *mh,
+                     const flux_msg_t *msg, void *arg)
+{
+}
+
+static double bench_handlers (flux_t *h, int nhandlers)
+{
+    struct flux_match match = FLUX_MATCH_EVENT;
+    flux_msg_handler_t **handlers;
+    flux_msg_handler_t *glob;
+    char topic[64];
+    flux_msg_t *msg;
+    struct timespec t0;
+    double elapsed;
+
+    if (!(handlers = calloc (nhandlers, sizeof (handlers[0]))))
+        log_err_exit ("calloc");
+    for (int i = 0; i < nhandlers; i++) {
+        snprintf (topic, sizeof (topic), "bench.%d", i);
+        match.topic_glob = topic;
+        if (!(handlers[i] = flux_msg_handler_create (h, match, event_cb, NULL)))
+            log_err_exit ("flux_msg_handler_create");
+        flux_msg_handler_start (handlers[i]);
+    }
+    match.topic_glob = "bench.*";
+    if (!(glob = flux_msg_handler_create (h, match, glob_cb, NULL)))
+        log_err_exit ("flux_msg_handler_create");
+    flux_msg_handler_start (glob);
+
+    /*  Send to the first registered topic, which is last in registration
+     *   order and so would be found last by a linear scan.
+     */
+    if (!(msg = flux_event_encode ("bench.0", NULL)))
+        log_err_exit ("flux_event_encode");
+    for (int i = 0; i < messages; i++) {
+        if (flux_send (h, msg, 0) < 0)
+            log_err_exit ("flux_send");
+    }
+    flux_msg_destroy (msg);
+
+    count = 0;
+    monotime (&t0);
+    if (flux_reactor_run (flux_get_reactor (h), 0) < 0)
+        log_err_exit ("flux_reactor_run");
+    elapsed = monotime_since (t0);
+    if (count != messages)
+        log_msg_exit ("dispatched %d of %d messages", count, messages);
+
+    flux_msg_handler_destroy (glob);
+    for (int i = 0; i < nhandlers; i++)
+        flux_msg_handler_destroy (handlers[i]);
+    free (handlers);
+
+    return (messages * 1000.) / elapsed;
+}
+
+int main (int argc, char *argv[])
+{
+    int max_handlers = argc > 1 ? strtol (argv[1], NULL, 10) : 10000;
+    flux_t *h;
+
+    messages = argc > 2 ? strtol (argv[2], NULL, 10) : 100000;
+
+    log_init ("dispatch-bench");
+
+    if (max_handlers <= 0 || messages <= 0)
+        log_msg_exit ("Usage: dispatch-bench [MAX_HANDLERS] [MESSAGES]");
+    if (!(h = loopback_create (0)))
+        log_err_exit ("loopback_create");
+
+    printf ("%8s %12s\n", "HANDLERS", "MSGS/S");
+    for (int n = 10; n <= max_handlers; n *= 10) {
+        printf ("%8d %12.0f\n", n, bench_handlers (h, n));
+        fflush (stdout);
+    }
+
+    flux_close (h);
+    log_fini ();
+    return 0;
+}
+
+/* vi: ts=4 sw=4 expandtab
+ */
@@ -462,6 +462,87 @@ void test_cloned_dispatch (flux_t *orig)
     diag ("destroyed reactor, closed clone");
 }
 
+/* Verify that an event is delivered to all matching handlers, whether
+ * registered for the exact topic (hashed) or a glob (listed), and that
+ * a handler may destroy itself from its own callback.
+ */
+int cb_destroy_called;
+void cb_destroy (flux_t *h, flux_msg_handler_t *mh, const flux_msg_t *msg,
+                 void *arg)
+{
+    flux_msg_handler_t **mhp = arg;
+    cb_destroy_called++;
+    flux_msg_handler_destroy (*mhp);
+    *mhp = NULL;
+}
+
+void test_event_topic (flux_t *h)
+{
+    struct flux_match match = FLUX_MATCH_EVENT;
+    flux_msg_handler_t *mh, *mh2, *mh3, *mh4;
+    flux_msg_t *msg;
+    int rc;
+
+    match.topic_glob = "foo.bar";
+    mh = flux_msg_handler_create (h, match, cb, NULL);
+    mh2 = flux_msg_handler_create (h, match, cb, NULL);
+    match.topic_glob = "foo.*";
+    mh3 = flux_msg_handler_create (h, match, cb2, NULL);
+    match.topic_glob = "foo.baz";
+    mh4 = flux_msg_handler_create (h, match, cb2, NULL);
+    ok (mh != NULL && mh2 != NULL && mh3 != NULL && mh4 != NULL,
+        "created two foo.bar, one foo.*, and one foo.baz event handler");
+    flux_msg_handler_start (mh);
+    flux_msg_handler_start (mh2);
+    flux_msg_handler_start (mh3);
+    flux_msg_handler_start (mh4);
+
+    ok ((msg = flux_event_encode ("foo.bar", NULL)) != NULL
+        && flux_send (h, msg, 0) == 0,
+        "sent foo.bar event");
+    cb_called = 0;
+    cb2_called = 0;
+    rc = flux_reactor_run (flux_get_reactor (h), FLUX_REACTOR_NOWAIT);
+    ok (rc >= 0,
+        "flux_reactor_run NOWAIT ran");
+    ok (cb_called == 2 && cb2_called == 1,
+        "both foo.bar handlers and the foo.* handler were called");
+    flux_msg_destroy (msg);
+
+    flux_msg_handler_stop (mh2);
+    ok ((msg = flux_event_encode ("foo.bar", NULL)) != NULL
+        && flux_send (h, msg, 0) == 0,
+        "sent foo.bar event");
+    cb_called = 0;
+    cb2_called = 0;
+    rc = flux_reactor_run (flux_get_reactor (h), FLUX_REACTOR_NOWAIT);
+    ok (rc >= 0,
+        "flux_reactor_run NOWAIT ran");
+    ok (cb_called == 1 && cb2_called == 1,
+        "stopped foo.bar handler was not called");
+    flux_msg_destroy (msg);
+
+    flux_msg_handler_destroy (mh);
+    flux_msg_handler_destroy (mh2);
+    flux_msg_handler_destroy (mh3);
+    flux_msg_handler_destroy (mh4);
+
+    match.topic_glob = "foo.bar";
+    mh = flux_msg_handler_create (h, match, cb_destroy, &mh);
+    ok (mh != NULL,
+        "created foo.bar event handler that destroys itself");
+    flux_msg_handler_start (mh);
+    ok ((msg = flux_event_encode ("foo.bar", NULL)) != NULL
+        && flux_send (h, msg, 0) == 0
+        && flux_send (h, msg, 0) == 0,
+        "sent foo.bar event twice");
+    cb_destroy_called = 0;
+    rc = flux_reactor_run (flux_get_reactor (h), FLUX_REACTOR_NOWAIT);
+    ok (rc >= 0 && cb_destroy_called == 1 && mh == NULL,
+        "handler was called once and destroyed itself");
+    flux_msg_destroy (msg);
+}
+
 int main (int argc, char *argv[])
 {
     flux_t *h;
@@ -481,6 +562,7 @@ int main (int argc, char *argv[])
     test_request_catchall (h);
     test_response_catchall (h);
     test_response_with_routes (h);
+    test_event_topic (h);
 
     flux_close (h);
     done_testing();
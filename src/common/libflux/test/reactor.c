@@ -15,6 +15,7 @@
 #include <stdlib.h>
 
 #include "src/common/libflux/reactor.h"
+#include "src/common/libflux/reactor_private.h"
 #include "src/common/libutil/xzmalloc.h"
 #include "src/common/libutil/fdutils.h"
 #include "src/common/libtap/tap.h"
@@ -1428,6 +1429,58 @@ static void test_active_ref (flux_reactor_t *r)
     flux_watcher_destroy (w);
 }
 
+struct ready_test {
+    flux_reactor_t *r;
+    struct reactor_ready e[3];
+    int count[3];
+};
+
+/* e[0] reposts itself once, e[1] cancels e[2], which never runs.
+ */
+static struct ready_test ready_test;
+
+static void ready_test_cb (void *arg)
+{
+    struct ready_test *t = &ready_test;
+    int i = (int)(intptr_t)arg;
+
+    t->count[i]++;
+    if (i == 0 && t->count[0] == 1) {
+        reactor_ready_post (t->r, &t->e[0]);
+        ok (t->count[0] == 1,
+            "entry posted from its own callback does not run until next loop");
+    }
+    if (i == 1)
+        reactor_ready_cancel (t->r, &t->e[2]);
+}
+
+static void test_ready (flux_reactor_t *r)
+{
+    struct ready_test *t = &ready_test;
+
+    memset (t, 0, sizeof (*t));
+    t->r = r;
+    for (int i = 0; i < 3; i++)
+        reactor_ready_init (&t->e[i], ready_test_cb, (void *)(intptr_t)i);
+    reactor_ready_post (r, &t->e[0]);
+    reactor_ready_post (r, &t->e[1]);
+    reactor_ready_post (r, &t->e[1]);
+    reactor_ready_post (r, &t->e[2]);
+    ok (flux_reactor_run (r, 0) == 0,
+        "reactor ran until ready queue was empty");
+    ok (t->count[0] == 2,
+        "entry that posted itself ran twice");
+    ok (t->count[1] == 1,
+        "entry posted twice ran once");
+    ok (t->count[2] == 0,
+        "entry cancelled by an earlier callback did not run");
+
+    reactor_ready_post (r, &t->e[2]);
+    reactor_ready_cancel (r, &t->e[2]);
+    ok (flux_reactor_run (r, 0) == 0 && t->count[2] == 0,
+        "cancelled entry did not run");
+}
+
 static void reactor_destroy_early (void)
 {
     flux_reactor_t *r;
@@ -1468,6 +1521,7 @@ int main (int argc, char *argv[])
     test_child (reactor);
     test_stat (reactor);
     test_active_ref (reactor);
+    test_ready (reactor);
 
     flux_reactor_destroy (reactor);
 
@@ -0,0 +1,120 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* rpc-bench - time RPC round trips as the number in flight grows.
+ *
+ * Usage: rpc-bench [MAX_WINDOW] [RPCS]
+ *
+ * A request handler that responds to "bench.ping" is registered on a
+ *  loopback handle.  For each window size from 1 up to MAX_WINDOW (x10),
+ *  that many RPCs are kept in flight, each continuation destroying its
+ *  future and sending the next RPC, until RPCS have completed.
+ *  RPCs per second are reported.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libtestutil/util.h"
+
+static int sent;
+static int count;
+static int rpcs;
+
+static void ping_cb (flux_t *h, flux_msg_handler_t *mh,
+                     const flux_msg_t *msg, void *arg)
+{
+    if (flux_respond (h, msg, NULL) < 0)
+        log_err_exit ("flux_respond");
+}
+
+static void send_ping (flux_t *h);
+
+static void ping_continuation (flux_future_t *f, void *arg)
+{
+    flux_t *h = arg;
+
+    if (flux_rpc_get (f, NULL) < 0)
+        log_err_exit ("bench.ping");
+    flux_future_destroy (f);
+    if (++count == rpcs)
+        flux_reactor_stop (flux_get_reactor (h));
+    else if (sent < rpcs)
+        send_ping (h);
+}
+
+static void send_ping (flux_t *h)
+{
+    flux_future_t *f;
+
+    if (!(f = flux_rpc (h, "bench.ping", NULL, FLUX_NODEID_ANY, 0))
+        || flux_future_then (f, -1., ping_continuation, h) < 0)
+        log_err_exit ("flux_rpc");
+    sent++;
+}
+
+static double bench_window (flux_t *h, int window)
+{
+    struct timespec t0;
+    double elapsed;
+
+    sent = count = 0;
+    monotime (&t0);
+    for (int i = 0; i < window && i < rpcs; i++)
+        send_ping (h);
+    if (flux_reactor_run (flux_get_reactor (h), 0) < 0)
+        log_err_exit ("flux_reactor_run");
+    elapsed = monotime_since (t0);
+    if (count != rpcs)
+        log_msg_exit ("completed %d of %d RPCs", count, rpcs);
+
+    return (rpcs * 1000.) / elapsed;
+}
+
+int main (int argc, char *argv[])
+{
+    int max_window = argc > 1 ? strtol (argv[1], NULL, 10) : 1000;
+    struct flux_match match = FLUX_MATCH_REQUEST;
+    flux_msg_handler_t *mh;
+    flux_t *h;
+
+    rpcs = argc > 2 ? strtol (argv[2], NULL, 10) : 100000;
+
+    log_init ("rpc-bench");
+
+    if (max_window <= 0 || rpcs <= 0)
+        log_msg_exit ("Usage: rpc-bench [MAX_WINDOW] [RPCS]");
+    if (!(h = loopback_create (0)))
+        log_err_exit ("loopback_create");
+    match.topic_glob = "bench.ping";
+    if (!(mh = flux_msg_handler_create (h, match, ping_cb, NULL)))
+        log_err_exit ("flux_msg_handler_create");
+    flux_msg_handler_start (mh);
+
+    printf ("%8s %12s\n", "WINDOW", "RPCS/S");
+    for (int n = 1; n <= max_window; n *= 10) {
+        printf ("%8d %12.0f\n", n, bench_window (h, n));
+        fflush (stdout);
+    }
+
+    flux_msg_handler_destroy (mh);
+    flux_close (h);
+    log_fini ();
+    return 0;
+}
+
+/* vi: ts=4 sw=4 expandtab
+ */
@@ -728,6 +728,70 @@ void test_multi_response_then_chain (flux_t *h)
         BAIL_OUT ("flux_reactor_run failed");
 }
 
+/* Check that futures of completed RPCs are recycled safely.
+ */
+static void recycle_then_cb (flux_future_t *f, void *arg)
+{
+    int *count = arg;
+    int n;
+
+    if (flux_rpc_get_unpack (f, "{s:i}", "n", &n) < 0)
+        BAIL_OUT ("flux_rpc_get_unpack failed: %s", flux_strerror (errno));
+    if (++(*count) == 100)
+        flux_reactor_stop (flux_future_get_reactor (f));
+    flux_future_destroy (f);
+}
+
+void test_recycle (flux_t *h)
+{
+    flux_future_t *f;
+    flux_future_t *f2;
+    uint32_t matchtag;
+    const char *s;
+    int count;
+    int i;
+
+    /* Completed RPCs are pooled, so a destroyed future is reused by the
+     * next RPC on the same handle, with its aux state cleared.
+     */
+    ok ((f = flux_rpc (h, "rpctest.hello", NULL, FLUX_NODEID_ANY, 0)) != NULL,
+        "flux_rpc works");
+    ok (flux_future_aux_set (f, "test", "foo", NULL) == 0,
+        "flux_future_aux_set works");
+    ok (flux_rpc_get (f, &s) == 0,
+        "flux_rpc_get works");
+    flux_future_destroy (f);
+
+    ok ((f2 = flux_rpc (h, "rpctest.hello", NULL, FLUX_NODEID_ANY, 0)) != NULL,
+        "flux_rpc works again");
+    ok (f2 == f,
+        "future of destroyed RPC was reused");
+    ok (flux_future_aux_get (f2, "test") == NULL,
+        "aux item of previous RPC was cleared");
+    ok ((matchtag = flux_rpc_get_matchtag (f2)) != FLUX_MATCHTAG_NONE,
+        "flux_rpc_get_matchtag works on reused future");
+    ok (flux_rpc_get (f2, &s) == 0,
+        "flux_rpc_get works on reused future");
+    flux_future_destroy (f2);
+
+    /* Many RPCs in flight at once, each destroyed in its continuation.
+     */
+    count = 0;
+    for (i = 0; i < 100; i++) {
+        if (!(f = flux_rpc_pack (h, "rpctest.incr", FLUX_NODEID_ANY, 0,
+                                 "{s:i}", "n", i)))
+            BAIL_OUT ("flux_rpc_pack failed: %s", flux_strerror (errno));
+        if (flux_future_then (f, -1., recycle_then_cb, &count) < 0)
+            BAIL_OUT ("flux_future_then failed: %s", flux_strerror (errno));
+    }
+    ok (flux_reactor_run (flux_get_reactor (h), 0) >= 0,
+        "reactor completed normally");
+    ok (count == 100,
+        "continuations ran for 100 concurrent RPCs");
+
+    diag ("completed test of RPC recycling");
+}
+
 /* Try flux_rpc_message() with various bad arguments
  */
 void test_rpc_message_inval (flux_t *h)
@@ -862,6 +926,7 @@ int main (int argc, char *argv[])
     test_multi_response_then_chain (h);
     test_rpc_message_inval (h);
     test_rpc_message (h);
+    test_recycle (h);
 
     ok (test_server_stop (h) == 0,
         "stopped test server thread");
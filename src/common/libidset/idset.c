@@ -18,6 +18,7 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "idset.h"
 #include "idset_private.h"
@@ -31,6 +32,67 @@ int validate_idset_flags (int flags, int allowed)
     return 0;
 }
 
+/* Dense bitmap helpers.  Bits at or above T.M in the last word are
+ * always zero, so word-at-a-time operations need no masking.
+ * The loops over words are written so the compiler can vectorize them.
+ */
+static inline size_t bitmap_words (size_t size)
+{
+    return (size + IDSET_WORD_BITS - 1) / IDSET_WORD_BITS;
+}
+
+static inline uint64_t bit (unsigned int id)
+{
+    return (uint64_t)1 << (id % IDSET_WORD_BITS);
+}
+
+static size_t bitmap_popcount (const uint64_t *bitmap, size_t nwords)
+{
+    size_t count = 0;
+    size_t i;
+
+    for (i = 0; i < nwords; i++)
+        count += __builtin_popcountll (bitmap[i]);
+    return count;
+}
+
+/* Mask of bits lo..hi (inclusive) within one word, 0 <= lo <= hi < 64.
+ */
+static inline uint64_t word_mask (unsigned int lo, unsigned int hi)
+{
+    uint64_t upper = hi == IDSET_WORD_BITS - 1 ? ~(uint64_t)0
+                                               : (bit (hi) << 1) - 1;
+    return upper & ~(bit (lo) - 1);
+}
+
+static bool use_bitmap (size_t size)
+{
+    return size <= IDSET_BITMAP_MAX;
+}
+
+/* Initialize idset storage for 'size' ids, choosing the representation.
+ * Returns 0 on success, -1 on failure with errno == ENOMEM.
+ */
+static int idset_alloc (struct idset *idset, size_t size)
+{
+    memset (&idset->T, 0, sizeof (idset->T));
+    idset->bitmap = NULL;
+    if (use_bitmap (size)) {
+        if (!(idset->bitmap = calloc (bitmap_words (size), sizeof (uint64_t))))
+            goto nomem;
+        idset->T.M = size;
+    }
+    else {
+        idset->T = vebnew (size, 0);
+        if (!idset->T.D)
+            goto nomem;
+    }
+    return 0;
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
 struct idset *idset_create (size_t size, int flags)
 {
     struct idset *idset;
@@ -41,10 +103,8 @@ struct idset *idset_create (size_t size, int flags)
         size = IDSET_DEFAULT_SIZE;
     if (!(idset = malloc (sizeof (*idset))))
         return NULL;
-    idset->T = vebnew (size, 0);
-    if (!idset->T.D) {
+    if (idset_alloc (idset, size) < 0) {
         free (idset);
-        errno = ENOMEM;
         return NULL;
     }
     idset->flags = flags;
@@ -56,6 +116,7 @@ void idset_destroy (struct idset *idset)
 {
     if (idset) {
         int saved_errno = errno;
+        free (idset->bitmap);
         free (idset->T.D);
         free (idset);
         errno = saved_errno;
@@ -82,13 +143,24 @@ struct idset *idset_copy (const struct idset *idset)
         errno = EINVAL;
         return NULL;
     }
-    if (!(cpy = malloc (sizeof (*idset))))
+    if (!(cpy = calloc (1, sizeof (*idset))))
         return NULL;
     cpy->flags = idset->flags;
-    cpy->T = vebdup (idset->T);
-    if (!cpy->T.D) {
-        idset_destroy (cpy);
-        return NULL;
+    if (idset->bitmap) {
+        size_t len = bitmap_words (idset->T.M) * sizeof (uint64_t);
+        if (!(cpy->bitmap = malloc (len))) {
+            idset_destroy (cpy);
+            return NULL;
+        }
+        memcpy (cpy->bitmap, idset->bitmap, len);
+        cpy->T.M = idset->T.M;
+    }
+    else {
+        cpy->T = vebdup (idset->T);
+        if (!cpy->T.D) {
+            idset_destroy (cpy);
+            return NULL;
+        }
     }
     cpy->count = idset->count;
     return cpy;
@@ -101,7 +173,58 @@ static bool valid_id (unsigned int id)
     return true;
 }
 
+/* Return the smallest id >= 'id' in idset, or T.M if there is none.
+ */
+unsigned int idset_succ (const struct idset *idset, unsigned int id)
+{
+    size_t nwords;
+    size_t w;
+    uint64_t word;
+
+    if (!idset->bitmap)
+        return vebsucc (idset->T, id);
+    if (id >= idset->T.M)
+        return idset->T.M;
+    nwords = bitmap_words (idset->T.M);
+    w = id / IDSET_WORD_BITS;
+    word = idset->bitmap[w] & ~(bit (id) - 1);
+    for (;;) {
+        if (word)
+            return w * IDSET_WORD_BITS + __builtin_ctzll (word);
+        if (++w == nwords)
+            return idset->T.M;
+        word = idset->bitmap[w];
+    }
+}
+
+/* Return the largest id <= 'id' in idset, or T.M if there is none.
+ */
+static unsigned int idset_pred (const struct idset *idset, unsigned int id)
+{
+    size_t w;
+    uint64_t word;
+
+    if (!idset->bitmap)
+        return vebpred (idset->T, id);
+    if (idset->T.M == 0)
+        return idset->T.M;
+    if (id >= idset->T.M)
+        id = idset->T.M - 1;
+    w = id / IDSET_WORD_BITS;
+    word = idset->bitmap[w] & word_mask (0, id % IDSET_WORD_BITS);
+    for (;;) {
+        if (word)
+            return w * IDSET_WORD_BITS + (IDSET_WORD_BITS - 1)
+                   - __builtin_clzll (word);
+        if (w-- == 0)
+            return idset->T.M;
+        word = idset->bitmap[w];
+    }
+}
+
 /* Double idset size until it has at least 'size' slots.
+ * The bitmap is converted to a veb tree once it would exceed
+ * IDSET_BITMAP_MAX.
  * Return 0 on success, -1 on failure with errno == ENOMEM.
  */
 static int idset_grow (struct idset *idset, size_t size)
@@ -118,15 +241,31 @@ static int idset_grow (struct idset *idset, size_t size)
             errno = EINVAL;
             return -1;
         }
+        if (idset->bitmap && use_bitmap (newsize)) {
+            size_t oldwords = bitmap_words (idset->T.M);
+            size_t newwords = bitmap_words (newsize);
+            uint64_t *bitmap;
+
+            if (!(bitmap = realloc (idset->bitmap,
+                                    newwords * sizeof (uint64_t))))
+                return -1;
+            memset (bitmap + oldwords, 0,
+                    (newwords - oldwords) * sizeof (uint64_t));
+            idset->bitmap = bitmap;
+            idset->T.M = newsize;
+            return 0;
+        }
         T = vebnew (newsize, 0);
         if (!T.D)
             return -1;
 
-        id = vebsucc (idset->T, 0);
+        id = idset_succ (idset, 0);
         while (id < idset->T.M) {
             vebput (T, id);
-            id = vebsucc (idset->T, id + 1);
+            id = idset_succ (idset, id + 1);
         }
+        free (idset->bitmap);
+        idset->bitmap = NULL;
         free (idset->T.D);
         idset->T = T;
     }
@@ -137,6 +276,14 @@ static int idset_grow (struct idset *idset, size_t size)
  */
 static void idset_put (struct idset *idset, unsigned int id)
 {
+    if (idset->bitmap) {
+        uint64_t *word = &idset->bitmap[id / IDSET_WORD_BITS];
+        if (!(*word & bit (id))) {
+            *word |= bit (id);
+            idset->count++;
+        }
+        return;
+    }
     if (!idset_test (idset, id))
         idset->count++;
     vebput (idset->T, id);
@@ -146,11 +293,46 @@ static void idset_put (struct idset *idset, unsigned int id)
  */
 static void idset_del (struct idset *idset, unsigned int id)
 {
+    if (idset->bitmap) {
+        uint64_t *word;
+        if (id >= idset->T.M)
+            return;
+        word = &idset->bitmap[id / IDSET_WORD_BITS];
+        if (*word & bit (id)) {
+            *word &= ~bit (id);
+            idset->count--;
+        }
+        return;
+    }
     if (idset_test (idset, id))
         idset->count--;
     vebdel (idset->T, id);
 }
 
+/* Set or clear ids lo..hi (lo <= hi < T.M) in a bitmap a word at a time.
+ */
+static void bitmap_range_update (struct idset *idset,
+                                 unsigned int lo,
+                                 unsigned int hi,
+                                 bool set)
+{
+    size_t w = lo / IDSET_WORD_BITS;
+    size_t last = hi / IDSET_WORD_BITS;
+
+    for (; w <= last; w++) {
+        unsigned int first = w == lo / IDSET_WORD_BITS
+                             ? lo % IDSET_WORD_BITS : 0;
+        unsigned int end = w == last
+                           ? hi % IDSET_WORD_BITS : IDSET_WORD_BITS - 1;
+        uint64_t mask = word_mask (first, end);
+        uint64_t old = idset->bitmap[w];
+
+        idset->bitmap[w] = set ? old | mask : old & ~mask;
+        idset->count += __builtin_popcountll (idset->bitmap[w]);
+        idset->count -= __builtin_popcountll (old);
+    }
+}
+
 int idset_set (struct idset *idset, unsigned int id)
 {
     if (!idset || !valid_id (id)) {
@@ -183,6 +365,10 @@ int idset_range_set (struct idset *idset, unsigned int lo, unsigned int hi)
     normalize_range (&lo, &hi);
     if (idset_grow (idset, hi + 1) < 0)
         return -1;
+    if (idset->bitmap) {
+        bitmap_range_update (idset, lo, hi, true);
+        return 0;
+    }
     for (id = lo; id <= hi; id++)
         idset_put (idset, id);
     return 0;
@@ -207,6 +393,11 @@ int idset_range_clear (struct idset *idset, unsigned int lo, unsigned int hi)
         return -1;
     }
     normalize_range (&lo, &hi);
+    if (idset->bitmap) {
+        if (lo < idset->T.M)
+            bitmap_range_update (idset, lo, MIN (hi, idset->T.M - 1), false);
+        return 0;
+    }
     for (id = lo; id <= hi && id < idset->T.M; id++)
         idset_del (idset, id);
     return 0;
@@ -216,6 +407,8 @@ bool idset_test (const struct idset *idset, unsigned int id)
 {
     if (!idset || !valid_id (id) || id >= idset->T.M)
         return false;
+    if (idset->bitmap)
+        return (idset->bitmap[id / IDSET_WORD_BITS] & bit (id)) != 0;
     return (vebsucc (idset->T, id) == id);
 }
 
@@ -224,7 +417,7 @@ unsigned int idset_first (const struct idset *idset)
     unsigned int next = IDSET_INVALID_ID;
 
     if (idset) {
-        next = vebsucc (idset->T, 0);
+        next = idset_succ (idset, 0);
         if (next == idset->T.M)
             next = IDSET_INVALID_ID;
     }
@@ -237,7 +430,7 @@ unsigned int idset_next (const struct idset *idset, unsigned int prev)
     unsigned int next = IDSET_INVALID_ID;
 
     if (idset) {
-        next = vebsucc (idset->T, prev + 1);
+        next = idset_succ (idset, prev + 1);
         if (next == idset->T.M)
             next = IDSET_INVALID_ID;
     }
@@ -249,7 +442,7 @@ unsigned int idset_last (const struct idset *idset)
     unsigned int last = IDSET_INVALID_ID;
 
     if (idset) {
-        last = vebpred (idset->T, idset->T.M - 1);
+        last = idset_pred (idset, idset->T.M - 1);
         if (last == idset->T.M)
             last = IDSET_INVALID_ID;
     }
@@ -263,29 +456,242 @@ size_t idset_count (const struct idset *idset)
     return idset->count;
 }
 
-bool idset_equal (const struct idset *idset1,
-                  const struct idset *idset2)
+/* Return true if every id in idset1 is also in idset2.
+ * Iterates over idset1, so pass the smaller set first where possible.
+ */
+static bool ids_subset (const struct idset *idset1,
+                        const struct idset *idset2)
 {
     unsigned int id;
 
+    id = idset_succ (idset1, 0);
+    while (id < idset1->T.M) {
+        if (!idset_test (idset2, id))
+            return false;
+        id = idset_succ (idset1, id + 1);
+    }
+    return true;
+}
+
+static bool words_zero (const uint64_t *bitmap, size_t from, size_t to)
+{
+    size_t i;
+
+    for (i = from; i < to; i++) {
+        if (bitmap[i])
+            return false;
+    }
+    return true;
+}
+
+bool idset_equal (const struct idset *idset1,
+                  const struct idset *idset2)
+{
     if (!idset1 || !idset2)
         return false;
     if (idset_count (idset1) != idset_count (idset2))
         return false;
+    if (idset1->bitmap && idset2->bitmap) {
+        size_t n1 = bitmap_words (idset1->T.M);
+        size_t n2 = bitmap_words (idset2->T.M);
+        size_t n = MIN (n1, n2);
+
+        if (memcmp (idset1->bitmap, idset2->bitmap, n * sizeof (uint64_t)))
+            return false;
+        return words_zero (idset1->bitmap, n, n1)
+            && words_zero (idset2->bitmap, n, n2);
+    }
+    /* Counts are equal, so one inclusion implies equality.
+     */
+    return ids_subset (idset1, idset2);
+}
 
-    id = vebsucc (idset1->T, 0);
-    while (id < idset1->T.M) {
-        if (vebsucc (idset2->T, id) != id)
-            return false; // id in idset1 not set in idset2
-        id = vebsucc (idset1->T, id + 1);
+bool idset_is_subset (const struct idset *a, const struct idset *b)
+{
+    if (!a || !b)
+        return false;
+    if (idset_count (a) > idset_count (b))
+        return false;
+    if (a->bitmap && b->bitmap) {
+        size_t na = bitmap_words (a->T.M);
+        size_t nb = bitmap_words (b->T.M);
+        size_t n = MIN (na, nb);
+        uint64_t diff = 0;
+        size_t i;
+
+        for (i = 0; i < n; i++)
+            diff |= a->bitmap[i] & ~b->bitmap[i];
+        return diff == 0 && words_zero (a->bitmap, n, na);
+    }
+    return ids_subset (a, b);
+}
+
+bool idset_has_intersection (const struct idset *a, const struct idset *b)
+{
+    const struct idset *small;
+    const struct idset *large;
+    unsigned int id;
+
+    if (!a || !b)
+        return false;
+    if (a->bitmap && b->bitmap) {
+        size_t n = MIN (bitmap_words (a->T.M), bitmap_words (b->T.M));
+        uint64_t common = 0;
+        size_t i;
+
+        for (i = 0; i < n; i++)
+            common |= a->bitmap[i] & b->bitmap[i];
+        return common != 0;
     }
-    id = vebsucc (idset2->T, 0);
-    while (id < idset2->T.M) {
-        if (vebsucc (idset1->T, id) != id)
-            return false; // id in idset2 not set in idset1
-        id = vebsucc (idset2->T, id + 1);
+    small = idset_count (a) < idset_count (b) ? a : b;
+    large = small == a ? b : a;
+    id = idset_succ (small, 0);
+    while (id < small->T.M) {
+        if (idset_test (large, id))
+            return true;
+        id = idset_succ (small, id + 1);
     }
-    return true;
+    return false;
+}
+
+int idset_add (struct idset *a, const struct idset *b)
+{
+    unsigned int id;
+
+    if (!a) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!b || idset_count (b) == 0)
+        return 0;
+    if (idset_grow (a, idset_last (b) + 1) < 0)
+        return -1;
+    if (a->bitmap && b->bitmap) {
+        size_t n = bitmap_words (b->T.M);
+        size_t i;
+
+        /* a was grown to hold the last id of b, so any words of b
+         * beyond a's size are zero.
+         */
+        n = MIN (n, bitmap_words (a->T.M));
+        for (i = 0; i < n; i++)
+            a->bitmap[i] |= b->bitmap[i];
+        a->count = bitmap_popcount (a->bitmap, bitmap_words (a->T.M));
+        return 0;
+    }
+    id = idset_succ (b, 0);
+    while (id < b->T.M) {
+        idset_put (a, id);
+        id = idset_succ (b, id + 1);
+    }
+    return 0;
+}
+
+int idset_subtract (struct idset *a, const struct idset *b)
+{
+    unsigned int id;
+
+    if (!a) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!b || idset_count (b) == 0 || idset_count (a) == 0)
+        return 0;
+    if (a->bitmap && b->bitmap) {
+        size_t n = MIN (bitmap_words (a->T.M), bitmap_words (b->T.M));
+        size_t i;
+
+        for (i = 0; i < n; i++)
+            a->bitmap[i] &= ~b->bitmap[i];
+        a->count = bitmap_popcount (a->bitmap, bitmap_words (a->T.M));
+        return 0;
+    }
+    if (idset_count (b) > idset_count (a)) {
+        /* Cheaper to walk a and test membership in b.
+         */
+        id = idset_succ (a, 0);
+        while (id < a->T.M) {
+            unsigned int next = idset_succ (a, id + 1);
+            if (idset_test (b, id))
+                idset_del (a, id);
+            id = next;
+        }
+        return 0;
+    }
+    id = idset_succ (b, 0);
+    while (id < b->T.M) {
+        idset_del (a, id);
+        id = idset_succ (b, id + 1);
+    }
+    return 0;
+}
+
+struct idset *idset_union (const struct idset *a, const struct idset *b)
+{
+    struct idset *result;
+
+    if (!(result = idset_copy (a)))
+        return NULL;
+    result->flags |= IDSET_FLAG_AUTOGROW;
+    if (idset_add (result, b) < 0) {
+        idset_destroy (result);
+        return NULL;
+    }
+    return result;
+}
+
+struct idset *idset_difference (const struct idset *a, const struct idset *b)
+{
+    struct idset *result;
+
+    if (!(result = idset_copy (a)))
+        return NULL;
+    result->flags |= IDSET_FLAG_AUTOGROW;
+    if (idset_subtract (result, b) < 0) {
+        idset_destroy (result);
+        return NULL;
+    }
+    return result;
+}
+
+struct idset *idset_intersect (const struct idset *a, const struct idset *b)
+{
+    struct idset *result;
+    const struct idset *small;
+    const struct idset *large;
+    unsigned int id;
+
+    if (!a || !b) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (a->bitmap && b->bitmap) {
+        size_t n = MIN (bitmap_words (a->T.M), bitmap_words (b->T.M));
+        size_t i;
+
+        if (!(result = idset_copy (a)))
+            return NULL;
+        for (i = 0; i < n; i++)
+            result->bitmap[i] &= b->bitmap[i];
+        memset (result->bitmap + n, 0,
+                (bitmap_words (a->T.M) - n) * sizeof (uint64_t));
+        result->count = bitmap_popcount (result->bitmap, n);
+        result->flags |= IDSET_FLAG_AUTOGROW;
+        return result;
+    }
+    if (!(result = idset_create (0, IDSET_FLAG_AUTOGROW)))
+        return NULL;
+    small = idset_count (a) < idset_count (b) ? a : b;
+    large = small == a ? b : a;
+    id = idset_succ (small, 0);
+    while (id < small->T.M) {
+        if (idset_test (large, id) && idset_set (result, id) < 0) {
+            idset_destroy (result);
+            return NULL;
+        }
+        id = idset_succ (small, id + 1);
+    }
+    return result;
 }
 
 /*
@@ -100,6 +100,30 @@ size_t idset_count (const struct idset *idset);
  */
 bool idset_equal (const struct idset *set1, const struct idset *set2);
 
+/* Add all ids in 'b' to 'a' (a |= b), or remove them (a &= ~b).
+ * 'b' may be NULL, which has no effect.  idset_add() fails with EINVAL
+ * if 'a' is too small for an id in 'b' and was not created with
+ * IDSET_FLAG_AUTOGROW.
+ * Return 0 on success, -1 on failure with errno set.
+ */
+int idset_add (struct idset *a, const struct idset *b);
+int idset_subtract (struct idset *a, const struct idset *b);
+
+/* Return a new idset (with IDSET_FLAG_AUTOGROW) containing the
+ * union (a | b), difference (a & ~b) or intersection (a & b) of two idsets.
+ * For union and difference, 'b' may be NULL.
+ * Returns idset on success, or NULL on failure with errno set.
+ */
+struct idset *idset_union (const struct idset *a, const struct idset *b);
+struct idset *idset_difference (const struct idset *a, const struct idset *b);
+struct idset *idset_intersect (const struct idset *a, const struct idset *b);
+
+/* Return true if every id in 'a' is in 'b', or if 'a' and 'b' have
+ * at least one id in common, respectively.
+ */
+bool idset_is_subset (const struct idset *a, const struct idset *b);
+bool idset_has_intersection (const struct idset *a, const struct idset *b);
+
 /* Expand bracketed idset string(s) in 's', calling 'fun()' for each
  * expanded string.  'fun()' should return 0 on success, or -1 on failure
  * with errno set.  A fun() failure causes idset_format_map () to immediately
@@ -86,9 +86,9 @@ static int encode_ranged (const struct idset *idset,
     unsigned int hi = 0;
     bool first = true;
 
-    lo = hi = id = vebsucc (idset->T, 0);
+    lo = hi = id = idset_succ (idset, 0);
     while (id < idset->T.M) {
-        unsigned int next = vebsucc (idset->T, id + 1);;
+        unsigned int next = idset_succ (idset, id + 1);;
         bool last = (next == idset->T.M);
 
         if (first)                  // first iteration
@@ -120,9 +120,9 @@ static int encode_simple (const struct idset *idset,
     int count = 0;
     unsigned int id;
 
-    id = vebsucc (idset->T, 0);
+    id = idset_succ (idset, 0);
     while (id != idset->T.M) {
-        int next = vebsucc (idset->T, id + 1);
+        int next = idset_succ (idset, id + 1);
         char *sep = next == idset->T.M ? "" : ",";
         if (catprintf (s, sz, len, "%d%s", id, sep) < 0)
             return -1;
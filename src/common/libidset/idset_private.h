@@ -11,25 +11,36 @@
 #ifndef HAVE_LIBIDSET_PRIVATE_H
 #define HAVE_LIBIDSET_PRIVATE_H 1
 
-/* Implemented as a Van Emde Boas tree using code.google.com/p/libveb.
- * T.D is data; T.M is size
- * All ops are O(log m), for key bitsize m: 2^m == T.M.
+/* Sets of up to IDSET_BITMAP_MAX ids are stored in a dense bitmap,
+ * which makes set operations word-parallel.  Larger sets are converted
+ * to a Van Emde Boas tree using code.google.com/p/libveb, where
+ * all ops are O(log m), for key bitsize m: 2^m == T.M.
+ * T.M is the size in either case; T.D is NULL while bitmap is in use.
  */
 
+#include <stdint.h>
+
 #include "src/common/libutil/veb.h"
 #include "idset.h"
 
 struct idset {
     size_t count;
     Veb T;
+    uint64_t *bitmap;
     int flags;
 };
 
 #define IDSET_ENCODE_CHUNK 1024
 #define IDSET_DEFAULT_SIZE 1024 // default idset size if size=0
+#define IDSET_BITMAP_MAX (1U << 16) // max size stored as a bitmap
+#define IDSET_WORD_BITS 64
 
 int validate_idset_flags (int flags, int allowed);
 
+/* Return the smallest id >= 'id', or T.M if there is none.
+ */
+unsigned int idset_succ (const struct idset *idset, unsigned int id);
+
 int format_first (char *buf,
                   size_t bufsz,
                   const char *fmt,
@@ -527,6 +527,135 @@ void test_autogrow (void)
     idset_destroy (idset);
 }
 
+void test_bitmap_convert (void)
+{
+    struct idset *idset;
+    struct idset *cpy;
+
+    if (!(idset = idset_create (0, IDSET_FLAG_AUTOGROW)))
+        BAIL_OUT ("idset_create failed");
+    ok (idset->bitmap != NULL,
+        "default size idset is stored as a bitmap");
+    ok (idset_range_set (idset, 60, 200) == 0 && idset_count (idset) == 141,
+        "idset_range_set across word boundaries works");
+    ok (idset_range_clear (idset, 64, 127) == 0 && idset_count (idset) == 77,
+        "idset_range_clear of a full word works");
+    ok (idset_first (idset) == 60 && idset_next (idset, 63) == 128
+        && idset_last (idset) == 200,
+        "idset_first/next/last skip empty words");
+    if (!(cpy = idset_copy (idset)))
+        BAIL_OUT ("idset_copy failed");
+    ok (idset_set (idset, IDSET_BITMAP_MAX + 1) == 0 && idset->bitmap == NULL,
+        "idset converts to veb when it grows past IDSET_BITMAP_MAX");
+    ok (idset_count (idset) == 78
+        && idset_test (idset, 60) && !idset_test (idset, 64)
+        && idset_test (idset, 200) && idset_test (idset, IDSET_BITMAP_MAX + 1),
+        "idset contains expected ids after conversion");
+    ok (idset_clear (idset, IDSET_BITMAP_MAX + 1) == 0
+        && idset_equal (idset, cpy),
+        "idset_equal works between veb and bitmap idsets");
+    idset_destroy (cpy);
+    idset_destroy (idset);
+}
+
+static bool check_idset (struct idset *idset, const char *expected)
+{
+    char *s = idset_encode (idset, IDSET_FLAG_RANGE);
+    bool result = s && !strcmp (s, expected);
+    if (!result)
+        diag ("got '%s' expected '%s'", s ? s : "NULL", expected);
+    free (s);
+    return result;
+}
+
+void test_setops (void)
+{
+    struct idset *a;
+    struct idset *b;
+    struct idset *c;
+    struct idset *result;
+
+    if (!(a = idset_decode ("0-9,100-199")))
+        BAIL_OUT ("idset_decode 0-9,100-199 failed");
+    if (!(b = idset_decode ("5-150")))
+        BAIL_OUT ("idset_decode 5-150 failed");
+    if (!(c = idset_decode ("1048576")))
+        BAIL_OUT ("idset_decode 1048576 failed");
+
+    ok ((result = idset_union (a, b)) != NULL
+        && check_idset (result, "0-199") && idset_count (result) == 200,
+        "idset_union works");
+    idset_destroy (result);
+    ok ((result = idset_intersect (a, b)) != NULL
+        && check_idset (result, "5-9,100-150") && idset_count (result) == 56,
+        "idset_intersect works");
+    idset_destroy (result);
+    ok ((result = idset_difference (a, b)) != NULL
+        && check_idset (result, "0-4,151-199") && idset_count (result) == 54,
+        "idset_difference works");
+    idset_destroy (result);
+
+    ok ((result = idset_union (a, c)) != NULL
+        && check_idset (result, "0-9,100-199,1048576")
+        && idset_count (result) == 111,
+        "idset_union works with a veb idset");
+    idset_destroy (result);
+    ok ((result = idset_intersect (c, a)) != NULL
+        && check_idset (result, "") && idset_count (result) == 0,
+        "idset_intersect works with a veb idset");
+    idset_destroy (result);
+    ok ((result = idset_difference (c, a)) != NULL
+        && check_idset (result, "1048576"),
+        "idset_difference works with a veb idset");
+    idset_destroy (result);
+
+    ok (idset_has_intersection (a, b) && !idset_has_intersection (a, c),
+        "idset_has_intersection works");
+    ok (!idset_is_subset (a, b) && !idset_is_subset (b, a),
+        "idset_is_subset returns false for overlapping sets");
+    ok ((result = idset_intersect (a, b)) != NULL
+        && idset_is_subset (result, a) && idset_is_subset (result, b),
+        "idset_is_subset returns true for intersection");
+    idset_destroy (result);
+
+    ok (idset_add (a, b) == 0 && check_idset (a, "0-199")
+        && idset_count (a) == 200,
+        "idset_add works");
+    ok (idset_subtract (a, b) == 0 && check_idset (a, "0-4,151-199")
+        && idset_count (a) == 54,
+        "idset_subtract works");
+    ok (idset_add (a, NULL) == 0 && idset_subtract (a, NULL) == 0
+        && idset_count (a) == 54,
+        "idset_add/subtract b=NULL has no effect");
+    ok (idset_add (a, c) == 0 && idset_test (a, 1048576)
+        && idset_count (a) == 55,
+        "idset_add grows idset as needed");
+    ok (idset_subtract (a, c) == 0 && check_idset (a, "0-4,151-199"),
+        "idset_subtract works with a veb idset");
+
+    errno = 0;
+    ok (idset_add (NULL, b) < 0 && errno == EINVAL,
+        "idset_add a=NULL fails with EINVAL");
+    errno = 0;
+    ok (idset_subtract (NULL, b) < 0 && errno == EINVAL,
+        "idset_subtract a=NULL fails with EINVAL");
+    errno = 0;
+    ok (idset_intersect (a, NULL) == NULL && errno == EINVAL,
+        "idset_intersect b=NULL fails with EINVAL");
+    ok (!idset_has_intersection (a, NULL) && !idset_is_subset (NULL, a),
+        "idset_has_intersection/is_subset return false on NULL");
+
+    idset_destroy (a);
+    idset_destroy (b);
+    if (!(b = idset_create (16, 0)))
+        BAIL_OUT ("idset_create failed");
+    errno = 0;
+    ok (idset_add (b, c) < 0 && errno == EINVAL,
+        "idset_add fails with EINVAL if idset can't grow");
+    idset_destroy (b);
+    idset_destroy (c);
+}
+
 /* N.B. internal function */
 void test_format_first (void)
 {
@@ -760,6 +889,8 @@ int main (int argc, char *argv[])
     test_equal ();
     test_copy ();
     test_autogrow ();
+    test_bitmap_convert ();
+    test_setops ();
     test_format_first ();
     test_format_map ();
     issue_1974 ();
@@ -13,7 +13,9 @@
 #endif
 
 #include <stdarg.h>
+#include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <errno.h>
 
@@ -166,6 +168,111 @@ cleanup:
     return rv;
 }
 
+#define IORAW_MAGIC     0
+#define IORAW_FLAG_EOF  1
+
+void *ioencode_raw (const char *stream,
+                    const char *rank,
+                    const char *data,
+                    int len,
+                    bool eof,
+                    int *sizep)
+{
+    size_t stream_len;
+    size_t rank_len;
+    size_t size;
+    char *buf;
+    char *p;
+
+    /* data can be NULL and len == 0 if eof true */
+    if (!stream
+        || !rank
+        || !sizep
+        || (data && len <= 0)
+        || (!data && len != 0)
+        || (!data && !len && !eof)) {
+        errno = EINVAL;
+        return NULL;
+    }
+    stream_len = strlen (stream) + 1;
+    rank_len = strlen (rank) + 1;
+    size = 2 + stream_len + rank_len + len;
+    if (size > INT_MAX) {
+        errno = EOVERFLOW;
+        return NULL;
+    }
+    if (!(buf = malloc (size)))
+        return NULL;
+    p = buf;
+    *p++ = IORAW_MAGIC;
+    *p++ = eof ? IORAW_FLAG_EOF : 0;
+    memcpy (p, stream, stream_len);
+    p += stream_len;
+    memcpy (p, rank, rank_len);
+    p += rank_len;
+    if (len > 0)
+        memcpy (p, data, len);
+    *sizep = size;
+    return buf;
+}
+
+bool ioencode_is_raw (const void *buf, int size)
+{
+    return (buf && size >= 2 && ((const char *)buf)[0] == IORAW_MAGIC);
+}
+
+int iodecode_raw (const void *buf,
+                  int size,
+                  const char **streamp,
+                  const char **rankp,
+                  const char **datap,
+                  int *lenp,
+                  bool *eofp)
+{
+    const char *p = buf;
+    const char *end = p + size;
+    const char *stream;
+    const char *rank;
+    const char *nul;
+    bool eof;
+    int len;
+
+    if (!buf || size < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!ioencode_is_raw (buf, size))
+        goto eproto;
+    eof = (p[1] & IORAW_FLAG_EOF) ? true : false;
+    p += 2;
+    stream = p;
+    if (!(nul = memchr (p, '\0', end - p)))
+        goto eproto;
+    p = nul + 1;
+    rank = p;
+    if (!(nul = memchr (p, '\0', end - p)))
+        goto eproto;
+    p = nul + 1;
+    len = end - p;
+    if (len == 0 && !eof)
+        goto eproto;
+
+    if (streamp)
+        (*streamp) = stream;
+    if (rankp)
+        (*rankp) = rank;
+    if (datap)
+        (*datap) = len > 0 ? p : NULL;
+    if (lenp)
+        (*lenp) = len;
+    if (eofp)
+        (*eofp) = eof;
+    return 0;
+eproto:
+    errno = EPROTO;
+    return -1;
+}
+
 /*
  * vi: ts=4 sw=4 expandtab
  */
@@ -37,4 +37,34 @@ int iodecode (json_t *o,
               int *len,
               bool *eof);
 
+/* encode io data and/or EOF into a binary frame, avoiding base64
+ * - frame is: magic byte (0), flags byte, stream\0, rank\0, data
+ * - a frame can never be confused with a JSON payload, which cannot
+ *   begin with a NUL byte
+ * - same argument rules as ioencode ()
+ * - returned buffer should be free()'d after use
+ */
+void *ioencode_raw (const char *stream,
+                    const char *rank,
+                    const char *data,
+                    int len,
+                    bool eof,
+                    int *sizep);
+
+/* decode a frame from ioencode_raw () without copying
+ * - stream, rank, and data point into 'buf'
+ * - if no data available, data set to NULL and len to 0
+ */
+int iodecode_raw (const void *buf,
+                  int size,
+                  const char **stream,
+                  const char **rank,
+                  const char **data,
+                  int *len,
+                  bool *eof);
+
+/* return true if 'buf' looks like an ioencode_raw () frame
+ */
+bool ioencode_is_raw (const void *buf, int size);
+
 #endif /* !_IOENCODE_H */
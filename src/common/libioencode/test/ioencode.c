@@ -9,6 +9,7 @@
 \************************************************************/
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <jansson.h>
 #include <errno.h>
@@ -77,12 +78,95 @@ void basic (void)
     free (data);
 }
 
+void raw_corner_case (void)
+{
+    int size;
+    char buf[] = { 0, 0, 's', 't', 'd', 'o', 'u', 't' };
+
+    errno = 0;
+    ok (ioencode_raw (NULL, NULL, NULL, -1, false, &size) == NULL
+        && errno == EINVAL,
+        "ioencode_raw returns EINVAL on bad input");
+    errno = 0;
+    ok (ioencode_raw ("stdout", "0", NULL, 0, false, &size) == NULL
+        && errno == EINVAL,
+        "ioencode_raw returns EINVAL on no data and no eof");
+    errno = 0;
+    ok (iodecode_raw (NULL, 0, NULL, NULL, NULL, NULL, NULL) < 0
+        && errno == EINVAL,
+        "iodecode_raw returns EINVAL on bad input");
+    errno = 0;
+    ok (iodecode_raw ("{}", 3, NULL, NULL, NULL, NULL, NULL) < 0
+        && errno == EPROTO,
+        "iodecode_raw returns EPROTO on JSON payload");
+    errno = 0;
+    ok (iodecode_raw (buf, sizeof (buf), NULL, NULL, NULL, NULL, NULL) < 0
+        && errno == EPROTO,
+        "iodecode_raw returns EPROTO on truncated frame");
+    ok (!ioencode_is_raw ("{}", 3),
+        "ioencode_is_raw returns false on JSON payload");
+}
+
+void raw (void)
+{
+    void *buf;
+    int size;
+    const char *stream;
+    const char *rank;
+    const char *data;
+    int len;
+    bool eof;
+    const char bin[] = { 'a', 0, 'b', '\n' };
+
+    ok ((buf = ioencode_raw ("stdout", "1", "foo", 3, false, &size)) != NULL
+        && size == 2 + 7 + 2 + 3,
+        "ioencode_raw success (data, eof = false)");
+    ok (ioencode_is_raw (buf, size),
+        "ioencode_is_raw returns true");
+    ok (!iodecode_raw (buf, size, &stream, &rank, &data, &len, &eof),
+        "iodecode_raw success");
+    ok (!strcmp (stream, "stdout")
+        && !strcmp (rank, "1")
+        && len == 3
+        && !strncmp (data, "foo", len)
+        && data > (char *)buf && data < (char *)buf + size
+        && eof == false,
+        "iodecode_raw returned correct info without copying");
+    free (buf);
+
+    ok ((buf = ioencode_raw ("stderr", "[4,5]", NULL, 0, true, &size)) != NULL,
+        "ioencode_raw success (no data, eof = true)");
+    ok (!iodecode_raw (buf, size, &stream, &rank, &data, &len, &eof),
+        "iodecode_raw success");
+    ok (!strcmp (stream, "stderr")
+        && !strcmp (rank, "[4,5]")
+        && data == NULL
+        && len == 0
+        && eof == true,
+        "iodecode_raw returned correct info");
+    free (buf);
+
+    ok ((buf = ioencode_raw ("stdout", "0", bin, sizeof (bin), true, &size))
+        != NULL,
+        "ioencode_raw success (binary data, eof = true)");
+    ok (!iodecode_raw (buf, size, &stream, &rank, &data, &len, &eof)
+        && !strcmp (stream, "stdout")
+        && !strcmp (rank, "0")
+        && len == sizeof (bin)
+        && !memcmp (data, bin, len)
+        && eof == true,
+        "iodecode_raw returned binary data intact");
+    free (buf);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
 
     basic_corner_case ();
     basic ();
+    raw_corner_case ();
+    raw ();
 
     done_testing ();
 
@@ -0,0 +1,206 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <endian.h>
+#include <arpa/inet.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "state_batch.h"
+
+struct state_batch {
+    uint8_t *buf;
+    size_t size;
+    int count;
+};
+
+static size_t batch_len (int count)
+{
+    return STATE_BATCH_HDRSIZE + (size_t)count * STATE_BATCH_RECSIZE;
+}
+
+static void put_u32 (uint8_t *p, uint32_t val)
+{
+    val = htonl (val);
+    memcpy (p, &val, sizeof (val));
+}
+
+static uint32_t get_u32 (const uint8_t *p)
+{
+    uint32_t val;
+    memcpy (&val, p, sizeof (val));
+    return ntohl (val);
+}
+
+static void put_u64 (uint8_t *p, uint64_t val)
+{
+    val = htobe64 (val);
+    memcpy (p, &val, sizeof (val));
+}
+
+static uint64_t get_u64 (const uint8_t *p)
+{
+    uint64_t val;
+    memcpy (&val, p, sizeof (val));
+    return be64toh (val);
+}
+
+void state_batch_destroy (struct state_batch *sb)
+{
+    if (sb) {
+        int saved_errno = errno;
+        free (sb->buf);
+        free (sb);
+        errno = saved_errno;
+    }
+}
+
+struct state_batch *state_batch_create (void)
+{
+    struct state_batch *sb;
+
+    if (!(sb = calloc (1, sizeof (*sb))))
+        return NULL;
+    sb->size = batch_len (16);
+    if (!(sb->buf = malloc (sb->size))) {
+        state_batch_destroy (sb);
+        return NULL;
+    }
+    put_u32 (sb->buf, STATE_BATCH_MAGIC);
+    put_u32 (sb->buf + 4, 0);
+    return sb;
+}
+
+int state_batch_append (struct state_batch *sb,
+                        flux_jobid_t id,
+                        flux_job_state_t state,
+                        double timestamp)
+{
+    uint8_t *p;
+    uint64_t ts;
+
+    if (!sb) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (batch_len (sb->count + 1) > sb->size) {
+        size_t size = sb->size * 2;
+        uint8_t *new;
+        if (!(new = realloc (sb->buf, size)))
+            return -1;
+        sb->buf = new;
+        sb->size = size;
+    }
+    p = sb->buf + batch_len (sb->count);
+    memcpy (&ts, &timestamp, sizeof (ts));
+    put_u64 (p, id);
+    put_u32 (p + 8, state);
+    put_u32 (p + 12, 0);
+    put_u64 (p + 16, ts);
+    put_u32 (sb->buf + 4, ++sb->count);
+    return 0;
+}
+
+int state_batch_count (struct state_batch *sb)
+{
+    return sb ? sb->count : 0;
+}
+
+void state_batch_encode (struct state_batch *sb, const void **buf, int *len)
+{
+    if (buf)
+        *buf = sb->buf;
+    if (len)
+        *len = batch_len (sb->count);
+}
+
+json_t *state_batch_tojson (struct state_batch *sb)
+{
+    json_t *a;
+    int i;
+
+    if (!(a = json_array ()))
+        goto nomem;
+    for (i = 0; i < sb->count; i++) {
+        flux_jobid_t id;
+        flux_job_state_t state;
+        double timestamp;
+        json_t *o;
+
+        state_batch_decode_entry (sb->buf, i, &id, &state, &timestamp);
+        if (!(o = json_pack ("[I,s,f]",
+                             id,
+                             flux_job_statetostr (state, false),
+                             timestamp)))
+            goto nomem;
+        if (json_array_append_new (a, o) < 0) {
+            json_decref (o);
+            goto nomem;
+        }
+    }
+    return a;
+nomem:
+    json_decref (a);
+    errno = ENOMEM;
+    return NULL;
+}
+
+bool state_batch_is_binary (const void *buf, int len)
+{
+    if (!buf || len < STATE_BATCH_HDRSIZE
+             || get_u32 (buf) != STATE_BATCH_MAGIC)
+        return false;
+    return true;
+}
+
+int state_batch_decode (const void *buf, int len)
+{
+    uint32_t count;
+
+    if (!state_batch_is_binary (buf, len))
+        goto eproto;
+    count = get_u32 ((const uint8_t *)buf + 4);
+    if (count > INT32_MAX || batch_len (count) != (size_t)len)
+        goto eproto;
+    return count;
+eproto:
+    errno = EPROTO;
+    return -1;
+}
+
+void state_batch_decode_entry (const void *buf,
+                               int index,
+                               flux_jobid_t *id,
+                               flux_job_state_t *state,
+                               double *timestamp)
+{
+    const uint8_t *p = (const uint8_t *)buf + batch_len (index);
+    uint64_t ts;
+
+    if (id)
+        *id = get_u64 (p);
+    if (state)
+        *state = get_u32 (p + 8);
+    if (timestamp) {
+        ts = get_u64 (p + 16);
+        memcpy (timestamp, &ts, sizeof (*timestamp));
+    }
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
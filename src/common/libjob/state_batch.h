@@ -0,0 +1,83 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _JOB_STATE_BATCH_H
+#define _JOB_STATE_BATCH_H
+
+#include <stdbool.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+/* A batch of job state transitions, as published by the job-manager
+ * in the "job-state" event.
+ *
+ * The batch may be encoded in the original JSON form:
+ *   {"transitions":[[id, "S", timestamp], ...]}
+ * or in a compact binary form, consisting of an 8 byte header
+ * (magic, count) followed by 'count' fixed size records of
+ * (id, state, reserved, timestamp), all in network byte order.
+ * The binary form can be decoded in place from the message payload.
+ */
+
+#define STATE_BATCH_MAGIC       0x46534231  // "FSB1"
+#define STATE_BATCH_HDRSIZE     8
+#define STATE_BATCH_RECSIZE     24
+
+struct state_batch;
+
+struct state_batch *state_batch_create (void);
+void state_batch_destroy (struct state_batch *sb);
+
+/* Append a transition of job 'id' to 'state' at 'timestamp' to batch.
+ * Return 0 on success, -1 on failure with errno set.
+ */
+int state_batch_append (struct state_batch *sb,
+                        flux_jobid_t id,
+                        flux_job_state_t state,
+                        double timestamp);
+
+/* Return the number of transitions in batch.
+ */
+int state_batch_count (struct state_batch *sb);
+
+/* Get binary encoding of batch.  The buffer remains valid until the
+ * next state_batch_append() or state_batch_destroy().
+ */
+void state_batch_encode (struct state_batch *sb, const void **buf, int *len);
+
+/* Encode batch as JSON transitions array: [[id, "S", timestamp], ...].
+ * Return new reference on success, NULL on failure with errno set.
+ */
+json_t *state_batch_tojson (struct state_batch *sb);
+
+/* Return true if buffer holds a binary encoded batch.
+ */
+bool state_batch_is_binary (const void *buf, int len);
+
+/* Validate binary encoded batch in 'buf', without copying.
+ * Return the number of transitions on success, -1 with errno == EPROTO
+ * on failure.
+ */
+int state_batch_decode (const void *buf, int len);
+
+/* Get transition 'index' from a binary batch previously validated
+ * with state_batch_decode().
+ */
+void state_batch_decode_entry (const void *buf,
+                               int index,
+                               flux_jobid_t *id,
+                               flux_job_state_t *state,
+                               double *timestamp);
+
+#endif /* _JOB_STATE_BATCH_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,148 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <string.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libjob/state_batch.h"
+
+void empty (void)
+{
+    struct state_batch *sb;
+    const void *buf;
+    int len;
+    json_t *o;
+
+    if (!(sb = state_batch_create ()))
+        BAIL_OUT ("state_batch_create failed");
+    ok (state_batch_count (sb) == 0,
+        "state_batch_count of new batch is 0");
+    state_batch_encode (sb, &buf, &len);
+    ok (len == STATE_BATCH_HDRSIZE,
+        "empty batch encodes to header only");
+    ok (state_batch_is_binary (buf, len) == true,
+        "state_batch_is_binary works on empty batch");
+    ok (state_batch_decode (buf, len) == 0,
+        "state_batch_decode of empty batch returns 0");
+    ok ((o = state_batch_tojson (sb)) != NULL
+        && json_is_array (o) && json_array_size (o) == 0,
+        "state_batch_tojson of empty batch returns empty array");
+    json_decref (o);
+    state_batch_destroy (sb);
+}
+
+void basic (void)
+{
+    struct state_batch *sb;
+    const void *buf;
+    int len;
+    int i;
+    int errors;
+    json_t *o;
+    json_int_t id;
+    const char *state;
+    double t;
+
+    if (!(sb = state_batch_create ()))
+        BAIL_OUT ("state_batch_create failed");
+    errors = 0;
+    for (i = 0; i < 100; i++) {
+        if (state_batch_append (sb, 1000 + i, FLUX_JOB_RUN, 1.5 + i) < 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "state_batch_append works 100 times");
+    ok (state_batch_count (sb) == 100,
+        "state_batch_count is 100");
+
+    state_batch_encode (sb, &buf, &len);
+    ok (len == STATE_BATCH_HDRSIZE + 100 * STATE_BATCH_RECSIZE,
+        "encoded batch has expected length");
+    ok (state_batch_decode (buf, len) == 100,
+        "state_batch_decode returns 100");
+
+    errors = 0;
+    for (i = 0; i < 100; i++) {
+        flux_jobid_t xid;
+        flux_job_state_t xstate;
+        double xt;
+        state_batch_decode_entry (buf, i, &xid, &xstate, &xt);
+        if (xid != 1000 + i || xstate != FLUX_JOB_RUN || xt != 1.5 + i)
+            errors++;
+    }
+    ok (errors == 0,
+        "state_batch_decode_entry returns expected values");
+
+    o = state_batch_tojson (sb);
+    ok (o != NULL && json_array_size (o) == 100,
+        "state_batch_tojson returns array of 100");
+    ok (json_unpack (json_array_get (o, 99), "[I,s,f]", &id, &state, &t) == 0
+        && id == 1099 && !strcmp (state, "RUN") && t == 100.5,
+        "last JSON transition has expected values");
+    json_decref (o);
+
+    state_batch_destroy (sb);
+}
+
+void corrupt (void)
+{
+    struct state_batch *sb;
+    const void *buf;
+    int len;
+    char tmp[256];
+
+    if (!(sb = state_batch_create ()))
+        BAIL_OUT ("state_batch_create failed");
+    if (state_batch_append (sb, 1, FLUX_JOB_SCHED, 1.0) < 0
+        || state_batch_append (sb, 2, FLUX_JOB_SCHED, 2.0) < 0)
+        BAIL_OUT ("state_batch_append failed");
+    state_batch_encode (sb, &buf, &len);
+
+    errno = 0;
+    ok (state_batch_decode (buf, len - 1) < 0 && errno == EPROTO,
+        "state_batch_decode fails on truncated buffer");
+    errno = 0;
+    ok (state_batch_decode (buf, 4) < 0 && errno == EPROTO,
+        "state_batch_decode fails on short header");
+    memcpy (tmp, buf, len);
+    tmp[0] = '{';
+    errno = 0;
+    ok (state_batch_is_binary (tmp, len) == false
+        && state_batch_decode (tmp, len) < 0 && errno == EPROTO,
+        "state_batch_decode fails on bad magic");
+    ok (state_batch_is_binary ("{\"transitions\":[]}", 18) == false,
+        "state_batch_is_binary returns false for JSON payload");
+    errno = 0;
+    ok (state_batch_append (NULL, 1, FLUX_JOB_RUN, 0.) < 0 && errno == EINVAL,
+        "state_batch_append sb=NULL fails with EINVAL");
+
+    state_batch_destroy (sb);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    empty ();
+    basic ();
+    corrupt ();
+
+    done_testing ();
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -390,6 +390,206 @@ const char *flux_kvs_lookup_get_key (flux_future_t *f)
 }
 
 
+/* Decoded result of one key of a batch lookup, filled in on demand.
+ */
+struct batch_val {
+    char *treeobj_str;
+    void *val_data;
+    int val_len;
+    bool val_valid;
+};
+
+struct lookup_batch_ctx {
+    int count;
+    json_t *results;
+    struct batch_val *vals;
+};
+
+static const char *batch_auxkey = "flux::lookup_batch_ctx";
+
+static void free_batch_ctx (struct lookup_batch_ctx *ctx)
+{
+    if (ctx) {
+        int i;
+        for (i = 0; i < ctx->count; i++) {
+            free (ctx->vals[i].treeobj_str);
+            free (ctx->vals[i].val_data);
+        }
+        free (ctx->vals);
+        json_decref (ctx->results);
+        free (ctx);
+    }
+}
+
+flux_future_t *flux_kvs_lookup_batch (flux_t *h, const char *ns, int flags,
+                                      const char **keys, int count)
+{
+    struct lookup_batch_ctx *ctx = NULL;
+    json_t *a = NULL;
+    flux_future_t *f;
+    int i;
+
+    if (!h || !keys || count <= 0
+        || validate_lookup_flags (flags, false) < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!ns) {
+        if (!(ns = kvs_get_namespace ()))
+            return NULL;
+    }
+    if (!(a = json_array ()))
+        goto nomem;
+    for (i = 0; i < count; i++) {
+        json_t *o;
+        if (!keys[i] || strlen (keys[i]) == 0) {
+            json_decref (a);
+            errno = EINVAL;
+            return NULL;
+        }
+        if (!(o = json_string (keys[i]))
+            || json_array_append_new (a, o) < 0) {
+            json_decref (o);
+            goto nomem;
+        }
+    }
+    if (!(ctx = calloc (1, sizeof (*ctx)))
+        || !(ctx->vals = calloc (count, sizeof (ctx->vals[0]))))
+        goto nomem;
+    ctx->count = count;
+    if (!(f = flux_rpc_pack (h, "kvs.lookup-batch", FLUX_NODEID_ANY, 0,
+                             "{s:s s:O s:i}",
+                             "namespace", ns,
+                             "keys", a,
+                             "flags", flags))) {
+        free_batch_ctx (ctx);
+        json_decref (a);
+        return NULL;
+    }
+    if (flux_future_aux_set (f, batch_auxkey, ctx,
+                             (flux_free_f)free_batch_ctx) < 0) {
+        free_batch_ctx (ctx);
+        json_decref (a);
+        flux_future_destroy (f);
+        return NULL;
+    }
+    json_decref (a);
+    return f;
+nomem:
+    free_batch_ctx (ctx);
+    json_decref (a);
+    errno = ENOMEM;
+    return NULL;
+}
+
+/* Get the treeobj result for key 'index' of a batch lookup, failing
+ * with that key's errno if its lookup failed.
+ */
+static int batch_get_treeobj (flux_future_t *f, int index,
+                              struct lookup_batch_ctx **ctxp,
+                              json_t **treeobj)
+{
+    struct lookup_batch_ctx *ctx;
+    json_t *o;
+    int errnum;
+
+    if (!(ctx = flux_future_aux_get (f, batch_auxkey))
+        || index < 0
+        || index >= ctx->count) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!ctx->results) {
+        json_t *results;
+
+        if (flux_rpc_get_unpack (f, "{s:o}", "results", &results) < 0)
+            return -1;
+        if (!json_is_array (results)
+            || json_array_size (results) != ctx->count) {
+            errno = EPROTO;
+            return -1;
+        }
+        ctx->results = json_incref (results);
+    }
+    o = json_array_get (ctx->results, index);
+    if (json_unpack (o, "{s:i}", "errno", &errnum) == 0) {
+        errno = errnum;
+        return -1;
+    }
+    if (json_unpack (o, "{s:o}", "val", treeobj) < 0
+        || treeobj_validate (*treeobj) < 0) {
+        errno = EPROTO;
+        return -1;
+    }
+    *ctxp = ctx;
+    return 0;
+}
+
+static int batch_decode_val (flux_future_t *f, int index,
+                             struct batch_val **vp)
+{
+    struct lookup_batch_ctx *ctx;
+    struct batch_val *v;
+    json_t *treeobj;
+
+    if (batch_get_treeobj (f, index, &ctx, &treeobj) < 0)
+        return -1;
+    v = &ctx->vals[index];
+    if (!v->val_valid) {
+        if (treeobj_decode_val (treeobj, &v->val_data, &v->val_len) < 0)
+            return -1;
+        v->val_valid = true;
+    }
+    *vp = v;
+    return 0;
+}
+
+int flux_kvs_lookup_batch_get (flux_future_t *f, int index,
+                               const char **value)
+{
+    struct batch_val *v;
+
+    if (batch_decode_val (f, index, &v) < 0)
+        return -1;
+    if (value)
+        *value = v->val_data;
+    return 0;
+}
+
+int flux_kvs_lookup_batch_get_raw (flux_future_t *f, int index,
+                                   const void **data, int *len)
+{
+    struct batch_val *v;
+
+    if (batch_decode_val (f, index, &v) < 0)
+        return -1;
+    if (data)
+        *data = v->val_data;
+    if (len)
+        *len = v->val_len;
+    return 0;
+}
+
+int flux_kvs_lookup_batch_get_treeobj (flux_future_t *f, int index,
+                                       const char **treeobj)
+{
+    struct lookup_batch_ctx *ctx;
+    struct batch_val *v;
+    json_t *obj;
+
+    if (batch_get_treeobj (f, index, &ctx, &obj) < 0)
+        return -1;
+    v = &ctx->vals[index];
+    if (!v->treeobj_str) {
+        if (!(v->treeobj_str = treeobj_encode (obj)))
+            return -1;
+    }
+    if (treeobj)
+        *treeobj = v->treeobj_str;
+    return 0;
+}
+
+
 /* This only applies with FLUX_KVS_WATCH.
  * Causes a stream of lookup responses to end with an ENODATA response.
  */
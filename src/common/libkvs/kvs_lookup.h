@@ -31,6 +31,22 @@ int flux_kvs_lookup_get_symlink (flux_future_t *f,
 
 const char *flux_kvs_lookup_get_key (flux_future_t *f);
 
+/* Look up 'count' keys in one request, all against the same root
+ * snapshot of namespace 'ns'.  Results are accessed by the index of
+ * the key in 'keys'.  The accessors fail with errno set to the error
+ * of that key's lookup, e.g. ENOENT if it does not exist.
+ * FLUX_KVS_WATCH and FLUX_KVS_WAITCREATE are not supported.
+ */
+flux_future_t *flux_kvs_lookup_batch (flux_t *h, const char *ns, int flags,
+                                      const char **keys, int count);
+
+int flux_kvs_lookup_batch_get (flux_future_t *f, int index,
+                               const char **value);
+int flux_kvs_lookup_batch_get_raw (flux_future_t *f, int index,
+                                   const void **data, int *len);
+int flux_kvs_lookup_batch_get_treeobj (flux_future_t *f, int index,
+                                       const char **treeobj);
+
 /* Cancel a FLUX_KVS_WATCH "stream".
  * Once the cancel request is processed, an ENODATA error response is sent,
  * thus the user should continue to reset and consume responses until an
@@ -53,9 +53,32 @@ void errors (void)
     ok (flux_kvs_lookup_cancel (NULL) == -1 && errno == EINVAL,
         "flux_kvs_lookup_cancel future=NULL fails with EINVAL");
 
+    errno = 0;
+    ok (flux_kvs_lookup_batch (NULL, NULL, 0, NULL, 0) == NULL
+        && errno == EINVAL,
+        "flux_kvs_lookup_batch fails on bad input");
+
+    errno = 0;
+    ok (flux_kvs_lookup_batch_get (NULL, 0, NULL) < 0 && errno == EINVAL,
+        "flux_kvs_lookup_batch_get fails on bad input");
+
+    errno = 0;
+    ok (flux_kvs_lookup_batch_get_raw (NULL, 0, NULL, NULL) < 0
+        && errno == EINVAL,
+        "flux_kvs_lookup_batch_get_raw fails on bad input");
+
+    errno = 0;
+    ok (flux_kvs_lookup_batch_get_treeobj (NULL, 0, NULL) < 0
+        && errno == EINVAL,
+        "flux_kvs_lookup_batch_get_treeobj fails on bad input");
+
     if (!(f = flux_future_create (NULL, NULL)))
         BAIL_OUT ("flux_future_create failed");
 
+    errno = 0;
+    ok (flux_kvs_lookup_batch_get (f, 0, NULL) < 0 && errno == EINVAL,
+        "flux_kvs_lookup_batch_get future=(wrong type) fails with EINVAL");
+
     errno = 0;
     ok (flux_kvs_lookup_get_key (f) == NULL && errno == EINVAL,
         "flux_kvs_lookup_get_key future=(wrong type) fails with EINVAL");
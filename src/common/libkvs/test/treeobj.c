@@ -411,6 +411,103 @@ void test_dir_peek (void)
     json_decref (dir);
 }
 
+void test_hdir (void)
+{
+    json_t *hdir, *sub, *dir, *dirref, *val, *cpy;
+    char key0[3], key1[5], key[32];
+
+    val = treeobj_create_val ("foo", 4);
+    dir = treeobj_create_dir ();
+    dirref = treeobj_create_dirref ("sha1-fbedb6b7d3e3c6ea7bf2e9a6cd8fd8fcd34c6cbd");
+    if (!val || !dir || !dirref)
+        BAIL_OUT ("can't continue without test values");
+    if (treeobj_insert_entry (dir, "foo", val) < 0)
+        BAIL_OUT ("treeobj_insert_entry failed");
+
+    ok ((hdir = treeobj_create_hdir ()) != NULL,
+        "treeobj_create_hdir works");
+    ok (treeobj_validate (hdir) == 0,
+        "treeobj_validate likes empty hdir");
+    ok (treeobj_is_hdir (hdir) && !treeobj_is_dir (hdir),
+        "treeobj_is_hdir returns true, treeobj_is_dir returns false");
+    ok (treeobj_get_count (hdir) == 0,
+        "treeobj_get_count returns 0");
+
+    ok (treeobj_hdir_key ("foo", 0, key0, sizeof (key0)) == 0
+        && strlen (key0) == 2,
+        "treeobj_hdir_key level 0 works");
+    ok (treeobj_hdir_key ("foo", 1, key1, sizeof (key1)) == 0
+        && strlen (key1) == 4,
+        "treeobj_hdir_key level 1 works");
+    ok (strncmp (key0, key1, 2) == 0,
+        "treeobj_hdir_key level 0 key is prefix of level 1 key");
+    ok (treeobj_hdir_key ("foo", 0, key, sizeof (key)) == 0
+        && !strcmp (key, key0),
+        "treeobj_hdir_key is deterministic");
+    errno = 0;
+    ok (treeobj_hdir_key ("foo", 1, key, 4) < 0 && errno == EINVAL,
+        "treeobj_hdir_key fails with EINVAL on short buffer");
+    errno = 0;
+    ok (treeobj_hdir_key ("foo", TREEOBJ_HDIR_MAX_LEVEL, key, sizeof (key)) < 0
+        && errno == EINVAL,
+        "treeobj_hdir_key fails with EINVAL on level too deep");
+    errno = 0;
+    ok (treeobj_hdir_key (NULL, 0, key, sizeof (key)) < 0 && errno == EINVAL,
+        "treeobj_hdir_key fails with EINVAL on NULL name");
+
+    ok (treeobj_insert_shard (hdir, key0, dir) == 0
+        && treeobj_get_count (hdir) == 1
+        && treeobj_get_shard (hdir, key0) == dir
+        && treeobj_peek_shard (hdir, key0) == dir,
+        "treeobj_insert_shard works with dir");
+    ok (treeobj_insert_shard (hdir, "00", dirref) == 0
+        && treeobj_get_count (hdir) == 2,
+        "treeobj_insert_shard works with dirref");
+    if (!(sub = treeobj_create_hdir ()))
+        BAIL_OUT ("treeobj_create_hdir failed");
+    ok (treeobj_insert_shard (hdir, "01", sub) == 0
+        && treeobj_get_count (hdir) == 3,
+        "treeobj_insert_shard works with hdir");
+    ok (treeobj_validate (hdir) == 0,
+        "treeobj_validate likes populated hdir");
+    errno = 0;
+    ok (treeobj_insert_shard (hdir, "02", val) < 0 && errno == EINVAL,
+        "treeobj_insert_shard fails with EINVAL on val shard");
+    errno = 0;
+    ok (treeobj_insert_shard (dir, "02", sub) < 0 && errno == EINVAL,
+        "treeobj_insert_shard fails with EINVAL on non-hdir treeobj");
+    errno = 0;
+    ok (treeobj_get_shard (hdir, "ff") == NULL && errno == ENOENT,
+        "treeobj_get_shard fails with ENOENT on unknown key");
+    errno = 0;
+    ok (treeobj_peek_shard (dir, "ff") == NULL && errno == EINVAL,
+        "treeobj_peek_shard fails with EINVAL on non-hdir treeobj");
+
+    ok ((cpy = treeobj_copy (hdir)) != NULL
+        && treeobj_is_hdir (cpy)
+        && treeobj_get_count (cpy) == 3
+        && treeobj_get_shard (cpy, key0) == dir,
+        "treeobj_copy makes shallow copy of hdir");
+    ok (treeobj_delete_shard (cpy, "01") == 0
+        && treeobj_get_count (cpy) == 2
+        && treeobj_get_count (hdir) == 3,
+        "treeobj_delete_shard on copy does not affect original");
+    errno = 0;
+    ok (treeobj_delete_shard (cpy, "01") < 0 && errno == ENOENT,
+        "treeobj_delete_shard fails with ENOENT on unknown key");
+    json_decref (cpy);
+
+    json_object_set_new (treeobj_get_data (hdir), "03", json_integer (1));
+    ok (treeobj_validate (hdir) < 0,
+        "treeobj_validate rejects hdir with non-dir shard");
+
+    json_decref (sub);
+    json_decref (dirref);
+    json_decref (dir);
+    json_decref (val);
+    json_decref (hdir);
+}
+
 void test_copy (void)
 {
     json_t *val, *symlink, *dirref, *valref, *dir;
@@ -810,6 +907,7 @@ int main(int argc, char** argv)
     test_dirref ();
     test_dir ();
     test_dir_peek ();
+    test_hdir ();
     test_copy ();
     test_deep_copy ();
     test_symlink ();
@@ -15,6 +15,8 @@
 #endif
 #include <errno.h>
 #include <string.h>
+#include <stdio.h>
+#include <stdint.h>
 #include <assert.h>
 #include <sodium.h>
 
@@ -101,6 +103,19 @@ int treeobj_validate (const json_t *obj)
                 goto inval;
         }
     }
+    else if (!strcmp (type, "hdir")) {
+        const char *key;
+        if (!json_is_object (data))
+            goto inval;
+        json_object_foreach ((json_t *)data, key, o) {
+            if (!treeobj_is_dir (o)
+                && !treeobj_is_dirref (o)
+                && !treeobj_is_hdir (o))
+                goto inval;
+            if (treeobj_validate (o) < 0)
+                goto inval;
+        }
+    }
     else if (!strcmp (type, "symlink")) {
         json_t *o;
         if (!json_is_object (data))
@@ -166,6 +181,12 @@ bool treeobj_is_dirref (const json_t *obj)
     return type && !strcmp (type, "dirref");
 }
 
+bool treeobj_is_hdir (const json_t *obj)
+{
+    const char *type = treeobj_get_type (obj);
+    return type && !strcmp (type, "hdir");
+}
+
 json_t *treeobj_get_data (json_t *obj)
 {
     json_t *data;
@@ -261,7 +282,7 @@ int treeobj_get_count (const json_t *obj)
     if (!strcmp (type, "valref") || !strcmp (type, "dirref")) {
         count = json_array_size (data);
     }
-    else if (!strcmp (type, "dir")) {
+    else if (!strcmp (type, "dir") || !strcmp (type, "hdir")) {
         count = json_object_size (data);
     }
     else if (!strcmp (type, "symlink") || !strcmp (type, "val")) {
@@ -365,6 +386,107 @@ const json_t *treeobj_peek_entry (const json_t *obj, const char *name)
     return obj2;
 }
 
+/* 64-bit FNV-1a */
+static uint64_t hdir_hash (const char *name)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    while (*name) {
+        hash ^= (unsigned char)*name++;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+int treeobj_hdir_key (const char *name, int level, char *buf, int bufsize)
+{
+    uint64_t hash;
+    int i;
+
+    if (!name || level < 0 || level >= TREEOBJ_HDIR_MAX_LEVEL
+              || !buf || bufsize < (level + 1) * 2 + 1) {
+        errno = EINVAL;
+        return -1;
+    }
+    hash = hdir_hash (name);
+    for (i = 0; i <= level; i++) {
+        snprintf (buf + i * 2, 3, "%02x", (unsigned int)(hash >> 56));
+        hash <<= 8;
+    }
+    return 0;
+}
+
+json_t *treeobj_get_shard (json_t *obj, const char *key)
+{
+    const char *type;
+    json_t *data, *shard;
+
+    if (!key || treeobj_unpack (obj, &type, &data) < 0
+             || strcmp (type, "hdir") != 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(shard = json_object_get (data, key))) {
+        errno = ENOENT;
+        return NULL;
+    }
+    return shard;
+}
+
+const json_t *treeobj_peek_shard (const json_t *obj, const char *key)
+{
+    const char *type;
+    const json_t *data, *shard;
+
+    if (!key || treeobj_peek (obj, &type, &data) < 0
+             || strcmp (type, "hdir") != 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(shard = json_object_get (data, key))) {
+        errno = ENOENT;
+        return NULL;
+    }
+    return shard;
+}
+
+int treeobj_insert_shard (json_t *obj, const char *key, json_t *shard)
+{
+    const char *type;
+    json_t *data;
+
+    if (!key || !shard || treeobj_unpack (obj, &type, &data) < 0
+             || strcmp (type, "hdir") != 0
+             || (!treeobj_is_dir (shard)
+                 && !treeobj_is_dirref (shard)
+                 && !treeobj_is_hdir (shard))) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (json_object_set (data, key, shard) < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+int treeobj_delete_shard (json_t *obj, const char *key)
+{
+    const char *type;
+    json_t *data;
+
+    if (!key || treeobj_unpack (obj, &type, &data) < 0
+             || strcmp (type, "hdir") != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (json_object_del (data, key) < 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    return 0;
+}
+
 json_t *treeobj_copy (json_t *obj)
 {
     json_t *data;
@@ -377,10 +499,14 @@ json_t *treeobj_copy (json_t *obj)
         return NULL;
     }
     /* shallow copy of treeobj data and deep copy of treeobj is
-     * identical except for dir object.
+     * identical except for dir and hdir objects.
      */
-    if (treeobj_is_dir (obj)) {
-        if (!(cpy = treeobj_create_dir ()))
+    if (treeobj_is_dir (obj) || treeobj_is_hdir (obj)) {
+        if (treeobj_is_dir (obj))
+            cpy = treeobj_create_dir ();
+        else
+            cpy = treeobj_create_hdir ();
+        if (!cpy)
             return NULL;
 
         if (!(datacpy = json_copy (data))) {
@@ -470,6 +596,19 @@ json_t *treeobj_create_dir (void)
     return obj;
 }
 
+json_t *treeobj_create_hdir (void)
+{
+    json_t *obj;
+
+    if (!(obj = json_pack ("{s:i s:s s:{}}", "ver", treeobj_version,
+                                            "type", "hdir",
+                                            "data"))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return obj;
+}
+
 json_t *treeobj_create_symlink (const char *ns, const char *target)
 {
     json_t *data, *obj;
@@ -28,6 +28,7 @@ json_t *treeobj_create_val (const void *data, int len);
 json_t *treeobj_create_valref (const char *blobref);
 json_t *treeobj_create_dir (void);
 json_t *treeobj_create_dirref (const char *blobref);
+json_t *treeobj_create_hdir (void);
 
 /* Validate treeobj, recursively.
  * Return 0 if valid, -1 with errno = EINVAL if invalid.
@@ -45,10 +46,12 @@ bool treeobj_is_val (const json_t *obj);
 bool treeobj_is_valref (const json_t *obj);
 bool treeobj_is_dir (const json_t *obj);
 bool treeobj_is_dirref (const json_t *obj);
+bool treeobj_is_hdir (const json_t *obj);
 
 /* get type-specific value.
  * For dirref/valref, this is an array of blobrefs.
  * For directory, this is dictionary of treeobjs
+ * For sharded directory, this is dictionary of shards
  * For symlink, this is an object with optinoal namespace and target.
  * For val this is string containing base64-encoded data.
  * Return JSON object on success, NULL on error with errno = EINVAL.
@@ -72,6 +75,7 @@ int treeobj_decode_val (const json_t *obj, void **data, int *len);
 /* get type-specific count.
  * For dirref/valref, this is the number of blobrefs.
  * For directory, this is number of entries
+ * For sharded directory, this is number of shards
  * For symlink or val, this is 1.
  * Return count on success, -1 on error with errno = EINVAL.
  */
@@ -95,6 +99,35 @@ int treeobj_insert_entry_novalidate (json_t *obj,
                                      const char *name,
                                      json_t *obj2);
 
+/* A sharded directory ("hdir") is a hash array mapped trie of
+ * directories, for directories too large to rewrite on every change.
+ * Each entry name is hashed, and at trie level L the shard for the
+ * name is keyed by the first L+1 bytes of the hash in hex.  A shard is
+ * a dir holding the entries themselves, an hdir at level L+1, or a
+ * dirref to either.  An hdir is never a directory entry itself, it is
+ * always referred to by a dirref.
+ */
+#define TREEOBJ_HDIR_MAX_LEVEL 8
+
+/* Size of a buffer that holds a shard key at any level, with its '\0'.
+ */
+#define TREEOBJ_HDIR_KEY_SIZE (TREEOBJ_HDIR_MAX_LEVEL * 2 + 1)
+
+/* Compute the shard key for 'name' at trie 'level' into 'buf'.
+ * Return 0 on success, -1 on error with errno set.
+ */
+int treeobj_hdir_key (const char *name, int level, char *buf, int bufsize);
+
+/* get/add/remove shard of sharded directory
+ * Get returns JSON object (owned by 'obj', do not destory), NULL on error.
+ * insert takes a reference on 'shard' (caller retains ownership).
+ * insert/delete return 0 on success, -1 on error with errno set.
+ */
+json_t *treeobj_get_shard (json_t *obj, const char *key);
+const json_t *treeobj_peek_shard (const json_t *obj, const char *key);
+int treeobj_insert_shard (json_t *obj, const char *key, json_t *shard);
+int treeobj_delete_shard (json_t *obj, const char *key);
+
 /* peek directory entry
  * identical to treeobj_get_entry(), but is a const equivalent.  Good
  * to use when modifications will not occur.
@@ -104,7 +137,8 @@ const json_t *treeobj_peek_entry (const json_t *obj, const char *name);
 /* Shallow copy a treeobj
  * Note that this is not a shallow copy on the json object, but is a
  * shallow copy on the data within a tree object.  For example, for a
- * dir object, the first level of directory entries will be copied.
+ * dir object, the first level of directory entries will be copied, and
+ * for an hdir object, the first level of shards.
  */
 json_t *treeobj_copy (json_t *obj);
 
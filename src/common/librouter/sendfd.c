@@ -39,6 +39,12 @@
  *   is assembled, then it is freed.  The static buffer is sized somewhat
  *   arbitrarily at 4K.
  *
+ * - sendfd_batch/recvfd_batch move many messages per system call
+ *   through an iobuf_batch, for servers with many messages in flight
+ *   to a peer.  The encoding is the same, so either side may use
+ *   either interface.  The batch buffer is kept for reuse, but is freed
+ *   when it drains if a large message grew it beyond IOBUF_BATCH_SIZE.
+ *
  * - sendfd/recvfd do not encrypt messages, therefore this transport
  *   is only appropriate for use on AF_LOCAL sockets or on file descriptors
  *   tunneled through a secure channel.
@@ -49,12 +55,17 @@
 #endif
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 #include <flux/core.h>
 
 #include "sendfd.h"
 
 #define IOBUF_MAGIC 0xffee0012
 
+#define IOBUF_BATCH_SIZE 16384
+
 void iobuf_init (struct iobuf *iobuf)
 {
     memset (iobuf, 0, sizeof (*iobuf));
@@ -175,6 +186,199 @@ done:
     return msg;
 }
 
+void iobuf_batch_init (struct iobuf_batch *batch)
+{
+    memset (batch, 0, sizeof (*batch));
+}
+
+void iobuf_batch_clean (struct iobuf_batch *batch)
+{
+    free (batch->buf);
+    memset (batch, 0, sizeof (*batch));
+}
+
+size_t iobuf_batch_pending (struct iobuf_batch *batch)
+{
+    return batch->tail - batch->head;
+}
+
+/* Messages in a batch are packed back to back, so headers may be
+ * unaligned.  Access them with memcpy().
+ */
+static void batch_header_set (uint8_t *p, size_t size)
+{
+    uint32_t hdr[2] = { IOBUF_MAGIC, htonl (size - 8) };
+    memcpy (p, hdr, sizeof (hdr));
+}
+
+static int batch_header_get (const uint8_t *p, size_t *size)
+{
+    uint32_t hdr[2];
+
+    memcpy (hdr, p, sizeof (hdr));
+    if (hdr[0] != IOBUF_MAGIC) {
+        errno = EPROTO;
+        return -1;
+    }
+    *size = ntohl (hdr[1]) + 8;
+    return 0;
+}
+
+int iobuf_batch_reserve (struct iobuf_batch *batch, size_t need)
+{
+    size_t pending = batch->tail - batch->head;
+    size_t size;
+    uint8_t *buf;
+
+    if (batch->size - batch->tail >= need)
+        return 0;
+    if (batch->head > 0) {
+        memmove (batch->buf, batch->buf + batch->head, pending);
+        batch->head = 0;
+        batch->tail = pending;
+        if (batch->size - batch->tail >= need)
+            return 0;
+    }
+    size = batch->size > 0 ? batch->size : IOBUF_BATCH_SIZE;
+    while (size - pending < need)
+        size *= 2;
+    if (!(buf = realloc (batch->buf, size)))
+        return -1;
+    batch->buf = buf;
+    batch->size = size;
+    return 0;
+}
+
+/* Reset a drained batch, releasing the buffer if it was grown
+ * for a large message.
+ */
+static void batch_drained (struct iobuf_batch *batch)
+{
+    batch->head = batch->tail = 0;
+    if (batch->size > IOBUF_BATCH_SIZE) {
+        free (batch->buf);
+        batch->buf = NULL;
+        batch->size = 0;
+    }
+}
+
+void iobuf_batch_consume (struct iobuf_batch *batch, size_t n)
+{
+    batch->head += n;
+    if (batch->head >= batch->tail)
+        batch_drained (batch);
+}
+
+int iobuf_batch_put (struct iobuf_batch *batch, const flux_msg_t *msg)
+{
+    size_t size;
+    uint8_t *p;
+
+    if (!batch || !msg) {
+        errno = EINVAL;
+        return -1;
+    }
+    size = flux_msg_encode_size (msg) + 8;
+    if (iobuf_batch_reserve (batch, size) < 0)
+        return -1;
+    p = batch->buf + batch->tail;
+    batch_header_set (p, size);
+    if (flux_msg_encode (msg, &p[8], size - 8) < 0)
+        return -1;
+    batch->tail += size;
+    return 0;
+}
+
+bool iobuf_batch_ready (struct iobuf_batch *batch)
+{
+    size_t size;
+
+    if (!batch || batch->tail - batch->head < 8)
+        return false;
+    if (batch_header_get (batch->buf + batch->head, &size) < 0)
+        return true;
+    return batch->tail - batch->head >= size;
+}
+
+flux_msg_t *iobuf_batch_get (struct iobuf_batch *batch)
+{
+    size_t pending;
+    size_t size;
+    uint8_t *p;
+    flux_msg_t *msg;
+
+    if (!batch) {
+        errno = EINVAL;
+        return NULL;
+    }
+    pending = batch->tail - batch->head;
+    p = batch->buf + batch->head;
+    if (pending < 8) {
+        errno = EWOULDBLOCK;
+        return NULL;
+    }
+    if (batch_header_get (p, &size) < 0)
+        return NULL;
+    if (pending < size) {
+        errno = EWOULDBLOCK;
+        return NULL;
+    }
+    if (!(msg = flux_msg_decode (&p[8], size - 8)))
+        return NULL;
+    iobuf_batch_consume (batch, size);
+    return msg;
+}
+
+int sendfd_batch (int fd, struct iobuf_batch *batch)
+{
+    ssize_t n;
+
+    if (fd < 0 || !batch) {
+        errno = EINVAL;
+        return -1;
+    }
+    while (batch->head < batch->tail) {
+        n = write (fd, batch->buf + batch->head, batch->tail - batch->head);
+        if (n < 0)
+            return -1;
+        iobuf_batch_consume (batch, n);
+    }
+    batch_drained (batch);
+    return 0;
+}
+
+int recvfd_batch (int fd, struct iobuf_batch *batch)
+{
+    size_t pending;
+    size_t need = 8;
+    ssize_t n;
+
+    if (fd < 0 || !batch) {
+        errno = EINVAL;
+        return -1;
+    }
+    /* If the header of a partial message has been read, make room for
+     * the rest of it, otherwise read whatever fits.
+     */
+    pending = batch->tail - batch->head;
+    if (pending >= 8) {
+        if (batch_header_get (batch->buf + batch->head, &need) < 0)
+            return -1;
+        need = need > pending ? need - pending : 8;
+    }
+    if (iobuf_batch_reserve (batch, need) < 0)
+        return -1;
+    n = read (fd, batch->buf + batch->tail, batch->size - batch->tail);
+    if (n < 0)
+        return -1;
+    if (n == 0) {
+        errno = ECONNRESET;
+        return -1;
+    }
+    batch->tail += n;
+    return 0;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
@@ -11,6 +11,7 @@
 #ifndef _ROUTER_SENDFD_H
 #define _ROUTER_SENDFD_H
 
+#include <stdbool.h>
 #include <flux/core.h>
 
 struct iobuf {
@@ -41,6 +42,62 @@ void iobuf_init (struct iobuf *iobuf);
  */
 void iobuf_clean (struct iobuf *iobuf);
 
+/* Batch buffer for non-blocking streams of many messages.
+ * Encoded messages occupy buf[head..tail).  The buffer is reused across
+ * calls and is only reallocated when a message does not fit.
+ */
+struct iobuf_batch {
+    uint8_t *buf;
+    size_t size;
+    size_t head;
+    size_t tail;
+};
+
+/* Initialize/free iobuf_batch members.
+ */
+void iobuf_batch_init (struct iobuf_batch *batch);
+void iobuf_batch_clean (struct iobuf_batch *batch);
+
+/* Return the number of bytes buffered but not yet written or parsed.
+ */
+size_t iobuf_batch_pending (struct iobuf_batch *batch);
+
+/* Ensure at least 'need' bytes are free after batch->tail, for a caller
+ * filling the batch directly.  Returns 0 on success, -1 on failure.
+ */
+int iobuf_batch_reserve (struct iobuf_batch *batch, size_t need);
+
+/* Discard 'n' bytes from the front of batch, for a caller draining the
+ * batch directly.
+ */
+void iobuf_batch_consume (struct iobuf_batch *batch, size_t n);
+
+/* Encode message onto the end of batch, to be written by sendfd_batch().
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int iobuf_batch_put (struct iobuf_batch *batch, const flux_msg_t *msg);
+
+/* Return true if iobuf_batch_get() would not fail with EWOULDBLOCK.
+ */
+bool iobuf_batch_ready (struct iobuf_batch *batch);
+
+/* Decode the next complete message read by recvfd_batch().
+ * Returns message on success, NULL on failure with errno set.
+ * If no complete message is buffered, errno is set to EWOULDBLOCK.
+ */
+flux_msg_t *iobuf_batch_get (struct iobuf_batch *batch);
+
+/* Write as much of batch as possible to file descriptor.
+ * Returns 0 if batch was completely written, -1 on failure with errno set
+ * (EWOULDBLOCK or EAGAIN if data remains).
+ */
+int sendfd_batch (int fd, struct iobuf_batch *batch);
+
+/* Append available data from file descriptor to batch with one read().
+ * Returns 0 on success, -1 on failure with errno set (ECONNRESET on EOF).
+ */
+int recvfd_batch (int fd, struct iobuf_batch *batch);
+
 #endif /* !_ROUTER_SENDFD_H */
 
 /*
@@ -0,0 +1,573 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* shmring.c - shared memory rings for usock connections
+ *
+ * Segment layout:
+ *
+ *   page 0        - header: magic, ring size, ring control blocks
+ *   ring[SERVER]  - server to client data (size bytes)
+ *   ring[CLIENT]  - client to server data (size bytes)
+ *
+ * Ring control blocks are indexed by producer.  'tail' is written only
+ * by the producer, 'head' only by the consumer, and each is on its own
+ * cache line.  Indices increase without wrapping and are reduced modulo
+ * the (power of 2) ring size when used as offsets.  Each end keeps its
+ * own indices privately and only publishes them to the segment, so a
+ * misbehaving peer can corrupt the data it sends but not the memory
+ * outside the rings.
+ *
+ * Wakeups: after publishing a new tail, the producer signals the
+ * consumer's doorbell if the consumer had drained the ring.  A producer
+ * that finds the ring full sets 'waiting' and the consumer signals the
+ * producer's doorbell after it frees space.  Sequentially consistent
+ * loads and stores on the indices ensure a wakeup is not lost between
+ * one side's last check and the other side's update.  For that, the
+ * consumer must not stop until it sees the ring empty after publishing
+ * its head: data added after it loaded 'tail' but before it stored
+ * 'head' does not signal the doorbell.
+ *
+ * The ring size is chosen by the server, which caps the size requested
+ * by the client, since each ring pins memory for the connection's life.
+ *
+ * Without memfd_create(2) (glibc < 2.27), shmring_create() fails with
+ * ENOSYS, so the server declines every hello and clients stay on the
+ * socket.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "src/common/libutil/errno_safe.h"
+
+#include "shmring.h"
+
+#define SHMRING_MAGIC       0x464c5852  // "FLXR"
+#define SHMRING_HELLO_MAGIC 0xffee0013
+#define SHMRING_ACK_MAGIC   0xffee0014
+
+#define SHMRING_SIZE_MIN    (64*1024)
+#define SHMRING_SIZE_MAX    (1024*1024)
+
+struct ring_ctl {
+    uint64_t tail __attribute__ ((aligned (64)));
+    uint64_t head __attribute__ ((aligned (64)));
+    uint32_t waiting __attribute__ ((aligned (64)));
+};
+
+struct shmring_hdr {
+    uint32_t magic;
+    uint32_t size;
+    struct ring_ctl ctl[2];
+};
+
+struct shmring {
+    int role;
+    void *base;
+    size_t maplen;
+    uint32_t size;
+    struct ring_ctl *tx;
+    struct ring_ctl *rx;
+    uint8_t *txbuf;
+    uint8_t *rxbuf;
+    uint64_t tx_tail;
+    uint64_t rx_head;
+    int memfd;
+    int efd[2];
+};
+
+static uint64_t load64 (uint64_t *p)
+{
+    return __atomic_load_n (p, __ATOMIC_SEQ_CST);
+}
+
+static void store64 (uint64_t *p, uint64_t val)
+{
+    __atomic_store_n (p, val, __ATOMIC_SEQ_CST);
+}
+
+static uint32_t load32 (uint32_t *p)
+{
+    return __atomic_load_n (p, __ATOMIC_SEQ_CST);
+}
+
+static void store32 (uint32_t *p, uint32_t val)
+{
+    __atomic_store_n (p, val, __ATOMIC_SEQ_CST);
+}
+
+static size_t data_offset (void)
+{
+    size_t pagesize = sysconf (_SC_PAGESIZE);
+
+    return ((sizeof (struct shmring_hdr) + pagesize - 1) / pagesize)
+           * pagesize;
+}
+
+static struct shmring *ring_alloc (int role)
+{
+    struct shmring *ring;
+
+    if (!(ring = calloc (1, sizeof (*ring))))
+        return NULL;
+    ring->role = role;
+    ring->base = MAP_FAILED;
+    ring->memfd = -1;
+    ring->efd[0] = ring->efd[1] = -1;
+    return ring;
+}
+
+/* Map 'maplen' bytes of ring->memfd and point the ring at its half.
+ */
+static int ring_map (struct shmring *ring, size_t maplen)
+{
+    uint8_t *data;
+
+    ring->base = mmap (NULL,
+                       maplen,
+                       PROT_READ | PROT_WRITE,
+                       MAP_SHARED,
+                       ring->memfd,
+                       0);
+    if (ring->base == MAP_FAILED)
+        return -1;
+    ring->maplen = maplen;
+    data = (uint8_t *)ring->base + data_offset ();
+    ring->tx = &((struct shmring_hdr *)ring->base)->ctl[ring->role];
+    ring->rx = &((struct shmring_hdr *)ring->base)->ctl[!ring->role];
+    ring->txbuf = data + ring->role * ring->size;
+    ring->rxbuf = data + !ring->role * ring->size;
+    return 0;
+}
+
+void shmring_destroy (struct shmring *ring)
+{
+    if (ring) {
+        int saved_errno = errno;
+        if (ring->base != MAP_FAILED)
+            (void)munmap (ring->base, ring->maplen);
+        if (ring->memfd >= 0)
+            (void)close (ring->memfd);
+        if (ring->efd[0] >= 0)
+            (void)close (ring->efd[0]);
+        if (ring->efd[1] >= 0)
+            (void)close (ring->efd[1]);
+        free (ring);
+        errno = saved_errno;
+    }
+}
+
+/* Create an anonymous file of 'len' bytes, sealed against resizing.
+ */
+static int memfd_open (size_t len)
+{
+#if HAVE_MEMFD_CREATE
+    int fd;
+
+    if ((fd = memfd_create ("flux-shmring",
+                            MFD_CLOEXEC | MFD_ALLOW_SEALING)) < 0)
+        return -1;
+    if (ftruncate (fd, len) < 0
+        || fcntl (fd,
+                  F_ADD_SEALS,
+                  F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0) {
+        ERRNO_SAFE_WRAP (close, fd);
+        return -1;
+    }
+    return fd;
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+struct shmring *shmring_create (size_t size)
+{
+    struct shmring *ring;
+    struct shmring_hdr *hdr;
+    size_t maplen;
+    uint32_t n = SHMRING_SIZE_MIN;
+
+    while (n < size && n < SHMRING_SIZE_MAX)
+        n *= 2;
+    maplen = data_offset () + 2 * (size_t)n;
+
+    if (!(ring = ring_alloc (SHMRING_SERVER)))
+        return NULL;
+    ring->size = n;
+    if ((ring->memfd = memfd_open (maplen)) < 0)
+        goto error;
+    if (ring_map (ring, maplen) < 0)
+        goto error;
+    hdr = ring->base;
+    hdr->magic = SHMRING_MAGIC;
+    hdr->size = n;
+    if ((ring->efd[0] = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0
+        || (ring->efd[1] = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0)
+        goto error;
+    return ring;
+error:
+    shmring_destroy (ring);
+    return NULL;
+}
+
+struct shmring *shmring_attach (int fds[SHMRING_NFDS])
+{
+    struct shmring *ring;
+    struct shmring_hdr *hdr;
+    struct stat sb;
+    uint32_t size;
+
+    if (!(ring = ring_alloc (SHMRING_CLIENT))) {
+        for (int i = 0; i < SHMRING_NFDS; i++)
+            ERRNO_SAFE_WRAP (close, fds[i]);
+        return NULL;
+    }
+    ring->memfd = fds[0];
+    ring->efd[0] = fds[1];
+    ring->efd[1] = fds[2];
+    if (fstat (ring->memfd, &sb) < 0)
+        goto error;
+    if (sb.st_size < data_offset ()) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (ring_map (ring, sb.st_size) < 0)
+        goto error;
+    hdr = ring->base;
+    size = hdr->size;
+    if (hdr->magic != SHMRING_MAGIC
+        || size < SHMRING_SIZE_MIN
+        || size > SHMRING_SIZE_MAX
+        || (size & (size - 1)) != 0
+        || data_offset () + 2 * (size_t)size > sb.st_size) {
+        errno = EPROTO;
+        goto error;
+    }
+    /* Now that the ring size is known, point at the ring data.
+     */
+    ring->size = size;
+    ring->txbuf = (uint8_t *)ring->base + data_offset () + size;
+    ring->rxbuf = (uint8_t *)ring->base + data_offset ();
+    (void)close (ring->memfd);
+    ring->memfd = -1;
+    return ring;
+error:
+    shmring_destroy (ring);
+    return NULL;
+}
+
+int shmring_get_fds (struct shmring *ring, int fds[SHMRING_NFDS])
+{
+    if (!ring || ring->memfd < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    fds[0] = ring->memfd;
+    fds[1] = ring->efd[0];
+    fds[2] = ring->efd[1];
+    return 0;
+}
+
+int shmring_pollfd (struct shmring *ring)
+{
+    return ring ? ring->efd[ring->role] : -1;
+}
+
+void shmring_clear (struct shmring *ring)
+{
+    uint64_t val;
+
+    if (ring)
+        (void)read (ring->efd[ring->role], &val, sizeof (val));
+}
+
+static void ring_notify (struct shmring *ring, int role)
+{
+    uint64_t one = 1;
+
+    (void)write (ring->efd[role], &one, sizeof (one));
+}
+
+bool shmring_readable (struct shmring *ring)
+{
+    return ring && load64 (&ring->rx->tail) != ring->rx_head;
+}
+
+int shmring_send_batch (struct shmring *ring, struct iobuf_batch *batch)
+{
+    size_t pending;
+
+    if (!ring || !batch) {
+        errno = EINVAL;
+        return -1;
+    }
+    while ((pending = iobuf_batch_pending (batch)) > 0) {
+        uint64_t used = ring->tx_tail - load64 (&ring->tx->head);
+        uint64_t tail = ring->tx_tail;
+        size_t off = tail & (ring->size - 1);
+        size_t n;
+
+        if (used > ring->size) {
+            errno = EPROTO;
+            return -1;
+        }
+        if (used == ring->size) {
+            store32 (&ring->tx->waiting, 1);
+            if (ring->tx_tail - load64 (&ring->tx->head) == ring->size) {
+                errno = EWOULDBLOCK;
+                return -1;
+            }
+            store32 (&ring->tx->waiting, 0);
+            continue;
+        }
+        n = ring->size - used;
+        if (n > pending)
+            n = pending;
+        if (n > ring->size - off) {
+            memcpy (ring->txbuf + off, batch->buf + batch->head,
+                    ring->size - off);
+            memcpy (ring->txbuf, batch->buf + batch->head + ring->size - off,
+                    n - (ring->size - off));
+        }
+        else
+            memcpy (ring->txbuf + off, batch->buf + batch->head, n);
+        ring->tx_tail += n;
+        store64 (&ring->tx->tail, ring->tx_tail);
+        if (load64 (&ring->tx->head) == tail)
+            ring_notify (ring, !ring->role);
+        iobuf_batch_consume (batch, n);
+    }
+    return 0;
+}
+
+int shmring_recv_batch (struct shmring *ring, struct iobuf_batch *batch)
+{
+    uint64_t avail;
+    size_t total = 0;
+    size_t off;
+
+    if (!ring || !batch) {
+        errno = EINVAL;
+        return -1;
+    }
+    /* Take what is in the ring until it is seen empty after 'head' is
+     * published (see Wakeups above).  Stop after a ring's worth so a busy
+     * producer can't hold the caller here, and signal our own doorbell
+     * so the caller comes back for the rest.
+     */
+    while ((avail = load64 (&ring->rx->tail) - ring->rx_head) > 0) {
+        if (avail > ring->size) {
+            errno = EPROTO;
+            return -1;
+        }
+        if (total >= ring->size) {
+            ring_notify (ring, ring->role);
+            break;
+        }
+        if (iobuf_batch_reserve (batch, avail) < 0)
+            return -1;
+        off = ring->rx_head & (ring->size - 1);
+        if (avail > ring->size - off) {
+            memcpy (batch->buf + batch->tail, ring->rxbuf + off,
+                    ring->size - off);
+            memcpy (batch->buf + batch->tail + ring->size - off, ring->rxbuf,
+                    avail - (ring->size - off));
+        }
+        else
+            memcpy (batch->buf + batch->tail, ring->rxbuf + off, avail);
+        batch->tail += avail;
+        ring->rx_head += avail;
+        total += avail;
+        store64 (&ring->rx->head, ring->rx_head);
+        if (load32 (&ring->rx->waiting)) {
+            store32 (&ring->rx->waiting, 0);
+            ring_notify (ring, !ring->role);
+        }
+    }
+    if (total == 0) {
+        errno = EWOULDBLOCK;
+        return -1;
+    }
+    return 0;
+}
+
+/* Wait for fd to become ready for 'events'.
+ */
+static int wait_fd (int fd, int events)
+{
+    struct pollfd pfd = { .fd = fd, .events = events, .revents = 0 };
+
+    if (poll (&pfd, 1, -1) < 0)
+        return -1;
+    if ((pfd.revents & (POLLERR | POLLNVAL))) {
+        errno = EIO;
+        return -1;
+    }
+    return 0;
+}
+
+int shmring_send_hello (int fd, size_t size)
+{
+    uint32_t hdr[2] = { SHMRING_HELLO_MAGIC, htonl (size) };
+    size_t done = 0;
+    ssize_t n;
+
+    while (done < sizeof (hdr)) {
+        if ((n = write (fd, (char *)hdr + done, sizeof (hdr) - done)) < 0) {
+            if (errno != EWOULDBLOCK && errno != EAGAIN)
+                return -1;
+            if (wait_fd (fd, POLLOUT) < 0)
+                return -1;
+            continue;
+        }
+        done += n;
+    }
+    return 0;
+}
+
+int shmring_check_hello (struct iobuf_batch *batch, size_t *size)
+{
+    uint32_t hdr[2];
+
+    if (iobuf_batch_pending (batch) < sizeof (hdr)) {
+        errno = EWOULDBLOCK;
+        return -1;
+    }
+    memcpy (hdr, batch->buf + batch->head, sizeof (hdr));
+    if (hdr[0] != SHMRING_HELLO_MAGIC)
+        return 0;
+    *size = ntohl (hdr[1]);
+    if (*size > SHMRING_SIZE_MAX)
+        *size = SHMRING_SIZE_MAX;
+    iobuf_batch_consume (batch, sizeof (hdr));
+    return 1;
+}
+
+int shmring_send_ack (int fd, struct shmring *ring, int errnum)
+{
+    uint32_t hdr[2] = { SHMRING_ACK_MAGIC, htonl (errnum) };
+    struct iovec iov = { .iov_base = hdr, .iov_len = sizeof (hdr) };
+    union {
+        char buf[CMSG_SPACE (sizeof (int) * SHMRING_NFDS)];
+        struct cmsghdr align;
+    } cbuf;
+    struct msghdr msg;
+    int fds[SHMRING_NFDS];
+
+    memset (&msg, 0, sizeof (msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (errnum == 0) {
+        struct cmsghdr *cmsg;
+
+        if (shmring_get_fds (ring, fds) < 0)
+            return -1;
+        memset (&cbuf, 0, sizeof (cbuf));
+        msg.msg_control = cbuf.buf;
+        msg.msg_controllen = sizeof (cbuf.buf);
+        cmsg = CMSG_FIRSTHDR (&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN (sizeof (fds));
+        memcpy (CMSG_DATA (cmsg), fds, sizeof (fds));
+    }
+    /* The socket buffer is empty at this point in the protocol,
+     * so a short write is treated as an error.
+     */
+    if (sendmsg (fd, &msg, MSG_NOSIGNAL) != sizeof (hdr)) {
+        if (errno == EWOULDBLOCK || errno == EAGAIN)
+            errno = EPROTO;
+        return -1;
+    }
+    if (errnum == 0) {
+        (void)close (ring->memfd);
+        ring->memfd = -1;
+    }
+    return 0;
+}
+
+struct shmring *shmring_recv_ack (int fd)
+{
+    uint32_t hdr[2];
+    struct iovec iov = { .iov_base = hdr, .iov_len = sizeof (hdr) };
+    union {
+        char buf[CMSG_SPACE (sizeof (int) * SHMRING_NFDS)];
+        struct cmsghdr align;
+    } cbuf;
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    int fds[SHMRING_NFDS];
+    int nfds = 0;
+    ssize_t n;
+
+    memset (&msg, 0, sizeof (msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cbuf.buf;
+    msg.msg_controllen = sizeof (cbuf.buf);
+    while ((n = recvmsg (fd, &msg, MSG_CMSG_CLOEXEC)) < 0) {
+        if (errno != EWOULDBLOCK && errno != EAGAIN)
+            return NULL;
+        if (wait_fd (fd, POLLIN) < 0)
+            return NULL;
+    }
+    for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            int count = (cmsg->cmsg_len - CMSG_LEN (0)) / sizeof (int);
+            int *data = (int *)CMSG_DATA (cmsg);
+            for (int i = 0; i < count; i++) {
+                if (nfds < SHMRING_NFDS)
+                    fds[nfds++] = data[i];
+                else
+                    (void)close (data[i]);
+            }
+        }
+    }
+    if (n == 0) {
+        errno = ECONNRESET;
+        goto error;
+    }
+    if (n != sizeof (hdr) || hdr[0] != SHMRING_ACK_MAGIC) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (ntohl (hdr[1]) != 0) {
+        errno = ntohl (hdr[1]);
+        goto error;
+    }
+    if (nfds != SHMRING_NFDS) {
+        errno = EPROTO;
+        goto error;
+    }
+    return shmring_attach (fds);
+error:
+    for (int i = 0; i < nfds; i++)
+        ERRNO_SAFE_WRAP (close, fds[i]);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,98 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _ROUTER_SHMRING_H
+#define _ROUTER_SHMRING_H
+
+#include <stdbool.h>
+
+#include "sendfd.h"
+
+/* Shared memory transport between a usock server and a local client.
+ *
+ * A shared memory segment holds two single-producer, single-consumer
+ * byte rings, one per direction, carrying messages in the sendfd
+ * encoding.  Each end has an eventfd "doorbell" that the peer signals
+ * when it adds data to an empty ring or frees space in a ring that the
+ * owner of the doorbell found full.
+ *
+ * The server creates the segment and both eventfds and passes them to
+ * the client over the unix domain socket.  The segment is sealed so
+ * the client cannot resize it.  Ring indices written by the peer are
+ * validated before use.
+ */
+
+enum {
+    SHMRING_SERVER = 0,
+    SHMRING_CLIENT = 1,
+};
+
+#define SHMRING_NFDS 3
+
+struct shmring;
+
+/* Create the server end with rings of at least 'size' bytes,
+ * up to a limit of 1MB.  Fails with ENOSYS if memfd_create(2)
+ * is not available.
+ */
+struct shmring *shmring_create (size_t size);
+
+/* Attach the client end to fds received from the server.
+ * The fds are consumed, even on failure.
+ */
+struct shmring *shmring_attach (int fds[SHMRING_NFDS]);
+
+void shmring_destroy (struct shmring *ring);
+
+/* Get the fds to be passed to the client (server end only).
+ */
+int shmring_get_fds (struct shmring *ring, int fds[SHMRING_NFDS]);
+
+/* Get the doorbell eventfd for this end, which becomes readable when the
+ * peer has signaled it.  Call shmring_clear() after wakeup.
+ */
+int shmring_pollfd (struct shmring *ring);
+void shmring_clear (struct shmring *ring);
+
+/* Return true if data is waiting in the receive ring.
+ */
+bool shmring_readable (struct shmring *ring);
+
+/* Copy as much of batch as fits into the send ring.
+ * Returns 0 if batch was completely sent, -1 on failure with errno set
+ * (EWOULDBLOCK if the ring is full - the doorbell is signaled when the
+ * peer frees space).
+ */
+int shmring_send_batch (struct shmring *ring, struct iobuf_batch *batch);
+
+/* Move data in the receive ring to batch, until the ring is seen empty
+ * or up to a ring's worth has been moved.  In the latter case, the
+ * doorbell is signaled so the caller is woken to continue.
+ * Returns 0 on success, -1 on failure with errno set (EWOULDBLOCK if
+ * the ring is empty).
+ */
+int shmring_recv_batch (struct shmring *ring, struct iobuf_batch *batch);
+
+/* Negotiation over the usock connection, after the auth byte.
+ * The client sends a hello frame in place of its first message.  The
+ * server replies with an ack frame carrying an errno value, and if zero,
+ * the ring fds as SCM_RIGHTS.  shmring_check_hello() caps the size
+ * requested by the client to the largest size shmring_create() allows.
+ */
+int shmring_send_hello (int fd, size_t size);
+int shmring_check_hello (struct iobuf_batch *batch, size_t *size);
+int shmring_send_ack (int fd, struct shmring *ring, int errnum);
+struct shmring *shmring_recv_ack (int fd);
+
+#endif /* !_ROUTER_SHMRING_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -292,6 +292,117 @@ next:
     free (buf);
 }
 
+/* Send many messages, some larger than the batch buffer, through a
+ * non-blocking pipe with sendfd_batch() and recvfd_batch().
+ */
+void test_batch (int count)
+{
+    int pfd[2];
+    struct iobuf_batch out;
+    struct iobuf_batch in;
+    char *big;
+    int sent = 0;
+    int recvd = 0;
+    int errors = 0;
+
+    if (pipe2 (pfd, O_CLOEXEC) < 0)
+        BAIL_OUT ("pipe2 failed");
+    if (fd_set_nonblocking (pfd[0]) < 0 || fd_set_nonblocking (pfd[1]) < 0)
+        BAIL_OUT ("fd_set_nonblocking failed");
+    if (!(big = malloc (65536)))
+        BAIL_OUT ("malloc failed");
+    memset (big, 0x0f, 65536);
+    iobuf_batch_init (&out);
+    iobuf_batch_init (&in);
+
+    while (recvd < count) {
+        flux_msg_t *msg;
+
+        while (sent < count && iobuf_batch_pending (&out) < 16384) {
+            int len = sent % 10 == 0 ? 65536 : 0;
+            if (!(msg = flux_request_encode_raw ("foo.bar",
+                                                 len > 0 ? big : NULL,
+                                                 len))
+                || flux_msg_set_matchtag (msg, sent) < 0)
+                BAIL_OUT ("flux_request_encode failed");
+            if (iobuf_batch_put (&out, msg) < 0)
+                BAIL_OUT ("iobuf_batch_put failed");
+            flux_msg_destroy (msg);
+            sent++;
+        }
+        if (sendfd_batch (pfd[1], &out) < 0 && errno != EAGAIN)
+            BAIL_OUT ("sendfd_batch failed: %s", strerror (errno));
+        if (recvfd_batch (pfd[0], &in) < 0 && errno != EAGAIN)
+            BAIL_OUT ("recvfd_batch failed: %s", strerror (errno));
+        while ((msg = iobuf_batch_get (&in))) {
+            uint32_t matchtag;
+            if (flux_msg_get_matchtag (msg, &matchtag) < 0
+                || matchtag != recvd)
+                errors++;
+            flux_msg_destroy (msg);
+            recvd++;
+        }
+        if (errno != EWOULDBLOCK)
+            BAIL_OUT ("iobuf_batch_get failed: %s", strerror (errno));
+    }
+    ok (recvd == count && errors == 0,
+        "batch: received %d messages in order", count);
+    ok (iobuf_batch_pending (&out) == 0 && iobuf_batch_pending (&in) == 0,
+        "batch: buffers are empty");
+
+    close (pfd[1]);
+    errno = 0;
+    ok (recvfd_batch (pfd[0], &in) < 0 && errno == ECONNRESET,
+        "recvfd_batch fails with ECONNRESET when sender closes pipe");
+
+    iobuf_batch_clean (&out);
+    iobuf_batch_clean (&in);
+    close (pfd[0]);
+    free (big);
+}
+
+/* Batch and single message interfaces use the same encoding.
+ */
+void test_batch_compat (void)
+{
+    int pfd[2];
+    struct iobuf_batch batch;
+    flux_msg_t *msg, *msg2;
+    const char *topic;
+
+    if (pipe2 (pfd, O_CLOEXEC) < 0)
+        BAIL_OUT ("pipe2 failed");
+    if (!(msg = flux_request_encode ("foo.bar", NULL)))
+        BAIL_OUT ("flux_request_encode failed");
+    iobuf_batch_init (&batch);
+
+    ok (iobuf_batch_put (&batch, msg) == 0
+        && sendfd_batch (pfd[1], &batch) == 0,
+        "sendfd_batch works");
+    ok ((msg2 = recvfd (pfd[0], NULL)) != NULL
+        && flux_request_decode (msg2, &topic, NULL) == 0
+        && !strcmp (topic, "foo.bar"),
+        "recvfd received message sent with sendfd_batch");
+    flux_msg_destroy (msg2);
+
+    ok (sendfd (pfd[1], msg, NULL) == 0,
+        "sendfd works");
+    ok (recvfd_batch (pfd[0], &batch) == 0
+        && (msg2 = iobuf_batch_get (&batch)) != NULL
+        && flux_request_decode (msg2, &topic, NULL) == 0
+        && !strcmp (topic, "foo.bar"),
+        "iobuf_batch_get decoded message sent with sendfd");
+    flux_msg_destroy (msg2);
+    errno = 0;
+    ok (iobuf_batch_get (&batch) == NULL && errno == EWOULDBLOCK,
+        "iobuf_batch_get fails with EWOULDBLOCK when batch is empty");
+
+    iobuf_batch_clean (&batch);
+    flux_msg_destroy (msg);
+    close (pfd[1]);
+    close (pfd[0]);
+}
+
 void test_inval (void)
 {
     flux_msg_t *msg;
@@ -310,6 +421,16 @@ void test_inval (void)
     ok (sendfd (0, NULL, NULL) < 0 && errno == EINVAL,
         "senfd msg=NULL fails with EINVAL");
 
+    errno = 0;
+    ok (sendfd_batch (-1, NULL) < 0 && errno == EINVAL,
+        "sendfd_batch fd=-1 fails with EINVAL");
+    errno = 0;
+    ok (recvfd_batch (-1, NULL) < 0 && errno == EINVAL,
+        "recvfd_batch fd=-1 fails with EINVAL");
+    errno = 0;
+    ok (iobuf_batch_put (NULL, msg) < 0 && errno == EINVAL,
+        "iobuf_batch_put batch=NULL fails with EINVAL");
+
     flux_msg_destroy (msg);
 }
 
@@ -324,6 +445,8 @@ int main (int argc, char *argv[])
     test_nonblock (4096, 256);
     test_nonblock (16384, 64);
     test_nonblock (1048586, 1);
+    test_batch (1000);
+    test_batch_compat ();
     test_inval ();
 
     done_testing();
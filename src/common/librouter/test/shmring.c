@@ -0,0 +1,390 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <string.h>
+#include <errno.h>
+#include <flux/core.h>
+
+#include "src/common/librouter/sendfd.h"
+#include "src/common/librouter/shmring.h"
+#include "src/common/libtap/tap.h"
+
+static bool fd_is_readable (int fd)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+    return poll (&pfd, 1, 0) == 1 && (pfd.revents & POLLIN);
+}
+
+/* Create a server end and attach a client end to copies of its fds.
+ */
+static void create_pair (size_t size,
+                         struct shmring **server,
+                         struct shmring **client)
+{
+    int fds[SHMRING_NFDS];
+
+    if (!(*server = shmring_create (size)))
+        BAIL_OUT ("shmring_create failed: %s", strerror (errno));
+    if (shmring_get_fds (*server, fds) < 0)
+        BAIL_OUT ("shmring_get_fds failed");
+    for (int i = 0; i < SHMRING_NFDS; i++) {
+        if ((fds[i] = fcntl (fds[i], F_DUPFD_CLOEXEC, 0)) < 0)
+            BAIL_OUT ("dup failed");
+    }
+    if (!(*client = shmring_attach (fds)))
+        BAIL_OUT ("shmring_attach failed: %s", strerror (errno));
+}
+
+/* Stream 'count' messages of 'size' bytes from one end to the other,
+ * alternating between the two ends when the ring fills.
+ */
+static void test_stream (struct shmring *tx,
+                         struct shmring *rx,
+                         int size,
+                         int count)
+{
+    struct iobuf_batch out;
+    struct iobuf_batch in;
+    char *buf;
+    int sent = 0;
+    int recvd = 0;
+    int errors = 0;
+    int full = 0;
+
+    if (!(buf = malloc (size)))
+        BAIL_OUT ("malloc failed");
+    memset (buf, 0x5a, size);
+    iobuf_batch_init (&out);
+    iobuf_batch_init (&in);
+
+    while (recvd < count) {
+        flux_msg_t *msg;
+
+        if (sent < count && iobuf_batch_pending (&out) == 0) {
+            if (!(msg = flux_request_encode_raw ("a", buf, size))
+                || flux_msg_set_matchtag (msg, sent) < 0
+                || iobuf_batch_put (&out, msg) < 0)
+                BAIL_OUT ("error encoding message");
+            flux_msg_destroy (msg);
+            sent++;
+        }
+        if (shmring_send_batch (tx, &out) < 0) {
+            if (errno != EWOULDBLOCK)
+                BAIL_OUT ("shmring_send_batch: %s", strerror (errno));
+            full++;
+        }
+        if (shmring_recv_batch (rx, &in) < 0 && errno != EWOULDBLOCK)
+            BAIL_OUT ("shmring_recv_batch: %s", strerror (errno));
+        while ((msg = iobuf_batch_get (&in))) {
+            uint32_t matchtag;
+            if (flux_msg_get_matchtag (msg, &matchtag) < 0
+                || matchtag != recvd)
+                errors++;
+            flux_msg_destroy (msg);
+            recvd++;
+        }
+        if (errno != EWOULDBLOCK)
+            BAIL_OUT ("iobuf_batch_get: %s", strerror (errno));
+    }
+    ok (recvd == count && errors == 0,
+        "received %d messages of size %d in order", count, size);
+    if (size > 65536)
+        ok (full > 0,
+            "sender found ring full %d times", full);
+
+    iobuf_batch_clean (&out);
+    iobuf_batch_clean (&in);
+    free (buf);
+}
+
+static void test_basic (void)
+{
+    struct shmring *server;
+    struct shmring *client;
+
+    create_pair (0, &server, &client);
+
+    ok (shmring_readable (server) == false
+        && shmring_readable (client) == false,
+        "new rings are empty");
+
+    test_stream (client, server, 100, 1000);
+    test_stream (server, client, 100, 1000);
+    test_stream (client, server, 1024*1024, 4);
+    test_stream (server, client, 1024*1024, 4);
+
+    shmring_destroy (client);
+    shmring_destroy (server);
+}
+
+/* Check that the doorbell is signaled when data is added to an empty
+ * ring, and when space is freed in a ring the sender found full.
+ */
+static void test_doorbell (void)
+{
+    struct shmring *server;
+    struct shmring *client;
+    struct iobuf_batch out;
+    struct iobuf_batch in;
+    flux_msg_t *msg;
+
+    create_pair (0, &server, &client);
+    iobuf_batch_init (&out);
+    iobuf_batch_init (&in);
+
+    if (!(msg = flux_request_encode ("a", NULL)))
+        BAIL_OUT ("flux_request_encode failed");
+
+    ok (!fd_is_readable (shmring_pollfd (server))
+        && !fd_is_readable (shmring_pollfd (client)),
+        "doorbells are not signaled initially");
+    if (iobuf_batch_put (&out, msg) < 0)
+        BAIL_OUT ("iobuf_batch_put failed");
+    ok (shmring_send_batch (client, &out) == 0,
+        "client sent a message");
+    ok (fd_is_readable (shmring_pollfd (server)),
+        "server doorbell was signaled");
+    ok (shmring_readable (server) == true,
+        "server ring is readable");
+    shmring_clear (server);
+    ok (!fd_is_readable (shmring_pollfd (server)),
+        "shmring_clear reset the server doorbell");
+
+    /* Fill the ring.
+     */
+    while (iobuf_batch_pending (&out) < 2*65536) {
+        if (iobuf_batch_put (&out, msg) < 0)
+            BAIL_OUT ("iobuf_batch_put failed");
+    }
+    errno = 0;
+    ok (shmring_send_batch (client, &out) < 0 && errno == EWOULDBLOCK,
+        "shmring_send_batch fails with EWOULDBLOCK when ring is full");
+    ok (!fd_is_readable (shmring_pollfd (server)),
+        "server doorbell was not signaled for data added to non-empty ring");
+    ok (shmring_recv_batch (server, &in) == 0,
+        "server received data");
+    ok (fd_is_readable (shmring_pollfd (client)),
+        "client doorbell was signaled when space was freed");
+    errno = 0;
+    ok (shmring_recv_batch (server, &in) < 0 && errno == EWOULDBLOCK,
+        "shmring_recv_batch fails with EWOULDBLOCK when ring is empty");
+
+    flux_msg_destroy (msg);
+    iobuf_batch_clean (&out);
+    iobuf_batch_clean (&in);
+    shmring_destroy (client);
+    shmring_destroy (server);
+}
+
+struct race_ctx {
+    struct shmring *tx;
+    int rounds;
+    size_t size;
+    size_t consumed;
+};
+
+/* Each round, send a large write and then a small one after a varying
+ * delay, so the second often lands while the consumer is copying the
+ * first: after it loaded 'tail' but before it stored 'head'.  The
+ * producer doesn't ring the doorbell for it, and sends nothing more
+ * until the consumer has taken both.
+ */
+static void *race_producer (void *arg)
+{
+    struct race_ctx *ctx = arg;
+    struct iobuf_batch out;
+
+    iobuf_batch_init (&out);
+    for (int i = 0; i < ctx->rounds; i++) {
+        size_t sizes[2] = { ctx->size, 8 };
+
+        for (int j = 0; j < 2; j++) {
+            if (iobuf_batch_reserve (&out, sizes[j]) < 0)
+                BAIL_OUT ("iobuf_batch_reserve failed");
+            memset (out.buf + out.tail, 0x5a, sizes[j]);
+            out.tail += sizes[j];
+            if (shmring_send_batch (ctx->tx, &out) < 0)
+                BAIL_OUT ("shmring_send_batch: %s", strerror (errno));
+            for (volatile int k = 0; k < (i % 512) * 100; k++)
+                ;
+        }
+        while (__atomic_load_n (&ctx->consumed, __ATOMIC_SEQ_CST)
+               < (i + 1) * (ctx->size + 8))
+            ;
+    }
+    iobuf_batch_clean (&out);
+    return NULL;
+}
+
+/* The consumer only receives when its doorbell is signaled, as usock
+ * does, so data left in the ring without a wakeup stalls it.
+ */
+static void test_wakeup_race (void)
+{
+    struct shmring *server;
+    struct shmring *client;
+    struct race_ctx ctx = { .rounds = 10000, .size = 32768 };
+    struct iobuf_batch in;
+    size_t total = ctx.rounds * (ctx.size + 8);
+    size_t received = 0;
+    pthread_t t;
+
+    create_pair (0, &server, &client);
+    iobuf_batch_init (&in);
+    ctx.tx = client;
+    if (pthread_create (&t, NULL, race_producer, &ctx) != 0)
+        BAIL_OUT ("pthread_create failed");
+    while (received < total) {
+        struct pollfd pfd = {
+            .fd = shmring_pollfd (server),
+            .events = POLLIN,
+        };
+        if (poll (&pfd, 1, 10000) != 1)
+            break;
+        shmring_clear (server);
+        if (shmring_recv_batch (server, &in) < 0 && errno != EWOULDBLOCK)
+            BAIL_OUT ("shmring_recv_batch: %s", strerror (errno));
+        received += iobuf_batch_pending (&in);
+        iobuf_batch_consume (&in, iobuf_batch_pending (&in));
+        __atomic_store_n (&ctx.consumed, received, __ATOMIC_SEQ_CST);
+    }
+    ok (received == total,
+        "consumer woken for all data over %d rounds", ctx.rounds);
+    if (received < total)
+        BAIL_OUT ("producer is stuck waiting for a lost wakeup");
+    pthread_join (t, NULL);
+
+    iobuf_batch_clean (&in);
+    shmring_destroy (client);
+    shmring_destroy (server);
+}
+
+/* Negotiate over a socketpair as usock does.
+ */
+static void test_negotiate (void)
+{
+    int sv[2];
+    struct iobuf_batch batch;
+    struct shmring *server;
+    struct shmring *client;
+    size_t size;
+    flux_msg_t *msg;
+
+    if (socketpair (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0)
+        BAIL_OUT ("socketpair failed");
+    iobuf_batch_init (&batch);
+
+    ok (shmring_send_hello (sv[0], 1024*1024) == 0,
+        "shmring_send_hello works");
+    ok (recvfd_batch (sv[1], &batch) == 0
+        && shmring_check_hello (&batch, &size) == 1
+        && size == 1024*1024,
+        "shmring_check_hello recognized hello frame");
+    ok ((server = shmring_create (size)) != NULL,
+        "shmring_create works");
+    ok (shmring_send_ack (sv[1], server, 0) == 0,
+        "shmring_send_ack works");
+    ok ((client = shmring_recv_ack (sv[0])) != NULL,
+        "shmring_recv_ack returned client end");
+    test_stream (client, server, 100, 100);
+    shmring_destroy (client);
+    shmring_destroy (server);
+
+    ok (shmring_send_hello (sv[0], 64*1024*1024) == 0
+        && recvfd_batch (sv[1], &batch) == 0
+        && shmring_check_hello (&batch, &size) == 1
+        && size == 1024*1024,
+        "shmring_check_hello caps the requested size at 1MB");
+
+    ok (shmring_send_ack (sv[1], NULL, EPERM) == 0,
+        "shmring_send_ack works with nonzero errnum");
+    errno = 0;
+    ok (shmring_recv_ack (sv[0]) == NULL && errno == EPERM,
+        "shmring_recv_ack fails with server's errnum");
+
+    if (!(msg = flux_request_encode ("a", NULL)))
+        BAIL_OUT ("flux_request_encode failed");
+    if (sendfd (sv[0], msg, NULL) < 0)
+        BAIL_OUT ("sendfd failed");
+    ok (recvfd_batch (sv[1], &batch) == 0
+        && shmring_check_hello (&batch, &size) == 0
+        && iobuf_batch_pending (&batch) > 0,
+        "shmring_check_hello returns 0 and leaves a regular message");
+    flux_msg_destroy (msg);
+
+    close (sv[1]);
+    errno = 0;
+    ok (shmring_recv_ack (sv[0]) == NULL && errno == ECONNRESET,
+        "shmring_recv_ack fails with ECONNRESET on EOF");
+    close (sv[0]);
+    iobuf_batch_clean (&batch);
+}
+
+static void test_inval (void)
+{
+    struct iobuf_batch batch;
+    int fds[SHMRING_NFDS];
+    size_t size;
+
+    iobuf_batch_init (&batch);
+
+    for (int i = 0; i < SHMRING_NFDS; i++) {
+        if ((fds[i] = open ("/dev/null", O_RDWR | O_CLOEXEC)) < 0)
+            BAIL_OUT ("open /dev/null failed");
+    }
+    ok (shmring_attach (fds) == NULL,
+        "shmring_attach fails on fds that are not a ring");
+    errno = 0;
+    ok (shmring_send_batch (NULL, &batch) < 0 && errno == EINVAL,
+        "shmring_send_batch ring=NULL fails with EINVAL");
+    errno = 0;
+    ok (shmring_recv_batch (NULL, &batch) < 0 && errno == EINVAL,
+        "shmring_recv_batch ring=NULL fails with EINVAL");
+    errno = 0;
+    ok (shmring_check_hello (&batch, &size) < 0 && errno == EWOULDBLOCK,
+        "shmring_check_hello fails with EWOULDBLOCK on empty batch");
+    ok (shmring_pollfd (NULL) < 0,
+        "shmring_pollfd ring=NULL returns -1");
+    lives_ok ({shmring_destroy (NULL);},
+        "shmring_destroy ring=NULL doesn't crash");
+
+    iobuf_batch_clean (&batch);
+}
+
+int main (int argc, char *argv[])
+{
+#if !HAVE_MEMFD_CREATE
+    plan (SKIP_ALL, "memfd_create is not available");
+#endif
+    plan (NO_PLAN);
+
+    test_basic ();
+    test_doorbell ();
+    test_wakeup_race ();
+    test_negotiate ();
+    test_inval ();
+
+    done_testing();
+    return (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -208,6 +208,111 @@ static void test_one_echo (flux_t *h)
     flux_msg_destroy (msg);
 }
 
+/* Enable shared memory, then send 'count' messages of 'size' bytes
+ * and receive them back.
+ */
+static void test_shm_echo (flux_t *h, int size, int count)
+{
+    char sockpath[PATH_MAX + 1];
+    flux_msg_t *msg;
+    flux_msg_t *rmsg;
+    int fd;
+    struct usock_client *client;
+    char *buf;
+    int errors;
+    int i;
+
+    if (!(buf = malloc (size)))
+        BAIL_OUT ("malloc failed");
+    memset (buf, 0xf0, size);
+    if (!(msg = flux_request_encode_raw ("a", buf, size)))
+        BAIL_OUT ("flux_request_encode failed");
+
+    if (snprintf (sockpath,
+                  sizeof (sockpath),
+                  "%s/server",
+                  tmpdir) >= sizeof (sockpath))
+        BAIL_OUT ("buffer overflow");
+    fd = usock_client_connect (sockpath, USOCK_RETRY_DEFAULT);
+    if (fd < 0)
+        BAIL_OUT ("usock_client_connect failed");
+    if (!(client = usock_client_create (fd)))
+        BAIL_OUT ("usock_client_create failed");
+
+    ok (usock_client_enable_shm (client, 0) == 0,
+        "usock_client_enable_shm works");
+    ok (usock_client_pollfd (client) != fd,
+        "usock_client_pollfd no longer returns the socket");
+
+    errors = 0;
+    for (i = 0; i < count; i++) {
+        if (usock_client_send (client, msg, 0) < 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "shm: sent %d messages size %d", count, size);
+    errors = 0;
+    for (i = 0; i < count; i++) {
+        if (!(rmsg = usock_client_recv (client, 0))
+            || !equal_message (msg, rmsg))
+            errors++;
+        flux_msg_destroy (rmsg);
+    }
+    ok (errors == 0,
+        "shm: %d recv messages match sent messages", count);
+    errno = 0;
+    ok (usock_client_recv (client, FLUX_O_NONBLOCK) == NULL
+        && errno == EWOULDBLOCK,
+        "shm: usock_client_recv FLUX_O_NONBLOCK fails with EWOULDBLOCK");
+
+    diag ("disconnecting");
+
+    usock_client_destroy (client);
+    (void)close (fd);
+    free (buf);
+    flux_msg_destroy (msg);
+}
+
+#if !HAVE_MEMFD_CREATE
+/* Without shared memory support, the server declines the hello
+ * and the client continues on the socket.
+ */
+static void test_shm_declined (flux_t *h)
+{
+    char sockpath[PATH_MAX + 1];
+    flux_msg_t *msg;
+    flux_msg_t *rmsg = NULL;
+    int fd;
+    struct usock_client *client;
+
+    if (!(msg = flux_request_encode ("a", NULL)))
+        BAIL_OUT ("flux_request_encode failed");
+    if (snprintf (sockpath,
+                  sizeof (sockpath),
+                  "%s/server",
+                  tmpdir) >= sizeof (sockpath))
+        BAIL_OUT ("buffer overflow");
+    fd = usock_client_connect (sockpath, USOCK_RETRY_DEFAULT);
+    if (fd < 0)
+        BAIL_OUT ("usock_client_connect failed");
+    if (!(client = usock_client_create (fd)))
+        BAIL_OUT ("usock_client_create failed");
+
+    errno = 0;
+    ok (usock_client_enable_shm (client, 0) < 0 && errno == ENOSYS,
+        "usock_client_enable_shm fails with ENOSYS");
+    ok (usock_client_send (client, msg, 0) == 0
+        && (rmsg = usock_client_recv (client, 0)) != NULL
+        && equal_message (msg, rmsg),
+        "echo still works on the socket");
+
+    usock_client_destroy (client);
+    (void)close (fd);
+    flux_msg_destroy (rmsg);
+    flux_msg_destroy (msg);
+}
+#endif
+
 struct async_ctx {
     flux_reactor_t *r;
     flux_msg_t *msg;
@@ -304,6 +409,12 @@ int main (int argc, char *argv[])
     test_async_stream (h, 4096, 256);
     test_async_stream (h, 16384, 64);
     test_async_stream (h, 1048576, 1);
+#if HAVE_MEMFD_CREATE
+    test_shm_echo (h, 1024, 1024);
+    test_shm_echo (h, 1048576, 4);
+#else
+    test_shm_declined (h);
+#endif
 
     diag ("stopping test server");
     if (test_server_stop (h) < 0)
@@ -29,8 +29,21 @@
  *
  * Sending/receiving messages from client:
  * - usock_conn_send() adds a message to a queue, starts fd (write) watcher.
+ * - When the fd is writable, queued messages are encoded into a reusable
+ *   buffer and written with one write(2), up to OUTQUEUE_BATCH_SIZE bytes.
  * - Register a receive callback to receive complete messages from client.
+ *   All complete messages from one read(2) are delivered in a single
+ *   wakeup, so the callback must not destroy the connection.
  * - Register an error callback to be notified when I/O errors occur.
+ *
+ * Shared memory:
+ * - A client may call usock_client_enable_shm() after connecting to move
+ *   message traffic to a pair of shared memory rings (see shmring.h).
+ *   The server end is created on request when the client's first frame
+ *   is a shmring hello.  The socket remains open to detect disconnect.
+ * - Messages use the same encoding, and credentials are applied the same
+ *   way as on the socket.  If the server declines, the client continues
+ *   on the socket.
  */
 
 #if HAVE_CONFIG_H
@@ -39,6 +52,7 @@
 #include <sys/un.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/epoll.h>
 #include <poll.h>
 #include <unistd.h>
 #include <errno.h>
@@ -54,9 +68,12 @@
 
 #include "usock.h"
 #include "sendfd.h"
+#include "shmring.h"
 
 #define LISTEN_BACKLOG 5
 
+#define OUTQUEUE_BATCH_SIZE 16384
+
 #ifndef UUID_STR_LEN
 #define UUID_STR_LEN 37     // defined in later libuuid headers
 #endif
@@ -74,7 +91,7 @@ struct usock_server {
 struct usock_io {
     int fd;
     flux_watcher_t *w;
-    struct iobuf iobuf;
+    struct iobuf_batch batch;
 };
 
 struct usock_conn {
@@ -99,13 +116,22 @@ struct usock_conn {
     struct usock_server *server;
     int refcount;
 
+    struct shmring *ring;
+    flux_watcher_t *ring_w;
+
     unsigned char enable_close_on_destroy:1;
+    unsigned char negotiate:1;
 };
 
 struct usock_client {
     int fd;
     struct iobuf in_iobuf;
     struct iobuf out_iobuf;
+
+    struct shmring *ring;
+    int epfd;
+    struct iobuf_batch in_batch;
+    struct iobuf_batch out_batch;
 };
 
 const struct flux_msg_cred *usock_conn_get_cred (struct usock_conn *conn)
@@ -195,6 +221,132 @@ int usock_conn_send (struct usock_conn *conn, const flux_msg_t *msg)
     return 0;
 }
 
+/* Deliver all complete messages in the input buffer.
+ */
+static int conn_deliver (struct usock_conn *conn)
+{
+    flux_msg_t *msg;
+
+    while ((msg = iobuf_batch_get (&conn->in.batch))) {
+        /* Update message credentials based on connected creds.
+         */
+        if (auth_init_message (msg, &conn->cred) < 0) {
+            ERRNO_SAFE_WRAP (flux_msg_destroy, msg);
+            return -1;
+        }
+        if (conn->recv_cb)
+            conn->recv_cb (conn, msg, conn->recv_arg);
+        flux_msg_destroy (msg);
+    }
+    if (errno != EWOULDBLOCK)
+        return -1;
+    return 0;
+}
+
+static void conn_write_cb (flux_reactor_t *r,
+                           flux_watcher_t *w,
+                           int revents,
+                           void *arg);
+
+/* Client has signaled the doorbell: it added messages to the ring,
+ * or freed space in a ring that conn_write_cb() found full.
+ * shmring_recv_batch() takes messages until it sees the ring empty,
+ * or signals the doorbell again if it stops early, so messages the
+ * client adds meanwhile are not left without a wakeup.
+ */
+static void conn_ring_cb (flux_reactor_t *r,
+                          flux_watcher_t *w,
+                          int revents,
+                          void *arg)
+{
+    struct usock_conn *conn = arg;
+
+    shmring_clear (conn->ring);
+    if (shmring_recv_batch (conn->ring, &conn->in.batch) < 0) {
+        if (errno != EWOULDBLOCK)
+            goto error;
+    }
+    if (conn_deliver (conn) < 0)
+        goto error;
+    if (zlist_size (conn->outqueue) > 0
+        || iobuf_batch_pending (&conn->out.batch) > 0)
+        flux_watcher_start (conn->out.w);
+    return;
+error:
+    conn_io_error (conn, errno);
+}
+
+/* Switch output to the ring.  The output watcher is re-created on the
+ * doorbell eventfd, which is always writable, so it runs whenever
+ * output is queued.  It is stopped while the ring is full.
+ */
+static int conn_enable_shm (struct usock_conn *conn,
+                            flux_reactor_t *r,
+                            struct shmring *ring)
+{
+    flux_watcher_t *ring_w;
+    flux_watcher_t *out_w;
+
+    if (!(ring_w = flux_fd_watcher_create (r,
+                                           shmring_pollfd (ring),
+                                           FLUX_POLLIN,
+                                           conn_ring_cb,
+                                           conn)))
+        return -1;
+    if (!(out_w = flux_fd_watcher_create (r,
+                                          shmring_pollfd (ring),
+                                          FLUX_POLLOUT,
+                                          conn_write_cb,
+                                          conn))) {
+        flux_watcher_destroy (ring_w);
+        return -1;
+    }
+    if (shmring_send_ack (conn->out.fd, ring, 0) < 0) {
+        ERRNO_SAFE_WRAP (flux_watcher_destroy, out_w);
+        ERRNO_SAFE_WRAP (flux_watcher_destroy, ring_w);
+        return -1;
+    }
+    flux_watcher_destroy (conn->out.w);
+    conn->out.w = out_w;
+    conn->ring_w = ring_w;
+    conn->ring = ring;
+    flux_watcher_start (conn->ring_w);
+    return 0;
+}
+
+/* If the client's first frame is a shmring hello, set up shared memory
+ * and reply.  Returns 0 when negotiation is complete, or -1 with errno
+ * set (EWOULDBLOCK if the first frame has not been fully received).
+ */
+static int conn_negotiate (struct usock_conn *conn, flux_reactor_t *r)
+{
+    struct shmring *ring;
+    size_t size;
+    int rc;
+
+    if ((rc = shmring_check_hello (&conn->in.batch, &size)) < 0)
+        return -1;
+    conn->negotiate = 0;
+    if (rc == 0)
+        return 0;
+    /* The client sends nothing else until it gets the ack,
+     * so there should be nothing in flight in either direction.
+     */
+    if (iobuf_batch_pending (&conn->in.batch) > 0
+        || iobuf_batch_pending (&conn->out.batch) > 0
+        || zlist_size (conn->outqueue) > 0) {
+        errno = EPROTO;
+        return -1;
+    }
+    if (!(ring = shmring_create (size)))
+        return shmring_send_ack (conn->out.fd, NULL, errno);
+    if (conn_enable_shm (conn, r, ring) < 0) {
+        shmring_destroy (ring);
+        return shmring_send_ack (conn->out.fd, NULL, errno);
+    }
+    return 0;
+}
+
 static void conn_read_cb (flux_reactor_t *r,
                           flux_watcher_t *w,
                           int revents,
@@ -207,22 +359,17 @@ static void conn_read_cb (flux_reactor_t *r,
         goto error;
     }
     if ((revents & FLUX_POLLIN)) {
-        flux_msg_t *msg;
-
-        if (!(msg = recvfd (conn->in.fd, &conn->in.iobuf))) {
+        if (recvfd_batch (conn->in.fd, &conn->in.batch) < 0) {
             if (errno != EWOULDBLOCK && errno != EAGAIN)
                 goto error;
         }
-        else {
-            /* Update message credentials based on connected creds.
-             */
-            if (auth_init_message (msg, &conn->cred) < 0)
+        if (conn->negotiate && conn_negotiate (conn, r) < 0) {
+            if (errno != EWOULDBLOCK)
                 goto error;
-
-            if (conn->recv_cb)
-                conn->recv_cb (conn, msg, conn->recv_arg);
-            flux_msg_destroy (msg);
+            return;
         }
+        if (conn_deliver (conn) < 0)
+            goto error;
     }
     return;
 error:
@@ -251,30 +398,47 @@ static void conn_write_cb (flux_reactor_t *r,
     }
 
     if ((revents & FLUX_POLLOUT)) {
-        const flux_msg_t *msg = zlist_head (conn->outqueue);
-        if (msg) {
-            if (sendfd (conn->out.fd, msg, &conn->out.iobuf) < 0) {
-                if (errno == EPIPE) {
-                    /* Remote peer has closed connection.
-                     * However, there may still be pending messages sent
-                     * by peer, so do not destroy connection here. Instead,
-                     * drop all pending messsages in the output queue, and
-                     * let connection be closed after EOF/ECONNRESET from
-                     * *read* side of connection.
-                     */
-                    while (conn_outqueue_drop (conn))
-                        ;
-                    flux_watcher_stop (conn->out.w);
-                }
-                else if (errno != EWOULDBLOCK && errno != EAGAIN)
-                    goto error;
+        const flux_msg_t *msg;
+        int rc;
+
+        /* Top up the output buffer from the queue, then write as much
+         * of it as the socket will take.
+         */
+        while (iobuf_batch_pending (&conn->out.batch) < OUTQUEUE_BATCH_SIZE
+               && (msg = zlist_head (conn->outqueue))) {
+            if (iobuf_batch_put (&conn->out.batch, msg) < 0)
+                goto error;
+            (void) conn_outqueue_drop (conn);
+        }
+        if (conn->ring)
+            rc = shmring_send_batch (conn->ring, &conn->out.batch);
+        else
+            rc = sendfd_batch (conn->out.fd, &conn->out.batch);
+        if (rc < 0) {
+            if (errno == EPIPE) {
+                /* Remote peer has closed connection.
+                 * However, there may still be pending messages sent
+                 * by peer, so do not destroy connection here. Instead,
+                 * drop all pending messsages in the output queue, and
+                 * let connection be closed after EOF/ECONNRESET from
+                 * *read* side of connection.
+                 */
+                while (conn_outqueue_drop (conn))
+                    ;
+                iobuf_batch_clean (&conn->out.batch);
+                flux_watcher_stop (conn->out.w);
             }
-            else {
-                (void) conn_outqueue_drop (conn);
-                if (zlist_size (conn->outqueue) == 0)
-                    flux_watcher_stop (conn->out.w);
+            else if (errno != EWOULDBLOCK && errno != EAGAIN)
+                goto error;
+            else if (conn->ring) {
+                /* Ring is full.  conn_ring_cb() restarts the watcher
+                 * when the client frees space.
+                 */
+                flux_watcher_stop (conn->out.w);
             }
         }
+        else if (zlist_size (conn->outqueue) == 0)
+            flux_watcher_stop (conn->out.w);
     }
     return;
 error:
@@ -330,7 +494,7 @@ void usock_conn_destroy (struct usock_conn *conn)
             (*conn->close_cb) (conn, conn->close_arg);
         aux_destroy (&conn->aux);
         flux_watcher_destroy (conn->in.w);
-        iobuf_clean (&conn->in.iobuf);
+        iobuf_batch_clean (&conn->in.batch);
         if (conn->outqueue) {
             const flux_msg_t *msg;
             while ((msg = zlist_pop (conn->outqueue)))
@@ -338,7 +502,9 @@ void usock_conn_destroy (struct usock_conn *conn)
             zlist_destroy (&conn->outqueue);
         }
         flux_watcher_destroy (conn->out.w);
-        iobuf_clean (&conn->out.iobuf);
+        iobuf_batch_clean (&conn->out.batch);
+        flux_watcher_destroy (conn->ring_w);
+        shmring_destroy (conn->ring);
         if (conn->server)
             zlist_remove (conn->server->connections, conn);
         if (conn->enable_close_on_destroy) {
@@ -428,7 +594,7 @@ struct usock_conn *usock_conn_create (flux_reactor_t *r, int infd, int outfd)
                                                conn_read_cb,
                                                conn)))
         goto error;
-    iobuf_init (&conn->in.iobuf);
+    iobuf_batch_init (&conn->in.batch);
 
     if (!(conn->out.w = flux_fd_watcher_create (r,
                                                 conn->out.fd,
@@ -436,7 +602,7 @@ struct usock_conn *usock_conn_create (flux_reactor_t *r, int infd, int outfd)
                                                 conn_write_cb,
                                                 conn)))
         goto error;
-    iobuf_init (&conn->out.iobuf);
+    iobuf_batch_init (&conn->out.batch);
     uuid_generate (conn->uuid);
     uuid_unparse (conn->uuid, conn->uuid_str);
 
@@ -464,6 +630,7 @@ static struct usock_conn *server_accept (struct usock_server *server,
         return NULL;
     }
     conn->enable_close_on_destroy = 1;
+    conn->negotiate = 1;
     return conn;
 }
 
@@ -548,6 +715,84 @@ static bool is_poll_error (int revents)
     return false;
 }
 
+/* Once shared memory is enabled the server does not write to the socket,
+ * so the socket becoming readable means the server has disconnected.
+ */
+static int client_check_socket (struct usock_client *client)
+{
+    char c;
+    int n;
+
+    if ((n = read (client->fd, &c, 1)) < 0) {
+        if (errno == EWOULDBLOCK || errno == EAGAIN)
+            return 0;
+        return -1;
+    }
+    errno = n == 0 ? ECONNRESET : EPROTO;
+    return -1;
+}
+
+/* Clear the doorbell and check the socket if they are ready.
+ * Callers then re-check the rings, so a doorbell signaled after this
+ * is not lost.
+ */
+static int client_shm_clear (struct usock_client *client)
+{
+    struct epoll_event ev[2];
+    int n;
+
+    if ((n = epoll_wait (client->epfd, ev, 2, 0)) < 0)
+        return -1;
+    for (int i = 0; i < n; i++) {
+        if (ev[i].data.fd == client->fd) {
+            if (client_check_socket (client) < 0)
+                return -1;
+        }
+        else
+            shmring_clear (client->ring);
+    }
+    return 0;
+}
+
+/* Block until the server signals the doorbell or disconnects.
+ */
+static int client_shm_wait (struct usock_client *client)
+{
+    struct pollfd pfd = { .fd = client->epfd, .events = POLLIN };
+
+    if (poll (&pfd, 1, -1) < 0)
+        return -1;
+    return client_shm_clear (client);
+}
+
+/* Move output to the ring.  Returns 0 if all output was sent, or -1
+ * with errno set (EWOULDBLOCK if the ring is full).
+ */
+static int client_shm_flush (struct usock_client *client)
+{
+    if (iobuf_batch_pending (&client->out_batch) == 0)
+        return 0;
+    return shmring_send_batch (client->ring, &client->out_batch);
+}
+
+static int client_shm_pollevents (struct usock_client *client)
+{
+    int flux_revents = 0;
+
+    if (client_shm_clear (client) < 0)
+        return FLUX_POLLERR;
+    if (client_shm_flush (client) < 0 && errno != EWOULDBLOCK)
+        return FLUX_POLLERR;
+    if (shmring_recv_batch (client->ring, &client->in_batch) < 0
+        && errno != EWOULDBLOCK)
+        return FLUX_POLLERR;
+    if (iobuf_batch_ready (&client->in_batch))
+        flux_revents |= FLUX_POLLIN;
+    if (iobuf_batch_pending (&client->out_batch) < OUTQUEUE_BATCH_SIZE)
+        flux_revents |= FLUX_POLLOUT;
+    return flux_revents;
+}
+
 /* Check which events are pending events on client fd (non-blocking).
  * If none are pending, return 0.  If an error occurred, return FLUX_POLLERR.
  * N.B. see op->pollevents in libflux/connector.h
@@ -557,6 +802,9 @@ int usock_client_pollevents (struct usock_client *client)
     struct pollfd pfd;
     int flux_revents = 0;
 
+    if (client->ring)
+        return client_shm_pollevents (client);
+
     pfd.fd = client->fd;
     pfd.events = POLLIN | POLLOUT;
     pfd.revents = 0;
@@ -579,6 +827,8 @@ int usock_client_pollevents (struct usock_client *client)
  */
 int usock_client_pollfd (struct usock_client *client)
 {
+    if (client->ring)
+        return client->epfd;
     return client->fd;
 }
 
@@ -602,6 +852,51 @@ static int usock_client_poll (int fd, int events)
     return 0;
 }
 
+static int client_shm_send (struct usock_client *client,
+                            const flux_msg_t *msg,
+                            int flags)
+{
+    if ((flags & FLUX_O_NONBLOCK)
+        && iobuf_batch_pending (&client->out_batch) >= OUTQUEUE_BATCH_SIZE
+        && client_shm_flush (client) < 0)
+        return -1;
+    if (iobuf_batch_put (&client->out_batch, msg) < 0)
+        return -1;
+    while (client_shm_flush (client) < 0) {
+        if (errno != EWOULDBLOCK)
+            return -1;
+        if ((flags & FLUX_O_NONBLOCK))
+            return 0; // flushed by later calls or pollevents
+        if (client_shm_wait (client) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+static flux_msg_t *client_shm_recv (struct usock_client *client, int flags)
+{
+    flux_msg_t *msg;
+
+    while (!(msg = iobuf_batch_get (&client->in_batch))) {
+        if (errno != EWOULDBLOCK)
+            return NULL;
+        /* Don't wait for a response to a request that is still
+         * waiting for space in the ring.
+         */
+        if (client_shm_flush (client) < 0 && errno != EWOULDBLOCK)
+            return NULL;
+        if (shmring_recv_batch (client->ring, &client->in_batch) == 0)
+            continue;
+        if (errno != EWOULDBLOCK)
+            return NULL;
+        if ((flags & FLUX_O_NONBLOCK))
+            return NULL;
+        if (client_shm_wait (client) < 0)
+            return NULL;
+    }
+    return msg;
+}
+
 /* Try to send message.  If flags does not include FLUX_O_NONBLOCK,
  * and sendfd fails with EWOULDBLOCK/EAGAIN, then poll(POLLOUT) and
  * keep trying until the full message is sent.
@@ -610,6 +905,8 @@ int usock_client_send (struct usock_client *client,
                        const flux_msg_t *msg,
                        int flags)
 {
+    if (client->ring)
+        return client_shm_send (client, msg, flags);
     while (sendfd (client->fd, msg, &client->out_iobuf) < 0) {
         if (errno != EWOULDBLOCK && errno != EAGAIN)
             return -1;
@@ -629,6 +926,8 @@ flux_msg_t *usock_client_recv (struct usock_client *client, int flags)
 {
     flux_msg_t *msg;
 
+    if (client->ring)
+        return client_shm_recv (client, flags);
     while (!(msg = recvfd (client->fd, &client->in_iobuf))) {
         if (errno != EWOULDBLOCK && errno != EAGAIN)
             return NULL;
@@ -716,8 +1015,11 @@ struct usock_client *usock_client_create (int fd)
         return NULL;
 
     client->fd = fd;
+    client->epfd = -1;
     iobuf_init (&client->in_iobuf);
     iobuf_init (&client->out_iobuf);
+    iobuf_batch_init (&client->in_batch);
+    iobuf_batch_init (&client->out_batch);
 
     if (usock_client_read_zero (client->fd) < 0)
         goto error;
@@ -729,11 +1031,53 @@ error:
     return NULL;
 }
 
+/* Ask the server to move traffic to shared memory rings of 'size' bytes.
+ * This must be called before any messages are sent.  If the server
+ * declines, -1 is returned with errno set to its reason and the client
+ * may continue on the socket.
+ */
+int usock_client_enable_shm (struct usock_client *client, size_t size)
+{
+    struct epoll_event ev = { .events = EPOLLIN };
+    struct shmring *ring;
+    int epfd;
+
+    if (!client || client->ring) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((epfd = epoll_create1 (EPOLL_CLOEXEC)) < 0)
+        return -1;
+    ev.data.fd = client->fd;
+    if (epoll_ctl (epfd, EPOLL_CTL_ADD, client->fd, &ev) < 0)
+        goto error;
+    if (shmring_send_hello (client->fd, size) < 0)
+        goto error;
+    if (!(ring = shmring_recv_ack (client->fd)))
+        goto error;
+    ev.data.fd = shmring_pollfd (ring);
+    if (epoll_ctl (epfd, EPOLL_CTL_ADD, ev.data.fd, &ev) < 0) {
+        shmring_destroy (ring);
+        goto error;
+    }
+    client->ring = ring;
+    client->epfd = epfd;
+    return 0;
+error:
+    ERRNO_SAFE_WRAP (close, epfd);
+    return -1;
+}
+
 void usock_client_destroy (struct usock_client *client)
 {
     if (client) {
         iobuf_clean (&client->in_iobuf);
         iobuf_clean (&client->out_iobuf);
+        iobuf_batch_clean (&client->in_batch);
+        iobuf_batch_clean (&client->out_batch);
+        shmring_destroy (client->ring);
+        if (client->epfd >= 0)
+            ERRNO_SAFE_WRAP (close, client->epfd);
         ERRNO_SAFE_WRAP (free, client);
     }
 }
@@ -112,6 +112,8 @@ int usock_client_connect (const char *sockpath,
 struct usock_client *usock_client_create (int fd);
 void usock_client_destroy (struct usock_client *client);
 
+int usock_client_enable_shm (struct usock_client *client, size_t size);
+
 #endif /* !_ROUTER_USOCK_H */
 
 /*
@@ -69,6 +69,7 @@ int schedutil_alloc_respond_cancel (schedutil_t *util, const flux_msg_t *msg)
 
 struct alloc {
     char *note;
+    char *R;
     const flux_msg_t *msg;
     flux_kvs_txn_t *txn;
 };
@@ -80,39 +81,44 @@ static void alloc_destroy (struct alloc *ctx)
         flux_kvs_txn_destroy (ctx->txn);
         flux_msg_decref (ctx->msg);
         free (ctx->note);
+        free (ctx->R);
         free (ctx);
         errno = saved_errno;
     }
 }
 
-static struct alloc *alloc_create (const flux_msg_t *msg, const char *R,
-                                   const char *note)
+static struct alloc *alloc_create (const flux_msg_t *msg, const char *note)
 {
     struct alloc *ctx;
-    flux_jobid_t id;
-    char key[64];
 
-    if (flux_request_unpack (msg, NULL, "{s:I}", "id", &id) < 0)
-        return NULL;
-    if (flux_job_kvs_key (key, sizeof (key), id, "R") < 0) {
-        errno = EINVAL;
-        return NULL;
-    }
     if (!(ctx = calloc (1, sizeof (*ctx))))
         return NULL;
     ctx->msg = flux_msg_incref (msg);
     if (note && !(ctx->note = strdup (note)))
         goto error;
-    if (!(ctx->txn = flux_kvs_txn_create ()))
-        goto error;
-    if (flux_kvs_txn_put (ctx->txn, 0, key, R) < 0)
-        goto error;
     return ctx;
 error:
     alloc_destroy (ctx);
     return NULL;
 }
 
+/* Add R for the job in alloc request 'msg' to transaction 'txn'.
+ */
+static int alloc_txn_put_R (flux_kvs_txn_t *txn, const flux_msg_t *msg,
+                            const char *R)
+{
+    flux_jobid_t id;
+    char key[64];
+
+    if (flux_request_unpack (msg, NULL, "{s:I}", "id", &id) < 0)
+        return -1;
+    if (flux_job_kvs_key (key, sizeof (key), id, "R") < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return flux_kvs_txn_put (txn, 0, key, R);
+}
+
 static void alloc_continuation (flux_future_t *f, void *arg)
 {
     schedutil_t *util = arg;
@@ -140,11 +146,14 @@ int schedutil_alloc_respond_R (schedutil_t *util, const flux_msg_t *msg,
                                const char *R, const char *note)
 {
     struct alloc *ctx;
-    flux_future_t *f;
+    flux_future_t *f = NULL;
     flux_t *h = util->h;
 
-    if (!(ctx = alloc_create (msg, R, note)))
+    if (!(ctx = alloc_create (msg, note)))
         return -1;
+    if (!(ctx->txn = flux_kvs_txn_create ())
+        || alloc_txn_put_R (ctx->txn, msg, R) < 0)
+        goto error;
     if (!(f = flux_kvs_commit (h, NULL, 0, ctx->txn)))
         goto error;
     if (flux_future_aux_set (f, "flux::alloc_ctx",
@@ -168,6 +177,166 @@ error:
     return -1;
 }
 
+struct schedutil_alloc_batch {
+    schedutil_t *util;
+    flux_kvs_txn_t *txn;
+    zlistx_t *allocs;
+    schedutil_alloc_batch_fail_f *fail_cb;
+    void *fail_arg;
+};
+
+void schedutil_alloc_batch_destroy (schedutil_alloc_batch_t *batch)
+{
+    if (batch) {
+        int saved_errno = errno;
+        zlistx_destroy (&batch->allocs);
+        flux_kvs_txn_destroy (batch->txn);
+        free (batch);
+        errno = saved_errno;
+    }
+}
+
+static void alloc_destructor (void **item)
+{
+    if (item) {
+        alloc_destroy (*item);
+        *item = NULL;
+    }
+}
+
+schedutil_alloc_batch_t *schedutil_alloc_batch_create (
+                                        schedutil_t *util,
+                                        schedutil_alloc_batch_fail_f *fail_cb,
+                                        void *arg)
+{
+    schedutil_alloc_batch_t *batch;
+
+    if (!util || !fail_cb) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(batch = calloc (1, sizeof (*batch))))
+        return NULL;
+    batch->util = util;
+    batch->fail_cb = fail_cb;
+    batch->fail_arg = arg;
+    if (!(batch->txn = flux_kvs_txn_create ())
+        || !(batch->allocs = zlistx_new ()))
+        goto error;
+    zlistx_set_destructor (batch->allocs, alloc_destructor);
+    return batch;
+error:
+    schedutil_alloc_batch_destroy (batch);
+    return NULL;
+}
+
+int schedutil_alloc_batch_add_R (schedutil_alloc_batch_t *batch,
+                                 const flux_msg_t *msg,
+                                 const char *R,
+                                 const char *note)
+{
+    struct alloc *ctx;
+
+    if (!batch || !msg || !R) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(ctx = alloc_create (msg, note)))
+        return -1;
+    if (!(ctx->R = strdup (R))
+        || alloc_txn_put_R (batch->txn, msg, R) < 0
+        || !zlistx_add_end (batch->allocs, ctx)) {
+        alloc_destroy (ctx);
+        return -1;
+    }
+    return 0;
+}
+
+size_t schedutil_alloc_batch_count (schedutil_alloc_batch_t *batch)
+{
+    return batch ? zlistx_size (batch->allocs) : 0;
+}
+
+/* R for the batch could not be committed.  Respond to each request with
+ * 'errnum' and hand its R back to the scheduler.
+ */
+static void alloc_batch_fail (schedutil_alloc_batch_t *batch, int errnum)
+{
+    flux_t *h = batch->util->h;
+    struct alloc *ctx;
+
+    ctx = zlistx_first (batch->allocs);
+    while (ctx) {
+        if (flux_respond_error (h, ctx->msg, errnum,
+                                "error committing R to KVS") < 0)
+            flux_log_error (h, "alloc response");
+        batch->fail_cb (h, ctx->msg, ctx->R, batch->fail_arg);
+        ctx = zlistx_next (batch->allocs);
+    }
+}
+
+static void alloc_batch_continuation (flux_future_t *f, void *arg)
+{
+    schedutil_alloc_batch_t *batch = arg;
+    schedutil_t *util = batch->util;
+    flux_t *h = util->h;
+    struct alloc *ctx;
+
+    schedutil_remove_outstanding_future (util, f);
+    if (flux_future_get (f, NULL) < 0) {
+        flux_log_error (h, "commit R batch");
+        alloc_batch_fail (batch, errno);
+        goto done;
+    }
+    ctx = zlistx_first (batch->allocs);
+    while (ctx) {
+        if (schedutil_alloc_respond (h, ctx->msg, 0, ctx->note) < 0)
+            flux_log_error (h, "alloc response");
+        ctx = zlistx_next (batch->allocs);
+    }
+done:
+    flux_future_destroy (f);
+}
+
+int schedutil_alloc_batch_commit (schedutil_alloc_batch_t *batch)
+{
+    flux_future_t *f = NULL;
+    schedutil_t *util;
+    int saved_errno;
+
+    if (!batch) {
+        errno = EINVAL;
+        return -1;
+    }
+    util = batch->util;
+    if (zlistx_size (batch->allocs) == 0) {
+        schedutil_alloc_batch_destroy (batch);
+        return 0;
+    }
+    if (!(f = flux_kvs_commit (util->h, NULL, 0, batch->txn)))
+        goto error;
+    if (!schedutil_hang_responses (util)) {
+        if (flux_future_then (f, -1, alloc_batch_continuation, batch) < 0)
+            goto error;
+    }
+    /* else: intentionally do not register a continuation to force
+     * a permanent outstanding request for testing
+     */
+    if (flux_future_aux_set (f, "flux::alloc_batch",
+                             batch,
+                             (flux_free_f)schedutil_alloc_batch_destroy) < 0)
+        goto error;
+    schedutil_add_outstanding_future (util, f);
+    return 0;
+error:
+    saved_errno = errno;
+    alloc_batch_fail (batch, errno);
+    schedutil_alloc_batch_destroy (batch);
+    flux_future_destroy (f);
+    errno = saved_errno;
+    return -1;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
@@ -47,6 +47,41 @@ int schedutil_alloc_respond_denied (schedutil_t *util, const flux_msg_t *msg,
 int schedutil_alloc_respond_R (schedutil_t *util, const flux_msg_t *msg,
                                const char *R, const char *note);
 
+/* Respond to a batch of alloc requests - allocate R.
+ * R for every request added with schedutil_alloc_batch_add_R() is committed
+ * to the KVS in a single transaction by schedutil_alloc_batch_commit(),
+ * then the responses are sent in the order the requests were added.
+ * schedutil_alloc_batch_commit() consumes the batch, even on failure.
+ * If the commit fails, whether before or after it returns, each request
+ * in the batch gets an error response, then 'fail_cb' is called with its
+ * R so the scheduler can return those resources.
+ * Return 0 on success, -1 on error with errno set.
+ */
+typedef struct schedutil_alloc_batch schedutil_alloc_batch_t;
+
+/* Called for each request in a batch that could not be committed.
+ * 'msg' and 'R' are only valid for the duration of this call.
+ */
+typedef void (schedutil_alloc_batch_fail_f)(flux_t *h,
+                                            const flux_msg_t *msg,
+                                            const char *R,
+                                            void *arg);
+
+schedutil_alloc_batch_t *schedutil_alloc_batch_create (
+                                        schedutil_t *util,
+                                        schedutil_alloc_batch_fail_f *fail_cb,
+                                        void *arg);
+void schedutil_alloc_batch_destroy (schedutil_alloc_batch_t *batch);
+
+int schedutil_alloc_batch_add_R (schedutil_alloc_batch_t *batch,
+                                 const flux_msg_t *msg,
+                                 const char *R,
+                                 const char *note);
+
+size_t schedutil_alloc_batch_count (schedutil_alloc_batch_t *batch);
+
+int schedutil_alloc_batch_commit (schedutil_alloc_batch_t *batch);
+
 /* Respond to an alloc request message - canceled.
  * N.B. 'msg' is the alloc request, not the cancel request.
  */
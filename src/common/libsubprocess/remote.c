@@ -573,32 +573,21 @@ static int remote_state (flux_subprocess_t *p, flux_future_t *f,
     return 0;
 }
 
-static int remote_output (flux_subprocess_t *p, flux_future_t *f,
-                          int rank, pid_t pid)
+static int remote_output_buffer (flux_subprocess_t *p,
+                                 int rank,
+                                 pid_t pid,
+                                 const char *stream,
+                                 const char *data,
+                                 int len,
+                                 bool eof)
 {
     struct subprocess_channel *c;
-    const char *stream = NULL;
-    char *data = NULL;
-    int len = 0;
-    bool eof = false;
-    json_t *io = NULL;
-    int rv = -1;
-
-    if (flux_rpc_get_unpack (f, "{ s:o }", "io", &io)) {
-        flux_log_error (p->h, "flux_rpc_get_unpack EPROTO io");
-        goto cleanup;
-    }
-
-    if (iodecode (io, &stream, NULL, &data, &len, &eof) < 0) {
-        flux_log_error (p->h, "iodecode");
-        goto cleanup;
-    }
 
     if (!(c = zhash_lookup (p->channels, stream))) {
         flux_log_error (p->h, "invalid channel received: rank = %d, pid = %d, stream = %s",
                  rank, pid, stream);
         errno = EPROTO;
-        goto cleanup;
+        return -1;
     }
 
     if (data && len) {
@@ -606,7 +595,7 @@ static int remote_output (flux_subprocess_t *p, flux_future_t *f,
 
         if ((tmp = flux_buffer_write (c->read_buffer, data, len)) < 0) {
             flux_log_error (p->h, "flux_buffer_write");
-            goto cleanup;
+            return -1;
         }
 
         /* add list of msgs if there is overflow? */
@@ -615,7 +604,7 @@ static int remote_output (flux_subprocess_t *p, flux_future_t *f,
             flux_log_error (p->h, "channel buffer error: rank = %d pid = %d, stream = %s, len = %d",
                             rank, pid, stream, len);
             errno = EOVERFLOW;
-            goto cleanup;
+            return -1;
         }
     }
     if (eof) {
@@ -623,13 +612,52 @@ static int remote_output (flux_subprocess_t *p, flux_future_t *f,
         if (flux_buffer_readonly (c->read_buffer) < 0)
             flux_log_error (p->h, "flux_buffer_readonly");
     }
+    return 0;
+}
 
-    rv = 0;
+static int remote_output (flux_subprocess_t *p, flux_future_t *f,
+                          int rank, pid_t pid)
+{
+    const char *stream = NULL;
+    char *data = NULL;
+    int len = 0;
+    bool eof = false;
+    json_t *io = NULL;
+    int rv = -1;
+
+    if (flux_rpc_get_unpack (f, "{ s:o }", "io", &io)) {
+        flux_log_error (p->h, "flux_rpc_get_unpack EPROTO io");
+        goto cleanup;
+    }
+
+    if (iodecode (io, &stream, NULL, &data, &len, &eof) < 0) {
+        flux_log_error (p->h, "iodecode");
+        goto cleanup;
+    }
+
+    rv = remote_output_buffer (p, rank, pid, stream, data, len, eof);
 cleanup:
     free (data);
     return rv;
 }
 
+/* Output frames from ioencode_raw() are copied directly from the
+ * response payload into the channel buffer.
+ */
+static int remote_output_raw (flux_subprocess_t *p, const void *buf, int size)
+{
+    const char *stream;
+    const char *data;
+    int len;
+    bool eof;
+
+    if (iodecode_raw (buf, size, &stream, NULL, &data, &len, &eof) < 0) {
+        flux_log_error (p->h, "iodecode_raw");
+        return -1;
+    }
+    return remote_output_buffer (p, p->rank, p->pid, stream, data, len, eof);
+}
+
 static void remote_completion (flux_subprocess_t *p)
 {
     p->remote_completed = true;
@@ -645,6 +673,16 @@ static void remote_exec_cb (flux_future_t *f, void *arg)
     const char *type;
     int rank;
     pid_t pid;
+    const void *buf;
+    int size;
+
+    if (flux_rpc_get_raw (f, &buf, &size) == 0
+        && ioencode_is_raw (buf, size)) {
+        if (remote_output_raw (p, buf, size) < 0)
+            goto error;
+        flux_future_reset (f);
+        return;
+    }
 
     if (flux_rpc_get_unpack (f, "{ s:s s:i }",
                              "type", &type,
@@ -757,11 +795,12 @@ int remote_exec (flux_subprocess_t *p)
      * don't care if user doesn't want it.
      */
     if (!(f = flux_rpc_pack (p->h, "cmb.rexec", p->rank, 0,
-                             "{s:s s:i s:i s:i}",
+                             "{s:s s:i s:i s:i s:i}",
                              "cmd", cmd_str,
                              "on_channel_out", p->ops.on_channel_out ? 1 : 0,
                              "on_stdout", p->ops.on_stdout ? 1 : 0,
-                             "on_stderr", p->ops.on_stderr ? 1 : 0))) {
+                             "on_stderr", p->ops.on_stderr ? 1 : 0,
+                             "raw_io", 1))) {
         flux_log_error (p->h, "flux_rpc");
         goto error;
     }
@@ -40,6 +40,7 @@ static const char *auxkey = "flux::rexec";
 struct rexec {
     const flux_msg_t *msg;          // rexec request message
     flux_subprocess_server_t *s;    // server context
+    bool raw_io;                    // send output as ioencode_raw() frames
 };
 
 static void rexec_destroy (struct rexec *rex)
@@ -229,19 +230,51 @@ error:
     internal_fatal (rex->s, p);
 }
 
+/* Respond with a raw frame that the client recognizes by its leading
+ * NUL byte, avoiding base64 and JSON encoding of the output.
+ */
+static int rexec_output_raw (flux_subprocess_server_t *s,
+                             const flux_msg_t *msg,
+                             const char *stream,
+                             const char *rankstr,
+                             const char *data,
+                             int len,
+                             bool eof)
+{
+    void *buf;
+    int size;
+    int rv = -1;
+
+    if (!(buf = ioencode_raw (stream, rankstr, data, len, eof, &size))) {
+        flux_log_error (s->h, "%s: ioencode_raw", __FUNCTION__);
+        return -1;
+    }
+    if (flux_respond_raw (s->h, msg, buf, size) < 0) {
+        flux_log_error (s->h, "%s: flux_respond_raw", __FUNCTION__);
+        goto error;
+    }
+    rv = 0;
+error:
+    free (buf);
+    return rv;
+}
+
 static int rexec_output (flux_subprocess_t *p,
                          const char *stream,
-                         flux_subprocess_server_t *s,
-                         const flux_msg_t *msg,
+                         struct rexec *rex,
                          const char *data,
                          int len,
                          bool eof)
 {
+    flux_subprocess_server_t *s = rex->s;
+    const flux_msg_t *msg = rex->msg;
     json_t *io = NULL;
     char rankstr[64];
     int rv = -1;
 
     snprintf (rankstr, sizeof (rankstr), "%d", s->rank);
+    if (rex->raw_io)
+        return rexec_output_raw (s, msg, stream, rankstr, data, len, eof);
     if (!(io = ioencode (stream, rankstr, data, len, eof))) {
         flux_log_error (s->h, "%s: ioencode", __FUNCTION__);
         goto error;
@@ -276,11 +309,11 @@ static void rexec_output_cb (flux_subprocess_t *p, const char *stream)
     }
 
     if (lenp) {
-        if (rexec_output (p, stream, rex->s, rex->msg, ptr, lenp, false) < 0)
+        if (rexec_output (p, stream, rex, ptr, lenp, false) < 0)
             goto error;
     }
     else {
-        if (rexec_output (p, stream, rex->s, rex->msg, NULL, 0, true) < 0)
+        if (rexec_output (p, stream, rex, NULL, 0, true) < 0)
             goto error;
     }
 
@@ -306,13 +339,15 @@ static void server_exec_cb (flux_t *h, flux_msg_handler_t *mh,
         .on_stderr = rexec_output_cb,
     };
     int on_channel_out, on_stdout, on_stderr;
+    int raw_io = 0;
     char **env = NULL;
 
-    if (flux_request_unpack (msg, NULL, "{s:s s:i s:i s:i}",
+    if (flux_request_unpack (msg, NULL, "{s:s s:i s:i s:i s?i}",
                              "cmd", &cmd_str,
                              "on_channel_out", &on_channel_out,
                              "on_stdout", &on_stdout,
-                             "on_stderr", &on_stderr))
+                             "on_stderr", &on_stderr,
+                             "raw_io", &raw_io))
         goto error;
 
     if (!on_channel_out)
@@ -375,6 +410,7 @@ static void server_exec_cb (flux_t *h, flux_msg_handler_t *mh,
 
     if (!(rex = rexec_create (msg, s)))
         goto error;
+    rex->raw_io = raw_io ? true : false;
     if (flux_subprocess_aux_set (p,
                                 auxkey,
                                 rex,
@@ -0,0 +1,255 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* blake3.c - portable BLAKE3, following the reference implementation
+ *  in the BLAKE3 specification.
+ *
+ * Input is split into 1 KiB chunks, each compressed block by block
+ *  into a chaining value.  Chaining values are merged pairwise into a
+ *  binary tree using a stack: after chunk N is complete, one parent is
+ *  formed for each trailing zero bit of N.  The root node is compressed
+ *  with the ROOT flag to produce the digest.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+
+#include "blake3.h"
+
+enum {
+    CHUNK_START = 1 << 0,
+    CHUNK_END = 1 << 1,
+    PARENT = 1 << 2,
+    ROOT = 1 << 3,
+};
+
+static const uint32_t IV[8] = {
+    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+    0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19,
+};
+
+static const uint8_t MSG_SCHEDULE[7][16] = {
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+    { 2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8 },
+    { 3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1 },
+    { 10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6 },
+    { 12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4 },
+    { 9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7 },
+    { 11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13 },
+};
+
+static inline uint32_t rotr32 (uint32_t w, int c)
+{
+    return (w >> c) | (w << (32 - c));
+}
+
+static inline uint32_t load32 (const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8)
+         | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void store32 (uint8_t *p, uint32_t w)
+{
+    p[0] = w;
+    p[1] = w >> 8;
+    p[2] = w >> 16;
+    p[3] = w >> 24;
+}
+
+static inline void g (uint32_t *s, int a, int b, int c, int d,
+                      uint32_t x, uint32_t y)
+{
+    s[a] = s[a] + s[b] + x;
+    s[d] = rotr32 (s[d] ^ s[a], 16);
+    s[c] = s[c] + s[d];
+    s[b] = rotr32 (s[b] ^ s[c], 12);
+    s[a] = s[a] + s[b] + y;
+    s[d] = rotr32 (s[d] ^ s[a], 8);
+    s[c] = s[c] + s[d];
+    s[b] = rotr32 (s[b] ^ s[c], 7);
+}
+
+/* Compress one 64 byte block, leaving the full 16 word state in 'out'.
+ * The first 8 words are the new chaining value.
+ */
+static void compress (const uint32_t cv[8],
+                      const uint8_t block[BLAKE3_BLOCK_LEN],
+                      uint8_t block_len,
+                      uint64_t counter,
+                      uint8_t flags,
+                      uint32_t out[16])
+{
+    uint32_t m[16];
+    uint32_t s[16];
+    int r;
+    int i;
+
+    for (i = 0; i < 16; i++)
+        m[i] = load32 (block + 4 * i);
+    for (i = 0; i < 8; i++)
+        s[i] = cv[i];
+    s[8] = IV[0];
+    s[9] = IV[1];
+    s[10] = IV[2];
+    s[11] = IV[3];
+    s[12] = (uint32_t)counter;
+    s[13] = (uint32_t)(counter >> 32);
+    s[14] = block_len;
+    s[15] = flags;
+
+    for (r = 0; r < 7; r++) {
+        const uint8_t *sched = MSG_SCHEDULE[r];
+        g (s, 0, 4, 8, 12, m[sched[0]], m[sched[1]]);
+        g (s, 1, 5, 9, 13, m[sched[2]], m[sched[3]]);
+        g (s, 2, 6, 10, 14, m[sched[4]], m[sched[5]]);
+        g (s, 3, 7, 11, 15, m[sched[6]], m[sched[7]]);
+        g (s, 0, 5, 10, 15, m[sched[8]], m[sched[9]]);
+        g (s, 1, 6, 11, 12, m[sched[10]], m[sched[11]]);
+        g (s, 2, 7, 8, 13, m[sched[12]], m[sched[13]]);
+        g (s, 3, 4, 9, 14, m[sched[14]], m[sched[15]]);
+    }
+    for (i = 0; i < 8; i++) {
+        out[i] = s[i] ^ s[i + 8];
+        out[i + 8] = s[i + 8] ^ cv[i];
+    }
+}
+
+static void parent_block (const uint32_t left[8], const uint32_t right[8],
+                          uint8_t block[BLAKE3_BLOCK_LEN])
+{
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        store32 (block + 4 * i, left[i]);
+        store32 (block + 32 + 4 * i, right[i]);
+    }
+}
+
+static void chunk_reset (BLAKE3_CTX *ctx)
+{
+    memcpy (ctx->cv, IV, sizeof (ctx->cv));
+    memset (ctx->block, 0, sizeof (ctx->block));
+    ctx->block_len = 0;
+    ctx->blocks_compressed = 0;
+}
+
+static size_t chunk_len (BLAKE3_CTX *ctx)
+{
+    return BLAKE3_BLOCK_LEN * (size_t)ctx->blocks_compressed + ctx->block_len;
+}
+
+static uint8_t chunk_start_flag (BLAKE3_CTX *ctx)
+{
+    return ctx->blocks_compressed == 0 ? CHUNK_START : 0;
+}
+
+/* Push the chaining value of chunk number 'total_chunks' - 1, merging
+ * completed subtrees first.
+ */
+static void push_chunk_cv (BLAKE3_CTX *ctx, uint32_t cv[8],
+                           uint64_t total_chunks)
+{
+    uint8_t block[BLAKE3_BLOCK_LEN];
+    uint32_t out[16];
+
+    while ((total_chunks & 1) == 0) {
+        ctx->cv_stack_len--;
+        parent_block (ctx->cv_stack[ctx->cv_stack_len], cv, block);
+        compress (IV, block, BLAKE3_BLOCK_LEN, 0, PARENT, out);
+        memcpy (cv, out, 8 * sizeof (uint32_t));
+        total_chunks >>= 1;
+    }
+    memcpy (ctx->cv_stack[ctx->cv_stack_len++], cv, 8 * sizeof (uint32_t));
+}
+
+void blake3_init (BLAKE3_CTX *ctx)
+{
+    chunk_reset (ctx);
+    ctx->chunk_counter = 0;
+    ctx->cv_stack_len = 0;
+}
+
+void blake3_update (BLAKE3_CTX *ctx, const void *data, size_t len)
+{
+    const uint8_t *in = data;
+    uint32_t out[16];
+
+    while (len > 0) {
+        size_t take;
+
+        /* The current chunk is full and more input follows, so it
+         * is not the root: finish it and start the next one.
+         */
+        if (chunk_len (ctx) == BLAKE3_CHUNK_LEN) {
+            compress (ctx->cv, ctx->block, ctx->block_len,
+                      ctx->chunk_counter,
+                      chunk_start_flag (ctx) | CHUNK_END, out);
+            ctx->chunk_counter++;
+            push_chunk_cv (ctx, out, ctx->chunk_counter);
+            chunk_reset (ctx);
+        }
+        /* The current block is full and more input follows.
+         */
+        if (ctx->block_len == BLAKE3_BLOCK_LEN) {
+            compress (ctx->cv, ctx->block, BLAKE3_BLOCK_LEN,
+                      ctx->chunk_counter, chunk_start_flag (ctx), out);
+            memcpy (ctx->cv, out, sizeof (ctx->cv));
+            ctx->blocks_compressed++;
+            memset (ctx->block, 0, sizeof (ctx->block));
+            ctx->block_len = 0;
+        }
+        take = BLAKE3_BLOCK_LEN - ctx->block_len;
+        if (take > len)
+            take = len;
+        memcpy (ctx->block + ctx->block_len, in, take);
+        ctx->block_len += take;
+        in += take;
+        len -= take;
+    }
+}
+
+void blake3_final (BLAKE3_CTX *ctx, uint8_t digest[BLAKE3_OUT_LEN])
+{
+    uint32_t input_cv[8];
+    uint8_t block[BLAKE3_BLOCK_LEN];
+    uint8_t block_len;
+    uint64_t counter;
+    uint8_t flags;
+    uint32_t out[16];
+    int i;
+
+    /* The output node starts as the last chunk, then is folded into
+     * parents with each chaining value remaining on the stack.
+     */
+    memcpy (input_cv, ctx->cv, sizeof (input_cv));
+    memcpy (block, ctx->block, sizeof (block));
+    block_len = ctx->block_len;
+    counter = ctx->chunk_counter;
+    flags = chunk_start_flag (ctx) | CHUNK_END;
+
+    for (i = ctx->cv_stack_len - 1; i >= 0; i--) {
+        compress (input_cv, block, block_len, counter, flags, out);
+        parent_block (ctx->cv_stack[i], out, block);
+        memcpy (input_cv, IV, sizeof (input_cv));
+        block_len = BLAKE3_BLOCK_LEN;
+        counter = 0;
+        flags = PARENT;
+    }
+    compress (input_cv, block, block_len, counter, flags | ROOT, out);
+    for (i = 0; i < 8; i++)
+        store32 (digest + 4 * i, out[i]);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,44 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_BLAKE3_H
+#define _UTIL_BLAKE3_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Portable BLAKE3 in its default hash mode, with 32 byte output.
+ * See the BLAKE3 specification, https://github.com/BLAKE3-team/BLAKE3-specs
+ */
+
+#define BLAKE3_OUT_LEN      32
+#define BLAKE3_BLOCK_LEN    64
+#define BLAKE3_CHUNK_LEN    1024
+#define BLAKE3_MAX_DEPTH    54
+
+typedef struct {
+    uint32_t cv[8];
+    uint64_t chunk_counter;
+    uint8_t block[BLAKE3_BLOCK_LEN];
+    uint8_t block_len;
+    uint8_t blocks_compressed;
+    uint32_t cv_stack[BLAKE3_MAX_DEPTH][8];
+    uint8_t cv_stack_len;
+} BLAKE3_CTX;
+
+void blake3_init (BLAKE3_CTX *ctx);
+void blake3_update (BLAKE3_CTX *ctx, const void *data, size_t len);
+void blake3_final (BLAKE3_CTX *ctx, uint8_t digest[BLAKE3_OUT_LEN]);
+
+#endif /* !_UTIL_BLAKE3_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -20,6 +20,8 @@
 #include "blobref.h"
 #include "sha1.h"
 #include "sha256.h"
+#include "sha_ni.h"
+#include "blake3.h"
 
 #define SHA1_PREFIX_STRING  "sha1-"
 #define SHA1_PREFIX_LENGTH  5
@@ -29,6 +31,10 @@
 #define SHA256_PREFIX_LENGTH  7
 #define SHA256_STRING_SIZE    (SHA256_BLOCK_SIZE*2 + SHA256_PREFIX_LENGTH + 1)
 
+#define BLAKE3_PREFIX_STRING  "blake3-"
+#define BLAKE3_PREFIX_LENGTH  7
+#define BLAKE3_STRING_SIZE    (BLAKE3_OUT_LEN*2 + BLAKE3_PREFIX_LENGTH + 1)
+
 #if BLOBREF_MAX_STRING_SIZE < SHA1_STRING_SIZE
 #error BLOBREF_MAX_STRING_SIZE is too small
 #endif
@@ -41,9 +47,16 @@
 #if BLOBREF_MAX_DIGEST_SIZE < SHA256_BLOCK_SIZE
 #error BLOBREF_MAX_DIGEST_SIZE is too small
 #endif
+#if BLOBREF_MAX_STRING_SIZE < BLAKE3_STRING_SIZE
+#error BLOBREF_MAX_STRING_SIZE is too small
+#endif
+#if BLOBREF_MAX_DIGEST_SIZE < BLAKE3_OUT_LEN
+#error BLOBREF_MAX_DIGEST_SIZE is too small
+#endif
 
 static void sha1_hash (const void *data, int data_len, void *hash, int hash_len);
 static void sha256_hash (const void *data, int data_len, void *hash, int hash_len);
+static void blake3_hash (const void *data, int data_len, void *hash, int hash_len);
 
 struct blobhash {
     char *name;
@@ -60,6 +73,10 @@ static struct blobhash blobtab[] = {
       .hashlen = SHA256_BLOCK_SIZE,
       .hashfun = sha256_hash,
     },
+    { .name = "blake3",
+      .hashlen = BLAKE3_OUT_LEN,
+      .hashfun = blake3_hash,
+    },
     { NULL, 0, 0 },
 };
 
@@ -68,6 +85,10 @@ static void sha1_hash (const void *data, int data_len, void *hash, int hash_len)
     SHA1_CTX ctx;
 
     assert (hash_len == SHA1_DIGEST_SIZE);
+    if (sha_ni_available ()) {
+        sha1_ni_digest (data, data_len, hash);
+        return;
+    }
     SHA1_Init (&ctx);
     SHA1_Update (&ctx, data, data_len);
     SHA1_Final (&ctx, hash);
@@ -78,11 +99,25 @@ static void sha256_hash (const void *data, int data_len, void *hash, int hash_le
     SHA256_CTX ctx;
 
     assert (hash_len == SHA256_BLOCK_SIZE);
+    if (sha_ni_available ()) {
+        sha256_ni_digest (data, data_len, hash);
+        return;
+    }
     sha256_init (&ctx);
     sha256_update (&ctx, data, data_len);
     sha256_final (&ctx, hash);
 }
 
+static void blake3_hash (const void *data, int data_len, void *hash, int hash_len)
+{
+    BLAKE3_CTX ctx;
+
+    assert (hash_len == BLAKE3_OUT_LEN);
+    blake3_init (&ctx);
+    blake3_update (&ctx, data, data_len);
+    blake3_final (&ctx, hash);
+}
+
 /* true if s1 contains "s2-" prefix
  */
 static int prefixmatch (const char *s1, const char *s2)
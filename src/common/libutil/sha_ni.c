@@ -0,0 +1,285 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* sha_ni.c - SHA-1 and SHA-256 block transforms using the x86 SHA
+ *  extensions, after the Intel white paper "Intel SHA Extensions" (2013).
+ *
+ * The transforms are compiled with a function target attribute so the
+ *  rest of the tree need not be built for a newer ISA, and are only
+ *  called after cpuid reports support at runtime.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+#include <pthread.h>
+
+#include "sha_ni.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define HAVE_SHA_NI 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+typedef void (*transform_f)(uint32_t *state, const uint8_t *data,
+                            size_t nblocks);
+
+#if HAVE_SHA_NI
+static bool available;
+static pthread_once_t available_once = PTHREAD_ONCE_INIT;
+
+static void check_cpu (void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (__get_cpuid_max (0, NULL) < 7)
+        return;
+    __cpuid (1, eax, ebx, ecx, edx);
+    if (!(ecx & bit_SSSE3) || !(ecx & bit_SSE4_1))
+        return;
+    __cpuid_count (7, 0, eax, ebx, ecx, edx);
+    if (!(ebx & (1 << 29)))     /* SHA */
+        return;
+    available = true;
+}
+
+bool sha_ni_available (void)
+{
+    pthread_once (&available_once, check_cpu);
+    return available;
+}
+
+/* One SHA-1 step of 4 rounds.  Steps are expanded at compile time
+ * since sha1rnds4 takes its round function as an immediate.
+ * msg[] holds the 16 word message schedule window in 4 vectors, and
+ * each step also advances the schedule for step i + 1 (msg2), i + 2
+ * (xor) and i + 3 (msg1).
+ */
+#define SHA1_STEP(i) do { \
+    if ((i) < 4) \
+        msg[(i) & 3] = _mm_shuffle_epi8 ( \
+            _mm_loadu_si128 ((const __m128i *)(data + 16 * (i))), mask); \
+    if ((i) == 0) \
+        e[0] = _mm_add_epi32 (e[0], msg[0]); \
+    else \
+        e[(i) & 1] = _mm_sha1nexte_epu32 (e[(i) & 1], msg[(i) & 3]); \
+    e[((i) + 1) & 1] = abcd; \
+    if ((i) >= 3 && (i) <= 18) \
+        msg[((i) + 1) & 3] = _mm_sha1msg2_epu32 (msg[((i) + 1) & 3], \
+                                                 msg[(i) & 3]); \
+    abcd = _mm_sha1rnds4_epu32 (abcd, e[(i) & 1], (i) / 5); \
+    if ((i) >= 1 && (i) <= 16) \
+        msg[((i) + 3) & 3] = _mm_sha1msg1_epu32 (msg[((i) + 3) & 3], \
+                                                 msg[(i) & 3]); \
+    if ((i) >= 2 && (i) <= 17) \
+        msg[((i) + 2) & 3] = _mm_xor_si128 (msg[((i) + 2) & 3], \
+                                            msg[(i) & 3]); \
+} while (0)
+
+__attribute__((target("sha,sse4.1,ssse3")))
+static void sha1_transform (uint32_t *state, const uint8_t *data,
+                            size_t nblocks)
+{
+    const __m128i mask = _mm_set_epi64x (0x0001020304050607ULL,
+                                         0x08090a0b0c0d0e0fULL);
+    __m128i abcd, abcd_save, e_save;
+    __m128i e[2];
+    __m128i msg[4];
+
+    abcd = _mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *)state), 0x1B);
+    e[0] = _mm_set_epi32 (state[4], 0, 0, 0);
+
+    while (nblocks-- > 0) {
+        abcd_save = abcd;
+        e_save = e[0];
+
+        SHA1_STEP (0);  SHA1_STEP (1);  SHA1_STEP (2);  SHA1_STEP (3);
+        SHA1_STEP (4);  SHA1_STEP (5);  SHA1_STEP (6);  SHA1_STEP (7);
+        SHA1_STEP (8);  SHA1_STEP (9);  SHA1_STEP (10); SHA1_STEP (11);
+        SHA1_STEP (12); SHA1_STEP (13); SHA1_STEP (14); SHA1_STEP (15);
+        SHA1_STEP (16); SHA1_STEP (17); SHA1_STEP (18); SHA1_STEP (19);
+
+        e[0] = _mm_sha1nexte_epu32 (e[0], e_save);
+        abcd = _mm_add_epi32 (abcd, abcd_save);
+        data += 64;
+    }
+
+    _mm_storeu_si128 ((__m128i *)state, _mm_shuffle_epi32 (abcd, 0x1B));
+    state[4] = _mm_extract_epi32 (e[0], 3);
+}
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+/* One SHA-256 step of 4 rounds, advancing the message schedule for
+ * step i + 1 (msg2) and i + 3 (msg1) as in SHA1_STEP().
+ */
+#define SHA256_STEP(i) do { \
+    if ((i) < 4) \
+        msg[(i) & 3] = _mm_shuffle_epi8 ( \
+            _mm_loadu_si128 ((const __m128i *)(data + 16 * (i))), mask); \
+    wk = _mm_add_epi32 (msg[(i) & 3], \
+                        _mm_loadu_si128 ((const __m128i *) \
+                                         &sha256_k[4 * (i)])); \
+    state1 = _mm_sha256rnds2_epu32 (state1, state0, wk); \
+    if ((i) >= 3 && (i) <= 14) { \
+        tmp = _mm_alignr_epi8 (msg[(i) & 3], msg[((i) + 3) & 3], 4); \
+        msg[((i) + 1) & 3] = _mm_add_epi32 (msg[((i) + 1) & 3], tmp); \
+        msg[((i) + 1) & 3] = _mm_sha256msg2_epu32 (msg[((i) + 1) & 3], \
+                                                   msg[(i) & 3]); \
+    } \
+    wk = _mm_shuffle_epi32 (wk, 0x0E); \
+    state0 = _mm_sha256rnds2_epu32 (state0, state1, wk); \
+    if ((i) >= 1 && (i) <= 12) \
+        msg[((i) + 3) & 3] = _mm_sha256msg1_epu32 (msg[((i) + 3) & 3], \
+                                                   msg[(i) & 3]); \
+} while (0)
+
+__attribute__((target("sha,sse4.1,ssse3")))
+static void sha256_transform (uint32_t *state, const uint8_t *data,
+                              size_t nblocks)
+{
+    const __m128i mask = _mm_set_epi64x (0x0c0d0e0f08090a0bULL,
+                                         0x0405060700010203ULL);
+    __m128i state0, state1, save0, save1;
+    __m128i msg[4];
+    __m128i wk, tmp;
+
+    /* Rearrange state words into the ABEF/CDGH order the
+     * instructions expect.
+     */
+    tmp = _mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *)&state[0]),
+                             0xB1);
+    state1 = _mm_shuffle_epi32 (_mm_loadu_si128 ((const __m128i *)&state[4]),
+                                0x1B);
+    state0 = _mm_alignr_epi8 (tmp, state1, 8);
+    state1 = _mm_blend_epi16 (state1, tmp, 0xF0);
+
+    while (nblocks-- > 0) {
+        save0 = state0;
+        save1 = state1;
+
+        SHA256_STEP (0);  SHA256_STEP (1);  SHA256_STEP (2);
+        SHA256_STEP (3);  SHA256_STEP (4);  SHA256_STEP (5);
+        SHA256_STEP (6);  SHA256_STEP (7);  SHA256_STEP (8);
+        SHA256_STEP (9);  SHA256_STEP (10); SHA256_STEP (11);
+        SHA256_STEP (12); SHA256_STEP (13); SHA256_STEP (14);
+        SHA256_STEP (15);
+
+        state0 = _mm_add_epi32 (state0, save0);
+        state1 = _mm_add_epi32 (state1, save1);
+        data += 64;
+    }
+
+    tmp = _mm_shuffle_epi32 (state0, 0x1B);
+    state1 = _mm_shuffle_epi32 (state1, 0xB1);
+    state0 = _mm_blend_epi16 (tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8 (state1, tmp, 8);
+    _mm_storeu_si128 ((__m128i *)&state[0], state0);
+    _mm_storeu_si128 ((__m128i *)&state[4], state1);
+}
+
+#else /* !HAVE_SHA_NI */
+
+bool sha_ni_available (void)
+{
+    return false;
+}
+
+static void sha1_transform (uint32_t *state, const uint8_t *data,
+                            size_t nblocks)
+{
+}
+
+static void sha256_transform (uint32_t *state, const uint8_t *data,
+                              size_t nblocks)
+{
+}
+
+#endif /* !HAVE_SHA_NI */
+
+/* Run all of 'data' through 'transform', including the final padding
+ * and big-endian bit count common to SHA-1 and SHA-256.
+ */
+static void transform_padded (transform_f transform, uint32_t *state,
+                              const uint8_t *data, size_t len)
+{
+    uint8_t tail[128];
+    size_t nblocks = len / 64;
+    size_t rem = len % 64;
+    size_t tail_len = rem < 56 ? 64 : 128;
+    uint64_t bits = (uint64_t)len * 8;
+    int i;
+
+    if (nblocks > 0)
+        transform (state, data, nblocks);
+    memset (tail, 0, sizeof (tail));
+    if (rem > 0)
+        memcpy (tail, data + nblocks * 64, rem);
+    tail[rem] = 0x80;
+    for (i = 0; i < 8; i++)
+        tail[tail_len - 1 - i] = bits >> (8 * i);
+    transform (state, tail, tail_len / 64);
+}
+
+static void store_be32 (uint8_t *digest, const uint32_t *state, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++) {
+        digest[4 * i] = state[i] >> 24;
+        digest[4 * i + 1] = state[i] >> 16;
+        digest[4 * i + 2] = state[i] >> 8;
+        digest[4 * i + 3] = state[i];
+    }
+}
+
+void sha1_ni_digest (const void *data, size_t len, uint8_t digest[20])
+{
+    uint32_t state[5] = {
+        0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0,
+    };
+
+    transform_padded (sha1_transform, state, data, len);
+    store_be32 (digest, state, 5);
+}
+
+void sha256_ni_digest (const void *data, size_t len, uint8_t digest[32])
+{
+    uint32_t state[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+
+    transform_padded (sha256_transform, state, data, len);
+    store_be32 (digest, state, 8);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
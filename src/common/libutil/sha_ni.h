@@ -0,0 +1,33 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_SHA_NI_H
+#define _UTIL_SHA_NI_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* SHA-1 and SHA-256 using the x86 SHA extensions (SHA-NI).
+ * The digest functions may only be called if sha_ni_available()
+ * returns true, which is never the case on other architectures.
+ * Digests are identical to those of sha1.c and sha256.c.
+ */
+
+bool sha_ni_available (void);
+
+void sha1_ni_digest (const void *data, size_t len, uint8_t digest[20]);
+void sha256_ni_digest (const void *data, size_t len, uint8_t digest[32]);
+
+#endif /* !_UTIL_SHA_NI_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
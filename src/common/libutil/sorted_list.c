@@ -0,0 +1,275 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* sorted_list.c - ordered container of item pointers
+ *
+ * Items are stored in an array of chunks, each holding up to
+ * CHUNK_MAX item pointers in sorted order.  The chunk holding an item
+ * is found by binary search on the last item of each chunk, then the
+ * item by binary search within the chunk.  A full chunk is split in
+ * two, and a chunk that drops below a quarter full is merged with its
+ * neighbor when they fit in half a chunk.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "sorted_list.h"
+
+#define CHUNK_MAX 256
+
+struct chunk {
+    int count;
+    void *items[CHUNK_MAX];
+};
+
+struct sorted_list {
+    sorted_list_cmp_f cmp;
+    struct chunk **chunks;
+    int nchunks;
+    int maxchunks;
+    size_t size;
+    int cursor_chunk;
+    int cursor_index;
+};
+
+struct sorted_list *sorted_list_create (sorted_list_cmp_f cmp)
+{
+    struct sorted_list *sl;
+
+    if (!cmp) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(sl = calloc (1, sizeof (*sl))))
+        return NULL;
+    sl->cmp = cmp;
+    return sl;
+}
+
+void sorted_list_destroy (struct sorted_list *sl)
+{
+    if (sl) {
+        int saved_errno = errno;
+        int i;
+        for (i = 0; i < sl->nchunks; i++)
+            free (sl->chunks[i]);
+        free (sl->chunks);
+        free (sl);
+        errno = saved_errno;
+    }
+}
+
+size_t sorted_list_size (struct sorted_list *sl)
+{
+    return sl ? sl->size : 0;
+}
+
+/* Return index of the first chunk whose last item is >= item,
+ * or sl->nchunks if there is none.
+ */
+static int chunk_search (struct sorted_list *sl, const void *item)
+{
+    int lo = 0;
+    int hi = sl->nchunks;
+
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        struct chunk *c = sl->chunks[mid];
+        if (sl->cmp (c->items[c->count - 1], item) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* Return index of the first item in chunk that is >= item.
+ */
+static int item_search (struct sorted_list *sl,
+                        struct chunk *c,
+                        const void *item)
+{
+    int lo = 0;
+    int hi = c->count;
+
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (sl->cmp (c->items[mid], item) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static int chunk_insert (struct sorted_list *sl, int index)
+{
+    struct chunk *c;
+
+    if (sl->nchunks == sl->maxchunks) {
+        int maxchunks = sl->maxchunks ? sl->maxchunks * 2 : 4;
+        struct chunk **chunks;
+
+        if (!(chunks = realloc (sl->chunks, maxchunks * sizeof (chunks[0]))))
+            return -1;
+        sl->chunks = chunks;
+        sl->maxchunks = maxchunks;
+    }
+    if (!(c = malloc (sizeof (*c))))
+        return -1;
+    c->count = 0;
+    memmove (&sl->chunks[index + 1],
+             &sl->chunks[index],
+             (sl->nchunks - index) * sizeof (sl->chunks[0]));
+    sl->chunks[index] = c;
+    sl->nchunks++;
+    return 0;
+}
+
+static void chunk_remove (struct sorted_list *sl, int index)
+{
+    free (sl->chunks[index]);
+    memmove (&sl->chunks[index],
+             &sl->chunks[index + 1],
+             (sl->nchunks - index - 1) * sizeof (sl->chunks[0]));
+    sl->nchunks--;
+}
+
+int sorted_list_insert (struct sorted_list *sl, void *item)
+{
+    struct chunk *c;
+    int ci, i;
+
+    if (!sl) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (sl->nchunks == 0) {
+        if (chunk_insert (sl, 0) < 0)
+            goto nomem;
+        ci = 0;
+    }
+    else if ((ci = chunk_search (sl, item)) == sl->nchunks)
+        ci = sl->nchunks - 1;
+    c = sl->chunks[ci];
+    i = item_search (sl, c, item);
+    if (i < c->count && sl->cmp (c->items[i], item) == 0) {
+        errno = EEXIST;
+        return -1;
+    }
+    if (c->count == CHUNK_MAX) {
+        struct chunk *new;
+        int half = CHUNK_MAX / 2;
+
+        if (chunk_insert (sl, ci + 1) < 0)
+            goto nomem;
+        new = sl->chunks[ci + 1];
+        memcpy (new->items, &c->items[half], half * sizeof (c->items[0]));
+        new->count = half;
+        c->count = half;
+        if (i > half) {
+            c = new;
+            i -= half;
+        }
+    }
+    memmove (&c->items[i + 1],
+             &c->items[i],
+             (c->count - i) * sizeof (c->items[0]));
+    c->items[i] = item;
+    c->count++;
+    sl->size++;
+    return 0;
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
+int sorted_list_remove (struct sorted_list *sl, void *item)
+{
+    struct chunk *c;
+    int ci, i;
+
+    if (!sl) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((ci = chunk_search (sl, item)) == sl->nchunks)
+        goto noent;
+    c = sl->chunks[ci];
+    i = item_search (sl, c, item);
+    if (i == c->count || sl->cmp (c->items[i], item) != 0)
+        goto noent;
+    memmove (&c->items[i],
+             &c->items[i + 1],
+             (c->count - i - 1) * sizeof (c->items[0]));
+    c->count--;
+    sl->size--;
+
+    if (c->count == 0)
+        chunk_remove (sl, ci);
+    else if (c->count < CHUNK_MAX / 4 && ci + 1 < sl->nchunks) {
+        struct chunk *next = sl->chunks[ci + 1];
+        if (c->count + next->count <= CHUNK_MAX / 2) {
+            memcpy (&c->items[c->count],
+                    next->items,
+                    next->count * sizeof (next->items[0]));
+            c->count += next->count;
+            chunk_remove (sl, ci + 1);
+        }
+    }
+    return 0;
+noent:
+    errno = ENOENT;
+    return -1;
+}
+
+void *sorted_list_find (struct sorted_list *sl, const void *item)
+{
+    struct chunk *c;
+    int ci, i;
+
+    if (!sl || (ci = chunk_search (sl, item)) == sl->nchunks)
+        return NULL;
+    c = sl->chunks[ci];
+    i = item_search (sl, c, item);
+    if (i == c->count || sl->cmp (c->items[i], item) != 0)
+        return NULL;
+    return c->items[i];
+}
+
+void *sorted_list_first (struct sorted_list *sl)
+{
+    if (!sl || sl->nchunks == 0)
+        return NULL;
+    sl->cursor_chunk = 0;
+    sl->cursor_index = 0;
+    return sl->chunks[0]->items[0];
+}
+
+void *sorted_list_next (struct sorted_list *sl)
+{
+    if (!sl || sl->cursor_chunk >= sl->nchunks)
+        return NULL;
+    if (++sl->cursor_index == sl->chunks[sl->cursor_chunk]->count) {
+        sl->cursor_index = 0;
+        if (++sl->cursor_chunk == sl->nchunks)
+            return NULL;
+    }
+    return sl->chunks[sl->cursor_chunk]->items[sl->cursor_index];
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
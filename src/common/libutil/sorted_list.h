@@ -0,0 +1,64 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/*
+ *  sorted_list - ordered container of item pointers
+ *
+ *  Items are kept in sorted order by a comparator, in fixed size
+ *   chunks of contiguous pointers, so that insert and remove are a
+ *   binary search and iteration walks arrays rather than list nodes.
+ *
+ *  The comparator must be a total order: items comparing equal are
+ *   treated as duplicates.  The keys used by the comparator must not
+ *   change while an item is in the list.  The list does not own items.
+ */
+
+#ifndef HAVE_SORTED_LIST_H
+#define HAVE_SORTED_LIST_H
+
+#include <stddef.h>
+
+typedef int (*sorted_list_cmp_f) (const void *item1, const void *item2);
+
+struct sorted_list *sorted_list_create (sorted_list_cmp_f cmp);
+void sorted_list_destroy (struct sorted_list *sl);
+
+/*  Return number of items in the list.
+ */
+size_t sorted_list_size (struct sorted_list *sl);
+
+/*  Insert `item` in sorted position.
+ *  Returns 0 on success, -1 on failure with errno set:
+ *   EEXIST - an item comparing equal is already in the list
+ *   ENOMEM - out of memory
+ */
+int sorted_list_insert (struct sorted_list *sl, void *item);
+
+/*  Remove the item comparing equal to `item`.
+ *  Returns 0 on success, -1 with errno = ENOENT if not found.
+ */
+int sorted_list_remove (struct sorted_list *sl, void *item);
+
+/*  Return the item comparing equal to `item`, or NULL if not found.
+ */
+void *sorted_list_find (struct sorted_list *sl, const void *item);
+
+/*  Iterate items in sorted order using an internal cursor.
+ *   Return NULL when there are no more items.  Insert and remove
+ *   invalidate the cursor.
+ */
+void *sorted_list_first (struct sorted_list *sl);
+void *sorted_list_next (struct sorted_list *sl);
+
+#endif /* !HAVE_SORTED_LIST_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,95 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/blake3.h"
+
+/* From the BLAKE3 test vectors: input is bytes 0, 1, ... 250, 0, 1, ...
+ * of the given length; only the 32 byte default hash is checked.
+ */
+struct vector {
+    size_t len;
+    const char *hash;
+};
+
+static const struct vector vectors[] = {
+    { 0, "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262" },
+    { 1, "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213" },
+    { 1023,
+      "10108970eeda3eb932baac1428c7a2163b0e924c9a9e25b35bba72b28f70bd11" },
+    { 1024,
+      "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7" },
+    { 1025,
+      "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444" },
+    { 2048,
+      "e776b6028c7cd22a4d0ba182a8bf62205d2ef576467e838ed6f2529b85fba24a" },
+    { 2049,
+      "5f4d72f40d7a5f82b15ca2b2e44b1de3c2ef86c426c95c1af0b6879522563030" },
+    { 3072,
+      "b98cb0ff3623be03326b373de6b9095218513e64f1ee2edd2525c7ad1e5cffd2" },
+    { 8192,
+      "aae792484c8efe4f19e2ca7d371d8c467ffb10748d8a5a1ae579948f718a2a63" },
+    { 102400,
+      "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085" },
+};
+
+static uint8_t input[102400];
+
+static void tohex (const uint8_t *digest, char *s)
+{
+    int i;
+
+    for (i = 0; i < BLAKE3_OUT_LEN; i++)
+        sprintf (s + 2 * i, "%02x", digest[i]);
+}
+
+int main (int argc, char *argv[])
+{
+    BLAKE3_CTX ctx;
+    uint8_t digest[BLAKE3_OUT_LEN];
+    char hex[BLAKE3_OUT_LEN * 2 + 1];
+    size_t i;
+    size_t n;
+
+    plan (NO_PLAN);
+
+    for (i = 0; i < sizeof (input); i++)
+        input[i] = i % 251;
+
+    for (i = 0; i < sizeof (vectors) / sizeof (vectors[0]); i++) {
+        blake3_init (&ctx);
+        blake3_update (&ctx, input, vectors[i].len);
+        blake3_final (&ctx, digest);
+        tohex (digest, hex);
+        ok (!strcmp (hex, vectors[i].hash),
+            "blake3 input_len=%zu", vectors[i].len);
+    }
+
+    /* Odd sized updates cross block and chunk boundaries */
+    for (i = 0; i < sizeof (vectors) / sizeof (vectors[0]); i++) {
+        blake3_init (&ctx);
+        for (n = 0; n < vectors[i].len; n += 7)
+            blake3_update (&ctx, input + n,
+                           vectors[i].len - n < 7 ? vectors[i].len - n : 7);
+        blake3_final (&ctx, digest);
+        tohex (digest, hex);
+        ok (!strcmp (hex, vectors[i].hash),
+            "blake3 input_len=%zu in 7 byte updates", vectors[i].len);
+    }
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
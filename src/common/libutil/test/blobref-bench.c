@@ -0,0 +1,121 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* blobref-bench - compare blobref hash throughput by blob size.
+ *
+ * Usage: blobref-bench [MBYTES]
+ *
+ * For each blob size, MBYTES of data (default 64) is hashed in
+ *  blob sized pieces with each hash type, and MB/s is reported.
+ *  The sha1 and sha256 columns use blobref_hash(), which selects
+ *  the SHA extensions when the CPU has them; the "-c" columns force
+ *  the portable C implementation for comparison.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libutil/blobref.h"
+#include "src/common/libutil/sha1.h"
+#include "src/common/libutil/sha256.h"
+
+static const size_t sizes[] = {
+    64, 256, 1024, 4096, 16384, 65536, 1048576,
+};
+
+static void sha1_c (const void *data, size_t len)
+{
+    SHA1_CTX ctx;
+    uint8_t digest[SHA1_DIGEST_SIZE];
+
+    SHA1_Init (&ctx);
+    SHA1_Update (&ctx, data, len);
+    SHA1_Final (&ctx, digest);
+}
+
+static void sha256_c (const void *data, size_t len)
+{
+    SHA256_CTX ctx;
+    uint8_t digest[SHA256_BLOCK_SIZE];
+
+    sha256_init (&ctx);
+    sha256_update (&ctx, data, len);
+    sha256_final (&ctx, digest);
+}
+
+/* Hash 'total' bytes in 'size' pieces using 'fun' if non-NULL,
+ * otherwise blobref_hash() with 'hashtype'.  Return MB/s.
+ */
+static double bench (const char *hashtype,
+                     void (*fun)(const void *data, size_t len),
+                     const uint8_t *data,
+                     size_t size,
+                     size_t total)
+{
+    char ref[BLOBREF_MAX_STRING_SIZE];
+    size_t count = total / size > 0 ? total / size : 1;
+    struct timespec t0;
+    double elapsed;
+
+    monotime (&t0);
+    for (size_t i = 0; i < count; i++) {
+        if (fun)
+            fun (data, size);
+        else if (blobref_hash (hashtype, data, size, ref, sizeof (ref)) < 0)
+            log_err_exit ("blobref_hash %s", hashtype);
+    }
+    elapsed = monotime_since (t0);
+    if (elapsed <= 0)
+        elapsed = 1E-3;
+    return ((double)count * size / (1024. * 1024.)) / (elapsed / 1000.);
+}
+
+int main (int argc, char *argv[])
+{
+    int mbytes = argc > 1 ? strtol (argv[1], NULL, 10) : 64;
+    size_t total;
+    uint8_t *data;
+
+    log_init ("blobref-bench");
+
+    if (mbytes <= 0)
+        log_msg_exit ("Usage: blobref-bench [MBYTES]");
+    total = (size_t)mbytes * 1024 * 1024;
+    if (!(data = malloc (sizes[sizeof (sizes) / sizeof (sizes[0]) - 1])))
+        log_err_exit ("malloc");
+    for (size_t i = 0; i < sizes[sizeof (sizes) / sizeof (sizes[0]) - 1]; i++)
+        data[i] = rand ();
+
+    printf ("%8s %10s %10s %10s %10s %10s\n",
+            "SIZE", "SHA1-C", "SHA1", "SHA256-C", "SHA256", "BLAKE3");
+    for (int i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++) {
+        printf ("%8zu %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                sizes[i],
+                bench (NULL, sha1_c, data, sizes[i], total),
+                bench ("sha1", NULL, data, sizes[i], total),
+                bench (NULL, sha256_c, data, sizes[i], total),
+                bench ("sha256", NULL, data, sizes[i], total),
+                bench ("blake3", NULL, data, sizes[i], total));
+        fflush (stdout);
+    }
+
+    free (data);
+    log_fini ();
+    return 0;
+}
+
+/* vi: ts=4 sw=4 expandtab
+ */
@@ -0,0 +1,72 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/sha1.h"
+#include "src/common/libutil/sha256.h"
+#include "src/common/libutil/sha_ni.h"
+
+#define MAXLEN 4200
+
+/* Compare against the portable implementations for every length that
+ * exercises the padding (rem < 56 and >= 56) and multi-block input.
+ */
+int main (int argc, char *argv[])
+{
+    static uint8_t data[MAXLEN];
+    uint8_t expected[32];
+    uint8_t digest[32];
+    int sha1_errors = 0;
+    int sha256_errors = 0;
+    size_t len;
+
+    if (!sha_ni_available ())
+        plan (SKIP_ALL, "CPU does not support SHA extensions");
+    plan (NO_PLAN);
+
+    for (len = 0; len < MAXLEN; len++)
+        data[len] = rand ();
+
+    for (len = 0; len < MAXLEN; len += len < 300 ? 1 : 61) {
+        SHA1_CTX ctx1;
+        SHA256_CTX ctx256;
+
+        SHA1_Init (&ctx1);
+        SHA1_Update (&ctx1, data, len);
+        SHA1_Final (&ctx1, expected);
+        sha1_ni_digest (data, len, digest);
+        if (memcmp (expected, digest, SHA1_DIGEST_SIZE) != 0) {
+            diag ("sha1 len=%zu mismatch", len);
+            sha1_errors++;
+        }
+
+        sha256_init (&ctx256);
+        sha256_update (&ctx256, data, len);
+        sha256_final (&ctx256, expected);
+        sha256_ni_digest (data, len, digest);
+        if (memcmp (expected, digest, SHA256_BLOCK_SIZE) != 0) {
+            diag ("sha256 len=%zu mismatch", len);
+            sha256_errors++;
+        }
+    }
+    ok (sha1_errors == 0,
+        "sha1_ni_digest matches portable sha1");
+    ok (sha256_errors == 0,
+        "sha256_ni_digest matches portable sha256");
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,159 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <errno.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/sorted_list.h"
+
+static int int_cmp (const void *a, const void *b)
+{
+    int i = *(const int *)a;
+    int j = *(const int *)b;
+    return i < j ? -1 : i > j ? 1 : 0;
+}
+
+/* Iterate the list and check it is in order with 'n' items.
+ */
+static bool check_sorted (struct sorted_list *sl, int n)
+{
+    int *ip;
+    int prev = -1;
+    int count = 0;
+
+    ip = sorted_list_first (sl);
+    while (ip) {
+        if (*ip <= prev)
+            return false;
+        prev = *ip;
+        count++;
+        ip = sorted_list_next (sl);
+    }
+    return count == n;
+}
+
+void test_basic (void)
+{
+    struct sorted_list *sl;
+    int items[] = { 5, 1, 4, 2, 3 };
+    int dup = 3;
+    int missing = 42;
+    int *ip;
+    int i;
+
+    ok (sorted_list_create (NULL) == NULL && errno == EINVAL,
+        "sorted_list_create (NULL) fails with EINVAL");
+    sl = sorted_list_create (int_cmp);
+    ok (sl != NULL, "sorted_list_create works");
+    ok (sorted_list_size (sl) == 0, "sorted_list_size == 0");
+    ok (sorted_list_first (sl) == NULL, "sorted_list_first on empty list");
+
+    for (i = 0; i < 5; i++) {
+        if (sorted_list_insert (sl, &items[i]) < 0)
+            break;
+    }
+    ok (i == 5, "sorted_list_insert 5 items works");
+    ok (sorted_list_size (sl) == 5, "sorted_list_size == 5");
+    ok (check_sorted (sl, 5), "items are iterated in order");
+
+    errno = 0;
+    ok (sorted_list_insert (sl, &dup) < 0 && errno == EEXIST,
+        "sorted_list_insert of duplicate fails with EEXIST");
+    ip = sorted_list_find (sl, &dup);
+    ok (ip == &items[4], "sorted_list_find returns inserted item");
+    ok (sorted_list_find (sl, &missing) == NULL,
+        "sorted_list_find of missing item returns NULL");
+
+    ok (sorted_list_remove (sl, &dup) == 0, "sorted_list_remove works");
+    ok (sorted_list_size (sl) == 4, "sorted_list_size == 4");
+    ok (check_sorted (sl, 4), "items are in order after remove");
+    errno = 0;
+    ok (sorted_list_remove (sl, &dup) < 0 && errno == ENOENT,
+        "sorted_list_remove of missing item fails with ENOENT");
+    errno = 0;
+    ok (sorted_list_remove (sl, &missing) < 0 && errno == ENOENT,
+        "sorted_list_remove past end fails with ENOENT");
+
+    sorted_list_destroy (sl);
+}
+
+/* Insert enough items to split chunks many times, in an order that
+ * hits both the start and end of chunks, then remove most of them.
+ */
+void test_large (void)
+{
+    struct sorted_list *sl;
+    const int n = 10000;
+    int *items;
+    int i;
+    int errors;
+
+    if (!(items = calloc (n, sizeof (items[0]))))
+        BAIL_OUT ("calloc failed");
+    if (!(sl = sorted_list_create (int_cmp)))
+        BAIL_OUT ("sorted_list_create failed");
+
+    errors = 0;
+    for (i = 0; i < n; i++) {
+        /* alternate low and high values */
+        items[i] = (i % 2) ? n - i : i;
+        if (sorted_list_insert (sl, &items[i]) < 0)
+            errors++;
+    }
+    ok (errors == 0, "sorted_list_insert %d items works", n);
+    ok (sorted_list_size (sl) == n, "sorted_list_size == %d", n);
+    ok (check_sorted (sl, n), "items are iterated in order");
+
+    errors = 0;
+    for (i = 0; i < n; i++) {
+        if (sorted_list_find (sl, &items[i]) != &items[i])
+            errors++;
+    }
+    ok (errors == 0, "sorted_list_find finds all items");
+
+    errors = 0;
+    for (i = 0; i < n; i++) {
+        if (i % 10 == 0)
+            continue;
+        if (sorted_list_remove (sl, &items[i]) < 0)
+            errors++;
+    }
+    ok (errors == 0, "sorted_list_remove 90%% of items works");
+    ok (sorted_list_size (sl) == n / 10, "sorted_list_size == %d", n / 10);
+    ok (check_sorted (sl, n / 10), "remaining items are in order");
+
+    errors = 0;
+    for (i = 0; i < n; i += 10) {
+        if (sorted_list_remove (sl, &items[i]) < 0)
+            errors++;
+    }
+    ok (errors == 0 && sorted_list_size (sl) == 0,
+        "sorted_list_remove of remaining items empties list");
+    ok (sorted_list_first (sl) == NULL, "sorted_list_first returns NULL");
+
+    sorted_list_destroy (sl);
+    free (items);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_basic ();
+    test_large ();
+
+    done_testing ();
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -198,14 +198,60 @@ static int override_retry_count (struct usock_retry_params *retry)
     return 0;
 }
 
+/* If FLUX_LOCAL_CONNECTOR_SHM is set to a size in bytes, shared memory
+ * rings of that size are requested from the broker.  The broker rounds
+ * the size up to a power of two and caps it (see shmring.h).
+ */
+static int get_shm_size (size_t *size)
+{
+    const char *s;
+
+    *size = 0;
+    if ((s = getenv ("FLUX_LOCAL_CONNECTOR_SHM"))) {
+        char *endptr;
+        long n;
+
+        errno = 0;
+        n = strtol (s, &endptr, 10);
+        if (errno != 0 || *endptr != '\0' || n < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        *size = n;
+    }
+    return 0;
+}
+
+static int local_connect (struct local_connector *ctx,
+                          const char *path,
+                          struct usock_retry_params retry)
+{
+    if ((ctx->fd = usock_client_connect (path, retry)) < 0)
+        return -1;
+    if (!(ctx->uclient = usock_client_create (ctx->fd)))
+        return -1;
+    return 0;
+}
+
+static void local_disconnect (struct local_connector *ctx)
+{
+    usock_client_destroy (ctx->uclient);
+    ctx->uclient = NULL;
+    if (ctx->fd >= 0)
+        (void)close (ctx->fd);
+    ctx->fd = -1;
+}
+
 /* Path is interpreted as the directory containing the unix domain socket.
  */
 flux_t *connector_init (const char *path, int flags)
 {
     struct local_connector *ctx;
     struct usock_retry_params retry = USOCK_RETRY_DEFAULT;
+    size_t shm_size;
 
-    if (!path || override_retry_count (&retry) < 0) {
+    if (!path || override_retry_count (&retry) < 0
+              || get_shm_size (&shm_size) < 0) {
         errno = EINVAL;
         return NULL;
     }
@@ -215,11 +261,19 @@ flux_t *connector_init (const char *path, int flags)
     ctx->testing_userid = FLUX_USERID_UNKNOWN;
     ctx->testing_rolemask = FLUX_ROLE_NONE;
 
-    ctx->fd = usock_client_connect (path, retry);
-    if (ctx->fd < 0)
-        goto error;
-    if (!(ctx->uclient = usock_client_create (ctx->fd)))
+    if (local_connect (ctx, path, retry) < 0)
         goto error;
+    /* If the broker declines shared memory, continue on the socket.
+     * A broker without shared memory support drops the connection on
+     * the hello, so reconnect without it.
+     */
+    if (shm_size > 0
+        && usock_client_enable_shm (ctx->uclient, shm_size) < 0
+        && (errno == ECONNRESET || errno == EPROTO || errno == EPIPE)) {
+        local_disconnect (ctx);
+        if (local_connect (ctx, path, retry) < 0)
+            goto error;
+    }
     if (!(ctx->h = flux_handle_create (ctx, &handle_ops, flags)))
         goto error;
     return ctx->h;
@@ -14,27 +14,56 @@
 #include "config.h"
 #endif
 #include <sqlite3.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <stdbool.h>
 #include <czmq.h>
 #include <lz4.h>
+#if HAVE_ZSTD
+#include <zstd.h>
+#endif
 #include <flux/core.h>
 
 #include "src/common/libutil/blobref.h"
 #include "src/common/libutil/cleanup.h"
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/errno_safe.h"
+#include "src/common/libutil/read_all.h"
+
+const size_t comp_buf_chunksize = 1024*1024;
+const int default_compression_threshold = 256; /* compress blobs >= this */
 
-const size_t lzo_buf_chunksize = 1024*1024;
-const size_t compression_threshold = 256; /* compress blobs >= this size */
+/* Codec used to compress an object, stored per row in the 'codec' column.
+ * Rows written before the column existed have codec NULL, and are
+ * CODEC_NONE if size is -1, otherwise CODEC_LZ4.
+ */
+enum {
+    CODEC_NONE = 0,
+    CODEC_LZ4 = 1,
+    CODEC_ZSTD = 2,
+};
 
 const char *sql_create_table = "CREATE TABLE if not exists objects("
                                "  hash CHAR(20) PRIMARY KEY,"
                                "  size INT,"
-                               "  object BLOB"
+                               "  object BLOB,"
+                               "  codec INT"
                                ");";
-const char *sql_load = "SELECT object,size FROM objects"
+const char *sql_add_codec = "ALTER TABLE objects ADD COLUMN codec INT";
+const char *sql_load = "SELECT object,size,codec FROM objects"
                        "  WHERE hash = ?1 LIMIT 1";
-const char *sql_store = "INSERT INTO objects (hash,size,object) "
-                        "  values (?1, ?2, ?3)";
+const char *sql_store = "INSERT INTO objects (hash,size,object,codec) "
+                        "  values (?1, ?2, ?3, ?4)";
+const char *sql_create_table_dicts = "CREATE TABLE if not exists zstd_dicts("
+                                     "  id INT PRIMARY KEY"
+                                     ");";
+const char *sql_dicts_get = "SELECT id FROM zstd_dicts";
+const char *sql_dicts_put = "INSERT OR IGNORE INTO zstd_dicts (id) "
+                            "  values (%u)";
+const char *sql_begin = "BEGIN TRANSACTION";
+const char *sql_commit = "COMMIT TRANSACTION";
 
 const char *sql_create_table_checkpt = "CREATE TABLE if not exists checkpt("
                                        "  key TEXT UNIQUE,"
@@ -51,13 +80,25 @@ struct content_sqlite {
     sqlite3 *db;
     sqlite3_stmt *load_stmt;
     sqlite3_stmt *store_stmt;
+    sqlite3_stmt *begin_stmt;
+    sqlite3_stmt *commit_stmt;
     sqlite3_stmt *checkpt_get_stmt;
     sqlite3_stmt *checkpt_put_stmt;
     flux_t *h;
     const char *hashfun;
     uint32_t blob_size_limit;
-    size_t lzo_bufsize;
-    void *lzo_buf;
+    size_t comp_bufsize;
+    void *comp_buf;
+    int codec;                  /* codec for newly stored objects */
+    int compression_threshold;  /* compress blobs >= this size */
+#if HAVE_ZSTD
+    ZSTD_CCtx *zstd_cctx;
+    ZSTD_DCtx *zstd_dctx;
+    ZSTD_CDict *zstd_cdict;     /* optional dictionary */
+    ZSTD_DDict *zstd_ddict;
+    unsigned int zstd_dict_id;
+    bool zstd_dict_recorded;    /* zstd_dict_id is in zstd_dicts table */
+#endif
 };
 
 static void log_sqlite_error (struct content_sqlite *ctx, const char *fmt, ...)
@@ -108,20 +149,175 @@ static void set_errno_from_sqlite_error (struct content_sqlite *ctx)
     }
 }
 
-static int grow_lzo_buf (struct content_sqlite *ctx, size_t size)
+static int grow_comp_buf (struct content_sqlite *ctx, size_t size)
 {
-    size_t newsize = ctx->lzo_bufsize;
+    size_t newsize = ctx->comp_bufsize;
     void *newbuf;
     while (newsize < size)
-        newsize += lzo_buf_chunksize;
-    if (!(newbuf = realloc (ctx->lzo_buf, newsize))) {
+        newsize += comp_buf_chunksize;
+    if (!(newbuf = realloc (ctx->comp_buf, newsize))) {
         errno = ENOMEM;
         return -1;
     }
-    ctx->lzo_bufsize = newsize;
-    ctx->lzo_buf = newbuf;
+    ctx->comp_bufsize = newsize;
+    ctx->comp_buf = newbuf;
+    return 0;
+}
+
+static int codec_parse (const char *name)
+{
+    if (!strcmp (name, "none"))
+        return CODEC_NONE;
+    if (!strcmp (name, "lz4"))
+        return CODEC_LZ4;
+#if HAVE_ZSTD
+    if (!strcmp (name, "zstd"))
+        return CODEC_ZSTD;
+#endif
+    errno = EINVAL;
+    return -1;
+}
+
+/* Compress 'data' of 'size' bytes into ctx->comp_buf with ctx->codec.
+ * Returns compressed size on success, -1 on failure with errno set.
+ */
+static int codec_compress (struct content_sqlite *ctx,
+                           const void *data,
+                           int size)
+{
+    int bound;
+    int r;
+
+    switch (ctx->codec) {
+        case CODEC_LZ4:
+            bound = LZ4_compressBound (size);
+            if (ctx->comp_bufsize < bound && grow_comp_buf (ctx, bound) < 0)
+                return -1;
+            if ((r = LZ4_compress_default (data,
+                                           ctx->comp_buf,
+                                           size,
+                                           bound)) == 0)
+                goto inval;
+            return r;
+#if HAVE_ZSTD
+        case CODEC_ZSTD: {
+            size_t zr;
+            bound = ZSTD_compressBound (size);
+            if (ctx->comp_bufsize < bound && grow_comp_buf (ctx, bound) < 0)
+                return -1;
+            if (ctx->zstd_cdict)
+                zr = ZSTD_compress_usingCDict (ctx->zstd_cctx,
+                                               ctx->comp_buf,
+                                               bound,
+                                               data,
+                                               size,
+                                               ctx->zstd_cdict);
+            else
+                zr = ZSTD_compressCCtx (ctx->zstd_cctx,
+                                        ctx->comp_buf,
+                                        bound,
+                                        data,
+                                        size,
+                                        ZSTD_CLEVEL_DEFAULT);
+            if (ZSTD_isError (zr))
+                goto inval;
+            return zr;
+        }
+#endif
+    }
+inval:
+    errno = EINVAL;
+    return -1;
+}
+
+/* Uncompress 'data' of 'size' bytes into ctx->comp_buf with 'codec'.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+static int codec_uncompress (struct content_sqlite *ctx,
+                             int codec,
+                             const void *data,
+                             int size,
+                             int uncompressed_size)
+{
+    int r;
+
+    if (ctx->comp_bufsize < uncompressed_size
+                        && grow_comp_buf (ctx, uncompressed_size) < 0)
+        return -1;
+    switch (codec) {
+        case CODEC_LZ4:
+            r = LZ4_decompress_safe (data,
+                                     ctx->comp_buf,
+                                     size,
+                                     uncompressed_size);
+            if (r < 0)
+                goto inval;
+            break;
+#if HAVE_ZSTD
+        case CODEC_ZSTD: {
+            unsigned int dict_id = ZSTD_getDictID_fromFrame (data, size);
+            size_t zr;
+            if (dict_id != 0) {
+                if (!ctx->zstd_ddict || ctx->zstd_dict_id != dict_id) {
+                    flux_log (ctx->h, LOG_ERR,
+                              "load: zstd dictionary %u is not loaded",
+                              dict_id);
+                    goto inval;
+                }
+                zr = ZSTD_decompress_usingDDict (ctx->zstd_dctx,
+                                                 ctx->comp_buf,
+                                                 uncompressed_size,
+                                                 data,
+                                                 size,
+                                                 ctx->zstd_ddict);
+            }
+            else
+                zr = ZSTD_decompressDCtx (ctx->zstd_dctx,
+                                          ctx->comp_buf,
+                                          uncompressed_size,
+                                          data,
+                                          size);
+            if (ZSTD_isError (zr)) {
+                flux_log (ctx->h, LOG_ERR, "load: zstd: %s",
+                          ZSTD_getErrorName (zr));
+                goto inval;
+            }
+            r = zr;
+            break;
+        }
+#endif
+        default:
+            flux_log (ctx->h, LOG_ERR, "load: unknown codec %d", codec);
+            goto inval;
+    }
+    if (r != uncompressed_size) {
+        flux_log (ctx->h, LOG_ERR, "load: blob size mismatch");
+        goto inval;
+    }
+    return 0;
+inval:
+    errno = EINVAL;
+    return -1;
+}
+
+#if HAVE_ZSTD
+/* Note in the zstd_dicts table that objects have been compressed with
+ * the loaded dictionary, so the module refuses to start without it.
+ */
+static int record_zstd_dict (struct content_sqlite *ctx)
+{
+    char sql[64];
+
+    (void)snprintf (sql, sizeof (sql), sql_dicts_put, ctx->zstd_dict_id);
+    if (sqlite3_exec (ctx->db, sql, NULL, NULL, NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "store: recording zstd dictionary");
+        set_errno_from_sqlite_error (ctx);
+        return -1;
+    }
+    ctx->zstd_dict_recorded = true;
     return 0;
 }
+#endif
 
 /* Load blob from objects table, uncompressing if necessary.
  * Returns 0 on success, -1 on error with errno set.
@@ -138,6 +334,7 @@ static int content_sqlite_load (struct content_sqlite *ctx,
     const void *data = NULL;
     int size = 0;
     int uncompressed_size;
+    int codec;
 
     if ((hash_len = blobref_strtohash (blobref, hash, sizeof (hash))) < 0) {
         errno = ENOENT;
@@ -171,24 +368,14 @@ static int content_sqlite_load (struct content_sqlite *ctx,
         goto error;
     }
     uncompressed_size = sqlite3_column_int (ctx->load_stmt, 1);
-    if (uncompressed_size != -1) {
-        if (ctx->lzo_bufsize < uncompressed_size
-                                && grow_lzo_buf (ctx, uncompressed_size) < 0)
-            goto error;
-        int r = LZ4_decompress_safe (data,
-                                     ctx->lzo_buf,
-                                     size,
-                                     uncompressed_size);
-        if (r < 0) {
-            errno = EINVAL;
-            goto error;
-        }
-        if (r != uncompressed_size) {
-            flux_log (ctx->h, LOG_ERR, "load: blob size mismatch");
-            errno = EINVAL;
+    if (sqlite3_column_type (ctx->load_stmt, 2) == SQLITE_NULL)
+        codec = uncompressed_size == -1 ? CODEC_NONE : CODEC_LZ4;
+    else
+        codec = sqlite3_column_int (ctx->load_stmt, 2);
+    if (codec != CODEC_NONE) {
+        if (codec_uncompress (ctx, codec, data, size, uncompressed_size) < 0)
             goto error;
-        }
-        data = ctx->lzo_buf;
+        data = ctx->comp_buf;
         size = uncompressed_size;
     }
     *datap = data;
@@ -200,6 +387,7 @@ error:
 }
 
 /* Store blob to objects table, compressing if necessary.
+ * If compression does not make the blob smaller, it is stored uncompressed.
  * Blobref resulting from hash over 'data' is stored to 'blobref'.
  * Returns 0 on success, -1 on error with errno set.
  */
@@ -212,6 +400,7 @@ static int content_sqlite_store (struct content_sqlite *ctx,
     uint8_t hash[BLOBREF_MAX_DIGEST_SIZE];
     int hash_len;
     int uncompressed_size = -1;
+    int codec = CODEC_NONE;
 
     if (size > ctx->blob_size_limit) {
         errno = EFBIG;
@@ -225,19 +414,23 @@ static int content_sqlite_store (struct content_sqlite *ctx,
         return -1;
     if ((hash_len = blobref_strtohash (blobref, hash, sizeof (hash))) < 0)
         return -1;
-    if (size >= compression_threshold) {
+    if (ctx->codec != CODEC_NONE && size >= ctx->compression_threshold) {
         int r;
-        int out_len = LZ4_compressBound(size);
-        if (ctx->lzo_bufsize < out_len && grow_lzo_buf (ctx, out_len) < 0)
-            return -1;
-        r = LZ4_compress_default (data, ctx->lzo_buf, size, out_len);
-        if (r == 0) {
-            errno = EINVAL;
+        if ((r = codec_compress (ctx, data, size)) < 0)
             return -1;
+        if (r < size) {
+#if HAVE_ZSTD
+            if (ctx->codec == CODEC_ZSTD
+                && ctx->zstd_cdict
+                && !ctx->zstd_dict_recorded
+                && record_zstd_dict (ctx) < 0)
+                return -1;
+#endif
+            codec = ctx->codec;
+            uncompressed_size = size;
+            size = r;
+            data = ctx->comp_buf;
         }
-        uncompressed_size = size;
-        size = r;
-        data = ctx->lzo_buf;
     }
     if (sqlite3_bind_text (ctx->store_stmt,
                            1,
@@ -264,6 +457,11 @@ static int content_sqlite_store (struct content_sqlite *ctx,
         set_errno_from_sqlite_error (ctx);
         goto error;
     }
+    if (sqlite3_bind_int (ctx->store_stmt, 4, codec) != SQLITE_OK) {
+        log_sqlite_error (ctx, "store: binding codec");
+        set_errno_from_sqlite_error (ctx);
+        goto error;
+    }
     if (sqlite3_step (ctx->store_stmt) != SQLITE_DONE
                     && sqlite3_errcode (ctx->db) != SQLITE_CONSTRAINT) {
         log_sqlite_error (ctx, "store: executing stmt");
@@ -335,6 +533,106 @@ error:
         flux_log_error (h, "store: flux_respond_error");
 }
 
+/* Run a prepared statement that returns no rows, e.g. BEGIN or COMMIT.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+static int content_sqlite_exec (struct content_sqlite *ctx,
+                                sqlite3_stmt *stmt,
+                                const char *name)
+{
+    if (sqlite3_step (stmt) != SQLITE_DONE) {
+        log_sqlite_error (ctx, "%s: executing stmt", name);
+        set_errno_from_sqlite_error (ctx);
+        ERRNO_SAFE_WRAP (sqlite3_reset, stmt);
+        return -1;
+    }
+    sqlite3_reset (stmt);
+    return 0;
+}
+
+/* Store a batch of blobs in one sqlite transaction.
+ * The request payload is a sequence of blobs, each preceded by its
+ * length as a 4 byte integer in network byte order.  The response payload
+ * is the sequence of resulting NULL-terminated blobrefs, in request order.
+ * N.B. with journal_mode=OFF, ROLLBACK is not available, so on error the
+ * blobs stored so far are committed and an error is returned.  Since the
+ * objects table is content addressed, storing them again later is harmless.
+ */
+void store_batch_cb (flux_t *h,
+                     flux_msg_handler_t *mh,
+                     const flux_msg_t *msg,
+                     void *arg)
+{
+    struct content_sqlite *ctx = arg;
+    const uint8_t *data;
+    int size;
+    char *refs = NULL;
+    size_t refs_size = 0;
+    size_t refs_len = 0;
+    int saved_errno;
+
+    if (flux_request_decode_raw (msg, NULL, (const void **)&data, &size) < 0) {
+        flux_log_error (h, "store-batch: request decode failed");
+        goto error;
+    }
+    if (content_sqlite_exec (ctx, ctx->begin_stmt, "store-batch: begin") < 0)
+        goto error;
+    while (size > 0) {
+        char blobref[BLOBREF_MAX_STRING_SIZE];
+        uint32_t len;
+        size_t reflen;
+
+        if (size < sizeof (len)) {
+            errno = EPROTO;
+            goto error_commit;
+        }
+        memcpy (&len, data, sizeof (len));
+        len = ntohl (len);
+        data += sizeof (len);
+        size -= sizeof (len);
+        if (len > size) {
+            errno = EPROTO;
+            goto error_commit;
+        }
+        if (content_sqlite_store (ctx,
+                                  data,
+                                  len,
+                                  blobref,
+                                  sizeof (blobref)) < 0)
+            goto error_commit;
+        data += len;
+        size -= len;
+
+        reflen = strlen (blobref) + 1;
+        if (refs_len + reflen > refs_size) {
+            size_t newsize = refs_size ? refs_size * 2 : 4096;
+            char *newrefs;
+            while (newsize < refs_len + reflen)
+                newsize *= 2;
+            if (!(newrefs = realloc (refs, newsize)))
+                goto error_commit;
+            refs = newrefs;
+            refs_size = newsize;
+        }
+        memcpy (refs + refs_len, blobref, reflen);
+        refs_len += reflen;
+    }
+    if (content_sqlite_exec (ctx, ctx->commit_stmt, "store-batch: commit") < 0)
+        goto error;
+    if (flux_respond_raw (h, msg, refs, refs_len) < 0)
+        flux_log_error (h, "store-batch: flux_respond_raw");
+    free (refs);
+    return;
+error_commit:
+    saved_errno = errno;
+    (void)content_sqlite_exec (ctx, ctx->commit_stmt, "store-batch: commit");
+    errno = saved_errno;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "store-batch: flux_respond_error");
+    ERRNO_SAFE_WRAP (free, refs);
+}
+
 void checkpoint_get_cb (flux_t *h,
                         flux_msg_handler_t *mh,
                         const flux_msg_t *msg,
@@ -477,6 +775,14 @@ static void content_sqlite_closedb (struct content_sqlite *ctx)
             if (sqlite3_finalize (ctx->store_stmt) != SQLITE_OK)
                 log_sqlite_error (ctx, "sqlite_finalize store_stmt");
         }
+        if (ctx->begin_stmt) {
+            if (sqlite3_finalize (ctx->begin_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize begin_stmt");
+        }
+        if (ctx->commit_stmt) {
+            if (sqlite3_finalize (ctx->commit_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize commit_stmt");
+        }
         if (ctx->load_stmt) {
             if (sqlite3_finalize (ctx->load_stmt) != SQLITE_OK)
                 log_sqlite_error (ctx, "sqlite_finalize load_stmt");
@@ -539,6 +845,28 @@ static int content_sqlite_opendb (struct content_sqlite *ctx)
         log_sqlite_error (ctx, "creating object table");
         goto error;
     }
+    /* Databases created before the codec column was added lack it.
+     * Add it, ignoring the error if it is already present.
+     */
+    if (sqlite3_exec (ctx->db,
+                      sql_add_codec,
+                      NULL,
+                      NULL,
+                      NULL) != SQLITE_OK
+        && strncmp (sqlite3_errmsg (ctx->db),
+                    "duplicate column name",
+                    21) != 0) {
+        log_sqlite_error (ctx, "adding codec column");
+        goto error;
+    }
+    if (sqlite3_exec (ctx->db,
+                      sql_create_table_dicts,
+                      NULL,
+                      NULL,
+                      NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "creating zstd_dicts table");
+        goto error;
+    }
     if (sqlite3_exec (ctx->db,
                       sql_create_table_checkpt,
                       NULL,
@@ -563,6 +891,22 @@ static int content_sqlite_opendb (struct content_sqlite *ctx)
         log_sqlite_error (ctx, "preparing store stmt");
         goto error;
     }
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_begin,
+                            -1,
+                            &ctx->begin_stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing begin stmt");
+        goto error;
+    }
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_commit,
+                            -1,
+                            &ctx->commit_stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing commit stmt");
+        goto error;
+    }
     if (sqlite3_prepare_v2 (ctx->db,
                             sql_checkpt_get,
                             -1,
@@ -585,13 +929,64 @@ error:
     return -1;
 }
 
+/* zstd frames carry the ID of the dictionary they were compressed with,
+ * and the IDs in use are listed in the zstd_dicts table.  Fail if any of
+ * them is not the loaded dictionary, rather than failing loads later.
+ */
+static int check_zstd_dicts (struct content_sqlite *ctx)
+{
+    sqlite3_stmt *stmt;
+    int rc;
+
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_dicts_get,
+                            -1,
+                            &stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing zstd_dicts stmt");
+        set_errno_from_sqlite_error (ctx);
+        return -1;
+    }
+    while ((rc = sqlite3_step (stmt)) == SQLITE_ROW) {
+        unsigned int id = sqlite3_column_int64 (stmt, 0);
+#if HAVE_ZSTD
+        if (ctx->zstd_ddict && ctx->zstd_dict_id == id) {
+            ctx->zstd_dict_recorded = true;
+            continue;
+        }
+#endif
+        flux_log (ctx->h, LOG_ERR,
+                  "%s requires zstd dictionary %u, which is not loaded",
+                  ctx->dbfile,
+                  id);
+        errno = EINVAL;
+        goto error;
+    }
+    if (rc != SQLITE_DONE) {
+        log_sqlite_error (ctx, "reading zstd_dicts table");
+        set_errno_from_sqlite_error (ctx);
+        goto error;
+    }
+    (void)sqlite3_finalize (stmt);
+    return 0;
+error:
+    ERRNO_SAFE_WRAP (sqlite3_finalize, stmt);
+    return -1;
+}
+
 static void content_sqlite_destroy (struct content_sqlite *ctx)
 {
     if (ctx) {
         int saved_errno = errno;
         flux_msg_handler_delvec (ctx->handlers);
         free (ctx->dbfile);
-        free (ctx->lzo_buf);
+        free (ctx->comp_buf);
+#if HAVE_ZSTD
+        ZSTD_freeCCtx (ctx->zstd_cctx);
+        ZSTD_freeDCtx (ctx->zstd_dctx);
+        ZSTD_freeCDict (ctx->zstd_cdict);
+        ZSTD_freeDDict (ctx->zstd_ddict);
+#endif
         free (ctx);
         errno = saved_errno;
     }
@@ -600,6 +995,11 @@ static void content_sqlite_destroy (struct content_sqlite *ctx)
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST, "content-backing.load",    load_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "content-backing.store",   store_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST,
+      "content-backing.store-batch",
+      store_batch_cb,
+      0
+    },
     { FLUX_MSGTYPE_REQUEST, "kvs-checkpoint.get", checkpoint_get_cb, 0 },
     { FLUX_MSGTYPE_REQUEST, "kvs-checkpoint.put", checkpoint_put_cb, 0 },
     FLUX_MSGHANDLER_TABLE_END,
@@ -613,10 +1013,19 @@ static struct content_sqlite *content_sqlite_create (flux_t *h)
 
     if (!(ctx = calloc (1, sizeof (*ctx))))
         return NULL;
-    if (!(ctx->lzo_buf = calloc (1, lzo_buf_chunksize)))
+    if (!(ctx->comp_buf = calloc (1, comp_buf_chunksize)))
         goto error;
-    ctx->lzo_bufsize = lzo_buf_chunksize;
+    ctx->comp_bufsize = comp_buf_chunksize;
     ctx->h = h;
+    ctx->codec = CODEC_LZ4;
+    ctx->compression_threshold = default_compression_threshold;
+#if HAVE_ZSTD
+    if (!(ctx->zstd_cctx = ZSTD_createCCtx ())
+        || !(ctx->zstd_dctx = ZSTD_createDCtx ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+#endif
 
     /* Some tunables:
      * - the hash function, e.g. sha1, sha256
@@ -667,6 +1076,86 @@ error:
     return NULL;
 }
 
+#if HAVE_ZSTD
+/* Load a zstd dictionary, e.g. trained with 'zstd --train' on a sample
+ * of blobs.  It is used to compress new objects with the zstd codec,
+ * and it must be present to load objects that were compressed with it.
+ * Raw content dictionaries have no ID to mark frames with, so they
+ * are not accepted.
+ */
+static int load_zstd_dict (struct content_sqlite *ctx, const char *path)
+{
+    void *buf = NULL;
+    ssize_t size;
+    int fd;
+
+    if ((fd = open (path, O_RDONLY)) < 0
+        || (size = read_all (fd, &buf)) < 0) {
+        flux_log_error (ctx->h, "%s", path);
+        if (fd >= 0)
+            ERRNO_SAFE_WRAP (close, fd);
+        return -1;
+    }
+    close (fd);
+    ZSTD_freeCDict (ctx->zstd_cdict);
+    ZSTD_freeDDict (ctx->zstd_ddict);
+    ctx->zstd_ddict = NULL;
+    if (!(ctx->zstd_cdict = ZSTD_createCDict (buf,
+                                              size,
+                                              ZSTD_CLEVEL_DEFAULT))
+        || !(ctx->zstd_ddict = ZSTD_createDDict (buf, size))) {
+        flux_log (ctx->h, LOG_ERR, "%s: error loading zstd dictionary", path);
+        free (buf);
+        errno = EINVAL;
+        return -1;
+    }
+    free (buf);
+    if ((ctx->zstd_dict_id = ZSTD_getDictID_fromDDict (ctx->zstd_ddict)) == 0) {
+        flux_log (ctx->h, LOG_ERR, "%s: zstd dictionary has no ID", path);
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+#endif
+
+static int process_args (struct content_sqlite *ctx, int argc, char **argv)
+{
+    int i;
+    for (i = 0; i < argc; i++) {
+        if (!strncmp (argv[i], "codec=", 6)) {
+            if ((ctx->codec = codec_parse (argv[i] + 6)) < 0) {
+                flux_log (ctx->h, LOG_ERR, "invalid option: %s", argv[i]);
+                return -1;
+            }
+        }
+        else if (!strncmp (argv[i], "compression-threshold=", 22)) {
+            char *endptr;
+            long l;
+            errno = 0;
+            l = strtol (argv[i] + 22, &endptr, 10);
+            if (errno != 0 || *endptr != '\0' || l < 0 || l > INT_MAX) {
+                flux_log (ctx->h, LOG_ERR, "invalid option: %s", argv[i]);
+                errno = EINVAL;
+                return -1;
+            }
+            ctx->compression_threshold = l;
+        }
+#if HAVE_ZSTD
+        else if (!strncmp (argv[i], "zstd-dict=", 10)) {
+            if (load_zstd_dict (ctx, argv[i] + 10) < 0)
+                return -1;
+        }
+#endif
+        else {
+            flux_log (ctx->h, LOG_ERR, "unknown option: %s", argv[i]);
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    return 0;
+}
+
 int mod_main (flux_t *h, int argc, char **argv)
 {
     struct content_sqlite *ctx;
@@ -675,8 +1164,17 @@ int mod_main (flux_t *h, int argc, char **argv)
         flux_log_error (h, "content_sqlite_create failed");
         return -1;
     }
+    if (process_args (ctx, argc, argv) < 0) {
+        content_sqlite_destroy (ctx);
+        return -1;
+    }
     if (content_sqlite_opendb(ctx) < 0)
         goto done;
+    if (check_zstd_dicts (ctx) < 0) {
+        content_sqlite_closedb (ctx);
+        content_sqlite_destroy (ctx);
+        return -1;
+    }
     if (register_backing_store (h, "content-sqlite") < 0) {
         flux_log_error (h, "registering backing store");
         goto done;
@@ -20,6 +20,8 @@
 #include <czmq.h>
 
 #include "src/common/libutil/aux.h"
+#include "src/common/libsubprocess/command.h"
+#include "src/common/libioencode/ioencode.h"
 #include "bulk-exec.h"
 
 struct exec_cmd {
@@ -28,6 +30,15 @@ struct exec_cmd {
     int flags;
 };
 
+/*  A command launched in tree mode through "job-exec.launch"
+ */
+struct exec_launch {
+    struct bulk_exec *exec;
+    char *name;
+    struct idset *ranks;     /* ranks not yet complete */
+    flux_future_t *f;
+};
+
 struct bulk_exec {
     flux_t *h;
 
@@ -54,6 +65,10 @@ struct bulk_exec {
     zlist_t *commands;
     zlist_t *processes;
 
+    char *tree_name;         /* Non-NULL if launching via job-exec.launch */
+    int tree_seq;
+    zlist_t *launches;
+
     struct bulk_exec_ops *handlers;
     void *arg;
 };
@@ -65,6 +80,10 @@ int bulk_exec_rc (struct bulk_exec *exec)
 
 int bulk_exec_current (struct bulk_exec *exec)
 {
+    if (exec->tree_name) {
+        int current = exec->started - exec->complete;
+        return current > 0 ? current : 0;
+    }
     return zlist_size (exec->processes);
 }
 
@@ -73,10 +92,45 @@ int bulk_exec_total (struct bulk_exec *exec)
     return exec->total;
 }
 
+/*  Data is sent as an ioencoded object, since it need not be UTF-8.
+ */
+static int tree_write (struct bulk_exec *exec, const char *stream,
+                       const char *buf, size_t len, bool eof)
+{
+    struct exec_launch *l;
+    json_t *io;
+
+    if (len == 0 && !eof)
+        return 0;
+    if (!(io = ioencode (stream, "all", len ? buf : NULL, len, eof)))
+        return -1;
+    l = zlist_first (exec->launches);
+    while (l) {
+        flux_future_t *f;
+        if (!(f = flux_rpc_pack (exec->h, "job-exec.launch-write",
+                                 FLUX_NODEID_ANY,
+                                 FLUX_RPC_NORESPONSE,
+                                 "{s:s s:O}",
+                                 "name", l->name,
+                                 "io", io))) {
+            json_decref (io);
+            return -1;
+        }
+        flux_future_destroy (f);
+        l = zlist_next (exec->launches);
+    }
+    json_decref (io);
+    return 0;
+}
+
 int bulk_exec_write (struct bulk_exec *exec, const char *stream,
                      const char *buf, size_t len)
 {
-    flux_subprocess_t *p = zlist_first (exec->processes);
+    flux_subprocess_t *p;
+
+    if (exec->tree_name)
+        return tree_write (exec, stream, buf, len, false);
+    p = zlist_first (exec->processes);
     while (p) {
         if (flux_subprocess_write (p, stream, buf, len) < len)
             return -1;
@@ -87,7 +141,11 @@ int bulk_exec_write (struct bulk_exec *exec, const char *stream,
 
 int bulk_exec_close (struct bulk_exec *exec, const char *stream)
 {
-    flux_subprocess_t *p = zlist_first (exec->processes);
+    flux_subprocess_t *p;
+
+    if (exec->tree_name)
+        return tree_write (exec, stream, NULL, 0, true);
+    p = zlist_first (exec->processes);
     while (p) {
         if (flux_subprocess_close (p, stream) < 0)
             return -1;
@@ -123,9 +181,8 @@ static void exit_batch_cb (flux_reactor_t *r, flux_watcher_t *w,
  *  This appraoch avoids unecessarily calling into user's callback
  *   multiple times when all tasks exit within 0.01s.
  */
-static void exit_batch_append (struct bulk_exec *exec, flux_subprocess_t *p)
+static void exit_batch_append (struct bulk_exec *exec, int rank)
 {
-    int rank = flux_subprocess_rank (p);
     if (idset_set (exec->exit_batch, rank) < 0) {
         flux_log_error (exec->h, "exit_batch_append:idset_set");
         return;
@@ -145,10 +202,10 @@ static void exit_batch_append (struct bulk_exec *exec, flux_subprocess_t *p)
     }
 }
 
-static void exec_add_completed (struct bulk_exec *exec, flux_subprocess_t *p)
+static void exec_add_completed (struct bulk_exec *exec, int rank)
 {
     /* Append this process to the current batch for notification */
-    exit_batch_append (exec, p);
+    exit_batch_append (exec, rank);
 
     if (++exec->complete == exec->total) {
         exec_exit_notify (exec);
@@ -165,7 +222,20 @@ static void exec_complete_cb (flux_subprocess_t *p)
     if (status > exec->exit_status)
         exec->exit_status = status;
 
-    exec_add_completed (exec, p);
+    exec_add_completed (exec, flux_subprocess_rank (p));
+}
+
+int bulk_exec_fail_status (int errnum)
+{
+    int code = EXIT_CODE(1);
+
+    if (errnum == EPERM || errnum == EACCES)
+        code = EXIT_CODE(126);
+    else if (errnum == ENOENT)
+        code = EXIT_CODE(127);
+    else if (errnum == EHOSTUNREACH)
+        code = EXIT_CODE(68);
+    return code;
 }
 
 static void exec_state_cb (flux_subprocess_t *p, flux_subprocess_state_t state)
@@ -179,15 +249,7 @@ static void exec_state_cb (flux_subprocess_t *p, flux_subprocess_state_t state)
     }
     else if (state == FLUX_SUBPROCESS_FAILED
             || state == FLUX_SUBPROCESS_EXEC_FAILED) {
-        int errnum = flux_subprocess_fail_errno (p);
-        int code = EXIT_CODE(1);
-
-        if (errnum == EPERM || errnum == EACCES)
-            code = EXIT_CODE(126);
-        else if (errnum == ENOENT)
-            code = EXIT_CODE(127);
-        else if (errnum == EHOSTUNREACH)
-            code = EXIT_CODE(68);
+        int code = bulk_exec_fail_status (flux_subprocess_fail_errno (p));
 
         if (code > exec->exit_status)
             exec->exit_status = code;
@@ -195,7 +257,7 @@ static void exec_state_cb (flux_subprocess_t *p, flux_subprocess_state_t state)
         if (exec->handlers->on_error)
             (*exec->handlers->on_error) (exec, p, exec->arg);
 
-        exec_add_completed (exec, p);
+        exec_add_completed (exec, flux_subprocess_rank (p));
     }
 }
 
@@ -325,7 +387,190 @@ static int exec_start_cmds (struct bulk_exec *exec, int max)
     }
     return 0;
 }
+static void exec_launch_destroy (void *arg)
+{
+    struct exec_launch *l = arg;
+    if (l) {
+        int saved_errno = errno;
+        flux_future_destroy (l->f);
+        idset_destroy (l->ranks);
+        free (l->name);
+        free (l);
+        errno = saved_errno;
+    }
+}
 
+static struct exec_launch *exec_launch_create (struct bulk_exec *exec,
+                                               const char *name,
+                                               const struct idset *ranks)
+{
+    struct exec_launch *l = calloc (1, sizeof (*l));
+    if (!l)
+        return NULL;
+    l->exec = exec;
+    if (!(l->name = strdup (name))
+        || !(l->ranks = idset_copy (ranks))) {
+        exec_launch_destroy (l);
+        return NULL;
+    }
+    return l;
+}
+
+/*  Launch 'l' failed as a whole (e.g. no launch service on a rank in
+ *   the path).  Fail all ranks not yet complete.
+ */
+static void exec_launch_lost (struct exec_launch *l, int errnum)
+{
+    struct bulk_exec *exec = l->exec;
+    struct idset *ranks = l->ranks;
+    int code = bulk_exec_fail_status (errnum);
+    uint32_t rank;
+
+    if (!(l->ranks = idset_create (0, IDSET_FLAG_AUTOGROW))) {
+        flux_log_error (exec->h, "exec_launch_lost: idset_create");
+        l->ranks = ranks;
+        return;
+    }
+    if (code > exec->exit_status)
+        exec->exit_status = code;
+    rank = idset_first (ranks);
+    while (rank != IDSET_INVALID_ID) {
+        if (exec->handlers->on_rank_error)
+            (*exec->handlers->on_rank_error) (exec, rank, errnum, exec->arg);
+        exec_add_completed (exec, rank);
+        rank = idset_next (ranks, rank);
+    }
+    idset_destroy (ranks);
+}
+
+static int exec_launch_exit (struct exec_launch *l, const char *s, int status)
+{
+    struct bulk_exec *exec = l->exec;
+    struct idset *ranks;
+    uint32_t rank;
+
+    if (!(ranks = idset_decode (s)))
+        return -1;
+    if (status > exec->exit_status)
+        exec->exit_status = status;
+    rank = idset_first (ranks);
+    while (rank != IDSET_INVALID_ID) {
+        if (idset_test (l->ranks, rank)) {
+            idset_clear (l->ranks, rank);
+            exec_add_completed (exec, rank);
+        }
+        rank = idset_next (ranks, rank);
+    }
+    idset_destroy (ranks);
+    return 0;
+}
+
+static void exec_launch_cb (flux_future_t *f, void *arg)
+{
+    struct exec_launch *l = arg;
+    struct bulk_exec *exec = l->exec;
+    const char *type;
+    const char *ranks;
+    int count;
+    int status;
+    int rank;
+    int errnum;
+
+    if (flux_rpc_get_unpack (f, "{s:s}", "type", &type) < 0) {
+        if (errno != ENODATA || idset_count (l->ranks) > 0) {
+            errnum = errno == ENODATA ? EPROTO : errno;
+            flux_log (exec->h, LOG_ERR, "%s: launch failed: %s",
+                      l->name, flux_strerror (errnum));
+            exec_launch_lost (l, errnum);
+        }
+        zlist_remove (exec->launches, l);
+        return;
+    }
+    if (!strcmp (type, "start")) {
+        if (flux_rpc_get_unpack (f, "{s:i}", "count", &count) < 0)
+            goto proto;
+        exec->started += count;
+        if (exec->started == exec->total && exec->handlers->on_start)
+            (*exec->handlers->on_start) (exec, exec->arg);
+    }
+    else if (!strcmp (type, "exit")) {
+        if (flux_rpc_get_unpack (f, "{s:s s:i}",
+                                 "ranks", &ranks,
+                                 "status", &status) < 0
+            || exec_launch_exit (l, ranks, status) < 0)
+            goto proto;
+    }
+    else if (!strcmp (type, "error")) {
+        if (flux_rpc_get_unpack (f, "{s:i s:i}",
+                                 "rank", &rank,
+                                 "errnum", &errnum) < 0)
+            goto proto;
+        if (exec->handlers->on_rank_error)
+            (*exec->handlers->on_rank_error) (exec, rank, errnum, exec->arg);
+    }
+    flux_future_reset (f);
+    return;
+proto:
+    flux_log_error (exec->h, "%s: launch response", l->name);
+    flux_future_reset (f);
+}
+
+/*  Send 'cmd' to the local job-exec.launch service, which fans it out
+ *   over the TBON.
+ */
+static int exec_launch_cmd (struct bulk_exec *exec, struct exec_cmd *cmd)
+{
+    struct exec_launch *l = NULL;
+    char name[128];
+    char *ranks = NULL;
+    char *s = NULL;
+    int rc = -1;
+
+    if (snprintf (name, sizeof (name), "%s.%d",
+                  exec->tree_name, exec->tree_seq++) >= sizeof (name)) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    if (!(l = exec_launch_create (exec, name, cmd->ranks))
+        || !(ranks = idset_encode (cmd->ranks, IDSET_FLAG_RANGE))
+        || !(s = flux_cmd_tojson (cmd->cmd)))
+        goto out;
+    if (!(l->f = flux_rpc_pack (exec->h, "job-exec.launch",
+                                FLUX_NODEID_ANY,
+                                FLUX_RPC_STREAMING,
+                                "{s:s s:s s:s s:i}",
+                                "name", l->name,
+                                "ranks", ranks,
+                                "cmd", s,
+                                "flags", cmd->flags))
+        || flux_future_then (l->f, -1., exec_launch_cb, l) < 0)
+        goto out;
+    if (zlist_append (exec->launches, l) < 0) {
+        errno = ENOMEM;
+        goto out;
+    }
+    zlist_freefn (exec->launches, l, exec_launch_destroy, true);
+    l = NULL;
+    rc = 0;
+out:
+    exec_launch_destroy (l);
+    free (ranks);
+    free (s);
+    return rc;
+}
+
+static int exec_launch_cmds (struct bulk_exec *exec)
+{
+    struct exec_cmd *cmd;
+    while ((cmd = zlist_first (exec->commands))) {
+        if (exec_launch_cmd (exec, cmd) < 0) {
+            flux_log_error (exec->h, "exec_launch_cmd failed");
+            return -1;
+        }
+        zlist_remove (exec->commands, cmd);
+    }
+    return 0;
+}
 
 static void prep_cb (flux_reactor_t *r, flux_watcher_t *w,
                      int revents, void *arg)
@@ -359,6 +604,8 @@ void bulk_exec_destroy (struct bulk_exec *exec)
     if (exec) {
         zlist_destroy (&exec->processes);
         zlist_destroy (&exec->commands);
+        zlist_destroy (&exec->launches);
+        free (exec->tree_name);
         idset_destroy (exec->exit_batch);
         flux_watcher_destroy (exec->prep);
         flux_watcher_destroy (exec->check);
@@ -384,6 +631,7 @@ struct bulk_exec * bulk_exec_create (struct bulk_exec_ops *ops, void *arg)
     exec->arg = arg;
     exec->processes = zlist_new ();
     exec->commands = zlist_new ();
+    exec->launches = zlist_new ();
     exec->exit_batch = idset_create (0, IDSET_FLAG_AUTOGROW);
     exec->max_start_per_loop = 1;
 
@@ -400,6 +648,21 @@ int bulk_exec_set_max_per_loop (struct bulk_exec *exec, int max)
     return 0;
 }
 
+int bulk_exec_set_tree (struct bulk_exec *exec, const char *name)
+{
+    char *s;
+
+    if (!name || exec->active) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(s = strdup (name)))
+        return -1;
+    free (exec->tree_name);
+    exec->tree_name = s;
+    return 0;
+}
+
 int bulk_exec_push_cmd (struct bulk_exec *exec,
                        const struct idset *ranks,
                        flux_cmd_t *cmd,
@@ -416,6 +679,8 @@ int bulk_exec_push_cmd (struct bulk_exec *exec,
     zlist_freefn (exec->commands, c, exec_cmd_destroy, true);
 
     exec->total += idset_count (ranks);
+    if (exec->active && exec->tree_name)
+        return exec_launch_cmds (exec);
     if (exec->active) {
         flux_watcher_start (exec->prep);
         flux_watcher_start (exec->check);
@@ -428,6 +693,10 @@ int bulk_exec_start (flux_t *h, struct bulk_exec *exec)
 {
     flux_reactor_t *r = flux_get_reactor (h);
     exec->h = h;
+    if (exec->tree_name) {
+        exec->active = 1;
+        return exec_launch_cmds (exec);
+    }
     exec->prep = flux_prepare_watcher_create (r, prep_cb, exec);
     exec->check = flux_check_watcher_create (r, check_cb, exec);
     exec->idle = flux_idle_watcher_create (r, NULL, NULL);
@@ -466,11 +735,54 @@ int bulk_exec_cancel (struct bulk_exec *exec)
     return 0;
 }
 
+/*  Signal all launches with processes still active via
+ *   job-exec.launch-signal.  If 'imp_path' is set, processes are
+ *   signaled with "flux-imp kill" on each rank.
+ */
+static flux_future_t *exec_launch_kill (struct bulk_exec *exec,
+                                        const char *imp_path,
+                                        int signum)
+{
+    struct exec_launch *l;
+    flux_future_t *cf;
+
+    if (!(cf = flux_future_wait_all_create ()))
+        return NULL;
+    flux_future_set_flux (cf, exec->h);
+
+    l = zlist_first (exec->launches);
+    while (l) {
+        if (idset_count (l->ranks) > 0) {
+            flux_future_t *f;
+            if (!(f = flux_rpc_pack (exec->h, "job-exec.launch-signal",
+                                     FLUX_NODEID_ANY, 0,
+                                     imp_path ? "{s:s s:i s:s}" : "{s:s s:i}",
+                                     "name", l->name,
+                                     "signal", signum,
+                                     "imp", imp_path))
+                || flux_future_push (cf, l->name, f) < 0) {
+                flux_log_error (exec->h, "%s: launch-signal", l->name);
+                flux_future_destroy (f);
+            }
+        }
+        l = zlist_next (exec->launches);
+    }
+    if (!flux_future_first_child (cf)) {
+        flux_future_destroy (cf);
+        errno = ENOENT;
+        return NULL;
+    }
+    return cf;
+}
+
 flux_future_t *bulk_exec_kill (struct bulk_exec *exec, int signum)
 {
     flux_subprocess_t *p = zlist_first (exec->processes);
     flux_future_t *cf = NULL;
 
+    if (exec->tree_name)
+        return exec_launch_kill (exec, NULL, signum);
+
     if (!(cf = flux_future_wait_all_create ()))
         return NULL;
     flux_future_set_flux (cf, exec->h);
@@ -579,6 +891,9 @@ flux_future_t *bulk_exec_imp_kill (struct bulk_exec *exec,
     flux_future_t *f = NULL;
     int count = 0;
 
+    if (exec->tree_name)
+        return exec_launch_kill (exec, imp_path, signum);
+
     /* Empty future for return value
      */
     if (!(f = flux_future_create (NULL, NULL))) {
@@ -33,12 +33,18 @@ typedef void (*exec_error_f) (struct bulk_exec *,
                               flux_subprocess_t *,
                               void *arg);
 
+typedef void (*exec_rank_error_f) (struct bulk_exec *,
+                                   int rank,
+                                   int errnum,
+                                   void *arg);
+
 struct bulk_exec_ops {
     exec_cb_f    on_start;    /* called when all processes are running  */
     exec_exit_f  on_exit;     /* called when a set of tasks exits       */
     exec_cb_f    on_complete; /* called when all processes are done     */
     exec_io_f    on_output;   /* called on process output               */
     exec_error_f on_error;    /* called on any fatal error              */
+    exec_rank_error_f on_rank_error; /* process failed in tree mode     */
 };
 
 struct bulk_exec * bulk_exec_create (struct bulk_exec_ops *ops, void *arg);
@@ -55,6 +61,17 @@ int bulk_exec_aux_set (struct bulk_exec *exec,
  */
 int bulk_exec_set_max_per_loop (struct bulk_exec *exec, int max);
 
+/*  Launch commands through the job-exec.launch service instead of
+ *   one flux_rexec(3) per rank: a single request is sent to the local
+ *   broker, and each broker forwards one request per TBON child subtree.
+ *   Startup then scales with tree depth rather than the number of ranks.
+ *   Must be called before bulk_exec_start() on rank 0.  'name' must be
+ *   unique among active launches.  In this mode, process failures are
+ *   reported with on_rank_error, and output is logged by the broker
+ *   running each process rather than passed to on_output.
+ */
+int bulk_exec_set_tree (struct bulk_exec *exec, const char *name);
+
 void bulk_exec_destroy (struct bulk_exec *exec);
 
 int bulk_exec_push_cmd (struct bulk_exec *exec,
@@ -72,6 +89,9 @@ flux_future_t *bulk_exec_imp_kill (struct bulk_exec *exec,
 
 int bulk_exec_cancel (struct bulk_exec *exec);
 
+/* Returns the wait status used for a process that failed with errnum */
+int bulk_exec_fail_status (int errnum);
+
 /* Returns max wait status returned from all exited processes */
 int bulk_exec_rc (struct bulk_exec *exec);
 
@@ -22,8 +22,18 @@
  * {
  *    "mock_exception":s       - Generate a mock execption in phase:
  *                               "init", or "starting"
+ *    "launch":s               - Override launch mode, "direct" or "tree"
  * }
  *
+ * LAUNCH MODE
+ *
+ * By default, job shells are launched with one rexec request per rank
+ * sent from this broker.  With exec.launch = "tree" in the config (or
+ * launch=tree on the module command line), a single request is sent to
+ * the job-exec.launch service, which forwards it down the TBON so that
+ * startup scales with tree depth.  This requires job-exec to be loaded
+ * on all ranks.
+ *
  */
 
 #if HAVE_CONFIG_H
@@ -40,12 +50,14 @@ extern char **environ;
 static const char *default_cwd = "/tmp";
 static const char *default_job_shell = NULL;
 static const char *flux_imp_path = NULL;
+static const char *default_launch = "direct";
 
 /* Configuration for "bulk" execution implementation. Used only for testing
  *  for now.
  */
 struct exec_conf {
     const char *        mock_exception;   /* fake exception */
+    const char *        launch;           /* launch mode override */
 };
 
 static void exec_conf_destroy (struct exec_conf *tc)
@@ -58,11 +70,13 @@ static struct exec_conf *exec_conf_create (json_t *jobspec)
     struct exec_conf *conf = calloc (1, sizeof (*conf));
     if (conf == NULL)
         return NULL;
-    (void) json_unpack (jobspec, "{s:{s:{s:{s:{s:s}}}}}",
+    (void) json_unpack (jobspec, "{s:{s:{s:{s:{s?s s?s}}}}}",
                                  "attributes", "system", "exec",
                                      "bulkexec",
                                          "mock_exception",
-                                         &conf->mock_exception);
+                                         &conf->mock_exception,
+                                         "launch",
+                                         &conf->launch);
     return conf;
 }
 
@@ -74,6 +88,13 @@ static const char * exec_mock_exception (struct bulk_exec *exec)
     return conf->mock_exception;
 }
 
+static const char * exec_launch_mode (struct exec_conf *conf)
+{
+    if (conf && conf->launch)
+        return conf->launch;
+    return default_launch;
+}
+
 static const char *jobspec_get_job_shell (json_t *jobspec)
 {
     const char *path = NULL;
@@ -159,12 +180,24 @@ static void error_cb (struct bulk_exec *exec, flux_subprocess_t *p, void *arg)
                               arg0, flux_subprocess_rank (p));
 }
 
+static void rank_error_cb (struct bulk_exec *exec,
+                           int rank,
+                           int errnum,
+                           void *arg)
+{
+    struct jobinfo *job = arg;
+    jobinfo_fatal_error (job, errnum,
+                              "cmd=%s: rank=%d failed",
+                              job_shell_path (job), rank);
+}
+
 static struct bulk_exec_ops exec_ops = {
     .on_start =     start_cb,
     .on_exit =      NULL,
     .on_complete =  complete_cb,
     .on_output =    output_cb,
-    .on_error =     error_cb
+    .on_error =     error_cb,
+    .on_rank_error = rank_error_cb
 };
 
 static int exec_init (struct jobinfo *job)
@@ -198,6 +231,14 @@ static int exec_init (struct jobinfo *job)
         flux_log_error (job->h, "exec_init: bulk_exec_aux_set");
         goto err;
     }
+    if (strcmp (exec_launch_mode (conf), "tree") == 0) {
+        char name[32];
+        (void) snprintf (name, sizeof (name), "%ju", (uintmax_t) job->id);
+        if (bulk_exec_set_tree (exec, name) < 0) {
+            flux_log_error (job->h, "exec_init: bulk_exec_set_tree");
+            goto err;
+        }
+    }
     if (!(cmd = flux_cmd_create (0, NULL, environ))) {
         flux_log_error (job->h, "exec_init: flux_cmd_create");
         goto err;
@@ -361,6 +402,18 @@ static int exec_config (flux_t *h, int argc, char **argv)
         return -1;
     }
 
+    /*  Check configuration for exec.launch */
+    if (flux_conf_unpack (flux_get_conf (h),
+                          &err,
+                          "{s?:{s?s}}",
+                          "exec",
+                            "launch", &default_launch) < 0) {
+        flux_log (h, LOG_ERR,
+                  "error reading config value exec.launch: %s",
+                  err.errbuf);
+        return -1;
+    }
+
     /*  Check configuration for exec.imp */
     if (flux_conf_unpack (flux_get_conf (h),
                           &err,
@@ -379,6 +432,14 @@ static int exec_config (flux_t *h, int argc, char **argv)
             default_job_shell = argv[i]+10;
         else if (strncmp (argv[i], "imp=", 4) == 0)
             flux_imp_path = argv[i]+4;
+        else if (strncmp (argv[i], "launch=", 7) == 0)
+            default_launch = argv[i]+7;
+    }
+    if (strcmp (default_launch, "direct") != 0
+        && strcmp (default_launch, "tree") != 0) {
+        flux_log (h, LOG_ERR, "invalid launch mode: %s", default_launch);
+        errno = EINVAL;
+        return -1;
     }
     flux_log (h, LOG_DEBUG, "using default shell path %s", default_job_shell);
     if (flux_imp_path)
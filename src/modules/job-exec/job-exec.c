@@ -101,6 +101,7 @@
 #include "src/common/libutil/fsd.h"
 #include "src/common/libutil/errno_safe.h"
 #include "job-exec.h"
+#include "launch.h"
 
 static double kill_timeout=5.0;
 
@@ -117,6 +118,7 @@ struct job_exec_ctx {
     flux_t *              h;
     flux_msg_handler_t ** handlers;
     zhashx_t *            jobs;
+    struct launch_service *launch;
 };
 
 void jobinfo_incref (struct jobinfo *job)
@@ -1061,6 +1063,7 @@ static void job_exec_ctx_destroy (struct job_exec_ctx *ctx)
         return;
     zhashx_destroy (&ctx->jobs);
     flux_msg_handler_delvec (ctx->handlers);
+    launch_service_destroy (ctx->launch);
     free (ctx);
 }
 
@@ -1152,6 +1155,7 @@ int mod_main (flux_t *h, int argc, char **argv)
 {
     int saved_errno = 0;
     int rc = -1;
+    uint32_t rank = 0;
     struct job_exec_ctx *ctx = job_exec_ctx_create (h);
 
     if (job_exec_initialize (h, argc, argv) < 0
@@ -1159,6 +1163,21 @@ int mod_main (flux_t *h, int argc, char **argv)
         flux_log_error (h, "job-exec: module initialization failed");
         goto out;
     }
+    if (flux_get_rank (h, &rank) < 0) {
+        flux_log_error (h, "flux_get_rank");
+        goto out;
+    }
+    if (!(ctx->launch = launch_service_create (h))) {
+        flux_log_error (h, "launch_service_create");
+        goto out;
+    }
+
+    /*  On ranks other than 0 only the launch service is provided
+     */
+    if (rank > 0) {
+        rc = flux_reactor_run (flux_get_reactor (h), 0);
+        goto out;
+    }
 
     if (flux_msg_handler_addvec (h, htab, ctx, &ctx->handlers) < 0) {
         flux_log_error (h, "flux_msg_handler_addvec");
@@ -1174,7 +1193,7 @@ int mod_main (flux_t *h, int argc, char **argv)
     rc = flux_reactor_run (flux_get_reactor (h), 0);
 out:
     saved_errno = errno;
-    if (flux_event_unsubscribe (h, "job-exception") < 0)
+    if (rank == 0 && flux_event_unsubscribe (h, "job-exception") < 0)
         flux_log_error (h, "flux_event_unsubscribe ('job-exception')");
     job_exec_ctx_destroy (ctx);
     errno = saved_errno;
@@ -0,0 +1,825 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* Hierarchical launch service, see launch.h for the protocol.
+ *
+ * Each active launch on this broker tracks the local process (if any)
+ * and one streaming "job-exec.launch" RPC per TBON child subtree.
+ * Start counts are passed up once every process in the subtree has
+ * either started or failed.  Exits are batched for 0.01s, as in
+ * bulk-exec, and flushed immediately when the last process completes.
+ * If a child RPC fails (e.g. job-exec not loaded on that rank), all
+ * ranks still outstanding in that subtree are reported failed.
+ */
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <unistd.h>
+#include <jansson.h>
+#include <flux/core.h>
+#include <flux/idset.h>
+#include <czmq.h>
+
+#include "src/common/libutil/kary.h"
+#include "src/common/libsubprocess/command.h"
+#include "src/common/libioencode/ioencode.h"
+
+#include "bulk-exec.h"
+#include "launch.h"
+
+extern char **environ;
+
+struct launch_service {
+    flux_t *h;
+    uint32_t rank;
+    uint32_t size;
+    int k;
+    flux_msg_handler_t **handlers;
+    zhashx_t *launches;
+};
+
+struct launch_child {
+    struct launch *l;
+    uint32_t rank;
+    struct idset *ranks;    /* ranks in this subtree not yet complete */
+    flux_future_t *f;
+};
+
+struct launch {
+    struct launch_service *ls;
+    char *name;
+    char *cmd;              /* command in JSON form, forwarded as-is */
+    int flags;
+    const flux_msg_t *msg;
+
+    int total;
+    int started;
+    int failed;
+    int complete;
+    unsigned int start_sent:1;
+
+    flux_subprocess_t *p;   /* local process, if this rank is targeted */
+    zlist_t *children;
+
+    struct idset *exit_batch;
+    int exit_batch_status;
+    flux_watcher_t *exit_batch_timer;
+};
+
+static void launch_child_destroy (struct launch_child *c)
+{
+    if (c) {
+        int saved_errno = errno;
+        flux_future_destroy (c->f);
+        idset_destroy (c->ranks);
+        free (c);
+        errno = saved_errno;
+    }
+}
+
+static struct launch_child *launch_child_create (struct launch *l,
+                                                 uint32_t rank)
+{
+    struct launch_child *c;
+
+    if (!(c = calloc (1, sizeof (*c))))
+        return NULL;
+    c->l = l;
+    c->rank = rank;
+    if (!(c->ranks = idset_create (0, IDSET_FLAG_AUTOGROW))) {
+        launch_child_destroy (c);
+        return NULL;
+    }
+    return c;
+}
+
+static void launch_destroy (struct launch *l)
+{
+    if (l) {
+        int saved_errno = errno;
+        struct launch_child *c;
+
+        if (l->children) {
+            while ((c = zlist_pop (l->children)))
+                launch_child_destroy (c);
+            zlist_destroy (&l->children);
+        }
+        flux_subprocess_unref (l->p);
+        flux_watcher_destroy (l->exit_batch_timer);
+        idset_destroy (l->exit_batch);
+        flux_msg_decref (l->msg);
+        free (l->cmd);
+        free (l->name);
+        free (l);
+        errno = saved_errno;
+    }
+}
+
+static struct launch *launch_create (struct launch_service *ls,
+                                     const flux_msg_t *msg,
+                                     const char *name,
+                                     const char *cmd,
+                                     int flags)
+{
+    struct launch *l;
+
+    if (!(l = calloc (1, sizeof (*l))))
+        return NULL;
+    l->ls = ls;
+    l->flags = flags;
+    l->msg = flux_msg_incref (msg);
+    if (!(l->name = strdup (name))
+        || !(l->cmd = strdup (cmd))
+        || !(l->children = zlist_new ())
+        || !(l->exit_batch = idset_create (0, IDSET_FLAG_AUTOGROW)))
+        goto error;
+    return l;
+error:
+    launch_destroy (l);
+    return NULL;
+}
+
+static struct launch_child *launch_child_find (struct launch *l,
+                                               uint32_t rank)
+{
+    struct launch_child *c = zlist_first (l->children);
+    while (c) {
+        if (c->rank == rank)
+            return c;
+        c = zlist_next (l->children);
+    }
+    return NULL;
+}
+
+static void launch_respond_error (struct launch *l, int rank, int errnum)
+{
+    flux_t *h = l->ls->h;
+    if (flux_respond_pack (h, l->msg, "{s:s s:i s:i}",
+                           "type", "error",
+                           "rank", rank,
+                           "errnum", errnum) < 0)
+        flux_log_error (h, "%s: error respond", l->name);
+}
+
+static void launch_check_start (struct launch *l)
+{
+    flux_t *h = l->ls->h;
+
+    if (l->start_sent || l->started + l->failed < l->total)
+        return;
+    l->start_sent = 1;
+    if (l->started > 0
+        && flux_respond_pack (h, l->msg, "{s:s s:i}",
+                              "type", "start",
+                              "count", l->started) < 0)
+        flux_log_error (h, "%s: start respond", l->name);
+}
+
+static void launch_exit_flush (struct launch *l)
+{
+    flux_t *h = l->ls->h;
+    char *ranks;
+
+    flux_watcher_stop (l->exit_batch_timer);
+    if (idset_count (l->exit_batch) == 0)
+        return;
+    if (!(ranks = idset_encode (l->exit_batch, IDSET_FLAG_RANGE))
+        || flux_respond_pack (h, l->msg, "{s:s s:s s:i}",
+                              "type", "exit",
+                              "ranks", ranks,
+                              "status", l->exit_batch_status) < 0)
+        flux_log_error (h, "%s: exit respond", l->name);
+    free (ranks);
+    idset_range_clear (l->exit_batch, 0, INT_MAX);
+    l->exit_batch_status = 0;
+}
+
+static void exit_batch_cb (flux_reactor_t *r, flux_watcher_t *w,
+                           int revents, void *arg)
+{
+    launch_exit_flush (arg);
+}
+
+static void launch_exited (struct launch *l, uint32_t rank, int status)
+{
+    if (idset_set (l->exit_batch, rank) < 0)
+        flux_log_error (l->ls->h, "%s: exit batch idset_set", l->name);
+    if (status > l->exit_batch_status)
+        l->exit_batch_status = status;
+    l->complete++;
+    if (!l->exit_batch_timer) {
+        flux_reactor_t *r = flux_get_reactor (l->ls->h);
+        if (!(l->exit_batch_timer = flux_timer_watcher_create (r, 0.01, 0.,
+                                                               exit_batch_cb,
+                                                               l))) {
+            flux_log_error (l->ls->h, "%s: exit batch timer", l->name);
+            return;
+        }
+    }
+    /*  No-op if the timer is already armed for the current batch */
+    flux_watcher_start (l->exit_batch_timer);
+}
+
+/*  Terminate the launch stream and destroy the launch once all
+ *   processes in the subtree are complete and all child streams
+ *   have ended.  Must be the last use of 'l' by the caller.
+ */
+static void launch_check_done (struct launch *l)
+{
+    struct launch_service *ls = l->ls;
+    struct launch_child *c;
+
+    if (l->complete < l->total)
+        return;
+    c = zlist_first (l->children);
+    while (c) {
+        if (c->f)
+            return;
+        c = zlist_next (l->children);
+    }
+    launch_check_start (l);
+    launch_exit_flush (l);
+    if (flux_respond_error (ls->h, l->msg, ENODATA, NULL) < 0)
+        flux_log_error (ls->h, "%s: respond ENODATA", l->name);
+    zhashx_delete (ls->launches, l->name);
+}
+
+/*  Child subtree rooted at c->rank is unreachable or its launch failed.
+ *   Report failure for every rank not yet complete.
+ */
+static void launch_child_lost (struct launch_child *c, int errnum)
+{
+    struct launch *l = c->l;
+    int status = bulk_exec_fail_status (errnum);
+    uint32_t rank;
+
+    flux_log (l->ls->h, LOG_ERR, "%s: launch on rank %u subtree: %s",
+              l->name, (unsigned int) c->rank, flux_strerror (errnum));
+    rank = idset_first (c->ranks);
+    while (rank != IDSET_INVALID_ID) {
+        launch_respond_error (l, rank, errnum);
+        l->failed++;
+        launch_exited (l, rank, status);
+        rank = idset_next (c->ranks, rank);
+    }
+    idset_range_clear (c->ranks, 0, INT_MAX);
+    launch_check_start (l);
+}
+
+static int launch_child_exit (struct launch_child *c,
+                              const char *s,
+                              int status)
+{
+    struct idset *ranks;
+    uint32_t rank;
+
+    if (!(ranks = idset_decode (s)))
+        return -1;
+    rank = idset_first (ranks);
+    while (rank != IDSET_INVALID_ID) {
+        if (idset_test (c->ranks, rank)) {
+            idset_clear (c->ranks, rank);
+            launch_exited (c->l, rank, status);
+        }
+        rank = idset_next (ranks, rank);
+    }
+    idset_destroy (ranks);
+    return 0;
+}
+
+static void launch_child_cb (flux_future_t *f, void *arg)
+{
+    struct launch_child *c = arg;
+    struct launch *l = c->l;
+    flux_t *h = l->ls->h;
+    const char *type;
+    const char *ranks;
+    int count;
+    int status;
+    int rank;
+    int errnum;
+
+    if (flux_rpc_get_unpack (f, "{s:s}", "type", &type) < 0) {
+        if (errno != ENODATA)
+            launch_child_lost (c, errno);
+        else if (idset_count (c->ranks) > 0)
+            launch_child_lost (c, EPROTO);
+        flux_future_destroy (c->f);
+        c->f = NULL;
+        goto done;
+    }
+    if (!strcmp (type, "start")) {
+        if (flux_rpc_get_unpack (f, "{s:i}", "count", &count) < 0)
+            goto proto;
+        l->started += count;
+        launch_check_start (l);
+    }
+    else if (!strcmp (type, "exit")) {
+        if (flux_rpc_get_unpack (f, "{s:s s:i}",
+                                 "ranks", &ranks,
+                                 "status", &status) < 0
+            || launch_child_exit (c, ranks, status) < 0)
+            goto proto;
+    }
+    else if (!strcmp (type, "error")) {
+        if (flux_rpc_get_unpack (f, "{s:i s:i}",
+                                 "rank", &rank,
+                                 "errnum", &errnum) < 0)
+            goto proto;
+        launch_respond_error (l, rank, errnum);
+        l->failed++;
+        launch_check_start (l);
+    }
+    flux_future_reset (f);
+done:
+    launch_check_done (l);
+    return;
+proto:
+    flux_log_error (h, "%s: rank %u: launch response",
+                    l->name, (unsigned int) c->rank);
+    flux_future_reset (f);
+}
+
+static void launch_output_cb (flux_subprocess_t *p, const char *stream)
+{
+    struct launch *l = flux_subprocess_aux_get (p, "job-exec::launch");
+    const char *s;
+    int len;
+
+    if (!(s = flux_subprocess_getline (p, stream, &len))) {
+        flux_log_error (l->ls->h, "%s: flux_subprocess_getline", l->name);
+        return;
+    }
+    if (len)
+        flux_log (l->ls->h, LOG_INFO, "%s: %u: %s: %s",
+                  l->name, (unsigned int) l->ls->rank, stream, s);
+}
+
+static void launch_completion_cb (flux_subprocess_t *p)
+{
+    struct launch *l = flux_subprocess_aux_get (p, "job-exec::launch");
+
+    launch_exited (l, l->ls->rank, flux_subprocess_status (p));
+    launch_check_done (l);
+}
+
+static void launch_state_cb (flux_subprocess_t *p,
+                             flux_subprocess_state_t state)
+{
+    struct launch *l = flux_subprocess_aux_get (p, "job-exec::launch");
+
+    if (state == FLUX_SUBPROCESS_RUNNING) {
+        l->started++;
+        launch_check_start (l);
+    }
+    else if (state == FLUX_SUBPROCESS_FAILED
+             || state == FLUX_SUBPROCESS_EXEC_FAILED) {
+        int errnum = flux_subprocess_fail_errno (p);
+
+        launch_respond_error (l, l->ls->rank, errnum);
+        l->failed++;
+        launch_check_start (l);
+        launch_exited (l, l->ls->rank, bulk_exec_fail_status (errnum));
+        launch_check_done (l);
+    }
+}
+
+static int launch_local (struct launch *l)
+{
+    struct launch_service *ls = l->ls;
+    flux_subprocess_ops_t ops = {
+        .on_completion =   launch_completion_cb,
+        .on_state_change = launch_state_cb,
+        .on_stdout =       launch_output_cb,
+        .on_stderr =       launch_output_cb,
+    };
+    flux_cmd_t *cmd;
+    json_error_t error;
+
+    if (!(cmd = flux_cmd_fromjson (l->cmd, &error))) {
+        flux_log (ls->h, LOG_ERR, "%s: invalid cmd: %s", l->name, error.text);
+        errno = EPROTO;
+        return -1;
+    }
+    l->p = flux_rexec (ls->h, ls->rank, l->flags, cmd, &ops);
+    flux_cmd_destroy (cmd);
+    if (!l->p)
+        return -1;
+    if (flux_subprocess_aux_set (l->p, "job-exec::launch", l, NULL) < 0) {
+        flux_subprocess_destroy (l->p);
+        l->p = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static int launch_child_start (struct launch_child *c)
+{
+    struct launch *l = c->l;
+    flux_t *h = l->ls->h;
+    char *ranks;
+
+    if (!(ranks = idset_encode (c->ranks, IDSET_FLAG_RANGE)))
+        return -1;
+    c->f = flux_rpc_pack (h, "job-exec.launch", c->rank, FLUX_RPC_STREAMING,
+                          "{s:s s:s s:s s:i}",
+                          "name", l->name,
+                          "ranks", ranks,
+                          "cmd", l->cmd,
+                          "flags", l->flags);
+    free (ranks);
+    if (!c->f || flux_future_then (c->f, -1., launch_child_cb, c) < 0)
+        return -1;
+    return 0;
+}
+
+/*  Split 'ranks' into TBON child subtrees of this rank, then forward
+ *   one launch request to each child and start the local process if
+ *   this rank is targeted.  All ranks must be in this rank's subtree.
+ */
+static int launch_start (struct launch *l, struct idset *ranks)
+{
+    struct launch_service *ls = l->ls;
+    struct launch_child *c;
+    bool local = false;
+    uint32_t rank;
+
+    rank = idset_first (ranks);
+    while (rank != IDSET_INVALID_ID) {
+        if (rank == ls->rank)
+            local = true;
+        else {
+            uint32_t child = kary_child_route (ls->k, ls->size, ls->rank, rank);
+            if (child == KARY_NONE) {
+                errno = EINVAL;
+                return -1;
+            }
+            if (!(c = launch_child_find (l, child))) {
+                if (!(c = launch_child_create (l, child)))
+                    return -1;
+                if (zlist_append (l->children, c) < 0) {
+                    launch_child_destroy (c);
+                    errno = ENOMEM;
+                    return -1;
+                }
+            }
+            if (idset_set (c->ranks, rank) < 0)
+                return -1;
+        }
+        l->total++;
+        rank = idset_next (ranks, rank);
+    }
+    c = zlist_first (l->children);
+    while (c) {
+        if (launch_child_start (c) < 0)
+            launch_child_lost (c, errno);
+        c = zlist_next (l->children);
+    }
+    if (local && launch_local (l) < 0) {
+        int errnum = errno;
+        launch_respond_error (l, ls->rank, errnum);
+        l->failed++;
+        launch_check_start (l);
+        launch_exited (l, ls->rank, bulk_exec_fail_status (errnum));
+    }
+    return 0;
+}
+
+static void launch_cb (flux_t *h, flux_msg_handler_t *mh,
+                       const flux_msg_t *msg, void *arg)
+{
+    struct launch_service *ls = arg;
+    struct launch *l = NULL;
+    struct idset *ranks = NULL;
+    const char *name;
+    const char *s;
+    const char *cmd;
+    int flags;
+    const char *errmsg = NULL;
+
+    if (flux_request_unpack (msg, NULL, "{s:s s:s s:s s:i}",
+                             "name", &name,
+                             "ranks", &s,
+                             "cmd", &cmd,
+                             "flags", &flags) < 0)
+        goto error;
+    if (!flux_msg_is_streaming (msg)) {
+        errno = EPROTO;
+        errmsg = "launch requires FLUX_RPC_STREAMING";
+        goto error;
+    }
+    if (zhashx_lookup (ls->launches, name)) {
+        errno = EEXIST;
+        errmsg = "launch name is in use";
+        goto error;
+    }
+    if (!(ranks = idset_decode (s)) || idset_count (ranks) == 0) {
+        errno = EPROTO;
+        errmsg = "invalid launch ranks";
+        goto error;
+    }
+    if (!(l = launch_create (ls, msg, name, cmd, flags)))
+        goto error;
+    if (zhashx_insert (ls->launches, l->name, l) < 0) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (launch_start (l, ranks) < 0) {
+        zhashx_freefn (ls->launches, l->name, NULL);
+        zhashx_delete (ls->launches, l->name);
+        if (errno == EINVAL)
+            errmsg = "launch ranks are not in this subtree";
+        goto error;
+    }
+    idset_destroy (ranks);
+    launch_check_done (l);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errmsg) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    idset_destroy (ranks);
+    launch_destroy (l);
+}
+
+static void imp_kill_completion_cb (flux_subprocess_t *p)
+{
+    flux_subprocess_destroy (p);
+}
+
+static void imp_kill_state_cb (flux_subprocess_t *p,
+                               flux_subprocess_state_t state)
+{
+    if (state == FLUX_SUBPROCESS_FAILED
+        || state == FLUX_SUBPROCESS_EXEC_FAILED) {
+        struct launch_service *ls;
+
+        ls = flux_subprocess_aux_get (p, "job-exec::launch-service");
+        flux_log (ls->h, LOG_ERR, "flux-imp kill: %s",
+                  flux_strerror (flux_subprocess_fail_errno (p)));
+        flux_subprocess_destroy (p);
+    }
+}
+
+static void imp_kill_output_cb (flux_subprocess_t *p, const char *stream)
+{
+    struct launch_service *ls;
+    const char *s;
+    int len;
+
+    ls = flux_subprocess_aux_get (p, "job-exec::launch-service");
+    if ((s = flux_subprocess_getline (p, stream, &len)) && len > 0)
+        flux_log (ls->h, LOG_INFO, "flux-imp kill: %s: %s", stream, s);
+}
+
+/*  Run "flux-imp kill <signal> <pid>" on the local process.
+ */
+static int launch_imp_kill (struct launch *l, const char *imp, int signum)
+{
+    struct launch_service *ls = l->ls;
+    flux_subprocess_ops_t ops = {
+        .on_completion =   imp_kill_completion_cb,
+        .on_state_change = imp_kill_state_cb,
+        .on_stdout =       imp_kill_output_cb,
+        .on_stderr =       imp_kill_output_cb,
+    };
+    flux_subprocess_t *p = NULL;
+    flux_cmd_t *cmd;
+    int rc = -1;
+
+    if (!(cmd = flux_cmd_create (0, NULL, environ))
+        || flux_cmd_setcwd (cmd, "/tmp") < 0
+        || flux_cmd_argv_append (cmd, imp) < 0
+        || flux_cmd_argv_append (cmd, "kill") < 0
+        || flux_cmd_argv_appendf (cmd, "%d", signum) < 0
+        || flux_cmd_argv_appendf (cmd, "%ld",
+                                  (long) flux_subprocess_pid (l->p)) < 0)
+        goto out;
+    if (!(p = flux_rexec (ls->h, ls->rank, 0, cmd, &ops)))
+        goto out;
+    if (flux_subprocess_aux_set (p, "job-exec::launch-service", ls, NULL) < 0) {
+        flux_subprocess_destroy (p);
+        goto out;
+    }
+    rc = 0;
+out:
+    flux_cmd_destroy (cmd);
+    return rc;
+}
+
+static void signal_continuation (flux_future_t *cf, void *arg)
+{
+    flux_t *h = flux_future_get_flux (cf);
+    const flux_msg_t *msg = arg;
+    const char *name;
+    int errnum = 0;
+
+    name = flux_future_first_child (cf);
+    while (name) {
+        flux_future_t *f = flux_future_get_child (cf, name);
+        if (flux_future_get (f, NULL) < 0 && errno != ENOENT)
+            errnum = errno;
+        name = flux_future_next_child (cf);
+    }
+    if (errnum) {
+        if (flux_respond_error (h, msg, errnum, NULL) < 0)
+            flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    }
+    else if (flux_respond (h, msg, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond", __FUNCTION__);
+    flux_future_destroy (cf);
+}
+
+static void launch_signal_cb (flux_t *h, flux_msg_handler_t *mh,
+                              const flux_msg_t *msg, void *arg)
+{
+    struct launch_service *ls = arg;
+    struct launch *l;
+    struct launch_child *c;
+    flux_future_t *cf = NULL;
+    flux_future_t *f;
+    const char *name;
+    const char *imp = NULL;
+    int signum;
+    bool signaled = false;
+    char key[32];
+
+    if (flux_request_unpack (msg, NULL, "{s:s s:i s?:s}",
+                             "name", &name,
+                             "signal", &signum,
+                             "imp", &imp) < 0)
+        goto error;
+    if (!(l = zhashx_lookup (ls->launches, name))) {
+        errno = ENOENT;
+        goto error;
+    }
+    if (!(cf = flux_future_wait_all_create ()))
+        goto error;
+    flux_future_set_flux (cf, h);
+
+    if (l->p && (flux_subprocess_state (l->p) == FLUX_SUBPROCESS_RUNNING
+                 || flux_subprocess_state (l->p) == FLUX_SUBPROCESS_INIT)) {
+        if (imp) {
+            if (launch_imp_kill (l, imp, signum) < 0)
+                flux_log_error (h, "%s: flux-imp kill", l->name);
+            else
+                signaled = true;
+        }
+        else if (!(f = flux_subprocess_kill (l->p, signum))
+                 || flux_future_push (cf, "local", f) < 0) {
+            flux_log_error (h, "%s: flux_subprocess_kill", l->name);
+            flux_future_destroy (f);
+        }
+    }
+    c = zlist_first (l->children);
+    while (c) {
+        if (c->f) {
+            (void) snprintf (key, sizeof (key), "%u", (unsigned int) c->rank);
+            if (!(f = flux_rpc_pack (h, "job-exec.launch-signal", c->rank, 0,
+                                     imp ? "{s:s s:i s:s}" : "{s:s s:i}",
+                                     "name", l->name,
+                                     "signal", signum,
+                                     "imp", imp))
+                || flux_future_push (cf, key, f) < 0) {
+                flux_log_error (h, "%s: rank %s: launch-signal", l->name, key);
+                flux_future_destroy (f);
+            }
+        }
+        c = zlist_next (l->children);
+    }
+    if (!flux_future_first_child (cf)) {
+        flux_future_destroy (cf);
+        if (!signaled) {
+            errno = ENOENT;
+            goto error;
+        }
+        if (flux_respond (h, msg, NULL) < 0)
+            flux_log_error (h, "%s: flux_respond", __FUNCTION__);
+        return;
+    }
+    if (flux_future_aux_set (cf, "msg", (void *) flux_msg_incref (msg),
+                             (flux_free_f) flux_msg_decref) < 0) {
+        flux_msg_decref (msg);
+        goto error;
+    }
+    if (flux_future_then (cf, -1., signal_continuation, (void *) msg) < 0)
+        goto error;
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    flux_future_destroy (cf);
+}
+
+static void launch_write_cb (flux_t *h, flux_msg_handler_t *mh,
+                             const flux_msg_t *msg, void *arg)
+{
+    struct launch_service *ls = arg;
+    struct launch *l;
+    struct launch_child *c;
+    flux_future_t *f;
+    const char *name;
+    json_t *io;
+    const char *stream;
+    char *data = NULL;
+    int len = 0;
+    bool eof = false;
+
+    if (flux_request_unpack (msg, NULL, "{s:s s:o}",
+                             "name", &name,
+                             "io", &io) < 0
+        || iodecode (io, &stream, NULL, &data, &len, &eof) < 0) {
+        flux_log_error (h, "%s: error decoding request", __FUNCTION__);
+        return;
+    }
+    if (!(l = zhashx_lookup (ls->launches, name)))
+        goto out;
+    if (l->p) {
+        if (len > 0 && flux_subprocess_write (l->p, stream, data, len) < 0)
+            flux_log_error (h, "%s: flux_subprocess_write", l->name);
+        if (eof && flux_subprocess_close (l->p, stream) < 0)
+            flux_log_error (h, "%s: flux_subprocess_close", l->name);
+    }
+    c = zlist_first (l->children);
+    while (c) {
+        if (c->f) {
+            if (!(f = flux_rpc_pack (h, "job-exec.launch-write", c->rank,
+                                     FLUX_RPC_NORESPONSE,
+                                     "{s:s s:O}",
+                                     "name", l->name,
+                                     "io", io)))
+                flux_log_error (h, "%s: rank %u: launch-write",
+                                l->name, (unsigned int) c->rank);
+            flux_future_destroy (f);
+        }
+        c = zlist_next (l->children);
+    }
+out:
+    free (data);
+}
+
+static const struct flux_msg_handler_spec htab[] = {
+    { FLUX_MSGTYPE_REQUEST, "job-exec.launch",        launch_cb,        0 },
+    { FLUX_MSGTYPE_REQUEST, "job-exec.launch-signal", launch_signal_cb, 0 },
+    { FLUX_MSGTYPE_REQUEST, "job-exec.launch-write",  launch_write_cb,  0 },
+    FLUX_MSGHANDLER_TABLE_END
+};
+
+static void launch_destructor (void **item)
+{
+    if (item) {
+        launch_destroy (*item);
+        *item = NULL;
+    }
+}
+
+void launch_service_destroy (struct launch_service *ls)
+{
+    if (ls) {
+        int saved_errno = errno;
+        flux_msg_handler_delvec (ls->handlers);
+        zhashx_destroy (&ls->launches);
+        free (ls);
+        errno = saved_errno;
+    }
+}
+
+struct launch_service *launch_service_create (flux_t *h)
+{
+    struct launch_service *ls;
+    const char *arity;
+
+    if (!(ls = calloc (1, sizeof (*ls))))
+        return NULL;
+    ls->h = h;
+    if (flux_get_rank (h, &ls->rank) < 0
+        || flux_get_size (h, &ls->size) < 0
+        || !(arity = flux_attr_get (h, "tbon.arity")))
+        goto error;
+    if ((ls->k = strtol (arity, NULL, 10)) < 1) {
+        errno = EINVAL;
+        goto error;
+    }
+    if (!(ls->launches = zhashx_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    zhashx_set_destructor (ls->launches, launch_destructor);
+    if (flux_msg_handler_addvec (h, htab, ls, &ls->handlers) < 0)
+        goto error;
+    return ls;
+error:
+    launch_service_destroy (ls);
+    return NULL;
+}
+
+/* vi: ts=4 sw=4 expandtab
+ */
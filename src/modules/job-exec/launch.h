@@ -0,0 +1,44 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* Hierarchical launch service used by bulk-exec "tree" mode.
+ *
+ * A "job-exec.launch" streaming request carries a command and a set of
+ * ranks in the TBON subtree of the receiving broker.  The command is
+ * started locally if this broker's rank is in the set, and the remaining
+ * ranks are forwarded as one launch request per TBON child subtree.
+ * Responses from children are aggregated and passed up as:
+ *
+ *  {"type":"start", "count":i}             - count processes are running
+ *  {"type":"exit", "ranks":s, "status":i}  - ranks exited, max wait status
+ *  {"type":"error", "rank":i, "errnum":i}  - process on rank failed
+ *
+ * and the stream is terminated with ENODATA once all processes in the
+ * subtree have completed.  "job-exec.launch-signal" and
+ * "job-exec.launch-write" follow the same tree to signal processes or
+ * write to their stdin.  The write payload is {"name":s, "io":o} where
+ * io is an RFC 24 data object from ioencode().
+ */
+
+#ifndef HAVE_JOB_EXEC_LAUNCH_H
+#define HAVE_JOB_EXEC_LAUNCH_H 1
+
+#include <flux/core.h>
+
+struct launch_service;
+
+struct launch_service *launch_service_create (flux_t *h);
+
+void launch_service_destroy (struct launch_service *ls);
+
+#endif /* !HAVE_JOB_EXEC_LAUNCH_H */
+
+/* vi: ts=4 sw=4 expandtab
+ */
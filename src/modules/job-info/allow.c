@@ -27,25 +27,28 @@
 static int eventlog_get_userid (struct info_ctx *ctx, const char *s,
                                 int *useridp)
 {
-    json_t *a = NULL;
-    json_t *entry = NULL;
-    const char *name = NULL;
+    size_t offset = 0;
+    const char *entry;
+    size_t entrylen;
+    const char *name;
+    size_t namelen;
     json_t *context = NULL;
     int rv = -1;
 
-    if (!(a = eventlog_decode (s))) {
-        flux_log_error (ctx->h, "%s: eventlog_decode", __FUNCTION__);
-        goto error;
-    }
-    if (!(entry = json_array_get (a, 0))) {
+    if (!eventlog_next (s, strlen (s), &offset, &entry, &entrylen)) {
         errno = EINVAL;
         goto error;
     }
-    if (eventlog_entry_parse (entry, NULL, &name, &context) < 0) {
-        flux_log_error (ctx->h, "%s: eventlog_decode", __FUNCTION__);
+    if (eventlog_entry_scan (entry,
+                             entrylen,
+                             NULL,
+                             &name,
+                             &namelen,
+                             &context) < 0) {
+        flux_log_error (ctx->h, "%s: eventlog_entry_scan", __FUNCTION__);
         goto error;
     }
-    if (strcmp (name, "submit") != 0 || !context) {
+    if (!eventlog_entry_name_is (name, namelen, "submit") || !context) {
         flux_log_error (ctx->h, "%s: invalid event", __FUNCTION__);
         errno = EINVAL;
         goto error;
@@ -56,7 +59,7 @@ static int eventlog_get_userid (struct info_ctx *ctx, const char *s,
     }
     rv = 0;
 error:
-    json_decref (a);
+    json_decref (context);
     return rv;
 }
 
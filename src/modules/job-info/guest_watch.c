@@ -315,39 +315,47 @@ error:
 static int check_guest_namespace_status (struct guest_watch_ctx *gw,
                                          const char *s)
 {
-    json_t *a = NULL;
-    size_t index;
-    json_t *event;
-    int rv = -1;
-
-    if (!(a = eventlog_decode (s)))
-        goto error;
+    size_t len = strlen (s);
+    size_t offset = 0;
+    const char *entry;
+    size_t entrylen;
 
-    json_array_foreach (a, index, event) {
+    /* Only "release" events need their context decoded.
+     */
+    while (eventlog_next (s, len, &offset, &entry, &entrylen)) {
         const char *name;
+        size_t namelen;
         json_t *context = NULL;
-        if (eventlog_entry_parse (event, NULL, &name, &context) < 0)
-            goto error;
-        if (!strcmp (name, "start"))
+        json_t *value;
+
+        if (eventlog_entry_scan (entry,
+                                 entrylen,
+                                 NULL,
+                                 &name,
+                                 &namelen,
+                                 NULL) < 0)
+            return -1;
+        if (eventlog_entry_name_is (name, namelen, "start"))
             gw->guest_started = true;
-        if (!strcmp (name, "release")) {
-            void *iter = json_object_iter (context);
-            while (iter && !gw->guest_released) {
-                const char *key = json_object_iter_key (iter);
-                if (!strcmp (key, "final")) {
-                    json_t *value = json_object_iter_value (iter);
-                    if (json_is_boolean (value) && json_is_true (value))
-                        gw->guest_released = true;
-                }
-                iter = json_object_iter_next (context, iter);
-            }
+        if (eventlog_entry_name_is (name, namelen, "release")) {
+            if (eventlog_entry_scan (entry,
+                                     entrylen,
+                                     NULL,
+                                     NULL,
+                                     NULL,
+                                     &context) < 0)
+                return -1;
+            if ((value = json_object_get (context, "final"))
+                && json_is_true (value))
+                gw->guest_released = true;
+            json_decref (context);
         }
     }
-
-    rv = 0;
-error:
-    json_decref (a);
-    return rv;
+    if (offset != len) {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
 }
 
 static void get_main_eventlog_continuation (flux_future_t *f, void *arg)
@@ -443,32 +451,26 @@ error:
 static int check_guest_namespace_created (struct guest_watch_ctx *gw,
                                           const char *event)
 {
-    json_t *o = NULL;
     const char *name;
-    int save_errno, rv = -1;
-
-    if (!(o = eventlog_entry_decode (event))) {
-        flux_log_error (gw->ctx->h, "%s: eventlog_entry_decode", __FUNCTION__);
-        goto error;
-    }
-
-    if (eventlog_entry_parse (o, NULL, &name, NULL) < 0) {
-        flux_log_error (gw->ctx->h, "%s: eventlog_entry_decode", __FUNCTION__);
-        goto error;
+    size_t namelen;
+
+    if (eventlog_entry_scan (event,
+                             strlen (event),
+                             NULL,
+                             &name,
+                             &namelen,
+                             NULL) < 0) {
+        flux_log_error (gw->ctx->h, "%s: eventlog_entry_scan", __FUNCTION__);
+        return -1;
     }
 
-    if (!strcmp (name, "start"))
+    if (eventlog_entry_name_is (name, namelen, "start"))
         gw->guest_started = true;
 
     /* Do not need to check for "clean", if "start" never occurs, will
      * eventually get ENODATA */
 
-    rv = 0;
-error:
-    save_errno = errno;
-    json_decref (o);
-    errno = save_errno;
-    return rv;
+    return 0;
 }
 
 static void wait_guest_namespace_continuation (flux_future_t *f, void *arg)
@@ -741,25 +743,13 @@ error:
     return rv;
 }
 
-static bool eventlog_parse_next (const char **pp, const char **tok,
-                                 size_t *toklen)
-{
-    char *term;
-
-    if (!(term = strchr (*pp, '\n')))
-        return false;
-    *tok = *pp;
-    *toklen = term - *pp + 1;
-    *pp = term + 1;
-    return true;
-}
-
 static void main_namespace_lookup_continuation (flux_future_t *f, void *arg)
 {
     struct guest_watch_ctx *gw = arg;
     struct info_ctx *ctx = gw->ctx;
     const char *s;
-    const char *input;
+    size_t len;
+    size_t offset;
     const char *tok;
     size_t toklen;
     char path[PATH_MAX];
@@ -778,8 +768,9 @@ static void main_namespace_lookup_continuation (flux_future_t *f, void *arg)
         goto cleanup;
     }
 
-    input = s + gw->offset;
-    while (eventlog_parse_next (&input, &tok, &toklen)) {
+    len = strlen (s);
+    offset = gw->offset;
+    while (eventlog_next (s, len, &offset, &tok, &toklen)) {
         if (flux_respond_pack (ctx->h, gw->msg,
                                "{s:s#}",
                                "event", tok, toklen) < 0) {
@@ -11,6 +11,10 @@
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
 #include <czmq.h>
 #include <flux/core.h>
 
@@ -49,12 +53,14 @@ static void stats_cb (flux_t *h, flux_msg_handler_t *mh,
     int lookups = zlist_size (ctx->lookups);
     int watchers = zlist_size (ctx->watchers);
     int guest_watchers = zlist_size (ctx->guest_watchers);
-    int pending = zlistx_size (ctx->jsctx->pending);
-    int running = zlistx_size (ctx->jsctx->running);
-    int inactive = zlistx_size (ctx->jsctx->inactive);
+    int pending = sorted_list_size (ctx->jsctx->pending);
+    int running = sorted_list_size (ctx->jsctx->running);
+    int inactive = sorted_list_size (ctx->jsctx->inactive);
     int idsync_lookups = zlistx_size (ctx->idsync_lookups);
     int idsync_waits = zhashx_size (ctx->idsync_waits);
-    if (flux_respond_pack (h, msg, "{s:i s:i s:i s:{s:i s:i s:i} s:{s:i s:i}}",
+    int restart = job_state_restart_pending (ctx->jsctx);
+    if (flux_respond_pack (h, msg,
+                           "{s:i s:i s:i s:{s:i s:i s:i} s:{s:i s:i} s:i}",
                            "lookups", lookups,
                            "watchers", watchers,
                            "guest_watchers", guest_watchers,
@@ -64,7 +70,8 @@ static void stats_cb (flux_t *h, flux_msg_handler_t *mh,
                            "inactive", inactive,
                            "idsync",
                            "lookups", idsync_lookups,
-                           "waits", idsync_waits) < 0) {
+                           "waits", idsync_waits,
+                           "restart", restart) < 0) {
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
         goto error;
     }
@@ -102,6 +109,32 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
 }
 
+static int process_args (struct info_ctx *ctx, int argc, char **argv)
+{
+    int i;
+    for (i = 0; i < argc; i++) {
+        if (!strncmp (argv[i], "restart-window=", 15)) {
+            char *endptr;
+            long n;
+
+            errno = 0;
+            n = strtol (argv[i] + 15, &endptr, 10);
+            if (errno != 0 || *endptr != '\0' || n <= 0 || n > INT_MAX) {
+                flux_log (ctx->h, LOG_ERR, "invalid option: %s", argv[i]);
+                errno = EINVAL;
+                return -1;
+            }
+            ctx->jsctx->restart_window = n;
+        }
+        else {
+            flux_log (ctx->h, LOG_ERR, "unknown option: %s", argv[i]);
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    return 0;
+}
+
 static const struct flux_msg_handler_spec htab[] = {
     { .typemask     = FLUX_MSGTYPE_REQUEST,
       .topic_glob   = "job-info.lookup",
@@ -239,6 +272,8 @@ int mod_main (flux_t *h, int argc, char **argv)
         flux_log_error (h, "initialization error");
         goto done;
     }
+    if (process_args (ctx, argc, argv) < 0)
+        goto done;
     if (job_state_init_from_kvs (ctx) < 0)
         goto done;
     if (flux_reactor_run (flux_get_reactor (h), 0) < 0)
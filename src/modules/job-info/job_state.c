@@ -20,6 +20,7 @@
 #include "src/common/libeventlog/eventlog.h"
 #include "src/common/libutil/fluid.h"
 #include "src/common/libjob/job_hash.h"
+#include "src/common/libjob/state_batch.h"
 #include "src/common/libidset/idset.h"
 
 #include "job_state.h"
@@ -28,6 +29,19 @@
 
 #define NUMCMP(a,b) ((a)==(b)?0:((a)<(b)?-1:1))
 
+/* default maximum number of jobs with KVS lookups in flight during
+ * restart, see restart_continue() */
+#define RESTART_WINDOW_DEFAULT 512
+
+/* Jobs found in the KVS at restart, loaded in order of 'ids' */
+struct job_state_restart {
+    flux_jobid_t *ids;
+    int count;
+    int size;
+    int next;
+    zlistx_t *futures;
+};
+
 struct state_transition {
     flux_job_state_t state;
     bool processed;
@@ -35,10 +49,12 @@ struct state_transition {
 };
 
 static void process_next_state (struct info_ctx *ctx, struct job *job);
+static void restart_destroy (struct job_state_restart *r);
 
 /* Compare items for sorting in list, priority first (higher priority
  * before lower priority), t_submit second (earlier submission time
- * first) N.B. zlistx_comparator_fn signature
+ * first), and job id last so that the order is total.
+ * N.B. sorted_list_cmp_f signature
  */
 static int job_priority_cmp (const void *a1, const void *a2)
 {
@@ -46,30 +62,37 @@ static int job_priority_cmp (const void *a1, const void *a2)
     const struct job *j2 = a2;
     int rc;
 
-    if ((rc = (-1)*NUMCMP (j1->priority, j2->priority)) == 0)
-        rc = NUMCMP (j1->t_submit, j2->t_submit);
+    if ((rc = (-1)*NUMCMP (j1->priority, j2->priority)) == 0
+        && (rc = NUMCMP (j1->t_submit, j2->t_submit)) == 0)
+        rc = NUMCMP (j1->id, j2->id);
     return rc;
 }
 
 /* Compare items for sorting in list by timestamp (note that sorting
  * is in reverse order, most recently (i.e. bigger timestamp)
- * running/completed comes first).  N.B. zlistx_comparator_fn
- * signature
+ * running/completed comes first), then by job id (also in reverse
+ * order).  N.B. sorted_list_cmp_f signature
  */
 static int job_running_cmp (const void *a1, const void *a2)
 {
     const struct job *j1 = a1;
     const struct job *j2 = a2;
+    int rc;
 
-    return NUMCMP (j2->t_run, j1->t_run);
+    if ((rc = NUMCMP (j2->t_run, j1->t_run)) == 0)
+        rc = NUMCMP (j2->id, j1->id);
+    return rc;
 }
 
 static int job_inactive_cmp (const void *a1, const void *a2)
 {
     const struct job *j1 = a1;
     const struct job *j2 = a2;
+    int rc;
 
-    return NUMCMP (j2->t_inactive, j1->t_inactive);
+    if ((rc = NUMCMP (j2->t_inactive, j1->t_inactive)) == 0)
+        rc = NUMCMP (j2->id, j1->id);
+    return rc;
 }
 
 static void job_destroy (void *data)
@@ -100,6 +123,14 @@ void flux_msg_destroy_wrapper (void **data)
     }
 }
 
+static void flux_future_destroy_wrapper (void **data)
+{
+    if (data) {
+        flux_future_t **ptr = (flux_future_t **)data;
+        flux_future_destroy (*ptr);
+    }
+}
+
 static struct job *job_create (struct info_ctx *ctx, flux_jobid_t id)
 {
     struct job *job = NULL;
@@ -129,6 +160,7 @@ struct job_state_ctx *job_state_create (flux_t *h)
         return NULL;
     }
     jsctx->h = h;
+    jsctx->restart_window = RESTART_WINDOW_DEFAULT;
 
     /* Index is the primary data structure holding the job data
      * structures.  It is responsible for destruction.  Lists only
@@ -139,17 +171,14 @@ struct job_state_ctx *job_state_create (flux_t *h)
         goto error;
     zhashx_set_destructor (jsctx->index, job_destroy_wrapper);
 
-    if (!(jsctx->pending = zlistx_new ()))
+    if (!(jsctx->pending = sorted_list_create (job_priority_cmp)))
         goto error;
-    zlistx_set_comparator (jsctx->pending, job_priority_cmp);
 
-    if (!(jsctx->running = zlistx_new ()))
+    if (!(jsctx->running = sorted_list_create (job_running_cmp)))
         goto error;
-    zlistx_set_comparator (jsctx->running, job_running_cmp);
 
-    if (!(jsctx->inactive = zlistx_new ()))
+    if (!(jsctx->inactive = sorted_list_create (job_inactive_cmp)))
         goto error;
-    zlistx_set_comparator (jsctx->inactive, job_inactive_cmp);
 
     if (!(jsctx->processing = zlistx_new ()))
         goto error;
@@ -179,6 +208,7 @@ void job_state_destroy (void *data)
 {
     struct job_state_ctx *jsctx = data;
     if (jsctx) {
+        restart_destroy (jsctx->restart);
         /* Don't destroy processing until futures are complete */
         if (jsctx->futures) {
             flux_future_t *f;
@@ -196,12 +226,9 @@ void job_state_destroy (void *data)
          * destroy the job objects */
         if (jsctx->processing)
             zlistx_destroy (&jsctx->processing);
-        if (jsctx->inactive)
-            zlistx_destroy (&jsctx->inactive);
-        if (jsctx->running)
-            zlistx_destroy (&jsctx->running);
-        if (jsctx->pending)
-            zlistx_destroy (&jsctx->pending);
+        sorted_list_destroy (jsctx->inactive);
+        sorted_list_destroy (jsctx->running);
+        sorted_list_destroy (jsctx->pending);
         if (jsctx->index)
             zhashx_destroy (&jsctx->index);
         if (jsctx->transitions)
@@ -211,20 +238,6 @@ void job_state_destroy (void *data)
     }
 }
 
-/* zlistx_insert() and zlistx_reorder() take a 'low_value' parameter
- * which indicates which end of the list to search from.
- * false=search begins at tail (lowest priority, youngest)
- * true=search begins at head (highest priority, oldest)
- * Attempt to minimize search distance based on job priority.
- */
-static bool search_direction (struct job *job)
-{
-    if (job->priority > FLUX_JOB_PRIORITY_DEFAULT)
-        return true;
-    else
-        return false;
-}
-
 static int *state_counter (struct info_ctx *ctx,
                            struct job *job,
                            flux_job_state_t state)
@@ -275,54 +288,13 @@ static void update_job_state (struct info_ctx *ctx,
         (*increment)++;
 }
 
-static void job_insert_list (struct job_state_ctx *jsctx,
-                             struct job *job,
-                             flux_job_state_t newstate)
-{
-    /* Note: comparator is set for running & inactive lists, but the
-     * sort calls are not called on zlistx_add_start() */
-    if (newstate == FLUX_JOB_DEPEND
-        || newstate == FLUX_JOB_SCHED) {
-        if (!(job->list_handle = zlistx_insert (jsctx->pending,
-                                                job,
-                                                search_direction (job))))
-            flux_log_error (jsctx->h, "%s: zlistx_insert",
-                            __FUNCTION__);
-    }
-    else if (newstate == FLUX_JOB_RUN
-             || newstate == FLUX_JOB_CLEANUP) {
-        if (!(job->list_handle = zlistx_add_start (jsctx->running,
-                                                   job)))
-            flux_log_error (jsctx->h, "%s: zlistx_add_start",
-                            __FUNCTION__);
-    }
-    else { /* newstate == FLUX_JOB_INACTIVE */
-        if (!(job->list_handle = zlistx_add_start (jsctx->inactive,
-                                                   job)))
-            flux_log_error (jsctx->h, "%s: zlistx_add_start",
-                            __FUNCTION__);
-    }
-}
-
-/* remove job from one list and move it to another based on the
- * newstate */
-static void job_change_list (struct job_state_ctx *jsctx,
-                             struct job *job,
-                             zlistx_t *oldlist,
-                             flux_job_state_t newstate)
-{
-    if (zlistx_detach (oldlist, job->list_handle) < 0)
-        flux_log_error (jsctx->h, "%s: zlistx_detach",
-                        __FUNCTION__);
-    job->list_handle = NULL;
-
-    job_insert_list (jsctx, job, newstate);
-}
-
-static zlistx_t *get_list (struct job_state_ctx *jsctx, flux_job_state_t state)
+/* Return the sorted list for 'state', or NULL for FLUX_JOB_NEW, as
+ * those jobs are on the unsorted processing list */
+static struct sorted_list *get_list (struct job_state_ctx *jsctx,
+                                     flux_job_state_t state)
 {
     if (state == FLUX_JOB_NEW)
-        return jsctx->processing;
+        return NULL;
     else if (state == FLUX_JOB_DEPEND
              || state == FLUX_JOB_SCHED)
         return jsctx->pending;
@@ -333,24 +305,51 @@ static zlistx_t *get_list (struct job_state_ctx *jsctx, flux_job_state_t state)
         return jsctx->inactive;
 }
 
+static void job_insert_list (struct job_state_ctx *jsctx,
+                             struct job *job,
+                             flux_job_state_t newstate)
+{
+    if (sorted_list_insert (get_list (jsctx, newstate), job) < 0)
+        flux_log_error (jsctx->h, "%s: sorted_list_insert",
+                        __FUNCTION__);
+}
+
+/* remove job from the list for its current state */
+static void job_remove_list (struct job_state_ctx *jsctx,
+                             struct job *job)
+{
+    if (job->state == FLUX_JOB_NEW) {
+        if (zlistx_detach (jsctx->processing, job->list_handle) < 0)
+            flux_log_error (jsctx->h, "%s: zlistx_detach",
+                            __FUNCTION__);
+        job->list_handle = NULL;
+    }
+    else if (sorted_list_remove (get_list (jsctx, job->state), job) < 0)
+        flux_log_error (jsctx->h, "%s: sorted_list_remove",
+                        __FUNCTION__);
+}
+
 static void update_job_state_and_list (struct info_ctx *ctx,
                                        struct job *job,
                                        flux_job_state_t newstate,
                                        double timestamp)
 {
-    zlistx_t *oldlist, *newlist;
+    struct sorted_list *oldlist, *newlist;
     struct job_state_ctx *jsctx = job->ctx->jsctx;
 
     oldlist = get_list (jsctx, job->state);
     newlist = get_list (jsctx, newstate);
 
-    /* must call before job_change_list(), to ensure timestamps are
-     * set before any sorting based on timestamps are done
+    /* Lists are searched by their sort keys, so remove the job before
+     * update_job_state() sets timestamps, and insert it after.
      */
+    if (oldlist != newlist)
+        job_remove_list (jsctx, job);
+
     update_job_state (ctx, job, newstate, timestamp);
 
     if (oldlist != newlist)
-        job_change_list (jsctx, job, oldlist, newstate);
+        job_insert_list (jsctx, job, newstate);
 }
 
 static void list_id_respond (struct info_ctx *ctx,
@@ -393,33 +392,52 @@ static void check_waiting_id (struct info_ctx *ctx,
     }
 }
 
+/* Decode the context of an eventlog entry whose name has already
+ * been scanned.  Sets *context to a new reference, or NULL if the
+ * entry has no context.
+ */
+static int eventlog_entry_context (const char *entry,
+                                   size_t entrylen,
+                                   json_t **context)
+{
+    return eventlog_entry_scan (entry, entrylen, NULL, NULL, NULL, context);
+}
+
+/* Scan the eventlog only until the "submit" event is found, which
+ * is normally the first entry.
+ */
 static int eventlog_lookup_parse (struct info_ctx *ctx,
                                   struct job *job,
                                   const char *s)
 {
-    json_t *a = NULL;
-    size_t index;
-    json_t *value;
+    size_t len = strlen (s);
+    size_t offset = 0;
+    const char *entry;
+    size_t entrylen;
+    json_t *context = NULL;
     int rc = -1;
 
-    if (!(a = eventlog_decode (s))) {
-        flux_log_error (ctx->h, "%s: error parsing eventlog for %ju",
-                        __FUNCTION__, (uintmax_t)job->id);
-        goto out;
-    }
-
-    json_array_foreach (a, index, value) {
+    while (eventlog_next (s, len, &offset, &entry, &entrylen)) {
         const char *name;
-        double timestamp;
-        json_t *context = NULL;
-
-        if (eventlog_entry_parse (value, &timestamp, &name, &context) < 0) {
+        size_t namelen;
+
+        if (eventlog_entry_scan (entry,
+                                 entrylen,
+                                 NULL,
+                                 &name,
+                                 &namelen,
+                                 NULL) < 0) {
             flux_log_error (ctx->h, "%s: error parsing entry for %ju",
                             __FUNCTION__, (uintmax_t)job->id);
             goto out;
         }
 
-        if (!strcmp (name, "submit")) {
+        if (eventlog_entry_name_is (name, namelen, "submit")) {
+            if (eventlog_entry_context (entry, entrylen, &context) < 0) {
+                flux_log_error (ctx->h, "%s: error parsing entry for %ju",
+                                __FUNCTION__, (uintmax_t)job->id);
+                goto out;
+            }
             if (!context) {
                 flux_log_error (ctx->h, "%s: no submit context for %ju",
                                 __FUNCTION__, (uintmax_t)job->id);
@@ -440,7 +458,7 @@ static int eventlog_lookup_parse (struct info_ctx *ctx,
 
     rc = 0;
 out:
-    json_decref (a);
+    json_decref (context);
     return rc;
 }
 
@@ -727,17 +745,11 @@ static flux_future_t *state_depend_lookup (struct job_state_ctx *jsctx,
 
 static int idset_add_set (struct idset *set, struct idset *new)
 {
-    unsigned int i = idset_first (new);
-    while (i != IDSET_INVALID_ID) {
-        if (idset_test (set, i)) {
-            errno = EEXIST;
-            return -1;
-        }
-        if (idset_set (set, i) < 0)
-            return -1;
-        i = idset_next (new, i);
+    if (idset_has_intersection (set, new)) {
+        errno = EEXIST;
+        return -1;
     }
-    return 0;
+    return idset_add (set, new);
 }
 
 static int idset_set_string (struct idset *idset, const char *ids)
@@ -890,25 +902,37 @@ static int eventlog_inactive_parse (struct info_ctx *ctx,
                                     struct job *job,
                                     const char *s)
 {
-    json_t *a = NULL;
-    size_t index;
-    json_t *value;
+    size_t len = strlen (s);
+    size_t offset = 0;
+    const char *entry;
+    size_t entrylen;
+    json_t *context = NULL;
     int rc = -1;
 
-    if (!(a = eventlog_decode (s))) {
-        flux_log (ctx->h, LOG_ERR,
-                  "%s: job %ju eventlog_decode: %s",
-                  __FUNCTION__, (uintmax_t)job->id, strerror (errno));
-        goto error;
-    }
+    while (eventlog_next (s, len, &offset, &entry, &entrylen)) {
+        const char *name;
+        size_t namelen;
 
-    json_array_foreach (a, index, value) {
-        const char *name = NULL;
-        json_t *context = NULL;
+        json_decref (context);
+        context = NULL;
 
-        if (eventlog_entry_parse (value, NULL, &name, &context) < 0) {
+        if (eventlog_entry_scan (entry,
+                                 entrylen,
+                                 NULL,
+                                 &name,
+                                 &namelen,
+                                 NULL) < 0) {
             flux_log (ctx->h, LOG_ERR,
-                      "%s: job %ju eventlog_entry_parse: %s",
+                      "%s: job %ju eventlog_entry_scan: %s",
+                      __FUNCTION__, (uintmax_t)job->id,
+                      strerror (errno));
+            goto error;
+        }
+        if ((eventlog_entry_name_is (name, namelen, "finish")
+             || eventlog_entry_name_is (name, namelen, "exception"))
+            && eventlog_entry_context (entry, entrylen, &context) < 0) {
+            flux_log (ctx->h, LOG_ERR,
+                      "%s: job %ju eventlog_entry_scan: %s",
                       __FUNCTION__, (uintmax_t)job->id,
                       strerror (errno));
             goto error;
@@ -918,7 +942,7 @@ static int eventlog_inactive_parse (struct info_ctx *ctx,
          * "success" attribute.  "success" is always false unless the
          * job completes ("finish") without error.
          */
-        if (!strcmp (name, "finish")) {
+        if (eventlog_entry_name_is (name, namelen, "finish")) {
             int status;
             if (json_unpack (context, "{s:i}", "status", &status) < 0) {
                 flux_log (ctx->h, LOG_ERR,
@@ -929,7 +953,7 @@ static int eventlog_inactive_parse (struct info_ctx *ctx,
             if (!status)
                 job->success = true;
         }
-        else if (!strcmp (name, "exception")) {
+        else if (eventlog_entry_name_is (name, namelen, "exception")) {
             const char *type;
             int severity;
             const char *note = NULL;
@@ -955,10 +979,16 @@ static int eventlog_inactive_parse (struct info_ctx *ctx,
             }
         }
     }
+    if (offset != len) {
+        flux_log (ctx->h, LOG_ERR,
+                  "%s: job %ju eventlog has incomplete entry",
+                  __FUNCTION__, (uintmax_t)job->id);
+        goto error;
+    }
 
     rc = 0;
 error:
-    json_decref (a);
+    json_decref (context);
     return rc;
 }
 
@@ -1127,6 +1157,41 @@ static void process_next_state (struct info_ctx *ctx, struct job *job)
     }
 }
 
+static int update_job (struct info_ctx *ctx,
+                       flux_jobid_t id,
+                       flux_job_state_t state,
+                       double timestamp)
+{
+    struct job_state_ctx *jsctx = ctx->jsctx;
+    struct job *job;
+
+    if (!(job = zhashx_lookup (jsctx->index, &id))) {
+        if (!(job = job_create (ctx, id))){
+            flux_log_error (jsctx->h, "%s: job_create", __FUNCTION__);
+            return -1;
+        }
+        if (zhashx_insert (jsctx->index, &job->id, job) < 0) {
+            flux_log_error (jsctx->h, "%s: zhashx_insert", __FUNCTION__);
+            job_destroy (job);
+            return -1;
+        }
+        /* job always starts off on processing list */
+        if (!(job->list_handle = zlistx_add_end (jsctx->processing, job))) {
+            flux_log_error (jsctx->h, "%s: zlistx_add_end", __FUNCTION__);
+            return -1;
+        }
+    }
+
+    if (add_state_transition (job, state, timestamp) < 0) {
+        flux_log_error (jsctx->h, "%s: add_state_transition",
+                        __FUNCTION__);
+        return -1;
+    }
+
+    process_next_state (ctx, job);
+    return 0;
+}
+
 static void update_jobs (struct info_ctx *ctx, json_t *transitions)
 {
     struct job_state_ctx *jsctx = ctx->jsctx;
@@ -1139,7 +1204,6 @@ static void update_jobs (struct info_ctx *ctx, json_t *transitions)
     }
 
     json_array_foreach (transitions, index, value) {
-        struct job *job;
         json_t *o;
         flux_jobid_t id;
         flux_job_state_t state;
@@ -1177,32 +1241,33 @@ static void update_jobs (struct info_ctx *ctx, json_t *transitions)
 
         timestamp = json_real_value (o);
 
-        if (!(job = zhashx_lookup (jsctx->index, &id))) {
-            if (!(job = job_create (ctx, id))){
-                flux_log_error (jsctx->h, "%s: job_create", __FUNCTION__);
-                return;
-            }
-            if (zhashx_insert (jsctx->index, &job->id, job) < 0) {
-                flux_log_error (jsctx->h, "%s: zhashx_insert", __FUNCTION__);
-                job_destroy (job);
-                return;
-            }
-            /* job always starts off on processing list */
-            if (!(job->list_handle = zlistx_add_end (jsctx->processing, job))) {
-                flux_log_error (jsctx->h, "%s: zlistx_add_end", __FUNCTION__);
-                return;
-            }
-        }
-
-        if (add_state_transition (job, state, timestamp) < 0) {
-            flux_log_error (jsctx->h, "%s: add_state_transition",
-                            __FUNCTION__);
+        if (update_job (ctx, id, state, timestamp) < 0)
             return;
-        }
+    }
 
-        process_next_state (ctx, job);
+}
+
+/* Process a binary encoded batch of transitions (see libjob/state_batch.h)
+ * directly from the event payload.
+ */
+static void update_jobs_binary (struct info_ctx *ctx, const void *buf, int len)
+{
+    int count;
+    int i;
+
+    if ((count = state_batch_decode (buf, len)) < 0) {
+        flux_log_error (ctx->h, "%s: transitions EPROTO", __FUNCTION__);
+        return;
     }
+    for (i = 0; i < count; i++) {
+        flux_jobid_t id;
+        flux_job_state_t state;
+        double timestamp;
 
+        state_batch_decode_entry (buf, i, &id, &state, &timestamp);
+        if (update_job (ctx, id, state, timestamp) < 0)
+            return;
+    }
 }
 
 void job_state_cb (flux_t *h, flux_msg_handler_t *mh,
@@ -1210,8 +1275,10 @@ void job_state_cb (flux_t *h, flux_msg_handler_t *mh,
 {
     struct info_ctx *ctx = arg;
     json_t *transitions;
+    const void *buf;
+    int len;
 
-    if (ctx->jsctx->pause) {
+    if (ctx->jsctx->pause || ctx->jsctx->restart) {
         flux_msg_t *cpy;
 
         if (!(cpy = flux_msg_copy (msg, true))) {
@@ -1224,6 +1291,14 @@ void job_state_cb (flux_t *h, flux_msg_handler_t *mh,
         }
     }
     else {
+        if (flux_event_decode_raw (msg, NULL, &buf, &len) < 0) {
+            flux_log_error (h, "%s: flux_event_decode_raw", __FUNCTION__);
+            return;
+        }
+        if (state_batch_is_binary (buf, len)) {
+            update_jobs_binary (ctx, buf, len);
+            return;
+        }
         if (flux_event_unpack (msg, NULL, "{s:o}",
                                "transitions",
                                &transitions) < 0) {
@@ -1237,6 +1312,19 @@ void job_state_cb (flux_t *h, flux_msg_handler_t *mh,
     return;
 }
 
+/* Process job-state events queued while paused or restarting */
+static void job_state_replay (struct info_ctx *ctx)
+{
+    flux_msg_t *tmsg;
+
+    tmsg = zlistx_first (ctx->jsctx->transitions);
+    while (tmsg) {
+        job_state_cb (ctx->h, NULL, tmsg, ctx);
+        tmsg = zlistx_next (ctx->jsctx->transitions);
+    }
+    zlistx_purge (ctx->jsctx->transitions);
+}
+
 void job_state_pause_cb (flux_t *h, flux_msg_handler_t *mh,
                          const flux_msg_t *msg, void *arg)
 {
@@ -1260,28 +1348,23 @@ void job_state_unpause_cb (flux_t *h, flux_msg_handler_t *mh,
                            const flux_msg_t *msg, void *arg)
 {
     struct info_ctx *ctx = arg;
-    flux_msg_t *tmsg;
 
     ctx->jsctx->pause = false;
 
-    tmsg = zlistx_first (ctx->jsctx->transitions);
-    while (tmsg) {
-        job_state_cb (h, mh, tmsg, ctx);
-        tmsg = zlistx_next (ctx->jsctx->transitions);
-    }
+    /* if restarting, transitions are replayed once restart completes */
+    if (!ctx->jsctx->restart)
+        job_state_replay (ctx);
 
     if (flux_respond (h, msg, NULL) < 0) {
         flux_log_error (h, "%s: flux_respond", __FUNCTION__);
         goto error;
     }
 
-    zlistx_purge (ctx->jsctx->transitions);
     return;
 
  error:
     if (flux_respond_error (h, msg, errno, NULL) < 0)
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
-    zlistx_purge (ctx->jsctx->transitions);
 }
 
 static struct job *eventlog_restart_parse (struct info_ctx *ctx,
@@ -1289,31 +1372,39 @@ static struct job *eventlog_restart_parse (struct info_ctx *ctx,
                                            flux_jobid_t id)
 {
     struct job *job = NULL;
-    json_t *a = NULL;
-    size_t index;
-    json_t *value;
+    size_t len = strlen (eventlog);
+    size_t offset = 0;
+    const char *entry;
+    size_t entrylen;
+    json_t *context = NULL;
 
     if (!(job = job_create (ctx, id)))
         goto error;
 
-    if (!(a = eventlog_decode (eventlog))) {
-        flux_log_error (ctx->h, "%s: error parsing eventlog for %ju",
-                        __FUNCTION__, (uintmax_t)job->id);
-        goto error;
-    }
-
-    json_array_foreach (a, index, value) {
+    while (eventlog_next (eventlog, len, &offset, &entry, &entrylen)) {
         const char *name;
+        size_t namelen;
         double timestamp;
-        json_t *context = NULL;
 
-        if (eventlog_entry_parse (value, &timestamp, &name, &context) < 0) {
+        json_decref (context);
+        context = NULL;
+
+        if (eventlog_entry_scan (entry,
+                                 entrylen,
+                                 &timestamp,
+                                 &name,
+                                 &namelen,
+                                 NULL) < 0
+            || ((eventlog_entry_name_is (name, namelen, "submit")
+                 || eventlog_entry_name_is (name, namelen, "priority")
+                 || eventlog_entry_name_is (name, namelen, "exception"))
+                && eventlog_entry_context (entry, entrylen, &context) < 0)) {
             flux_log_error (ctx->h, "%s: error parsing entry for %ju",
                             __FUNCTION__, (uintmax_t)job->id);
             goto error;
         }
 
-        if (!strcmp (name, "submit")) {
+        if (eventlog_entry_name_is (name, namelen, "submit")) {
             if (!context) {
                 flux_log_error (ctx->h, "%s: no submit context for %ju",
                                 __FUNCTION__, (uintmax_t)job->id);
@@ -1330,10 +1421,10 @@ static struct job *eventlog_restart_parse (struct info_ctx *ctx,
             }
             update_job_state (ctx, job, FLUX_JOB_DEPEND, timestamp);
         }
-        else if (!strcmp (name, "depend")) {
+        else if (eventlog_entry_name_is (name, namelen, "depend")) {
             update_job_state (ctx, job, FLUX_JOB_SCHED, timestamp);
         }
-        else if (!strcmp (name, "priority")) {
+        else if (eventlog_entry_name_is (name, namelen, "priority")) {
             if (json_unpack (context, "{ s:i }",
                                       "priority", &job->priority) < 0) {
                 flux_log_error (ctx->h, "%s: priority context for %ju invalid",
@@ -1341,7 +1432,7 @@ static struct job *eventlog_restart_parse (struct info_ctx *ctx,
                 goto error;
             }
         }
-        else if (!strcmp (name, "exception")) {
+        else if (eventlog_entry_name_is (name, namelen, "exception")) {
             int severity;
             if (json_unpack (context, "{ s:i }", "severity", &severity) < 0) {
                 flux_log_error (ctx->h, "%s: exception context for %ju invalid",
@@ -1351,18 +1442,24 @@ static struct job *eventlog_restart_parse (struct info_ctx *ctx,
             if (severity == 0)
                 update_job_state (ctx, job, FLUX_JOB_CLEANUP, timestamp);
         }
-        else if (!strcmp (name, "alloc")) {
+        else if (eventlog_entry_name_is (name, namelen, "alloc")) {
             if (job->state == FLUX_JOB_SCHED)
                 update_job_state (ctx, job, FLUX_JOB_RUN, timestamp);
         }
-        else if (!strcmp (name, "finish")) {
+        else if (eventlog_entry_name_is (name, namelen, "finish")) {
             if (job->state == FLUX_JOB_RUN)
                 update_job_state (ctx, job, FLUX_JOB_CLEANUP, timestamp);
         }
-        else if (!strcmp (name, "clean")) {
+        else if (eventlog_entry_name_is (name, namelen, "clean")) {
             update_job_state (ctx, job, FLUX_JOB_INACTIVE, timestamp);
         }
     }
+    if (offset != len) {
+        errno = EINVAL;
+        flux_log_error (ctx->h, "%s: error parsing eventlog for %ju",
+                        __FUNCTION__, (uintmax_t)job->id);
+        goto error;
+    }
 
     if (job->state == FLUX_JOB_NEW) {
         flux_log_error (ctx->h, "%s: eventlog has no transition events",
@@ -1370,12 +1467,12 @@ static struct job *eventlog_restart_parse (struct info_ctx *ctx,
         goto error;
     }
 
-    json_decref (a);
+    json_decref (context);
     return job;
 
 error:
     job_destroy (job);
-    json_decref (a);
+    json_decref (context);
     return NULL;
 }
 
@@ -1389,84 +1486,237 @@ static int depthfirst_count_depth (const char *s)
     return count;
 }
 
-static int depthfirst_map_one (struct info_ctx *ctx, const char *key,
-                               int dirskip)
+static void restart_destroy (struct job_state_restart *r)
+{
+    if (r) {
+        int saved_errno = errno;
+        zlistx_destroy (&r->futures);
+        free (r->ids);
+        free (r);
+        errno = saved_errno;
+    }
+}
+
+static struct job_state_restart *restart_create (void)
+{
+    struct job_state_restart *r;
+
+    if (!(r = calloc (1, sizeof (*r))))
+        return NULL;
+    if (!(r->futures = zlistx_new ()))
+        goto nomem;
+    zlistx_set_destructor (r->futures, flux_future_destroy_wrapper);
+    return r;
+nomem:
+    restart_destroy (r);
+    errno = ENOMEM;
+    return NULL;
+}
+
+static int restart_add_id (struct job_state_restart *r, flux_jobid_t id)
+{
+    if (r->count == r->size) {
+        int size = r->size ? r->size * 2 : 1024;
+        flux_jobid_t *ids;
+
+        if (!(ids = realloc (r->ids, size * sizeof (ids[0]))))
+            return -1;
+        r->ids = ids;
+        r->size = size;
+    }
+    r->ids[r->count++] = id;
+    return 0;
+}
+
+/* Keys fetched for each job in one batch lookup, in this order */
+enum {
+    RESTART_KEY_EVENTLOG,
+    RESTART_KEY_JOBSPEC,
+    RESTART_KEY_R,
+    RESTART_KEY_COUNT,
+};
+
+/* Build a job from the eventlog, jobspec, and R fetched together in
+ * batch lookup 'f'.  R is only required if the job reached the RUN state.
+ */
+static int restart_load_job (struct info_ctx *ctx,
+                             flux_future_t *f,
+                             flux_jobid_t id)
 {
     struct job *job = NULL;
-    flux_jobid_t id;
-    flux_future_t *f1 = NULL;
-    flux_future_t *f2 = NULL;
-    flux_future_t *f3 = NULL;
     const char *eventlog, *jobspec, *R;
-    char path[64];
-    int rc = -1;
 
-    if (strlen (key) <= dirskip) {
-        errno = EINVAL;
-        return -1;
-    }
-    if (fluid_decode (key + dirskip + 1, &id, FLUID_STRING_DOTHEX) < 0)
-        return -1;
-    if (flux_job_kvs_key (path, sizeof (path), id, "eventlog") < 0) {
-        errno = EINVAL;
-        return -1;
+    if (flux_kvs_lookup_batch_get (f, RESTART_KEY_EVENTLOG, &eventlog) < 0) {
+        flux_log_error (ctx->h, "%s: eventlog lookup for %ju",
+                        __FUNCTION__, (uintmax_t)id);
+        goto error;
     }
-    if (!(f1 = flux_kvs_lookup (ctx->h, NULL, 0, path)))
-        goto done;
-    if (flux_kvs_lookup_get (f1, &eventlog) < 0)
-        goto done;
 
     if (!(job = eventlog_restart_parse (ctx, eventlog, id)))
-        goto done;
+        goto error;
 
-    if (flux_job_kvs_key (path, sizeof (path), id, "jobspec") < 0) {
-        errno = EINVAL;
-        goto done;
+    if (flux_kvs_lookup_batch_get (f, RESTART_KEY_JOBSPEC, &jobspec) < 0) {
+        flux_log_error (ctx->h, "%s: jobspec lookup for %ju",
+                        __FUNCTION__, (uintmax_t)id);
+        goto error;
     }
-    if (!(f2 = flux_kvs_lookup (ctx->h, NULL, 0, path)))
-        goto done;
-    if (flux_kvs_lookup_get (f2, &jobspec) < 0)
-        goto done;
 
     if (jobspec_parse (ctx, job, jobspec) < 0)
-        goto done;
+        goto error;
 
     if (job->states_mask & FLUX_JOB_RUN) {
-        if (flux_job_kvs_key (path, sizeof (path), id, "R") < 0) {
-            errno = EINVAL;
-            return -1;
+        if (flux_kvs_lookup_batch_get (f, RESTART_KEY_R, &R) < 0) {
+            flux_log_error (ctx->h, "%s: R lookup for %ju",
+                            __FUNCTION__, (uintmax_t)id);
+            goto error;
         }
-        if (!(f3 = flux_kvs_lookup (ctx->h, NULL, 0, path)))
-            goto done;
-        if (flux_kvs_lookup_get (f3, &R) < 0)
-            goto done;
 
         if (R_lookup_parse (ctx, job, R) < 0)
-            goto done;
+            goto error;
     }
 
     if (job->states_mask & FLUX_JOB_INACTIVE) {
         if (eventlog_inactive_parse (ctx, job, eventlog) < 0)
-            goto done;
+            goto error;
 
         if (eventlog_inactive_finish (ctx, job) < 0)
-            goto done;
+            goto error;
     }
 
     if (zhashx_insert (ctx->jsctx->index, &job->id, job) < 0) {
         flux_log_error (ctx->h, "%s: zhashx_insert", __FUNCTION__);
-        goto done;
+        goto error;
     }
     job_insert_list (ctx->jsctx, job, job->state);
+    check_waiting_id (ctx, job);
+    return 0;
 
-    rc = 1;
-done:
-    if (rc < 0)
-        job_destroy (job);
-    flux_future_destroy (f1);
-    flux_future_destroy (f2);
-    flux_future_destroy (f3);
-    return rc;
+error:
+    job_destroy (job);
+    return -1;
+}
+
+static void restart_finish (struct info_ctx *ctx)
+{
+    struct job_state_ctx *jsctx = ctx->jsctx;
+
+    flux_log (ctx->h, LOG_DEBUG, "%s: read %d jobs",
+              __FUNCTION__, jsctx->restart->count);
+    restart_destroy (jsctx->restart);
+    jsctx->restart = NULL;
+
+    /* job-state events were deferred while the restart ran */
+    if (!jsctx->pause)
+        job_state_replay (ctx);
+}
+
+static int restart_continue (struct info_ctx *ctx);
+
+static void restart_lookup_continuation (flux_future_t *f, void *arg)
+{
+    struct info_ctx *ctx = arg;
+    struct job_state_restart *r = ctx->jsctx->restart;
+    flux_jobid_t *id = flux_future_aux_get (f, "jobid");
+    void *handle = flux_future_aux_get (f, "handle");
+    int rc;
+
+    rc = restart_load_job (ctx, f, *id);
+
+    /* destroys 'f' */
+    zlistx_delete (r->futures, handle);
+
+    if (rc < 0 || restart_continue (ctx) < 0) {
+        flux_log_error (ctx->h, "%s: restart from KVS failed", __FUNCTION__);
+        flux_reactor_stop_error (flux_get_reactor (ctx->h));
+    }
+}
+
+static flux_future_t *restart_lookup (struct info_ctx *ctx, flux_jobid_t id)
+{
+    const char *names[RESTART_KEY_COUNT] = { "eventlog", "jobspec", "R" };
+    char paths[RESTART_KEY_COUNT][64];
+    const char *keys[RESTART_KEY_COUNT];
+    flux_future_t *f;
+    flux_jobid_t *idp = NULL;
+    int i;
+
+    for (i = 0; i < RESTART_KEY_COUNT; i++) {
+        if (flux_job_kvs_key (paths[i], sizeof (paths[i]), id, names[i]) < 0) {
+            errno = EINVAL;
+            return NULL;
+        }
+        keys[i] = paths[i];
+    }
+    if (!(f = flux_kvs_lookup_batch (ctx->h, NULL, 0, keys,
+                                     RESTART_KEY_COUNT))) {
+        flux_log_error (ctx->h, "%s: flux_kvs_lookup_batch", __FUNCTION__);
+        return NULL;
+    }
+
+    if (!(idp = malloc (sizeof (*idp))))
+        goto error;
+    *idp = id;
+    if (flux_future_aux_set (f, "jobid", idp, free) < 0) {
+        free (idp);
+        goto error;
+    }
+
+    if (flux_future_then (f, -1, restart_lookup_continuation, ctx) < 0) {
+        flux_log_error (ctx->h, "%s: flux_future_then", __FUNCTION__);
+        goto error;
+    }
+    return f;
+
+error:
+    flux_future_destroy (f);
+    return NULL;
+}
+
+/* Keep up to 'restart_window' jobs worth of lookups in flight.  Once
+ * all jobs found in the KVS have been loaded, finish the restart.
+ */
+static int restart_continue (struct info_ctx *ctx)
+{
+    struct job_state_ctx *jsctx = ctx->jsctx;
+    struct job_state_restart *r = jsctx->restart;
+
+    while (r->next < r->count
+           && zlistx_size (r->futures) < (size_t)jsctx->restart_window) {
+        flux_future_t *f;
+        void *handle;
+
+        if (!(f = restart_lookup (ctx, r->ids[r->next])))
+            return -1;
+        if (!(handle = zlistx_add_end (r->futures, f))) {
+            flux_future_destroy (f);
+            errno = ENOMEM;
+            return -1;
+        }
+        if (flux_future_aux_set (f, "handle", handle, NULL) < 0) {
+            zlistx_delete (r->futures, handle);
+            return -1;
+        }
+        r->next++;
+    }
+    if (zlistx_size (r->futures) == 0)
+        restart_finish (ctx);
+    return 0;
+}
+
+static int depthfirst_map_one (struct info_ctx *ctx, const char *key,
+                               int dirskip)
+{
+    flux_jobid_t id;
+
+    if (strlen (key) <= dirskip) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (fluid_decode (key + dirskip + 1, &id, FLUID_STRING_DOTHEX) < 0)
+        return -1;
+    if (restart_add_id (ctx->jsctx->restart, id) < 0)
+        return -1;
+    return 1;
 }
 
 static int depthfirst_map (struct info_ctx *ctx, const char *key,
@@ -1518,21 +1768,30 @@ done:
     return rc;
 }
 
-/* Read jobs present in the KVS at startup. */
+/* Number of jobs found in the KVS at startup not yet loaded */
+int job_state_restart_pending (struct job_state_ctx *jsctx)
+{
+    struct job_state_restart *r = jsctx->restart;
+
+    if (!r)
+        return 0;
+    return r->count - r->next + zlistx_size (r->futures);
+}
+
+/* Read jobs present in the KVS at startup.  The "job." directory walk
+ * is synchronous, but the jobs found are loaded asynchronously by
+ * restart_continue(), so job listing is served while they are loaded.
+ */
 int job_state_init_from_kvs (struct info_ctx *ctx)
 {
     const char *dirname = "job";
     int dirskip = strlen (dirname);
-    int count;
 
-    count = depthfirst_map (ctx, dirname, dirskip);
-    if (count < 0)
+    if (!(ctx->jsctx->restart = restart_create ()))
         return -1;
-    flux_log (ctx->h, LOG_DEBUG, "%s: read %d jobs", __FUNCTION__, count);
-
-    zlistx_sort (ctx->jsctx->running);
-    zlistx_sort (ctx->jsctx->inactive);
-    return 0;
+    if (depthfirst_map (ctx, dirname, dirskip) < 0)
+        return -1;
+    return restart_continue (ctx);
 }
 
 /*
@@ -14,6 +14,8 @@
 #include <flux/core.h>
 #include <jansson.h>
 
+#include "src/common/libutil/sorted_list.h"
+
 #include "info.h"
 
 /* To handle the common case of user queries on job state, we will
@@ -29,18 +31,26 @@
  *   are sorted by job completion time (later completion times
  *   first)
  *
+ * These lists are sorted_lists, ties are broken by job id.  A job's
+ * sort keys must not change while it is on a list.
+ *
  * There is also an additional list `processing` that stores jobs that
  * cannot yet be stored on one of the lists above.
  *
  * The list `futures` is used to store in process futures.
+ *
+ * While jobs are loaded from the KVS at startup, `restart` is
+ * non-NULL and job-state events are queued on `transitions`.
  */
 
+struct job_state_restart;
+
 struct job_state_ctx {
     flux_t *h;
     zhashx_t *index;
-    zlistx_t *pending;
-    zlistx_t *running;
-    zlistx_t *inactive;
+    struct sorted_list *pending;
+    struct sorted_list *running;
+    struct sorted_list *inactive;
     zlistx_t *processing;
     zlistx_t *futures;
 
@@ -51,6 +61,11 @@ struct job_state_ctx {
     int cleanup_count;
     int inactive_count;
 
+    /* restart from KVS, restart_window is max jobs with lookups
+     * in flight */
+    struct job_state_restart *restart;
+    int restart_window;
+
     /* debug/testing - if paused store job transitions on list for
      * processing later */
     bool pause;
@@ -96,7 +111,7 @@ struct job {
      */
     zlist_t *next_states;
     unsigned int states_mask;
-    void *list_handle;
+    void *list_handle;          /* processing list only */
 
     /* timestamp of when we enter the state
      *
@@ -131,6 +146,8 @@ void job_state_unpause_cb (flux_t *h, flux_msg_handler_t *mh,
 
 int job_state_init_from_kvs (struct info_ctx *ctx);
 
+int job_state_restart_pending (struct job_state_ctx *jsctx);
+
 #endif /* ! _FLUX_JOB_INFO_JOB_STATE_H */
 
 /*
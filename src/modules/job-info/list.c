@@ -52,7 +52,7 @@ bool job_filter (struct job *job, uint32_t userid, int states, int results)
  */
 int get_jobs_from_list (json_t *jobs,
                         job_info_error_t *errp,
-                        zlistx_t *list,
+                        struct sorted_list *list,
                         int max_entries,
                         json_t *attrs,
                         uint32_t userid,
@@ -61,7 +61,7 @@ int get_jobs_from_list (json_t *jobs,
 {
     struct job *job;
 
-    job = zlistx_first (list);
+    job = sorted_list_first (list);
     while (job) {
         if (job_filter (job, userid, states, results)) {
             json_t *o;
@@ -75,7 +75,7 @@ int get_jobs_from_list (json_t *jobs,
             if (json_array_size (jobs) == max_entries)
                 return 1;
         }
-        job = zlistx_next (list);
+        job = sorted_list_next (list);
     }
 
     return 0;
@@ -242,7 +242,7 @@ json_t *get_inactive_jobs (struct info_ctx *ctx,
     if (!(jobs = json_array ()))
         goto error_nomem;
 
-    job = zlistx_first (ctx->jsctx->inactive);
+    job = sorted_list_first (ctx->jsctx->inactive);
     while (job && (job->t_inactive > since)) {
         json_t *o;
         if (!name || strcmp (job->name, name) == 0) {
@@ -256,7 +256,7 @@ json_t *get_inactive_jobs (struct info_ctx *ctx,
             if (json_array_size (jobs) == max_entries)
                 goto out;
         }
-        job = zlistx_next (ctx->jsctx->inactive);
+        job = sorted_list_next (ctx->jsctx->inactive);
     }
 
 out:
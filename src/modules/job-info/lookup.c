@@ -27,12 +27,16 @@ struct lookup_ctx {
     flux_jobid_t id;
     json_t *keys;
     bool check_eventlog;
+    int eventlog_index;
     int flags;
     flux_future_t *f;
     bool allow;
 };
 
-static void info_lookup_continuation (flux_future_t *fall, void *arg);
+/* Maximum length of a job KVS path, see flux_job_kvs_key() */
+#define LOOKUP_PATH_MAX 64
+
+static void info_lookup_continuation (flux_future_t *f, void *arg);
 
 static void lookup_ctx_destroy (void *data)
 {
@@ -77,79 +81,78 @@ error:
     return NULL;
 }
 
-static int lookup_key (struct lookup_ctx *l,
-                       flux_future_t *fall,
-                       const char *key)
-{
-    flux_future_t *f = NULL;
-    char path[64];
-
-    if (flux_job_kvs_key (path, sizeof (path), l->id, key) < 0) {
-        flux_log_error (l->ctx->h, "%s: flux_job_kvs_key", __FUNCTION__);
-        goto error;
-    }
-
-    if (!(f = flux_kvs_lookup (l->ctx->h, NULL, 0, path))) {
-        flux_log_error (l->ctx->h, "%s: flux_kvs_lookup", __FUNCTION__);
-        goto error;
-    }
-
-    if (flux_future_push (fall, key, f) < 0) {
-        flux_log_error (l->ctx->h, "%s: flux_future_push", __FUNCTION__);
-        goto error;
-    }
-
-    return 0;
-
-error:
-    flux_future_destroy (f);
-    return -1;
-}
-
+/* Look up all keys in one batch, against one KVS root snapshot.  If
+ * the eventlog is needed for the access check and was not requested,
+ * it is looked up first.
+ */
 static int lookup_keys (struct lookup_ctx *l)
 {
-    flux_future_t *fall = NULL;
+    flux_future_t *f = NULL;
+    const char **paths = NULL;
+    char *buf = NULL;
+    int size = json_array_size (l->keys) + 1;
+    int count = 0;
     size_t index;
     json_t *key;
+    int rc = -1;
 
-    if (!(fall = flux_future_wait_all_create ())) {
-        flux_log_error (l->ctx->h, "%s: flux_wait_all_create", __FUNCTION__);
-        goto error;
+    if (!(paths = calloc (size, sizeof (paths[0])))
+        || !(buf = calloc (size, LOOKUP_PATH_MAX))) {
+        errno = ENOMEM;
+        goto done;
     }
-    flux_future_set_flux (fall, l->ctx->h);
 
+    l->eventlog_index = -1;
     if (l->check_eventlog) {
-        if (lookup_key (l, fall, "eventlog") < 0)
-            goto error;
+        if (flux_job_kvs_key (buf, LOOKUP_PATH_MAX, l->id, "eventlog") < 0) {
+            flux_log_error (l->ctx->h, "%s: flux_job_kvs_key", __FUNCTION__);
+            goto done;
+        }
+        l->eventlog_index = count;
+        paths[count++] = buf;
     }
 
     json_array_foreach(l->keys, index, key) {
+        char *path = buf + count * LOOKUP_PATH_MAX;
         const char *keystr;
+
         if (!(keystr = json_string_value (key))) {
             errno = EINVAL;
-            goto error;
+            goto done;
         }
-        if (lookup_key (l, fall, keystr) < 0)
-            goto error;
+        if (flux_job_kvs_key (path, LOOKUP_PATH_MAX, l->id, keystr) < 0) {
+            flux_log_error (l->ctx->h, "%s: flux_job_kvs_key", __FUNCTION__);
+            goto done;
+        }
+        if (!strcmp (keystr, "eventlog"))
+            l->eventlog_index = count;
+        paths[count++] = path;
     }
 
-    if (flux_future_then (fall,
+    if (!(f = flux_kvs_lookup_batch (l->ctx->h, NULL, 0, paths, count))) {
+        flux_log_error (l->ctx->h, "%s: flux_kvs_lookup_batch", __FUNCTION__);
+        goto done;
+    }
+
+    if (flux_future_then (f,
                           -1,
                           info_lookup_continuation,
                           l) < 0) {
         flux_log_error (l->ctx->h, "%s: flux_future_then", __FUNCTION__);
-        goto error;
+        goto done;
     }
 
-    l->f = fall;
-    return 0;
-
-error:
-    flux_future_destroy (fall);
-    return -1;
+    l->f = f;
+    f = NULL;
+    rc = 0;
+done:
+    flux_future_destroy (f);
+    free (paths);
+    free (buf);
+    return rc;
 }
 
-static void info_lookup_continuation (flux_future_t *fall, void *arg)
+static void info_lookup_continuation (flux_future_t *f, void *arg)
 {
     struct lookup_ctx *l = arg;
     struct info_ctx *ctx = l->ctx;
@@ -160,14 +163,7 @@ static void info_lookup_continuation (flux_future_t *fall, void *arg)
     char *data = NULL;
 
     if (!l->allow) {
-        flux_future_t *f;
-
-        if (!(f = flux_future_get_child (fall, "eventlog"))) {
-            flux_log_error (ctx->h, "%s: flux_future_get_child", __FUNCTION__);
-            goto error;
-        }
-
-        if (flux_kvs_lookup_get (f, &s) < 0) {
+        if (flux_kvs_lookup_batch_get (f, l->eventlog_index, &s) < 0) {
             if (errno != ENOENT)
                 flux_log_error (l->ctx->h, "%s: flux_kvs_lookup_get", __FUNCTION__);
             goto error;
@@ -182,7 +178,7 @@ static void info_lookup_continuation (flux_future_t *fall, void *arg)
         goto enomem;
 
     json_array_foreach(l->keys, index, key) {
-        flux_future_t *f;
+        int offset = l->check_eventlog ? 1 : 0;
         const char *keystr;
         json_t *str = NULL;
 
@@ -191,12 +187,7 @@ static void info_lookup_continuation (flux_future_t *fall, void *arg)
             goto error;
         }
 
-        if (!(f = flux_future_get_child (fall, keystr))) {
-            flux_log_error (ctx->h, "%s: flux_future_get_child", __FUNCTION__);
-            goto error;
-        }
-
-        if (flux_kvs_lookup_get (f, &s) < 0) {
+        if (flux_kvs_lookup_batch_get (f, index + offset, &s) < 0) {
             if (errno != ENOENT)
                 flux_log_error (l->ctx->h, "%s: flux_kvs_lookup_get", __FUNCTION__);
             goto error;
@@ -293,6 +284,14 @@ void lookup_cb (flux_t *h, flux_msg_handler_t *mh,
             goto error;
     }
 
+    /* nothing to look up */
+    if (json_array_size (keys) == 0 && l->allow) {
+        if (flux_respond (h, msg, "{}") < 0)
+            flux_log_error (h, "%s: flux_respond", __FUNCTION__);
+        lookup_ctx_destroy (l);
+        return;
+    }
+
     if (lookup_keys (l) < 0)
         goto error;
 
@@ -188,53 +188,25 @@ done:
     zlist_remove (ctx->watchers, w);
 }
 
-static bool eventlog_parse_next (const char **pp, const char **tok,
-                                 size_t *toklen)
-{
-    char *term;
-
-    if (!(term = strchr (*pp, '\n')))
-        return false;
-    *tok = *pp;
-    *toklen = term - *pp + 1;
-    *pp = term + 1;
-    return true;
-}
-
 static int check_eventlog_end (struct watch_ctx *w,
                                const char *tok,
                                size_t toklen)
 {
-    char *str = NULL;
-    json_t *o = NULL;
-    const char *name = NULL;
-    int saved_errno, rc = -1;
-
-    if (!(str = strndup (tok, toklen))) {
-        flux_log_error (w->ctx->h, "%s: strndup", __FUNCTION__);
-        goto error;
-    }
-
-    if (!(o = eventlog_entry_decode (str))) {
-        flux_log_error (w->ctx->h, "%s: eventlog_entry_decode", __FUNCTION__);
-        goto error;
-    }
-
-    if (eventlog_entry_parse (o, NULL, &name, NULL) < 0) {
-        flux_log_error (w->ctx->h, "%s: eventlog_entry_parse", __FUNCTION__);
-        goto error;
+    const char *name;
+    size_t namelen;
+
+    if (eventlog_entry_scan (tok,
+                             toklen,
+                             NULL,
+                             &name,
+                             &namelen,
+                             NULL) < 0) {
+        flux_log_error (w->ctx->h, "%s: eventlog_entry_scan", __FUNCTION__);
+        return -1;
     }
-
-    if (!strcmp (name, "clean"))
-        rc = 1;
-    else
-        rc = 0;
-error:
-    saved_errno = errno;
-    free (str);
-    json_decref (o);
-    errno = saved_errno;
-    return rc;
+    if (eventlog_entry_name_is (name, namelen, "clean"))
+        return 1;
+    return 0;
 }
 
 static void watch_continuation (flux_future_t *f, void *arg)
@@ -242,7 +214,8 @@ static void watch_continuation (flux_future_t *f, void *arg)
     struct watch_ctx *w = arg;
     struct info_ctx *ctx = w->ctx;
     const char *s;
-    const char *input;
+    size_t len;
+    size_t offset = 0;
     const char *tok;
     size_t toklen;
 
@@ -263,8 +236,8 @@ static void watch_continuation (flux_future_t *f, void *arg)
         w->allow = true;
     }
 
-    input = s;
-    while (eventlog_parse_next (&input, &tok, &toklen)) {
+    len = strlen (s);
+    while (eventlog_next (s, len, &offset, &tok, &toklen)) {
         if (flux_respond_pack (ctx->h, w->msg,
                                "{s:s#}",
                                "event", tok, toklen) < 0) {
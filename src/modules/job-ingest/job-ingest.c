@@ -682,9 +682,10 @@ static const struct flux_msg_handler_spec htab[] = {
 };
 
 /* Configure the validator.
- * Use compiled in path and string for validator program and args,
- * unless overridden with validator=path or schema=path on module load
- * command line.
+ * By default, jobspec is validated in-process.  If validator=PATH or
+ * validator-args=ARGS is set on the module load command line, run that
+ * validator program instead, falling back to the compiled in path and
+ * string for whichever was not set.
  */
 int validate_initialize (flux_t *h,
                          int argc,
@@ -693,13 +694,11 @@ int validate_initialize (flux_t *h,
 {
     const char *usage_message = "Usage: flux module load [OPTIONS] job-ingest "
                                 " [validator-args=ARGS] [validator=PATH]";
-    const char *valpath;
-    const char *valargs;
+    const char *valpath = NULL;
+    const char *valargs = NULL;
     struct validate *v;
     int i;
 
-    valpath = flux_conf_builtin_get ("jobspec_validate_path", FLUX_CONF_AUTO);
-    valargs = flux_conf_builtin_get ("jobspec_validator_args", FLUX_CONF_AUTO);
     for (i = 0; i < argc; i++) {
         if (!strncmp (argv[i], "validator-args=", 15)) {
             valargs = argv[i] + 15;
@@ -718,6 +717,14 @@ int validate_initialize (flux_t *h,
             return -1;
         }
     }
+    if (valpath || valargs) {
+        if (!valpath)
+            valpath = flux_conf_builtin_get ("jobspec_validate_path",
+                                             FLUX_CONF_AUTO);
+        if (!valargs)
+            valargs = flux_conf_builtin_get ("jobspec_validator_args",
+                                             FLUX_CONF_AUTO);
+    }
     if (!(v = validate_create (h, valpath, valargs))) {
         flux_log_error (h, "validate_create");
         return -1;
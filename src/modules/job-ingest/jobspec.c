@@ -0,0 +1,369 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* jobspec - in-process jobspec validation
+ *
+ * Apply the checks made by validate_jobspec() in the Python bindings
+ * (flux/job.py), with the same error messages, so that the common case
+ * needn't be sent to a validator process.  Keep the two in sync.
+ *
+ * That includes Python's quirks: a bool is an int there, so true and
+ * false pass integer and number checks as 1 and 0, and 'exclusive' may
+ * be any value equal to true or false.  A string is a sequence, so an
+ * empty string is accepted for 'resources', 'tasks', and 'with', and a
+ * non-empty one fails on its first character.  'with' may also be a
+ * mapping, which is iterated by key.  A task 'attributes' that is not
+ * a mapping gets Python's message, "count must be a mapping", even
+ * though it names the wrong key.
+ *
+ * The differences are where Python fails with an incidental exception
+ * rather than a validation error:
+ * - a jobspec that is not an object is rejected here with a message,
+ *   where Python raises an AttributeError.
+ * - a number, bool, or null 'with' gets "with must be a sequence", where
+ *   Python reports "'int' object is not iterable" or similar.
+ * - a number, bool, or null task 'command' gets "command must be a list
+ *   of strings", where Python reports "object of type 'int' has no len()"
+ *   or similar.
+ * - when several keys are missing or extraneous, the first in RFC 14
+ *   order is named here, where Python names an arbitrary one.
+ *
+ * Per RFC 14, every jobspec must have exactly the keys 'version',
+ * 'resources', 'tasks', and 'attributes'.  Resources are checked
+ * recursively through their 'with' lists, and each task is checked.
+ * Version 1 additionally requires attributes.system.duration.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <jansson.h>
+
+#include "jobspec.h"
+
+static int errprintf (char *errbuf, int errbufsz, const char *fmt, ...)
+{
+    va_list ap;
+
+    if (errbuf) {
+        va_start (ap, fmt);
+        (void)vsnprintf (errbuf, errbufsz, fmt, ap);
+        va_end (ap);
+    }
+    errno = EINVAL;
+    return -1;
+}
+
+/* Python's isinstance (x, int) is true for bools.
+ */
+static bool is_int (json_t *o)
+{
+    return json_is_integer (o) || json_is_boolean (o);
+}
+
+static json_int_t int_value (json_t *o)
+{
+    if (json_is_boolean (o))
+        return json_is_true (o) ? 1 : 0;
+    return json_integer_value (o);
+}
+
+/* Python's 'x in [True, False]' compares by value, so 1, 0, 1.0, and 0.0
+ * are accepted too.
+ */
+static bool is_bool_value (json_t *o)
+{
+    if (json_is_boolean (o))
+        return true;
+    if (json_is_number (o)) {
+        double d = json_number_value (o);
+        return d == 0. || d == 1.;
+    }
+    return false;
+}
+
+static bool key_in_list (const char *key, const char **keys)
+{
+    for (int i = 0; keys[i] != NULL; i++) {
+        if (!strcmp (key, keys[i]))
+            return true;
+    }
+    return false;
+}
+
+/* Require that object 'o' has all of 'keys' unless 'optional' is true,
+ * and no others unless 'additional' is true.
+ */
+static int check_keys (json_t *o,
+                       const char **keys,
+                       bool optional,
+                       bool additional,
+                       char *errbuf,
+                       int errbufsz)
+{
+    const char *key;
+    json_t *value;
+
+    if (!optional) {
+        for (int i = 0; keys[i] != NULL; i++) {
+            if (!json_object_get (o, keys[i]))
+                return errprintf (errbuf, errbufsz,
+                                  "Missing key (%s)", keys[i]);
+        }
+    }
+    if (!additional) {
+        json_object_foreach (o, key, value) {
+            if (!key_in_list (key, keys))
+                return errprintf (errbuf, errbufsz,
+                                  "Extraneous key (%s)", key);
+        }
+    }
+    return 0;
+}
+
+static int validate_complex_range (json_t *range, char *errbuf, int errbufsz)
+{
+    const char *keys[] = { "min", "max", "operator", "operand", NULL };
+    json_t *op;
+
+    if (!json_object_get (range, "min"))
+        return errprintf (errbuf, errbufsz, "min must be in range");
+    if (json_object_size (range) > 1
+        && check_keys (range, keys, false, false, errbuf, errbufsz) < 0)
+        return -1;
+    for (int i = 0; keys[i] != NULL; i++) {
+        json_t *value;
+
+        if (!strcmp (keys[i], "operator")
+            || !(value = json_object_get (range, keys[i])))
+            continue;
+        if (!is_int (value))
+            return errprintf (errbuf, errbufsz, "%s must be an int", keys[i]);
+        if (int_value (value) < 1)
+            return errprintf (errbuf, errbufsz, "%s must be > 0", keys[i]);
+    }
+    if ((op = json_object_get (range, "operator"))) {
+        const char *s = json_string_value (op);
+        if (!s || strlen (s) != 1 || !strchr ("+*^", s[0]))
+            return errprintf (errbuf, errbufsz,
+                              "operator must be one of ['+', '*', '^']");
+    }
+    return 0;
+}
+
+static int validate_resource (json_t *res, char *errbuf, int errbufsz)
+{
+    const char *string_keys[] = { "id", "unit", "label", NULL };
+    json_t *type;
+    json_t *count;
+    json_t *exclusive;
+
+    if (!json_is_object (res))
+        return errprintf (errbuf, errbufsz, "resource must be a mapping");
+
+    if (!(type = json_object_get (res, "type")))
+        return errprintf (errbuf, errbufsz,
+                          "type is a required key for resources");
+    if (!json_is_string (type))
+        return errprintf (errbuf, errbufsz, "type must be a string");
+
+    if (!(count = json_object_get (res, "count")))
+        return errprintf (errbuf, errbufsz,
+                          "count is a required key for resources");
+    if (json_is_object (count)) {
+        if (validate_complex_range (count, errbuf, errbufsz) < 0)
+            return -1;
+    }
+    else if (!is_int (count))
+        return errprintf (errbuf, errbufsz, "count must be an int or mapping");
+    else if (int_value (count) < 1)
+        return errprintf (errbuf, errbufsz, "count must be > 0");
+
+    for (int i = 0; string_keys[i] != NULL; i++) {
+        json_t *value = json_object_get (res, string_keys[i]);
+        if (value && !json_is_string (value))
+            return errprintf (errbuf, errbufsz,
+                              "%s must be a string", string_keys[i]);
+    }
+
+    if ((exclusive = json_object_get (res, "exclusive"))
+        && !is_bool_value (exclusive))
+        return errprintf (errbuf, errbufsz, "exclusive must be a boolean");
+
+    if (!strcmp (json_string_value (type), "slot")
+        && !json_object_get (res, "label"))
+        return errprintf (errbuf, errbufsz, "slots must have labels");
+    return 0;
+}
+
+/* Python iterates over the characters of a string and the keys of a
+ * mapping, so where a list is expected, either one is accepted if empty,
+ * and otherwise fails on its first element, which is a string.
+ * Return the number of elements Python would see.
+ */
+static size_t iter_size (json_t *o)
+{
+    if (json_is_array (o))
+        return json_array_size (o);
+    if (json_is_string (o))
+        return json_string_length (o);
+    if (json_is_object (o))
+        return json_object_size (o);
+    return 0;
+}
+
+/* Depth-first, pre-order traversal, as in Jobspec.__iter__().
+ * Recursion depth is bounded by the JSON decoder's nesting limit.
+ */
+static int validate_resources (json_t *resources, char *errbuf, int errbufsz)
+{
+    size_t index;
+    json_t *res;
+
+    if (!json_is_array (resources)) {
+        if (iter_size (resources) > 0)
+            return errprintf (errbuf, errbufsz, "resource must be a mapping");
+        return 0;
+    }
+    json_array_foreach (resources, index, res) {
+        json_t *with;
+
+        if (validate_resource (res, errbuf, errbufsz) < 0)
+            return -1;
+        if ((with = json_object_get (res, "with"))) {
+            if (!json_is_array (with)
+                && !json_is_string (with)
+                && !json_is_object (with))
+                return errprintf (errbuf, errbufsz,
+                                  "with must be a sequence");
+            if (validate_resources (with, errbuf, errbufsz) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+static int validate_task (json_t *task, char *errbuf, int errbufsz)
+{
+    const char *keys[] = { "command", "slot", "count", NULL };
+    json_t *attributes;
+    json_t *command;
+    size_t index;
+    json_t *arg;
+
+    if (!json_is_object (task))
+        return errprintf (errbuf, errbufsz, "task must be a mapping");
+    if (check_keys (task, keys, false, true, errbuf, errbufsz) < 0)
+        return -1;
+    if (!json_is_object (json_object_get (task, "count")))
+        return errprintf (errbuf, errbufsz, "count must be a mapping");
+    if (!json_is_string (json_object_get (task, "slot")))
+        return errprintf (errbuf, errbufsz, "slot must be a string");
+    if ((attributes = json_object_get (task, "attributes"))
+        && !json_is_object (attributes))
+        return errprintf (errbuf, errbufsz, "count must be a mapping");
+
+    command = json_object_get (task, "command");
+    if ((json_is_array (command)
+         || json_is_string (command)
+         || json_is_object (command))
+        && iter_size (command) == 0)
+        return errprintf (errbuf, errbufsz,
+                          "command array cannot have length of zero");
+    if (!json_is_array (command))
+        return errprintf (errbuf, errbufsz,
+                          "command must be a list of strings");
+    json_array_foreach (command, index, arg) {
+        if (!json_is_string (arg))
+            return errprintf (errbuf, errbufsz,
+                              "command must be a list of strings");
+    }
+    return 0;
+}
+
+static int validate_v1 (json_t *attributes, char *errbuf, int errbufsz)
+{
+    json_t *system;
+    json_t *duration;
+
+    if (!(system = json_object_get (attributes, "system")))
+        return errprintf (errbuf, errbufsz,
+                          "attributes.system is a required key");
+    if (!json_is_object (system))
+        return errprintf (errbuf, errbufsz,
+                          "attributes.system must be a mapping");
+    if (!(duration = json_object_get (system, "duration")))
+        return errprintf (errbuf, errbufsz,
+                          "attributes.system.duration is a required key");
+    if (!json_is_number (duration) && !json_is_boolean (duration))
+        return errprintf (errbuf, errbufsz,
+                          "attributes.system.duration must be a number");
+    return 0;
+}
+
+int jobspec_validate (json_t *o, char *errbuf, int errbufsz)
+{
+    const char *top_level_keys[] = {
+        "resources", "tasks", "version", "attributes", NULL
+    };
+    const char *attribute_keys[] = { "system", "user", NULL };
+    json_t *resources;
+    json_t *tasks;
+    json_t *version;
+    json_t *attributes;
+    size_t index;
+    json_t *task;
+
+    if (!json_is_object (o))
+        return errprintf (errbuf, errbufsz, "jobspec must be a mapping");
+    if (check_keys (o, top_level_keys, false, false, errbuf, errbufsz) < 0)
+        return -1;
+
+    resources = json_object_get (o, "resources");
+    tasks = json_object_get (o, "tasks");
+    version = json_object_get (o, "version");
+    attributes = json_object_get (o, "attributes");
+    if (!json_is_array (resources) && !json_is_string (resources))
+        return errprintf (errbuf, errbufsz, "resources must be a sequence");
+    if (!json_is_array (tasks) && !json_is_string (tasks))
+        return errprintf (errbuf, errbufsz, "tasks must be a sequence");
+    if (!is_int (version))
+        return errprintf (errbuf, errbufsz, "version must be an integer");
+    if (!json_is_object (attributes))
+        return errprintf (errbuf, errbufsz, "attributes must be a mapping");
+    if (int_value (version) < 1)
+        return errprintf (errbuf, errbufsz, "version must be >= 1");
+
+    if (validate_resources (resources, errbuf, errbufsz) < 0)
+        return -1;
+    if (json_is_string (tasks) && iter_size (tasks) > 0)
+        return errprintf (errbuf, errbufsz, "task must be a mapping");
+    json_array_foreach (tasks, index, task) {
+        if (validate_task (task, errbuf, errbufsz) < 0)
+            return -1;
+    }
+    if (check_keys (attributes, attribute_keys, true, false,
+                    errbuf, errbufsz) < 0)
+        return -1;
+
+    if (int_value (version) == 1
+        && validate_v1 (attributes, errbuf, errbufsz) < 0)
+        return -1;
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,28 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _JOB_INGEST_JOBSPEC_H
+#define _JOB_INGEST_JOBSPEC_H
+
+#include <jansson.h>
+
+/* Validate decoded jobspec 'o' in-process, applying the same rules as
+ * the default validator, validate-jobspec.py.  Version 1 jobspec is
+ * held to the additional V1 requirements.
+ * On failure, return -1 with errno = EINVAL, and put a message suitable
+ * for the submitting user in 'errbuf'.
+ */
+int jobspec_validate (json_t *o, char *errbuf, int errbufsz);
+
+#endif /* !_JOB_INGEST_JOBSPEC_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,254 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <string.h>
+#include <jansson.h>
+
+#include "src/common/libtap/tap.h"
+
+#include "src/modules/job-ingest/jobspec.h"
+
+#define RESOURCES \
+    "\"resources\":[{\"type\":\"slot\",\"count\":1,\"label\":\"task\"," \
+    "\"with\":[{\"type\":\"core\",\"count\":1}]}]"
+#define TASKS \
+    "\"tasks\":[{\"command\":[\"hostname\"],\"slot\":\"task\"," \
+    "\"count\":{\"per_slot\":1}}]"
+#define ATTRIBUTES \
+    "\"attributes\":{\"system\":{\"duration\":0}}"
+
+struct testcase {
+    const char *desc;
+    const char *jobspec;
+    const char *errmsg; // NULL if jobspec is valid
+};
+
+static struct testcase tests[] = {
+    { "basic v1 jobspec",
+      "{\"version\":1," RESOURCES "," TASKS "," ATTRIBUTES "}",
+      NULL,
+    },
+    { "v1 jobspec with user attributes and cwd",
+      "{\"version\":1," RESOURCES "," TASKS ","
+      "\"attributes\":{\"system\":{\"duration\":3.5,\"cwd\":\"/tmp\"},"
+      "\"user\":{\"a\":[1,2,3]}}}",
+      NULL,
+    },
+    { "non-v1 jobspec without duration",
+      "{\"version\":999," RESOURCES "," TASKS ",\"attributes\":{}}",
+      NULL,
+    },
+    { "complex range count",
+      "{\"version\":999,\"resources\":[{\"type\":\"node\",\"count\":"
+      "{\"min\":1,\"max\":4,\"operator\":\"+\",\"operand\":1}}],"
+      TASKS ",\"attributes\":{}}",
+      NULL,
+    },
+    { "jobspec that is not an object",
+      "[]",
+      "jobspec must be a mapping",
+    },
+    { "missing version",
+      "{" RESOURCES "," TASKS "," ATTRIBUTES "}",
+      "Missing key (version)",
+    },
+    { "extra top level key",
+      "{\"version\":1," RESOURCES "," TASKS "," ATTRIBUTES ",\"foo\":1}",
+      "Extraneous key (foo)",
+    },
+    { "resources not an array",
+      "{\"version\":1,\"resources\":{}," TASKS "," ATTRIBUTES "}",
+      "resources must be a sequence",
+    },
+    { "version not an integer",
+      "{\"version\":\"1\"," RESOURCES "," TASKS "," ATTRIBUTES "}",
+      "version must be an integer",
+    },
+    { "version zero",
+      "{\"version\":0," RESOURCES "," TASKS "," ATTRIBUTES "}",
+      "version must be >= 1",
+    },
+    { "attributes null",
+      "{\"version\":1," RESOURCES "," TASKS ",\"attributes\":null}",
+      "attributes must be a mapping",
+    },
+    { "nested resource count zero",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1,"
+      "\"label\":\"task\",\"with\":[{\"type\":\"core\",\"count\":0}]}],"
+      TASKS "," ATTRIBUTES "}",
+      "count must be > 0",
+    },
+    { "slot without label",
+      "{\"version\":1,\"resources\":[{\"type\":\"slot\",\"count\":1}],"
+      TASKS "," ATTRIBUTES "}",
+      "slots must have labels",
+    },
+    { "complex range missing operator",
+      "{\"version\":1,\"resources\":[{\"type\":\"node\",\"count\":"
+      "{\"min\":1,\"max\":4,\"operand\":1}}]," TASKS "," ATTRIBUTES "}",
+      "Missing key (operator)",
+    },
+    { "exclusive not a boolean",
+      "{\"version\":1,\"resources\":[{\"type\":\"node\",\"count\":1,"
+      "\"exclusive\":\"yes\"}]," TASKS "," ATTRIBUTES "}",
+      "exclusive must be a boolean",
+    },
+    { "task missing slot",
+      "{\"version\":1," RESOURCES ",\"tasks\":[{\"command\":[\"hostname\"],"
+      "\"count\":{\"per_slot\":1}}]," ATTRIBUTES "}",
+      "Missing key (slot)",
+    },
+    { "task command zero length",
+      "{\"version\":1," RESOURCES ",\"tasks\":[{\"command\":[],"
+      "\"slot\":\"task\",\"count\":{\"per_slot\":1}}]," ATTRIBUTES "}",
+      "command array cannot have length of zero",
+    },
+    { "task command a string",
+      "{\"version\":1," RESOURCES ",\"tasks\":[{\"command\":\"hostname\","
+      "\"slot\":\"task\",\"count\":{\"per_slot\":1}}]," ATTRIBUTES "}",
+      "command must be a list of strings",
+    },
+    { "unknown attributes section",
+      "{\"version\":1," RESOURCES "," TASKS ","
+      "\"attributes\":{\"system\":{\"duration\":0},\"foo\":1}}",
+      "Extraneous key (foo)",
+    },
+    { "v1 missing system attributes",
+      "{\"version\":1," RESOURCES "," TASKS ",\"attributes\":{}}",
+      "attributes.system is a required key",
+    },
+    { "v1 duration not a number",
+      "{\"version\":1," RESOURCES "," TASKS ","
+      "\"attributes\":{\"system\":{\"duration\":\"1h\"}}}",
+      "attributes.system.duration must be a number",
+    },
+    { "exclusive 1 and 0, as in Python",
+      "{\"version\":1,\"resources\":[{\"type\":\"node\",\"count\":1,"
+      "\"exclusive\":1,\"with\":[{\"type\":\"slot\",\"count\":1,"
+      "\"label\":\"task\",\"exclusive\":0}]}]," TASKS "," ATTRIBUTES "}",
+      NULL,
+    },
+    { "exclusive 1.0, as in Python",
+      "{\"version\":1,\"resources\":[{\"type\":\"node\",\"count\":1,"
+      "\"exclusive\":1.0}]," TASKS "," ATTRIBUTES "}",
+      NULL,
+    },
+    { "exclusive 2",
+      "{\"version\":1,\"resources\":[{\"type\":\"node\",\"count\":1,"
+      "\"exclusive\":2}]," TASKS "," ATTRIBUTES "}",
+      "exclusive must be a boolean",
+    },
+    { "boolean version, count, and duration, as in Python",
+      "{\"version\":true,\"resources\":[{\"type\":\"slot\",\"count\":true,"
+      "\"label\":\"task\",\"with\":[{\"type\":\"core\",\"count\":"
+      "{\"min\":true}}]}]," TASKS ","
+      "\"attributes\":{\"system\":{\"duration\":false}}}",
+      NULL,
+    },
+    { "resource count false",
+      "{\"version\":1,\"resources\":[{\"type\":\"node\",\"count\":false}],"
+      TASKS "," ATTRIBUTES "}",
+      "count must be > 0",
+    },
+    { "task attributes not a mapping (Python's message names count)",
+      "{\"version\":1," RESOURCES ",\"tasks\":[{\"command\":[\"hostname\"],"
+      "\"slot\":\"task\",\"count\":{\"per_slot\":1},\"attributes\":[]}],"
+      ATTRIBUTES "}",
+      "count must be a mapping",
+    },
+    { "empty string resources and tasks, as in Python",
+      "{\"version\":999,\"resources\":\"\",\"tasks\":\"\","
+      "\"attributes\":{}}",
+      NULL,
+    },
+    { "empty string and empty mapping with, as in Python",
+      "{\"version\":1,\"resources\":[{\"type\":\"node\",\"count\":1,"
+      "\"with\":\"\"},{\"type\":\"node\",\"count\":1,\"with\":{}}],"
+      TASKS "," ATTRIBUTES "}",
+      NULL,
+    },
+    { "string resources",
+      "{\"version\":1,\"resources\":\"node\"," TASKS "," ATTRIBUTES "}",
+      "resource must be a mapping",
+    },
+    { "string tasks",
+      "{\"version\":1," RESOURCES ",\"tasks\":\"hostname\"," ATTRIBUTES "}",
+      "task must be a mapping",
+    },
+    { "string with",
+      "{\"version\":1,\"resources\":[{\"type\":\"node\",\"count\":1,"
+      "\"with\":\"core\"}]," TASKS "," ATTRIBUTES "}",
+      "resource must be a mapping",
+    },
+    { "mapping with",
+      "{\"version\":1,\"resources\":[{\"type\":\"node\",\"count\":1,"
+      "\"with\":{\"type\":\"core\"}}]," TASKS "," ATTRIBUTES "}",
+      "resource must be a mapping",
+    },
+    { "numeric with, where Python raises a TypeError",
+      "{\"version\":1,\"resources\":[{\"type\":\"node\",\"count\":1,"
+      "\"with\":1}]," TASKS "," ATTRIBUTES "}",
+      "with must be a sequence",
+    },
+    { "task command empty string",
+      "{\"version\":1," RESOURCES ",\"tasks\":[{\"command\":\"\","
+      "\"slot\":\"task\",\"count\":{\"per_slot\":1}}]," ATTRIBUTES "}",
+      "command array cannot have length of zero",
+    },
+    { "task command empty mapping",
+      "{\"version\":1," RESOURCES ",\"tasks\":[{\"command\":{},"
+      "\"slot\":\"task\",\"count\":{\"per_slot\":1}}]," ATTRIBUTES "}",
+      "command array cannot have length of zero",
+    },
+    { "task command a mapping",
+      "{\"version\":1," RESOURCES ",\"tasks\":[{\"command\":{\"a\":\"b\"},"
+      "\"slot\":\"task\",\"count\":{\"per_slot\":1}}]," ATTRIBUTES "}",
+      "command must be a list of strings",
+    },
+    { NULL, NULL, NULL },
+};
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    for (int i = 0; tests[i].desc != NULL; i++) {
+        json_t *o;
+        char errbuf[256];
+        int rc;
+
+        if (!(o = json_loads (tests[i].jobspec, 0, NULL)))
+            BAIL_OUT ("%s: error decoding test jobspec", tests[i].desc);
+        errbuf[0] = '\0';
+        errno = 0;
+        rc = jobspec_validate (o, errbuf, sizeof (errbuf));
+        if (!tests[i].errmsg)
+            ok (rc == 0,
+                "jobspec_validate accepts %s", tests[i].desc);
+        else {
+            ok (rc < 0 && errno == EINVAL
+                && !strcmp (errbuf, tests[i].errmsg),
+                "jobspec_validate rejects %s", tests[i].desc);
+            diag ("%s", errbuf);
+        }
+        json_decref (o);
+    }
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -10,12 +10,12 @@
 
 /* validate - asynchronous jobspec validation interface
  *
- * Spawn worker(s) to validate jobspec.  Up to 'DEFAULT_WORKER_COUNT'
- * workers may be active at one time.  They are started lazily, on demand,
- * and stop after a period of inactivity (see "tunables" below).
+ * If no validator program is configured, jobspec is validated in-process
+ * by jobspec_validate(), and the future is fulfilled before it is returned.
  *
- * The validator executable and its command line, including the
- * location of jobspec.jsonschema, are currently hardwired.
+ * Otherwise, spawn worker(s) to run the validator.  Up to one worker per
+ * online CPU may be active at one time.  They are started lazily, on demand,
+ * and stop after a period of inactivity (see "tunables" below).
  *
  * Jobspec is expected to be in encoded JSON form, with or without
  * whitespace or NULL termination.  The encoding is normalized before
@@ -38,14 +38,11 @@
 
 #include "validate.h"
 #include "worker.h"
+#include "jobspec.h"
 
 /* Tunables:
  */
 
-/* The maximum number of concurrent workers.
- */
-#define MAX_WORKER_COUNT 4
-
 /* Start a new worker if backlog reaches this level for all active workers.
  */
 const int worker_queue_threshold = 32;
@@ -58,7 +55,8 @@ const double worker_inactivity_timeout = 5.0;
 
 struct validate {
     flux_t *h;
-    struct worker *worker[MAX_WORKER_COUNT];
+    struct worker **worker;
+    int worker_count;
 };
 
 static void validate_killall (struct validate *v)
@@ -71,7 +69,7 @@ static void validate_killall (struct validate *v)
         return;
     }
     flux_future_set_flux (cf, v->h);
-    for (i = 0; i < MAX_WORKER_COUNT; i++) {
+    for (i = 0; i < v->worker_count; i++) {
         if ((f = worker_kill (v->worker[i], SIGKILL)))
             flux_future_push (cf, NULL, f);
     }
@@ -92,7 +90,7 @@ int validate_stop_notify (struct validate *v, process_exit_f cb, void *arg)
     int count;
 
     count = 0;
-    for (i = 0; i < MAX_WORKER_COUNT; i++)
+    for (i = 0; i < v->worker_count; i++)
         count += worker_stop_notify (v->worker[i], cb, arg);
     return count;
 }
@@ -102,9 +100,12 @@ void validate_destroy (struct validate *v)
     if (v) {
         int saved_errno = errno;
         int i;
-        validate_killall (v);
-        for (i = 0; i < MAX_WORKER_COUNT; i++)
-            worker_destroy (v->worker[i]);
+        if (v->worker) {
+            validate_killall (v);
+            for (i = 0; i < v->worker_count; i++)
+                worker_destroy (v->worker[i]);
+            free (v->worker);
+        }
         free (v);
         errno = saved_errno;
     }
@@ -135,7 +136,8 @@ struct validate *validate_create (flux_t *h,
         return NULL;
     v->h = h;
 
-    assert (validate_path != NULL);
+    if (!validate_path)
+        return v;
 
     if (str_ends_with (validate_path, ".py"))
         argv[argc++] = PYTHON_INTERPRETER;
@@ -162,7 +164,15 @@ struct validate *validate_create (flux_t *h,
     }
     argv[argc] = NULL;
 
-    for (i = 0; i < MAX_WORKER_COUNT; i++) {
+    /* Allow one worker per online CPU, since a busy validator process
+     * keeps a core busy.  Extra workers only start when there is a backlog
+     * (see select_best_worker()).
+     */
+    if ((v->worker_count = sysconf (_SC_NPROCESSORS_ONLN)) < 1)
+        v->worker_count = 1;
+    if (!(v->worker = calloc (v->worker_count, sizeof (v->worker[0]))))
+        goto error;
+    for (i = 0; i < v->worker_count; i++) {
         if (!(v->worker[i] = worker_create (h, worker_inactivity_timeout,
                                             validate_path,
                                             argc, argv)))
@@ -185,7 +195,7 @@ struct worker *select_best_worker (struct validate *v)
     struct worker *idle = NULL;
     int i;
 
-    for (i = 0; i < MAX_WORKER_COUNT; i++) {
+    for (i = 0; i < v->worker_count; i++) {
         if (worker_is_running (v->worker[i])) {
             if (!best || (worker_queue_depth (v->worker[i])
                         < worker_queue_depth (best)))
@@ -200,29 +210,53 @@ struct worker *select_best_worker (struct validate *v)
     return best;
 }
 
+/* Create a future that is already fulfilled with the result of validation.
+ * If 'errmsg' is non-NULL, validation failed.
+ */
+static flux_future_t *validate_result (struct validate *v, const char *errmsg)
+{
+    flux_future_t *f;
+
+    if (!(f = flux_future_create (NULL, NULL)))
+        return NULL;
+    flux_future_set_flux (f, v->h);
+    if (errmsg)
+        flux_future_fulfill_error (f, EINVAL, errmsg);
+    else
+        flux_future_fulfill (f, NULL, NULL);
+    return f;
+}
+
 flux_future_t *validate_jobspec (struct validate *v, const char *buf, int len)
 {
     flux_future_t *f;
     json_t *o;
     json_error_t error;
+    char errbuf[256];
     char *s;
     int saved_errno;
     struct worker *w;
 
     /* Make sure jobspec decodes as JSON (no YAML allowed here).
      * Capture any JSON parsing errors by returning them in a future.
-     * Then re-encode in compact form to eliminate any white space (esp \n).
      */
     if (!(o = json_loadb (buf, len, 0, &error))) {
-        char errbuf[256];
-        if (!(f = flux_future_create (NULL, NULL)))
-            return NULL;
-        flux_future_set_flux (f, v->h);
         (void)snprintf (errbuf, sizeof (errbuf),
                        "jobspec: invalid JSON: %s", error.text);
-        flux_future_fulfill_error (f, EINVAL, errbuf);
+        return validate_result (v, errbuf);
+    }
+    /* Without a validator program, the decoded jobspec is checked here.
+     */
+    if (v->worker_count == 0) {
+        if (jobspec_validate (o, errbuf, sizeof (errbuf)) < 0)
+            f = validate_result (v, errbuf);
+        else
+            f = validate_result (v, NULL);
+        json_decref (o);
         return f;
     }
+    /* Re-encode in compact form to eliminate any white space (esp \n).
+     */
     if (!(s = json_dumps (o, JSON_COMPACT)))
         goto error;
     w = select_best_worker (v);
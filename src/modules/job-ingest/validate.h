@@ -28,6 +28,10 @@ flux_future_t *validate_jobspec (struct validate *v, const char *buf, int len);
  */
 int validate_stop_notify (struct validate *v, process_exit_f cb, void *arg);
 
+/* Create validation context that runs the validator program
+ * 'validate_path' with comma-separated 'validator_args'.
+ * If 'validate_path' is NULL, validate in-process with jobspec_validate().
+ */
 struct validate *validate_create (flux_t *h,
                                   const char *validate_path,
                                   const char *validator_args);
@@ -48,6 +48,7 @@
 #include "event.h"
 
 #include "src/common/libeventlog/eventlog.h"
+#include "src/common/libjob/state_batch.h"
 
 const double batch_timeout = 0.01;
 
@@ -57,13 +58,14 @@ struct event {
     flux_watcher_t *timer;
     zlist_t *pending;
     zlist_t *pub_futures;
+    bool state_binary; // publish job-state events in binary form
 };
 
 struct event_batch {
     struct event *event;
     flux_kvs_txn_t *txn;
     flux_future_t *f;
-    json_t *state_trans;
+    struct state_batch *state_trans;
     zlist_t *responses; // responses deferred until batch complete
 };
 
@@ -141,19 +143,40 @@ void timer_cb (flux_reactor_t *r, flux_watcher_t *w, int revents, void *arg)
     event_batch_commit (ctx->event);
 }
 
-void event_publish_state (struct event *event, json_t *state_trans)
+void event_publish_state (struct event *event,
+                          struct state_batch *state_trans)
 {
     struct job_manager *ctx = event->ctx;
     flux_future_t *f;
 
-    if (!(f = flux_event_publish_pack (ctx->h,
-                                       "job-state",
-                                       0,
-                                       "{s:O}",
-                                       "transitions",
-                                       state_trans))) {
-        flux_log_error (ctx->h, "%s: flux_event_publish_pack", __FUNCTION__);
-        goto error;
+    if (event->state_binary) {
+        const void *buf;
+        int len;
+
+        state_batch_encode (state_trans, &buf, &len);
+        if (!(f = flux_event_publish_raw (ctx->h, "job-state", 0, buf, len))) {
+            flux_log_error (ctx->h, "%s: flux_event_publish_raw",
+                            __FUNCTION__);
+            goto error;
+        }
+    }
+    else {
+        json_t *o;
+
+        if (!(o = state_batch_tojson (state_trans))) {
+            flux_log_error (ctx->h, "%s: state_batch_tojson", __FUNCTION__);
+            goto error;
+        }
+        if (!(f = flux_event_publish_pack (ctx->h,
+                                           "job-state",
+                                           0,
+                                           "{s:o}",
+                                           "transitions",
+                                           o))) {
+            flux_log_error (ctx->h, "%s: flux_event_publish_pack",
+                            __FUNCTION__);
+            goto error;
+        }
     }
     if (flux_future_then (f, -1., publish_continuation, event) < 0) {
         flux_future_destroy (f);
@@ -183,8 +206,9 @@ void event_batch_destroy (struct event_batch *batch)
         if (batch->f)
             (void)flux_future_wait_for (batch->f, -1);
         if (batch->state_trans) {
-            event_publish_state (batch->event, batch->state_trans);
-            json_decref (batch->state_trans);
+            if (state_batch_count (batch->state_trans) > 0)
+                event_publish_state (batch->event, batch->state_trans);
+            state_batch_destroy (batch->state_trans);
         }
         if (batch->responses) {
             flux_msg_t *msg;
@@ -208,7 +232,7 @@ struct event_batch *event_batch_create (struct event *event)
 
     if (!(batch = calloc (1, sizeof (*batch))))
         return NULL;
-    if (!(batch->state_trans = json_array ()))
+    if (!(batch->state_trans = state_batch_create ()))
         goto nomem;
     batch->event = event;
     return batch;
@@ -261,24 +285,25 @@ static int event_batch_commit_event (struct event *event,
 int event_batch_pub_state (struct event *event, struct job *job,
                            double timestamp)
 {
-    json_t *o;
-
     if (event_batch_start (event) < 0)
-        goto error;
-    if (!(o = json_pack ("[I,s,f]",
-                         job->id,
-                         flux_job_statetostr (job->state, false),
-                         timestamp)))
-        goto nomem;
-    if (json_array_append_new (event->batch->state_trans, o)) {
-        json_decref (o);
-        goto nomem;
+        return -1;
+    return state_batch_append (event->batch->state_trans,
+                               job->id,
+                               job->state,
+                               timestamp);
+}
+
+int event_set_state_format (struct event *event, const char *format)
+{
+    if (!strcmp (format, "binary"))
+        event->state_binary = true;
+    else if (!strcmp (format, "json"))
+        event->state_binary = false;
+    else {
+        errno = EINVAL;
+        return -1;
     }
     return 0;
-nomem:
-    errno = ENOMEM;
-error:
-    return -1;
 }
 
 int event_batch_respond (struct event *event, const flux_msg_t *msg)
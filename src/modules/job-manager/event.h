@@ -35,6 +35,12 @@ int event_job_update (struct job *job, json_t *event);
 int event_batch_pub_state (struct event *event, struct job *job,
                            double timestamp);
 
+/* Select the payload format of published "job-state" events:
+ * "json" (default) or "binary" (see libjob/state_batch.h).
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int event_set_state_format (struct event *event, const char *format);
+
 /* Add add response to batch, to be sent upon batch completion.
  */
 int event_batch_respond (struct event *event, const flux_msg_t *msg);
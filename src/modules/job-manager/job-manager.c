@@ -51,6 +51,25 @@ error:
         flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
 }
 
+static int process_args (struct job_manager *ctx, int argc, char **argv)
+{
+    int i;
+    for (i = 0; i < argc; i++) {
+        if (!strncmp (argv[i], "state-format=", 13)) {
+            if (event_set_state_format (ctx->event, argv[i] + 13) < 0) {
+                flux_log (ctx->h, LOG_ERR, "invalid option: %s", argv[i]);
+                return -1;
+            }
+        }
+        else {
+            flux_log (ctx->h, LOG_ERR, "unknown option: %s", argv[i]);
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    return 0;
+}
+
 static const struct flux_msg_handler_spec htab[] = {
     {
         FLUX_MSGTYPE_REQUEST,
@@ -92,6 +111,8 @@ int mod_main (flux_t *h, int argc, char **argv)
         flux_log_error (h, "error creating event batcher");
         goto done;
     }
+    if (process_args (&ctx, argc, argv) < 0)
+        goto done;
     if (!(ctx.submit = submit_ctx_create (&ctx))) {
         flux_log_error (h, "error creating submit interface");
         goto done;
@@ -0,0 +1,339 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* hashpool.c - encode and hash content store objects on worker threads
+ *
+ * Batches are queued on a list shared with the workers under 'lock'.
+ * Workers claim items from the batch at the head of the list a few at
+ * a time.  When the last item of a batch completes, the batch is moved
+ * to the done list and the eventfd is signaled, so that the reactor
+ * thread can call the batch's callback.  Workers only touch the items
+ * they have claimed, and never call back into flux or the KVS.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <flux/core.h>
+#include <jansson.h>
+#include <sodium.h>
+
+#include "src/common/libutil/macros.h"
+#include "src/common/libutil/blobref.h"
+#include "src/common/libkvs/treeobj.h"
+
+#include "hashpool.h"
+
+/* Items claimed by a worker at once, to limit lock traffic when
+ * items are small.
+ */
+#define HASHPOOL_CHUNK 8
+
+struct hashpool_batch {
+    struct hashpool_item *items;
+    int count;
+    int next;                   /* next unclaimed item */
+    int ndone;
+    hashpool_done_f cb;
+    void *arg;
+    struct hashpool_batch *link;
+};
+
+struct hashpool {
+    char *hash_name;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct hashpool_batch *queue;       /* batches with unclaimed items */
+    struct hashpool_batch *queue_tail;
+    struct hashpool_batch *running;     /* fully claimed, not yet done */
+    struct hashpool_batch *done;        /* waiting for reactor callback */
+    bool shutdown;
+    int efd;
+    flux_watcher_t *w;
+    pthread_t *threads;
+    int nthreads;
+};
+
+int hashpool_item_encode (struct hashpool_item *item, const char *hash_name)
+{
+    char *data = NULL;
+    size_t len = 0;
+
+    if (item->is_raw) {
+        const char *xdata = json_string_value (item->obj);
+        size_t xlen;
+
+        if (!xdata) {
+            item->errnum = EINVAL;
+            goto error;
+        }
+        xlen = strlen (xdata);
+        len = BASE64_DECODE_SIZE (xlen);
+        if (len > 0) {
+            if (!(data = malloc (len))) {
+                item->errnum = ENOMEM;
+                goto error;
+            }
+            if (sodium_base642bin ((unsigned char *)data, len, xdata, xlen,
+                                   NULL, &len, NULL,
+                                   sodium_base64_VARIANT_ORIGINAL) < 0) {
+                item->errnum = EPROTO;
+                goto error;
+            }
+        }
+    }
+    else {
+        if (treeobj_validate (item->obj) < 0
+            || !(data = treeobj_encode (item->obj))) {
+            item->errnum = errno;
+            goto error;
+        }
+        len = strlen (data);
+    }
+    if (blobref_hash (hash_name, data, len, item->ref, sizeof (item->ref)) < 0) {
+        item->errnum = errno;
+        goto error;
+    }
+    item->data = data;
+    item->len = len;
+    item->errnum = 0;
+    return 0;
+error:
+    free (data);
+    item->data = NULL;
+    item->len = 0;
+    errno = item->errnum;
+    return -1;
+}
+
+static void unlink_running (struct hashpool *hp, struct hashpool_batch *b)
+{
+    struct hashpool_batch **bp = &hp->running;
+
+    while (*bp && *bp != b)
+        bp = &(*bp)->link;
+    if (*bp)
+        *bp = b->link;
+}
+
+/* Wake the reactor.  Called with 'lock' held.  The eventfd counter
+ * cannot realistically overflow, so a failed write means a wakeup is
+ * already pending.
+ */
+static void signal_done (struct hashpool *hp)
+{
+    uint64_t one = 1;
+    ssize_t n;
+
+    n = write (hp->efd, &one, sizeof (one));
+    (void)n;
+}
+
+static void *worker (void *arg)
+{
+    struct hashpool *hp = arg;
+    struct hashpool_batch *b;
+    int first, last;
+
+    pthread_mutex_lock (&hp->lock);
+    for (;;) {
+        while (!hp->queue && !hp->shutdown)
+            pthread_cond_wait (&hp->cond, &hp->lock);
+        if (hp->shutdown)
+            break;
+
+        /* Claim a chunk of the head batch.  Once all of its items are
+         * claimed, move it to the running list so others move on.
+         */
+        b = hp->queue;
+        first = b->next;
+        last = first + HASHPOOL_CHUNK;
+        if (last >= b->count) {
+            last = b->count;
+            if (!(hp->queue = b->link))
+                hp->queue_tail = NULL;
+            b->link = hp->running;
+            hp->running = b;
+        }
+        b->next = last;
+        pthread_mutex_unlock (&hp->lock);
+
+        for (int i = first; i < last; i++)
+            (void)hashpool_item_encode (&b->items[i], hp->hash_name);
+
+        pthread_mutex_lock (&hp->lock);
+        b->ndone += last - first;
+        if (b->ndone == b->count) {
+            unlink_running (hp, b);
+            b->link = hp->done;
+            hp->done = b;
+            signal_done (hp);
+        }
+    }
+    pthread_mutex_unlock (&hp->lock);
+    return NULL;
+}
+
+/* Reactor callback: call back completed batches.
+ */
+static void done_cb (flux_reactor_t *r, flux_watcher_t *w,
+                     int revents, void *arg)
+{
+    struct hashpool *hp = arg;
+    struct hashpool_batch *done;
+    struct hashpool_batch *b;
+    uint64_t count;
+
+    if (read (hp->efd, &count, sizeof (count)) < 0)
+        return;
+    pthread_mutex_lock (&hp->lock);
+    done = hp->done;
+    hp->done = NULL;
+    pthread_mutex_unlock (&hp->lock);
+
+    while ((b = done)) {
+        done = b->link;
+        b->cb (hp, b->arg);
+        free (b);
+    }
+}
+
+int hashpool_run (struct hashpool *hp,
+                  struct hashpool_item *items,
+                  int count,
+                  hashpool_done_f cb,
+                  void *arg)
+{
+    struct hashpool_batch *b;
+
+    if (!hp || (count > 0 && !items) || count < 0 || !cb) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(b = calloc (1, sizeof (*b))))
+        return -1;
+    b->items = items;
+    b->count = count;
+    b->cb = cb;
+    b->arg = arg;
+
+    pthread_mutex_lock (&hp->lock);
+    if (count == 0) {
+        /* Nothing for the workers, but call back from the reactor
+         * all the same.
+         */
+        b->link = hp->done;
+        hp->done = b;
+        signal_done (hp);
+    }
+    else {
+        if (hp->queue_tail)
+            hp->queue_tail->link = b;
+        else
+            hp->queue = b;
+        hp->queue_tail = b;
+        pthread_cond_broadcast (&hp->cond);
+    }
+    pthread_mutex_unlock (&hp->lock);
+    return 0;
+}
+
+int hashpool_get_nthreads (struct hashpool *hp)
+{
+    return hp ? hp->nthreads : 0;
+}
+
+static void free_batches (struct hashpool_batch *b)
+{
+    struct hashpool_batch *next;
+
+    while (b) {
+        next = b->link;
+        free (b);
+        b = next;
+    }
+}
+
+void hashpool_destroy (struct hashpool *hp)
+{
+    if (hp) {
+        int saved_errno = errno;
+        if (hp->threads) {
+            pthread_mutex_lock (&hp->lock);
+            hp->shutdown = true;
+            pthread_cond_broadcast (&hp->cond);
+            pthread_mutex_unlock (&hp->lock);
+            for (int i = 0; i < hp->nthreads; i++)
+                pthread_join (hp->threads[i], NULL);
+            free (hp->threads);
+        }
+        free_batches (hp->queue);
+        free_batches (hp->running);
+        free_batches (hp->done);
+        flux_watcher_destroy (hp->w);
+        if (hp->efd >= 0)
+            close (hp->efd);
+        pthread_cond_destroy (&hp->cond);
+        pthread_mutex_destroy (&hp->lock);
+        free (hp->hash_name);
+        free (hp);
+        errno = saved_errno;
+    }
+}
+
+struct hashpool *hashpool_create (flux_reactor_t *r,
+                                  const char *hash_name,
+                                  int nthreads)
+{
+    struct hashpool *hp;
+    int e;
+
+    if (!r || !hash_name || nthreads <= 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(hp = calloc (1, sizeof (*hp))))
+        return NULL;
+    hp->efd = -1;
+    pthread_mutex_init (&hp->lock, NULL);
+    pthread_cond_init (&hp->cond, NULL);
+    if (!(hp->hash_name = strdup (hash_name)))
+        goto error;
+    if ((hp->efd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0)
+        goto error;
+    if (!(hp->w = flux_fd_watcher_create (r, hp->efd, FLUX_POLLIN,
+                                          done_cb, hp)))
+        goto error;
+    flux_watcher_start (hp->w);
+    if (!(hp->threads = calloc (nthreads, sizeof (hp->threads[0]))))
+        goto error;
+    for (hp->nthreads = 0; hp->nthreads < nthreads; hp->nthreads++) {
+        if ((e = pthread_create (&hp->threads[hp->nthreads], NULL,
+                                 worker, hp))) {
+            errno = e;
+            goto error;
+        }
+    }
+    return hp;
+error:
+    hashpool_destroy (hp);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
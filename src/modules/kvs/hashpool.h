@@ -0,0 +1,79 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_KVS_HASHPOOL_H
+#define _FLUX_KVS_HASHPOOL_H
+
+#include <stdbool.h>
+#include <flux/core.h>
+#include <jansson.h>
+
+#include "src/common/libutil/blobref.h"
+
+/* A hashpool encodes and hashes objects for the content store on a
+ * set of worker threads, so that large transactions do not serialize
+ * all of that work on the reactor thread.
+ */
+struct hashpool;
+
+/* An object to be stored.  On input, 'obj' is a treeobj to encode,
+ * or if 'is_raw' is true, a json string containing base64 data to
+ * decode.  'obj' must not be modified or freed until the item is
+ * complete, nor encoded by another thread meanwhile, since older
+ * jansson marks objects while encoding them.  On output, 'data' and
+ * 'len' hold the encoded object (caller must free 'data') and 'ref'
+ * holds its blobref.  If the item failed, 'errnum' is set and 'data'
+ * is NULL.
+ */
+struct hashpool_item {
+    json_t *obj;
+    bool is_raw;
+    void *data;
+    size_t len;
+    char ref[BLOBREF_MAX_STRING_SIZE];
+    int errnum;
+};
+
+typedef void (*hashpool_done_f)(struct hashpool *hp, void *arg);
+
+/* Encode and hash 'item' on the calling thread.
+ * Returns 0 on success, -1 on error with errno set (also in errnum).
+ */
+int hashpool_item_encode (struct hashpool_item *item, const char *hash_name);
+
+/* Create a pool of 'nthreads' workers, hashing with 'hash_name'.
+ * Completions are delivered by a watcher on reactor 'r'.
+ */
+struct hashpool *hashpool_create (flux_reactor_t *r,
+                                  const char *hash_name,
+                                  int nthreads);
+
+/* Stop and join the workers.  Batches that are still in progress are
+ * abandoned without calling their callbacks.
+ */
+void hashpool_destroy (struct hashpool *hp);
+
+/* Encode and hash the 'count' items of 'items' on the worker threads.
+ * 'cb' is called from the reactor once every item is complete.
+ * 'items' must remain valid until then.
+ */
+int hashpool_run (struct hashpool *hp,
+                  struct hashpool_item *items,
+                  int count,
+                  hashpool_done_f cb,
+                  void *arg);
+
+int hashpool_get_nthreads (struct hashpool *hp);
+
+#endif /* !_FLUX_KVS_HASHPOOL_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
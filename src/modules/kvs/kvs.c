@@ -19,6 +19,7 @@
 #include <libgen.h>
 #include <unistd.h>
 #include <stdbool.h>
+#include <limits.h>
 #include <sys/time.h>
 #include <czmq.h>
 #include <flux/core.h>
@@ -55,6 +56,13 @@ const int max_namespace_age = 1000;
  */
 const bool event_includes_rootdir = true;
 
+/* Worker threads for encoding and hashing objects stored by
+ * transactions on rank 0 (see hashpool.h).  0 does it all on the
+ * reactor thread.  Override with hash-threads=N module option.
+ */
+const int default_hash_threads = 4;
+const int max_hash_threads = 256;
+
 typedef struct {
     struct cache *cache;    /* blobref => cache_entry */
     kvsroot_mgr_t *krm;
@@ -66,6 +74,9 @@ typedef struct {
     flux_watcher_t *idle_w;
     flux_watcher_t *check_w;
     int transaction_merge;
+    int dir_shard_threshold;
+    int hash_threads;
+    struct hashpool *hashpool;  /* rank 0 only */
     bool events_init;            /* flag */
     const char *hash_name;
     unsigned int seq;           /* for commit transactions */
@@ -89,10 +100,18 @@ static void start_root_remove (kvs_ctx_t *ctx, const char *ns);
 /*
  * kvs_ctx_t functions
  */
+static void kvstxn_mgr_setup (kvs_ctx_t *ctx, struct kvsroot *root)
+{
+    kvstxn_mgr_set_shard_threshold (root->ktm, ctx->dir_shard_threshold);
+    kvstxn_mgr_set_hashpool (root->ktm, ctx->hashpool);
+}
+
 static void freectx (void *arg)
 {
     kvs_ctx_t *ctx = arg;
     if (ctx) {
+        /* stop workers before the transactions they work for go away */
+        hashpool_destroy (ctx->hashpool);
         cache_destroy (ctx->cache);
         kvsroot_mgr_destroy (ctx->krm);
         flux_watcher_destroy (ctx->prep_w);
@@ -156,6 +175,8 @@ static kvs_ctx_t *getctx (flux_t *h)
             flux_watcher_start (ctx->check_w);
         }
         ctx->transaction_merge = 1;
+        ctx->dir_shard_threshold = KVSTXN_SHARD_THRESHOLD_DEFAULT;
+        ctx->hash_threads = default_hash_threads;
         if (flux_aux_set (h, "kvssrv", ctx, freectx) < 0) {
             saved_errno = errno;
             goto error;
@@ -339,6 +360,7 @@ static void getroot_completion (flux_future_t *f, void *arg)
             flux_log_error (ctx->h, "%s: kvsroot_mgr_create_root", __FUNCTION__);
             goto error;
         }
+        kvstxn_mgr_setup (ctx, root);
 
         if (event_subscribe (ctx, ns) < 0) {
             save_errno = errno;
@@ -991,6 +1013,18 @@ static void kvstxn_apply (kvstxn_t *kt)
         assert (wait_get_usecount (wait) > 0);
         goto stall;
     }
+    else if (ret == KVSTXN_PROCESS_HASHING) {
+        if (!(wait = wait_create ((wait_cb_f)kvstxn_apply, kt))) {
+            errnum = errno;
+            goto done;
+        }
+
+        if (kvstxn_wait_hashing (kt, wait) < 0) {
+            errnum = errno;
+            goto done;
+        }
+        goto stall;
+    }
     else if (ret == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES) {
         struct kvs_cb_data cbd;
 
@@ -1506,6 +1540,272 @@ error:
 }
 
 
+/* kvs.lookup-batch resolves many keys against one root snapshot.  The
+ * lookups are advanced together, so the refs they are missing are
+ * loaded as one wave of content requests and the request is replayed
+ * once, rather than each key stalling on its own round trips.
+ */
+struct lookup_batch {
+    int count;
+    lookup_t **lh;
+    bool *done;
+    char *root_ref;
+    int root_seq;
+    int errnum;                 /* error in prior load() */
+};
+
+static void lookup_batch_destroy (struct lookup_batch *lb)
+{
+    if (lb) {
+        int saved_errno = errno;
+        int i;
+
+        for (i = 0; i < lb->count; i++)
+            lookup_destroy (lb->lh[i]);
+        free (lb->lh);
+        free (lb->done);
+        free (lb->root_ref);
+        free (lb);
+        errno = saved_errno;
+    }
+}
+
+static struct lookup_batch *lookup_batch_create (kvs_ctx_t *ctx,
+                                                 const flux_msg_t *msg,
+                                                 const char *ns,
+                                                 const char *root_ref,
+                                                 int root_seq,
+                                                 json_t *keys,
+                                                 int flags)
+{
+    struct lookup_batch *lb;
+    struct flux_msg_cred cred;
+    size_t index;
+    json_t *value;
+
+    if (flux_msg_get_cred (msg, &cred) < 0) {
+        flux_log_error (ctx->h, "flux_msg_get_cred");
+        return NULL;
+    }
+    if (!(lb = calloc (1, sizeof (*lb))))
+        return NULL;
+    lb->count = json_array_size (keys);
+    lb->root_seq = root_seq;
+    if (!(lb->lh = calloc (lb->count, sizeof (lb->lh[0])))
+        || !(lb->done = calloc (lb->count, sizeof (lb->done[0])))
+        || !(lb->root_ref = strdup (root_ref))) {
+        errno = ENOMEM;
+        goto error;
+    }
+    json_array_foreach (keys, index, value) {
+        const char *key;
+
+        if (!(key = json_string_value (value))) {
+            errno = EPROTO;
+            goto error;
+        }
+        if (!(lb->lh[index] = lookup_create (ctx->cache,
+                                             ctx->krm,
+                                             ctx->epoch,
+                                             ns,
+                                             root_ref,
+                                             root_seq,
+                                             key,
+                                             cred,
+                                             flags,
+                                             ctx->h)))
+            goto error;
+    }
+    return lb;
+error:
+    lookup_batch_destroy (lb);
+    return NULL;
+}
+
+static void lookup_batch_wait_error_cb (wait_t *w, int errnum, void *arg)
+{
+    struct lookup_batch *lb = arg;
+    lb->errnum = errnum;
+}
+
+/* Result for each key is { "val":o } or { "errno":i }, where ENOENT is
+ * reported like any other per-key error.
+ */
+static json_t *lookup_batch_results (struct lookup_batch *lb)
+{
+    json_t *results;
+    int i;
+
+    if (!(results = json_array ()))
+        goto nomem;
+    for (i = 0; i < lb->count; i++) {
+        json_t *val;
+        json_t *o;
+        int errnum;
+
+        if ((errnum = lookup_get_errnum (lb->lh[i])))
+            o = json_pack ("{s:i}", "errno", errnum);
+        else if (!(val = lookup_get_value (lb->lh[i])))
+            o = json_pack ("{s:i}", "errno", ENOENT);
+        else
+            o = json_pack ("{s:o}", "val", val);
+        if (!o || json_array_append_new (results, o) < 0) {
+            json_decref (o);
+            goto nomem;
+        }
+    }
+    return results;
+nomem:
+    json_decref (results);
+    errno = ENOMEM;
+    return NULL;
+}
+
+static void lookup_batch_request_cb (flux_t *h, flux_msg_handler_t *mh,
+                                     const flux_msg_t *msg, void *arg)
+{
+    kvs_ctx_t *ctx = arg;
+    struct lookup_batch *lb;
+    wait_t *wait = NULL;
+    json_t *results;
+    int i;
+
+    /* if lookup_batch exists in msg as aux data, is a replay */
+    if (!(lb = flux_msg_aux_get (msg, "lookup_batch"))) {
+        const char *ns = NULL;
+        const char *root_ref = NULL;
+        json_t *root_dirent = NULL;
+        int root_seq = -1;
+        json_t *keys;
+        int flags;
+
+        if (flux_request_unpack (msg, NULL, "{ s:o s:i }",
+                                 "keys", &keys,
+                                 "flags", &flags) < 0) {
+            flux_log_error (h, "%s: flux_request_unpack", __FUNCTION__);
+            goto error;
+        }
+
+        /* namespace is optional */
+        (void)flux_request_unpack (msg, NULL, "{ s:s }",
+                                   "namespace", &ns);
+
+        /* rootdir is optional */
+        (void)flux_request_unpack (msg, NULL, "{ s:o }",
+                                   "rootdir", &root_dirent);
+
+        /* either namespace or rootdir must be specified */
+        if ((!ns && !root_dirent)
+            || !json_is_array (keys)
+            || json_array_size (keys) == 0) {
+            errno = EPROTO;
+            goto error;
+        }
+
+        /* All keys are looked up in the same root, either the one
+         * specified or the current root of the namespace.
+         */
+        if (root_dirent) {
+            if (treeobj_validate (root_dirent) < 0
+                || !treeobj_is_dirref (root_dirent)
+                || !(root_ref = treeobj_get_blobref (root_dirent, 0))) {
+                errno = EINVAL;
+                goto error;
+            }
+        }
+        else {
+            struct kvsroot *root;
+            bool stall = false;
+
+            if (!(root = getroot (ctx, ns, mh, msg, NULL,
+                                  lookup_batch_request_cb, &stall))) {
+                if (stall)
+                    return;
+                goto error;
+            }
+            root_ref = root->ref;
+            root_seq = root->seq;
+        }
+
+        if (!(lb = lookup_batch_create (ctx, msg, ns, root_ref, root_seq,
+                                        keys, flags)))
+            goto error;
+    }
+    else {
+        /* error in prior load(), waited for in flight rpcs to complete */
+        if (lb->errnum) {
+            errno = lb->errnum;
+            goto error;
+        }
+        for (i = 0; i < lb->count; i++)
+            (void)lookup_set_current_epoch (lb->lh[i], ctx->epoch);
+    }
+
+    for (i = 0; i < lb->count; i++) {
+        struct kvs_cb_data cbd;
+        lookup_process_t lret;
+
+        if (lb->done[i])
+            continue;
+
+        /* LOOKUP_PROCESS_LOAD_MISSING_NAMESPACE is not possible, the
+         * root_ref was set above.  Errors are reported per key.
+         */
+        if ((lret = lookup (lb->lh[i])) != LOOKUP_PROCESS_LOAD_MISSING_REFS) {
+            lb->done[i] = true;
+            continue;
+        }
+
+        if (!wait) {
+            if (!(wait = wait_create_msg_handler (h, mh, msg, ctx,
+                                                  lookup_batch_request_cb)))
+                goto error;
+            if (wait_set_error_cb (wait, lookup_batch_wait_error_cb, lb) < 0)
+                goto error;
+            /* do not destroy lookup_batch on message destruction, we
+             * manage it in here */
+            if (wait_msg_aux_set (wait, "lookup_batch", lb, NULL) < 0)
+                goto error;
+        }
+
+        cbd.ctx = ctx;
+        cbd.wait = wait;
+        cbd.errnum = 0;
+
+        if (lookup_iter_missing_refs (lb->lh[i], lookup_load_cb, &cbd) < 0) {
+            /* rpcs already in flight, stall for them to complete */
+            if (wait_get_usecount (wait) > 0) {
+                lb->errnum = cbd.errnum;
+                return;
+            }
+            errno = cbd.errnum;
+            goto error;
+        }
+    }
+
+    /* stall until all missing refs of this wave are loaded */
+    if (wait) {
+        assert (wait_get_usecount (wait) > 0);
+        return;
+    }
+
+    if (!(results = lookup_batch_results (lb)))
+        goto error;
+    if (flux_respond_pack (h, msg, "{ s:o s:i s:s }",
+                           "results", results,
+                           "rootseq", lb->root_seq,
+                           "rootref", lb->root_ref) < 0)
+        flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+    lookup_batch_destroy (lb);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    if (wait && wait_get_usecount (wait) == 0)
+        wait_destroy (wait);
+    lookup_batch_destroy (lb);
+}
+
 static int finalize_transaction_req (treq_t *tr,
                                      const flux_msg_t *req,
                                      void *data)
@@ -2366,6 +2666,7 @@ static int namespace_create (kvs_ctx_t *ctx, const char *ns,
         flux_log_error (ctx->h, "%s: kvsroot_mgr_create_root", __FUNCTION__);
         return -1;
     }
+    kvstxn_mgr_setup (ctx, root);
 
     if (!(rootdir = treeobj_create_dir ())) {
         flux_log_error (ctx->h, "%s: treeobj_create_dir", __FUNCTION__);
@@ -2798,6 +3099,8 @@ static const struct flux_msg_handler_spec htab[] = {
                             lookup_request_cb, FLUX_ROLE_USER },
     { FLUX_MSGTYPE_REQUEST, "kvs.lookup-plus",
                             lookup_plus_request_cb, FLUX_ROLE_USER },
+    { FLUX_MSGTYPE_REQUEST, "kvs.lookup-batch",
+                            lookup_batch_request_cb, FLUX_ROLE_USER },
     { FLUX_MSGTYPE_REQUEST, "kvs.commit",
                             commit_request_cb, FLUX_ROLE_USER },
     { FLUX_MSGTYPE_REQUEST, "kvs.relaycommit", relaycommit_request_cb, 0 },
@@ -2819,16 +3122,46 @@ static const struct flux_msg_handler_spec htab[] = {
     FLUX_MSGHANDLER_TABLE_END,
 };
 
-static void process_args (kvs_ctx_t *ctx, int ac, char **av)
+/* Parse the value 's' of module option 'arg' as an integer in [0:max].
+ */
+static int parse_int_option (kvs_ctx_t *ctx, const char *arg, const char *s,
+                             int max, int *value)
+{
+    char *endptr;
+    long n;
+
+    errno = 0;
+    n = strtol (s, &endptr, 10);
+    if (errno != 0 || endptr == s || *endptr != '\0' || n < 0 || n > max) {
+        flux_log (ctx->h, LOG_ERR, "invalid option: %s", arg);
+        errno = EINVAL;
+        return -1;
+    }
+    *value = n;
+    return 0;
+}
+
+static int process_args (kvs_ctx_t *ctx, int ac, char **av)
 {
     int i;
 
     for (i = 0; i < ac; i++) {
         if (strncmp (av[i], "transaction-merge=", 13) == 0)
             ctx->transaction_merge = strtoul (av[i]+13, NULL, 10);
+        else if (strncmp (av[i], "dir-shard-threshold=", 20) == 0) {
+            if (parse_int_option (ctx, av[i], av[i]+20, INT_MAX,
+                                  &ctx->dir_shard_threshold) < 0)
+                return -1;
+        }
+        else if (strncmp (av[i], "hash-threads=", 13) == 0) {
+            if (parse_int_option (ctx, av[i], av[i]+13, max_hash_threads,
+                                  &ctx->hash_threads) < 0)
+                return -1;
+        }
         else
             flux_log (ctx->h, LOG_ERR, "Unknown option `%s'", av[i]);
     }
+    return 0;
 }
 
 /* Synchronously get string value by key from checkpoint service.
@@ -2969,12 +3302,22 @@ int mod_main (flux_t *h, int argc, char **argv)
         flux_log_error (h, "error creating KVS context");
         goto done;
     }
-    process_args (ctx, argc, argv);
+    if (process_args (ctx, argc, argv) < 0)
+        goto done;
     if (ctx->rank == 0) {
         struct kvsroot *root;
         char rootref[BLOBREF_MAX_STRING_SIZE];
         uint32_t owner = getuid ();
 
+        if (ctx->hash_threads > 0) {
+            if (!(ctx->hashpool = hashpool_create (flux_get_reactor (h),
+                                                   ctx->hash_name,
+                                                   ctx->hash_threads))) {
+                flux_log_error (h, "hashpool_create");
+                goto done;
+            }
+        }
+
         /* Look for a checkpoint and use it if found.
          * Otherwise start the primary root namespace with an empty directory.
          */
@@ -3002,6 +3345,7 @@ int mod_main (flux_t *h, int argc, char **argv)
                 flux_log_error (h, "kvsroot_mgr_create_root");
                 goto done;
             }
+            kvstxn_mgr_setup (ctx, root);
         }
 
         setroot (ctx, root, rootref, 0);
@@ -30,6 +30,7 @@
 #include "src/common/libkvs/kvs_util_private.h"
 
 #include "kvstxn.h"
+#include "hashpool.h"
 
 #define KVSTXN_PROCESSING      0x01
 #define KVSTXN_MERGED          0x02 /* kvstxn is a merger of transactions */
@@ -40,6 +41,8 @@ struct kvstxn_mgr {
     const char *ns_name;
     const char *hash_name;
     int noop_stores;            /* for kvs.stats.get, etc.*/
+    int shard_threshold;        /* shard dirs with more entries */
+    struct hashpool *hashpool;  /* encode/hash on workers, if set */
     zlist_t *ready;
     flux_t *h;
     void *aux;
@@ -61,16 +64,45 @@ struct kvstxn {
     zlist_t *dirty_cache_entries_list;
     int internal_flags;
     kvstxn_mgr_t *ktm;
+    struct store_wave *waves;   /* store plan, see store_plan_dir() */
+    int nwaves;
+    int wave;                   /* next wave to store */
+    bool wave_running;          /* wave 'wave' is on the hashpool */
+    bool wave_complete;
+    waitqueue_t *hashing_waiters;
     enum {
         KVSTXN_STATE_INIT = 1,
         KVSTXN_STATE_LOAD_ROOT = 2,
         KVSTXN_STATE_APPLY_OPS = 3,
         KVSTXN_STATE_STORE = 4,
-        KVSTXN_STATE_PRE_FINISHED = 5,
-        KVSTXN_STATE_FINISHED = 6,
+        KVSTXN_STATE_STORE_WAVES = 5,
+        KVSTXN_STATE_PRE_FINISHED = 6,
+        KVSTXN_STATE_FINISHED = 7,
     } state;
 };
 
+/* Objects to be stored in one wave of a parallel store.  Each object
+ * is stored only after the objects it contains have been stored and
+ * replaced by references, so objects are grouped by their height in
+ * the tree, and each wave is encoded and hashed as one batch.
+ * dests[i] says where the reference to items[i] goes: under 'key' in
+ * the treeobj data object 'container', or kt->newroot if NULL.
+ */
+struct store_dest {
+    json_t *container;
+    char *key;
+};
+
+struct store_wave {
+    struct hashpool_item *items;
+    struct store_dest *dests;
+    int count;
+    int size;
+    bool copied;    /* dir items were replaced with private copies */
+};
+
+static void store_plan_free (kvstxn_t *kt);
+
 static void kvstxn_destroy (kvstxn_t *kt)
 {
     if (kt) {
@@ -83,6 +115,8 @@ static void kvstxn_destroy (kvstxn_t *kt)
             zlist_destroy (&kt->missing_refs_list);
         if (kt->dirty_cache_entries_list)
             zlist_destroy (&kt->dirty_cache_entries_list);
+        store_plan_free (kt);
+        wait_queue_destroy (kt->hashing_waiters);
         free (kt);
     }
 }
@@ -208,6 +242,7 @@ json_t *kvstxn_get_keys (kvstxn_t *kt)
 void kvstxn_cleanup_dirty_cache_entry (kvstxn_t *kt, struct cache_entry *entry)
 {
     if (kt->state == KVSTXN_STATE_STORE
+        || kt->state == KVSTXN_STATE_STORE_WAVES
         || kt->state == KVSTXN_STATE_PRE_FINISHED) {
         char ref[BLOBREF_MAX_STRING_SIZE];
         const void *data;
@@ -238,61 +273,27 @@ static void cleanup_dirty_cache_list (kvstxn_t *kt)
         kvstxn_cleanup_dirty_cache_entry (kt, entry);
 }
 
-/* Store object 'o' under key 'ref' in local cache.
- * Object reference is still owned by the caller.
- * 'is_raw' indicates this data is a json string w/ base64 value and
- * should be flushed to the content store as raw data after it is
- * decoded.  Otherwise, the json object should be a treeobj.
+/* Store encoded object 'data' of 'len' bytes under key 'ref' in
+ * local cache.  'data' is still owned by the caller.
  * Returns -1 on error, 0 on success entry already there, 1 on success
  * entry needs to be flushed to content store
  */
-static int store_cache (kvstxn_t *kt, int current_epoch, json_t *o,
-                        bool is_raw, char *ref, int ref_len,
-                        struct cache_entry **entryp)
+static int store_cache_data (kvstxn_t *kt, int current_epoch,
+                             const char *ref, const void *data, size_t len,
+                             struct cache_entry **entryp)
 {
     struct cache_entry *entry;
-    int saved_errno, rc;
-    const char *xdata;
-    char *data = NULL;
-    size_t xlen, len;
-
-    if (is_raw) {
-        xdata = json_string_value (o);
-        xlen = strlen (xdata);
-        len = BASE64_DECODE_SIZE (xlen);
-        if (len > 0) {
-            if (!(data = malloc (len))) {
-                flux_log_error (kt->ktm->h, "malloc");
-                goto error;
-            }
-            if (sodium_base642bin ((unsigned char *)data, len, xdata, xlen,
-                                   NULL, &len, NULL,
-                                   sodium_base64_VARIANT_ORIGINAL) < 0) {
-                errno = EPROTO;
-                goto error;
-            }
-        }
-    }
-    else {
-        if (treeobj_validate (o) < 0 || !(data = treeobj_encode (o))) {
-            flux_log_error (kt->ktm->h, "%s: treeobj_encode", __FUNCTION__);
-            goto error;
-        }
-        len = strlen (data);
-    }
-    if (blobref_hash (kt->ktm->hash_name, data, len, ref, ref_len) < 0) {
-        flux_log_error (kt->ktm->h, "%s: blobref_hash", __FUNCTION__);
-        goto error;
-    }
+    int rc;
+
     if (!(entry = cache_lookup (kt->ktm->cache, ref, current_epoch))) {
         if (!(entry = cache_entry_create (ref))) {
             flux_log_error (kt->ktm->h, "%s: cache_entry_create", __FUNCTION__);
-            goto error;
+            return -1;
         }
         if (cache_insert (kt->ktm->cache, entry) < 0) {
             cache_entry_destroy (entry);
             flux_log_error (kt->ktm->h, "%s: cache_insert", __FUNCTION__);
-            goto error;
+            return -1;
         }
     }
     if (cache_entry_get_valid (entry)) {
@@ -304,28 +305,59 @@ static int store_cache (kvstxn_t *kt, int current_epoch, json_t *o,
             int ret;
             ret = cache_remove_entry (kt->ktm->cache, ref);
             assert (ret == 1);
-            goto error;
+            return -1;
         }
         if (cache_entry_set_dirty (entry, true) < 0) {
             flux_log_error (kt->ktm->h, "%s: cache_entry_set_dirty",__FUNCTION__);
             int ret;
             ret = cache_remove_entry (kt->ktm->cache, ref);
             assert (ret == 1);
-            goto error;
+            return -1;
         }
         rc = 1;
     }
     *entryp = entry;
-    free (data);
     return rc;
+}
 
- error:
+/* Store object 'o' under key 'ref' in local cache.
+ * Object reference is still owned by the caller.
+ * 'is_raw' indicates this data is a json string w/ base64 value and
+ * should be flushed to the content store as raw data after it is
+ * decoded.  Otherwise, the json object should be a treeobj.
+ * Returns -1 on error, 0 on success entry already there, 1 on success
+ * entry needs to be flushed to content store
+ */
+static int store_cache (kvstxn_t *kt, int current_epoch, json_t *o,
+                        bool is_raw, char *ref, int ref_len,
+                        struct cache_entry **entryp)
+{
+    struct hashpool_item item = { .obj = o, .is_raw = is_raw };
+    int saved_errno, rc;
+
+    if (hashpool_item_encode (&item, kt->ktm->hash_name) < 0) {
+        if (errno != EPROTO)
+            flux_log_error (kt->ktm->h, "%s: encode", __FUNCTION__);
+        return -1;
+    }
+    if (strlen (item.ref) >= ref_len) {
+        errno = EOVERFLOW;
+        rc = -1;
+    }
+    else {
+        strcpy (ref, item.ref);
+        rc = store_cache_data (kt, current_epoch, item.ref,
+                               item.data, item.len, entryp);
+    }
     saved_errno = errno;
-    free (data);
+    free (item.data);
     errno = saved_errno;
-    return -1;
+    return rc;
 }
 
+static int kvstxn_store_dir (kvstxn_t *kt, int current_epoch, json_t *dir,
+                             int level, char *ref, int ref_len);
+
 /* Store DIRVAL objects, converting them to DIRREFs.
  * Store (large) FILEVAL objects, converting them to FILEREFs.
  * Return 0 on success, -1 on error
@@ -352,19 +384,10 @@ static int kvstxn_unroll (kvstxn_t *kt, int current_epoch, json_t *dir)
      */
     while (iter) {
         dir_entry = json_object_iter_value (iter);
-        if (treeobj_is_dir (dir_entry)) {
-            if (kvstxn_unroll (kt, current_epoch, dir_entry) < 0) /* depth first */
-                return -1;
-            if ((ret = store_cache (kt, current_epoch, dir_entry,
-                                    false, ref, sizeof (ref), &entry)) < 0)
+        if (treeobj_is_dir (dir_entry) || treeobj_is_hdir (dir_entry)) {
+            if (kvstxn_store_dir (kt, current_epoch, dir_entry, 0,
+                                  ref, sizeof (ref)) < 0)
                 return -1;
-            if (ret) {
-                if (zlist_push (kt->dirty_cache_entries_list, entry) < 0) {
-                    kvstxn_cleanup_dirty_cache_entry (kt, entry);
-                    errno = ENOMEM;
-                    return -1;
-                }
-            }
             if (!(ktmp = treeobj_create_dirref (ref)))
                 return -1;
             if (json_object_iter_set_new (dir, iter, ktmp) < 0) {
@@ -408,6 +431,473 @@ static int kvstxn_unroll (kvstxn_t *kt, int current_epoch, json_t *dir)
     return 0;
 }
 
+/* Store the shards of sharded directory 'hdir' at trie 'level',
+ * converting them to DIRREFs.  Shards left empty are dropped.
+ * Return 0 on success, -1 on error
+ */
+static int kvstxn_unroll_hdir (kvstxn_t *kt, int current_epoch, json_t *hdir,
+                               int level)
+{
+    json_t *hdir_data;
+    json_t *shard;
+    json_t *ktmp;
+    json_t *empty;
+    char ref[BLOBREF_MAX_STRING_SIZE];
+    const char *key;
+    size_t index;
+    json_t *value;
+    void *iter;
+    int rc = -1;
+
+    if (!(hdir_data = treeobj_get_data (hdir)))
+        return -1;
+    if (!(empty = json_array ())) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    iter = json_object_iter (hdir_data);
+    while (iter) {
+        shard = json_object_iter_value (iter);
+        if (treeobj_is_dir (shard) && treeobj_get_count (shard) == 0) {
+            if (json_array_append_new (empty,
+                                       json_string (json_object_iter_key (iter))) < 0) {
+                errno = ENOMEM;
+                goto done;
+            }
+        }
+        else if (treeobj_is_dir (shard) || treeobj_is_hdir (shard)) {
+            if (kvstxn_store_dir (kt, current_epoch, shard, level + 1,
+                                  ref, sizeof (ref)) < 0)
+                goto done;
+            if (!(ktmp = treeobj_create_dirref (ref)))
+                goto done;
+            if (json_object_iter_set_new (hdir_data, iter, ktmp) < 0) {
+                json_decref (ktmp);
+                errno = ENOMEM;
+                goto done;
+            }
+        }
+        iter = json_object_iter_next (hdir_data, iter);
+    }
+
+    json_array_foreach (empty, index, value) {
+        if (!(key = json_string_value (value))
+            || treeobj_delete_shard (hdir, key) < 0)
+            goto done;
+    }
+    rc = 0;
+done:
+    json_decref (empty);
+    return rc;
+}
+
+/* Split the entries of 'dir' into shards of a new sharded directory
+ * at trie 'level'.
+ */
+static json_t *hdir_create_from_dir (json_t *dir, int level)
+{
+    json_t *hdir;
+    json_t *dir_data;
+    json_t *dir_entry;
+    const char *name;
+    int saved_errno;
+
+    if (!(dir_data = treeobj_get_data (dir))
+        || !(hdir = treeobj_create_hdir ()))
+        return NULL;
+
+    json_object_foreach (dir_data, name, dir_entry) {
+        char key[TREEOBJ_HDIR_KEY_SIZE];
+        json_t *shard;
+
+        if (treeobj_hdir_key (name, level, key, sizeof (key)) < 0)
+            goto error;
+        if (!(shard = treeobj_get_shard (hdir, key))) {
+            if (!(shard = treeobj_create_dir ()))
+                goto error;
+            if (treeobj_insert_shard (hdir, key, shard) < 0) {
+                json_decref (shard);
+                goto error;
+            }
+            json_decref (shard);
+        }
+        if (treeobj_insert_entry_novalidate (shard, name, dir_entry) < 0)
+            goto error;
+    }
+    return hdir;
+error:
+    saved_errno = errno;
+    json_decref (hdir);
+    errno = saved_errno;
+    return NULL;
+}
+
+/* Unroll and store directory 'dir', a dir or a sharded directory at
+ * trie 'level'.  A dir with more than shard_threshold entries is
+ * stored as a sharded directory, so that later changes rewrite one
+ * small shard rather than the whole directory.  The blobref of the
+ * stored object is returned in 'ref'.
+ * Return 0 on success, -1 on error
+ */
+static int kvstxn_store_dir (kvstxn_t *kt, int current_epoch, json_t *dir,
+                             int level, char *ref, int ref_len)
+{
+    struct cache_entry *entry;
+    json_t *hdir = NULL;
+    int saved_errno;
+    int ret;
+    int rc = -1;
+
+    if (treeobj_is_dir (dir)) {
+        if (kvstxn_unroll (kt, current_epoch, dir) < 0) /* depth first */
+            return -1;
+        if (kt->ktm->shard_threshold > 0
+            && treeobj_get_count (dir) > kt->ktm->shard_threshold
+            && level < TREEOBJ_HDIR_MAX_LEVEL) {
+            if (!(hdir = hdir_create_from_dir (dir, level)))
+                return -1;
+            dir = hdir;
+        }
+    }
+    if (treeobj_is_hdir (dir)) {
+        if (kvstxn_unroll_hdir (kt, current_epoch, dir, level) < 0)
+            goto done;
+    }
+    if ((ret = store_cache (kt, current_epoch, dir,
+                            false, ref, ref_len, &entry)) < 0)
+        goto done;
+    if (ret) {
+        if (zlist_push (kt->dirty_cache_entries_list, entry) < 0) {
+            kvstxn_cleanup_dirty_cache_entry (kt, entry);
+            errno = ENOMEM;
+            goto done;
+        }
+    }
+    rc = 0;
+done:
+    saved_errno = errno;
+    json_decref (hdir);
+    errno = saved_errno;
+    return rc;
+}
+
+/* Waves with fewer objects than this are stored on the reactor thread,
+ * since handing them to the hashpool would cost more than it saves.
+ */
+#define STORE_WAVE_MIN_POOL 16
+
+static void store_plan_free (kvstxn_t *kt)
+{
+    for (int i = 0; i < kt->nwaves; i++) {
+        struct store_wave *w = &kt->waves[i];
+        for (int j = 0; j < w->count; j++) {
+            if (w->copied && !w->items[j].is_raw)
+                json_decref (w->items[j].obj);
+            free (w->items[j].data);
+            free (w->dests[j].key);
+        }
+        free (w->items);
+        free (w->dests);
+    }
+    free (kt->waves);
+    kt->waves = NULL;
+    kt->nwaves = 0;
+    kt->wave = 0;
+}
+
+/* Add 'obj' to wave 'index' of the store plan.  Its reference will be
+ * stored under 'key' in 'container' (see struct store_dest).
+ */
+static int store_plan_add (kvstxn_t *kt, int index, json_t *container,
+                           const char *key, json_t *obj, bool is_raw)
+{
+    struct store_wave *w;
+
+    if (index >= kt->nwaves) {
+        struct store_wave *waves;
+        if (!(waves = realloc (kt->waves, (index + 1) * sizeof (*waves))))
+            return -1;
+        memset (&waves[kt->nwaves], 0,
+                (index + 1 - kt->nwaves) * sizeof (*waves));
+        kt->waves = waves;
+        kt->nwaves = index + 1;
+    }
+    w = &kt->waves[index];
+    if (w->count == w->size) {
+        int size = w->size ? w->size * 2 : 16;
+        struct hashpool_item *items;
+        struct store_dest *dests;
+
+        if (!(items = realloc (w->items, size * sizeof (*items))))
+            return -1;
+        w->items = items;
+        if (!(dests = realloc (w->dests, size * sizeof (*dests))))
+            return -1;
+        w->dests = dests;
+        w->size = size;
+    }
+    memset (&w->items[w->count], 0, sizeof (w->items[0]));
+    w->items[w->count].obj = obj;
+    w->items[w->count].is_raw = is_raw;
+    w->dests[w->count].container = container;
+    w->dests[w->count].key = NULL;
+    if (key && !(w->dests[w->count].key = strdup (key)))
+        return -1;
+    w->count++;
+    return 0;
+}
+
+/* If the dir at 'iter' in 'data' is over the shard threshold, replace
+ * it with a sharded directory at trie 'level' before it is planned,
+ * as kvstxn_store_dir() would when storing it.
+ */
+static int store_plan_shard (kvstxn_t *kt, json_t *data, void *iter,
+                             json_t **entryp, int level)
+{
+    json_t *hdir;
+
+    if (treeobj_is_dir (*entryp)
+        && kt->ktm->shard_threshold > 0
+        && treeobj_get_count (*entryp) > kt->ktm->shard_threshold
+        && level < TREEOBJ_HDIR_MAX_LEVEL) {
+        if (!(hdir = hdir_create_from_dir (*entryp, level)))
+            return -1;
+        if (json_object_iter_set_new (data, iter, hdir) < 0) {
+            json_decref (hdir);
+            errno = ENOMEM;
+            return -1;
+        }
+        *entryp = hdir;
+    }
+    return 0;
+}
+
+/* Plan the store of 'dir', a dir or sharded directory at trie 'level'
+ * held under 'key' in 'container' (NULL for the root), and everything
+ * it contains that must be stored first: the same objects, in the same
+ * order within each branch, that kvstxn_store_dir() stores.  Large
+ * vals go in the first wave.
+ * Returns the wave 'dir' was added to, or -1 on error.
+ */
+static int store_plan_dir (kvstxn_t *kt, json_t *container, const char *key,
+                           json_t *dir, int level)
+{
+    json_t *data;
+    json_t *entry;
+    json_t *empty = NULL;
+    const char *name;
+    size_t index;
+    json_t *value;
+    void *iter;
+    int wave = 0;
+    int saved_errno;
+    int w;
+
+    if (!(data = treeobj_get_data (dir)))
+        return -1;
+    if (treeobj_is_hdir (dir) && !(empty = json_array ())) {
+        errno = ENOMEM;
+        return -1;
+    }
+    iter = json_object_iter (data);
+    while (iter) {
+        entry = json_object_iter_value (iter);
+        name = json_object_iter_key (iter);
+        if (empty) {
+            if (treeobj_is_dir (entry) && treeobj_get_count (entry) == 0) {
+                if (json_array_append_new (empty, json_string (name)) < 0) {
+                    errno = ENOMEM;
+                    goto error;
+                }
+                goto next;
+            }
+            if (store_plan_shard (kt, data, iter, &entry, level + 1) < 0)
+                goto error;
+            if (treeobj_is_dir (entry) || treeobj_is_hdir (entry)) {
+                if ((w = store_plan_dir (kt, data, name, entry,
+                                         level + 1)) < 0)
+                    goto error;
+                if (wave < w + 1)
+                    wave = w + 1;
+            }
+        }
+        else {
+            if (store_plan_shard (kt, data, iter, &entry, 0) < 0)
+                goto error;
+            if (treeobj_is_dir (entry) || treeobj_is_hdir (entry)) {
+                if ((w = store_plan_dir (kt, data, name, entry, 0)) < 0)
+                    goto error;
+                if (wave < w + 1)
+                    wave = w + 1;
+            }
+            else if (treeobj_is_val (entry)) {
+                json_t *val_data;
+                const char *str;
+
+                if (!(val_data = treeobj_get_data (entry)))
+                    goto error;
+                str = json_string_value (val_data);
+                assert (str);
+                if (strlen (str) > BLOBREF_MAX_STRING_SIZE) {
+                    if (store_plan_add (kt, 0, data, name, val_data, true) < 0)
+                        goto error;
+                    if (wave < 1)
+                        wave = 1;
+                }
+            }
+        }
+next:
+        iter = json_object_iter_next (data, iter);
+    }
+    if (empty) {
+        json_array_foreach (empty, index, value) {
+            if (!(name = json_string_value (value))
+                || treeobj_delete_shard (dir, name) < 0)
+                goto error;
+        }
+        json_decref (empty);
+        empty = NULL;
+    }
+    if (store_plan_add (kt, wave, container, key, dir, false) < 0)
+        goto error;
+    return wave;
+error:
+    saved_errno = errno;
+    json_decref (empty);
+    errno = saved_errno;
+    return -1;
+}
+
+/* Put the results of a completed wave in the cache, and replace each
+ * stored object with a reference to it in its container.
+ */
+static int store_wave_finish (kvstxn_t *kt, int current_epoch,
+                              struct store_wave *w)
+{
+    for (int i = 0; i < w->count; i++) {
+        struct hashpool_item *item = &w->items[i];
+        struct store_dest *dest = &w->dests[i];
+        struct cache_entry *entry;
+        json_t *ktmp;
+        int ret;
+
+        if (item->errnum) {
+            if (item->errnum != EPROTO)
+                flux_log (kt->ktm->h, LOG_ERR, "%s: encode: %s",
+                          __FUNCTION__, strerror (item->errnum));
+            errno = item->errnum;
+            return -1;
+        }
+        if ((ret = store_cache_data (kt, current_epoch, item->ref,
+                                     item->data, item->len, &entry)) < 0)
+            return -1;
+        if (ret) {
+            if (zlist_push (kt->dirty_cache_entries_list, entry) < 0) {
+                kvstxn_cleanup_dirty_cache_entry (kt, entry);
+                errno = ENOMEM;
+                return -1;
+            }
+        }
+        free (item->data);
+        item->data = NULL;
+        if (!dest->container) {
+            strcpy (kt->newroot, item->ref);
+            continue;
+        }
+        if (item->is_raw)
+            ktmp = treeobj_create_valref (item->ref);
+        else
+            ktmp = treeobj_create_dirref (item->ref);
+        if (!ktmp)
+            return -1;
+        if (json_object_set_new (dest->container, dest->key, ktmp) < 0) {
+            json_decref (ktmp);
+            errno = ENOMEM;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Replace the dirs in 'w' with deep copies before they are encoded on
+ * the hashpool.  Their entries are shared with the content cache, and
+ * json_dumps() in jansson < 2.14 marks objects as it walks them, so the
+ * reactor must not be able to encode the same objects concurrently.
+ * Raw items are strings, which are not marked.
+ */
+static int store_wave_copy (struct store_wave *w)
+{
+    for (int i = 0; i < w->count; i++) {
+        json_t *cpy;
+
+        if (w->items[i].is_raw)
+            continue;
+        if (!(cpy = json_deep_copy (w->items[i].obj))) {
+            while (--i >= 0) {
+                if (!w->items[i].is_raw) {
+                    json_decref (w->items[i].obj);
+                    w->items[i].obj = NULL;
+                }
+            }
+            errno = ENOMEM;
+            return -1;
+        }
+        w->items[i].obj = cpy;
+    }
+    w->copied = true;
+    return 0;
+}
+
+static void store_wave_done_cb (struct hashpool *hp, void *arg)
+{
+    kvstxn_t *kt = arg;
+
+    kt->wave_complete = true;
+    if (wait_runqueue (kt->hashing_waiters) < 0)
+        flux_log_error (kt->ktm->h, "%s: wait_runqueue", __FUNCTION__);
+}
+
+/* Store the planned waves in order, handing large ones to the hashpool.
+ * Returns 1 when all waves are stored, 0 if a wave is on the hashpool,
+ * or -1 on error.
+ */
+static int store_waves (kvstxn_t *kt, int current_epoch)
+{
+    struct store_wave *w;
+
+    if (kt->wave_running) {
+        if (!kt->wave_complete)
+            return 0;
+        kt->wave_running = false;
+        if (store_wave_finish (kt, current_epoch, &kt->waves[kt->wave]) < 0)
+            return -1;
+        kt->wave++;
+    }
+    while (kt->wave < kt->nwaves) {
+        w = &kt->waves[kt->wave];
+        if (w->count >= STORE_WAVE_MIN_POOL) {
+            if (!kt->hashing_waiters
+                && !(kt->hashing_waiters = wait_queue_create ()))
+                return -1;
+            if (store_wave_copy (w) < 0)
+                return -1;
+            if (hashpool_run (kt->ktm->hashpool, w->items, w->count,
+                              store_wave_done_cb, kt) < 0)
+                return -1;
+            kt->wave_running = true;
+            kt->wave_complete = false;
+            return 0;
+        }
+        for (int i = 0; i < w->count; i++)
+            (void)hashpool_item_encode (&w->items[i], kt->ktm->hash_name);
+        if (store_wave_finish (kt, current_epoch, w) < 0)
+            return -1;
+        kt->wave++;
+    }
+    return 1;
+}
+
 static int kvstxn_val_data_to_cache (kvstxn_t *kt, int current_epoch,
                                      json_t *val, char *ref, int ref_len)
 {
@@ -536,7 +1026,8 @@ static int kvstxn_append (kvstxn_t *kt, int current_epoch, json_t *dirent,
         return -1;
     }
     else if (treeobj_is_dir (entry)
-             || treeobj_is_dirref (entry)) {
+             || treeobj_is_dirref (entry)
+             || treeobj_is_hdir (entry)) {
         errno = EISDIR;
         return -1;
     }
@@ -551,6 +1042,97 @@ static int kvstxn_append (kvstxn_t *kt, int current_epoch, json_t *dirent,
     return 0;
 }
 
+/* Get the cached object referenced by 'dirref' in 'objp'.  If it is
+ * not in the cache, set 'missing_ref' instead so the caller can stall.
+ * Return 0 on success, -1 on error
+ */
+static int load_dirref (kvstxn_t *kt, int current_epoch,
+                        const json_t *dirref, const json_t **objp,
+                        const char **missing_ref)
+{
+    struct cache_entry *entry;
+    const char *ref;
+    int refcount;
+
+    if ((refcount = treeobj_get_count (dirref)) < 0)
+        return -1;
+
+    if (refcount != 1) {
+        flux_log (kt->ktm->h, LOG_ERR, "invalid dirref count: %d",
+                  refcount);
+        errno = ENOTRECOVERABLE;
+        return -1;
+    }
+
+    if (!(ref = treeobj_get_blobref (dirref, 0)))
+        return -1;
+
+    if (!(entry = cache_lookup (kt->ktm->cache, ref, current_epoch))
+        || !cache_entry_get_valid (entry)) {
+        *missing_ref = ref;
+        return 0;
+    }
+
+    if (!(*objp = cache_entry_get_treeobj (entry))) {
+        errno = ENOTRECOVERABLE;
+        return -1;
+    }
+    return 0;
+}
+
+/* If 'dir' is a sharded directory, replace it with the shard that
+ * holds 'name'.  As with subdirectories in kvstxn_link_dirent(),
+ * shard dirrefs on the way are converted to copies in the working
+ * root, and missing shards are created.  If a shard is not in the
+ * cache, set 'missing_ref' so the caller can stall.
+ * Return 0 on success, -1 on error
+ */
+static int hdir_resolve (kvstxn_t *kt, int current_epoch, json_t **dirp,
+                         const char *name, const char **missing_ref)
+{
+    json_t *dir = *dirp;
+    int level = 0;
+
+    while (treeobj_is_hdir (dir)) {
+        char key[TREEOBJ_HDIR_KEY_SIZE];
+        const json_t *shardktmp;
+        json_t *shard;
+
+        if (treeobj_hdir_key (name, level, key, sizeof (key)) < 0)
+            return -1;
+        if (!(shard = treeobj_get_shard (dir, key))) {
+            if (!(shard = treeobj_create_dir ()))
+                return -1;
+            if (treeobj_insert_shard (dir, key, shard) < 0) {
+                json_decref (shard);
+                errno = EINVAL;
+                return -1;
+            }
+            json_decref (shard);
+        }
+        else if (treeobj_is_dirref (shard)) {
+            if (load_dirref (kt, current_epoch, shard,
+                             &shardktmp, missing_ref) < 0)
+                return -1;
+            if (*missing_ref)
+                return 0; /* stall */
+            /* do not corrupt store by modifying orig. */
+            if (!(shard = treeobj_deep_copy (shardktmp)))
+                return -1;
+            if (treeobj_insert_shard (dir, key, shard) < 0) {
+                json_decref (shard);
+                errno = EINVAL;
+                return -1;
+            }
+            json_decref (shard);
+        }
+        dir = shard;
+        level++;
+    }
+    *dirp = dir;
+    return 0;
+}
+
 /* link (key, dirent) into directory 'dir'.
  */
 static int kvstxn_link_dirent (kvstxn_t *kt, int current_epoch,
@@ -586,6 +1168,13 @@ static int kvstxn_link_dirent (kvstxn_t *kt, int current_epoch,
     while ((next = strchr (name, '.'))) {
         *next++ = '\0';
 
+        if (hdir_resolve (kt, current_epoch, &dir, name, missing_ref) < 0) {
+            saved_errno = errno;
+            goto done;
+        }
+        if (*missing_ref)
+            goto success; /* stall */
+
         if (!treeobj_is_dir (dir)) {
             saved_errno = ENOTRECOVERABLE;
             goto done;
@@ -604,41 +1193,19 @@ static int kvstxn_link_dirent (kvstxn_t *kt, int current_epoch,
                 goto done;
             }
             json_decref (subdir);
-        } else if (treeobj_is_dir (dir_entry)) {
+        } else if (treeobj_is_dir (dir_entry)
+                   || treeobj_is_hdir (dir_entry)) {
             subdir = dir_entry;
         } else if (treeobj_is_dirref (dir_entry)) {
-            struct cache_entry *entry;
-            const char *ref;
             const json_t *subdirktmp;
-            int refcount;
-
-            if ((refcount = treeobj_get_count (dir_entry)) < 0) {
-                saved_errno = errno;
-                goto done;
-            }
-
-            if (refcount != 1) {
-                flux_log (kt->ktm->h, LOG_ERR, "invalid dirref count: %d",
-                          refcount);
-                saved_errno = ENOTRECOVERABLE;
-                goto done;
-            }
 
-            if (!(ref = treeobj_get_blobref (dir_entry, 0))) {
+            if (load_dirref (kt, current_epoch, dir_entry,
+                             &subdirktmp, missing_ref) < 0) {
                 saved_errno = errno;
                 goto done;
             }
-
-            if (!(entry = cache_lookup (kt->ktm->cache, ref, current_epoch))
-                || !cache_entry_get_valid (entry)) {
-                *missing_ref = ref;
+            if (*missing_ref)
                 goto success; /* stall */
-            }
-
-            if (!(subdirktmp = cache_entry_get_treeobj (entry))) {
-                saved_errno = ENOTRECOVERABLE;
-                goto done;
-            }
 
             /* do not corrupt store by modifying orig. */
             if (!(subdir = treeobj_deep_copy (subdirktmp))) {
@@ -707,6 +1274,12 @@ static int kvstxn_link_dirent (kvstxn_t *kt, int current_epoch,
     /* This is the final path component of the key.  Add/modify/delete
      * it in the directory.
      */
+    if (hdir_resolve (kt, current_epoch, &dir, name, missing_ref) < 0) {
+        saved_errno = errno;
+        goto done;
+    }
+    if (*missing_ref)
+        goto success; /* stall */
     if (!json_is_null (dirent)) {
         if (flags & FLUX_KVS_APPEND) {
             if (kvstxn_append (kt,
@@ -969,10 +1542,23 @@ kvstxn_process_t kvstxn_process (kvstxn_t *kt,
          * as an object and keep its reference in kt->newroot.
          * Flushes to content cache are asynchronous but we don't
          * proceed until they are completed.
+         *
+         * With a hashpool, plan the stores instead, and encode and
+         * hash them on the workers in KVSTXN_STATE_STORE_WAVES.
          */
         struct cache_entry *entry;
         int sret;
 
+        if (kt->ktm->hashpool) {
+            if (store_plan_dir (kt, NULL, NULL, kt->rootcpy, 0) < 0) {
+                kt->errnum = errno;
+                store_plan_free (kt);
+                return KVSTXN_PROCESS_ERROR;
+            }
+            kt->state = KVSTXN_STATE_STORE_WAVES;
+            goto run_waves;
+        }
+
         if (kvstxn_unroll (kt, current_epoch, kt->rootcpy) < 0)
             kt->errnum = errno;
         else if ((sret = store_cache (kt,
@@ -1000,10 +1586,31 @@ kvstxn_process_t kvstxn_process (kvstxn_t *kt,
         kt->state = KVSTXN_STATE_PRE_FINISHED;
         json_decref (kt->rootcpy);
         kt->rootcpy = NULL;
+        goto pre_finished;
+    }
+    case KVSTXN_STATE_STORE_WAVES:
+    run_waves:
+    {
+        int sret;
+
+        if ((sret = store_waves (kt, current_epoch)) < 0) {
+            kt->errnum = errno;
+            cleanup_dirty_cache_list (kt);
+            store_plan_free (kt);
+            return KVSTXN_PROCESS_ERROR;
+        }
+        if (sret == 0)
+            goto stall_hashing;
+
+        kt->state = KVSTXN_STATE_PRE_FINISHED;
+        store_plan_free (kt);
+        json_decref (kt->rootcpy);
+        kt->rootcpy = NULL;
 
         /* fallthrough */
     }
     case KVSTXN_STATE_PRE_FINISHED:
+    pre_finished:
         /* If we did not fall through to here, caller didn't call
          * kvstxn_iter_dirty_cache_entries()
          */
@@ -1035,6 +1642,10 @@ kvstxn_process_t kvstxn_process (kvstxn_t *kt,
  stall_store:
     kt->blocked = 1;
     return KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES;
+
+ stall_hashing:
+    kt->blocked = 1;
+    return KVSTXN_PROCESS_HASHING;
 }
 
 int kvstxn_iter_missing_refs (kvstxn_t *kt, kvstxn_ref_f cb, void *data)
@@ -1067,6 +1678,17 @@ int kvstxn_iter_missing_refs (kvstxn_t *kt, kvstxn_ref_f cb, void *data)
     return rc;
 }
 
+int kvstxn_wait_hashing (kvstxn_t *kt, wait_t *wait)
+{
+    if (kt->state != KVSTXN_STATE_STORE_WAVES
+        || !kt->wave_running
+        || !wait) {
+        errno = EINVAL;
+        return -1;
+    }
+    return wait_addqueue (kt->hashing_waiters, wait);
+}
+
 int kvstxn_iter_dirty_cache_entries (kvstxn_t *kt,
                                      kvstxn_cache_entry_f cb,
                                      void *data)
@@ -1122,6 +1744,7 @@ kvstxn_mgr_t *kvstxn_mgr_create (struct cache *cache,
     }
     ktm->h = h;
     ktm->aux = aux;
+    ktm->shard_threshold = KVSTXN_SHARD_THRESHOLD_DEFAULT;
     return ktm;
 
  error:
@@ -1213,6 +1836,16 @@ void kvstxn_mgr_remove_transaction (kvstxn_mgr_t *ktm, kvstxn_t *kt,
     }
 }
 
+void kvstxn_mgr_set_shard_threshold (kvstxn_mgr_t *ktm, int threshold)
+{
+    ktm->shard_threshold = threshold;
+}
+
+void kvstxn_mgr_set_hashpool (kvstxn_mgr_t *ktm, struct hashpool *hp)
+{
+    ktm->hashpool = hp;
+}
+
 int kvstxn_mgr_get_noop_stores (kvstxn_mgr_t *ktm)
 {
     return ktm->noop_stores;
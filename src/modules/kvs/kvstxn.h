@@ -15,6 +15,8 @@
 #include <czmq.h>
 
 #include "cache.h"
+#include "waitqueue.h"
+#include "hashpool.h"
 
 typedef struct kvstxn_mgr kvstxn_mgr_t;
 typedef struct kvstxn kvstxn_t;
@@ -24,6 +26,7 @@ typedef enum {
     KVSTXN_PROCESS_LOAD_MISSING_REFS = 2,
     KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES = 3,
     KVSTXN_PROCESS_FINISHED = 4,
+    KVSTXN_PROCESS_HASHING = 5,
 } kvstxn_process_t;
 
 /*
@@ -83,6 +86,7 @@ json_t *kvstxn_get_keys (kvstxn_t *kt);
  * KVSTXN_PROCESS_LOAD_MISSING_REFS stall & load,
  * KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES stall & process dirty cache
  * entries,
+ * KVSTXN_PROCESS_HASHING stall & wait for hashpool,
  * KVSTXN_PROCESS_FINISHED all done
  *
  * on error, call kvstxn_get_errnum() to get error number
@@ -92,6 +96,8 @@ json_t *kvstxn_get_keys (kvstxn_t *kt);
  * on stall & process dirty cache entries, call
  * kvstxn_iter_dirty_cache_entries() to process entries.
  *
+ * on stall & wait for hashpool, call kvstxn_wait_hashing().
+ *
  * on completion, call kvstxn_get_newroot_ref() to get reference to
  * new root to be stored.
  */
@@ -115,6 +121,12 @@ int kvstxn_iter_dirty_cache_entries (kvstxn_t *kt,
                                      kvstxn_cache_entry_f cb,
                                      void *data);
 
+/* on stall, add 'wait' to be run from the reactor when the objects
+ * being encoded and hashed on the hashpool are ready.  Only valid
+ * after kvstxn_process() returns KVSTXN_PROCESS_HASHING.
+ */
+int kvstxn_wait_hashing (kvstxn_t *kt, wait_t *wait);
+
 /* convenience function for cleaning up a dirty cache entry that was
  * returned to the user via kvstxn_process().  Generally speaking, this
  * should only be used for error cleanup in the callback function used in
@@ -175,6 +187,18 @@ kvstxn_t *kvstxn_mgr_get_ready_transaction (kvstxn_mgr_t *ktm);
 void kvstxn_mgr_remove_transaction (kvstxn_mgr_t *ktm, kvstxn_t *kt,
                                     bool fallback);
 
+/* Directories with more than 'threshold' entries are stored as
+ * sharded directories (see treeobj.h).  0 disables sharding, the default.
+ */
+#define KVSTXN_SHARD_THRESHOLD_DEFAULT 0
+void kvstxn_mgr_set_shard_threshold (kvstxn_mgr_t *ktm, int threshold);
+
+/* Encode and hash objects to be stored on the worker threads of 'hp'
+ * (see hashpool.h).  NULL (the default) does all of that work in
+ * kvstxn_process().
+ */
+void kvstxn_mgr_set_hashpool (kvstxn_mgr_t *ktm, struct hashpool *hp);
+
 int kvstxn_mgr_get_noop_stores (kvstxn_mgr_t *ktm);
 void kvstxn_mgr_clear_noop_stores (kvstxn_mgr_t *ktm);
 
@@ -78,6 +78,7 @@ struct lookup {
      * return missing_ref string.
      */
     const json_t *valref_missing_refs;
+    json_t *hdir_missing_refs;  /* owned, shards missing from READDIR */
     const char *missing_ref;
 
     /* for namespace callback */
@@ -349,6 +350,160 @@ cleanup:
     return ret;
 }
 
+/* Descend sharded directory 'dir' to the leaf shard that would hold
+ * 'name', loading dirref shards from the cache.  On success *dirp and
+ * *entryp are updated to the leaf dir and the cache entry it lives in.
+ * *dirp is set to NULL if the shard does not exist.
+ */
+static lookup_process_t hdir_get_shard (lookup_t *lh,
+                                        const json_t **dirp,
+                                        struct cache_entry **entryp,
+                                        const char *name)
+{
+    const json_t *dir = *dirp;
+    struct cache_entry *entry = *entryp;
+    int level = 0;
+
+    while (treeobj_is_hdir (dir)) {
+        char key[TREEOBJ_HDIR_KEY_SIZE];
+        const json_t *shard;
+
+        if (treeobj_hdir_key (name, level, key, sizeof (key)) < 0) {
+            lh->errnum = errno;
+            return LOOKUP_PROCESS_ERROR;
+        }
+        if (!(shard = treeobj_peek_shard (dir, key))) {
+            *dirp = NULL;
+            return LOOKUP_PROCESS_FINISHED;
+        }
+        if (treeobj_is_dirref (shard)) {
+            const char *refstr;
+
+            if (!(refstr = treeobj_get_blobref (shard, 0))) {
+                lh->errnum = errno;
+                return LOOKUP_PROCESS_ERROR;
+            }
+            if (!(entry = cache_lookup (lh->cache, refstr, lh->current_epoch))
+                || !cache_entry_get_valid (entry)) {
+                lh->missing_ref = refstr;
+                return LOOKUP_PROCESS_LOAD_MISSING_REFS;
+            }
+            if (!(shard = cache_entry_get_treeobj (entry))) {
+                flux_log (lh->h, LOG_ERR, "shard dirref points to non-treeobj");
+                lh->errnum = ENOTRECOVERABLE;
+                return LOOKUP_PROCESS_ERROR;
+            }
+        }
+        dir = shard;
+        level++;
+    }
+    if (!treeobj_is_dir (dir)) {
+        lh->errnum = ENOTRECOVERABLE;
+        return LOOKUP_PROCESS_ERROR;
+    }
+    *dirp = dir;
+    *entryp = entry;
+    return LOOKUP_PROCESS_FINISHED;
+}
+
+/* Copy the entries of every leaf shard of 'hdir' into 'dir'.  Blobrefs
+ * of shards not in the cache are appended to 'missing' instead.
+ */
+static int hdir_merge (lookup_t *lh,
+                       const json_t *hdir,
+                       json_t *dir,
+                       json_t *missing)
+{
+    json_t *data = treeobj_get_data ((json_t *)hdir);
+    const char *key;
+    json_t *shard;
+
+    json_object_foreach (data, key, shard) {
+        const json_t *obj = shard;
+
+        if (treeobj_is_dirref (shard)) {
+            struct cache_entry *entry;
+            const char *refstr;
+
+            if (!(refstr = treeobj_get_blobref (shard, 0)))
+                return -1;
+            if (!(entry = cache_lookup (lh->cache, refstr, lh->current_epoch))
+                || !cache_entry_get_valid (entry)) {
+                if (treeobj_append_blobref (missing, refstr) < 0)
+                    return -1;
+                continue;
+            }
+            if (!(obj = cache_entry_get_treeobj (entry))) {
+                errno = ENOTRECOVERABLE;
+                return -1;
+            }
+        }
+        if (treeobj_is_hdir (obj)) {
+            if (hdir_merge (lh, obj, dir, missing) < 0)
+                return -1;
+        }
+        else if (treeobj_is_dir (obj)) {
+            json_t *entries = treeobj_get_data ((json_t *)obj);
+            const char *name;
+            json_t *dirent;
+
+            json_object_foreach (entries, name, dirent) {
+                json_t *cpy;
+
+                if (!(cpy = treeobj_deep_copy (dirent)))
+                    return -1;
+                if (treeobj_insert_entry_novalidate (dir, name, cpy) < 0) {
+                    json_decref (cpy);
+                    return -1;
+                }
+                json_decref (cpy);
+            }
+        }
+        else {
+            errno = ENOTRECOVERABLE;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* Flatten sharded directory 'hdir' into a plain dir in lh->val, so
+ * that READDIR callers need not know about sharding.  If any shards
+ * are missing from the cache, they are all reported at once through
+ * lh->valref_missing_refs.
+ */
+static lookup_process_t hdir_flatten (lookup_t *lh, const json_t *hdir)
+{
+    json_t *dir = NULL;
+    json_t *missing = NULL;
+
+    if (lh->hdir_missing_refs) {
+        json_decref (lh->hdir_missing_refs);
+        lh->hdir_missing_refs = NULL;
+        lh->valref_missing_refs = NULL;
+    }
+
+    if (!(dir = treeobj_create_dir ())
+        || !(missing = treeobj_create_valref (NULL))
+        || hdir_merge (lh, hdir, dir, missing) < 0) {
+        lh->errnum = errno;
+        goto error;
+    }
+    if (treeobj_get_count (missing) > 0) {
+        json_decref (dir);
+        lh->hdir_missing_refs = missing;
+        lh->valref_missing_refs = missing;
+        return LOOKUP_PROCESS_LOAD_MISSING_REFS;
+    }
+    json_decref (missing);
+    lh->val = dir;
+    return LOOKUP_PROCESS_FINISHED;
+error:
+    json_decref (dir);
+    json_decref (missing);
+    return LOOKUP_PROCESS_ERROR;
+}
+
 /* Get dirent of the requested path starting at the given root.
  *
  * Return true on success or error, error code is returned in ep and
@@ -409,7 +564,7 @@ static lookup_process_t walk (lookup_t *lh)
                     lh->errnum = ENOTRECOVERABLE;
                 goto error;
             }
-            if (!treeobj_is_dir (dir)) {
+            if (!treeobj_is_dir (dir) && !treeobj_is_hdir (dir)) {
                 /* dirref pointed to non-dir error, special case when
                  * root_dirent is bad, is EINVAL from user.
                  */
@@ -419,6 +574,18 @@ static lookup_process_t walk (lookup_t *lh)
                     lh->errnum = ENOTRECOVERABLE;
                 goto error;
             }
+            if (treeobj_is_hdir (dir)) {
+                lookup_process_t hret;
+
+                hret = hdir_get_shard (lh, &dir, &entry, pathcomp);
+                if (hret != LOOKUP_PROCESS_FINISHED) {
+                    if (hret == LOOKUP_PROCESS_ERROR)
+                        goto error;
+                    return hret;
+                }
+                if (!dir)
+                    goto done;
+            }
         } else {
             /* Unexpected dirent type */
             if (treeobj_is_valref (wl->dirent)
@@ -573,6 +740,7 @@ lookup_t *lookup_create (struct cache *cache,
 
     lh->val = NULL;
     lh->valref_missing_refs = NULL;
+    lh->hdir_missing_refs = NULL;
     lh->missing_ref = NULL;
     lh->errnum = 0;
 
@@ -599,6 +767,7 @@ void lookup_destroy (lookup_t *lh)
         free (lh->root_ref);
         free (lh->path);
         json_decref (lh->val);
+        json_decref (lh->hdir_missing_refs);
         free (lh->missing_namespace);
         zlist_destroy (&lh->levels);
         free (lh);
@@ -995,6 +1164,14 @@ lookup_process_t lookup (lookup_t *lh)
                         lh->errnum = EINVAL;
                         goto error;
                     }
+                    if (treeobj_is_hdir (valtmp)) {
+                        lookup_process_t hret = hdir_flatten (lh, valtmp);
+                        if (hret == LOOKUP_PROCESS_ERROR)
+                            goto error;
+                        if (hret == LOOKUP_PROCESS_LOAD_MISSING_REFS)
+                            return hret;
+                        goto done;
+                    }
                     if (!treeobj_is_dir (valtmp)) {
                         /* root_ref points to not dir */
                         lh->errnum = ENOTRECOVERABLE;
@@ -1093,12 +1270,19 @@ lookup_process_t lookup (lookup_t *lh)
                     lh->errnum = ENOTRECOVERABLE;
                     goto error;
                 }
-                if (!treeobj_is_dir (valtmp)) {
+                if (treeobj_is_hdir (valtmp)) {
+                    lookup_process_t hret = hdir_flatten (lh, valtmp);
+                    if (hret == LOOKUP_PROCESS_ERROR)
+                        goto error;
+                    if (hret == LOOKUP_PROCESS_LOAD_MISSING_REFS)
+                        return hret;
+                }
+                else if (!treeobj_is_dir (valtmp)) {
                     /* dirref points to not dir */
                     lh->errnum = ENOTRECOVERABLE;
                     goto error;
                 }
-                if (!(lh->val = treeobj_deep_copy (valtmp))) {
+                else if (!(lh->val = treeobj_deep_copy (valtmp))) {
                     lh->errnum = errno;
                     goto error;
                 }
@@ -0,0 +1,204 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/blobref.h"
+#include "src/common/libkvs/treeobj.h"
+#include "src/modules/kvs/hashpool.h"
+
+#define NITEMS 100
+
+static int batches_done;
+
+static void done_cb (struct hashpool *hp, void *arg)
+{
+    flux_reactor_t *r = arg;
+
+    if (--batches_done == 0)
+        flux_reactor_stop (r);
+}
+
+static void create_items (struct hashpool_item *items, int count)
+{
+    char buf[64];
+
+    memset (items, 0, count * sizeof (items[0]));
+    for (int i = 0; i < count; i++) {
+        snprintf (buf, sizeof (buf), "value-%d", i);
+        if (i % 2 == 0) {
+            if (!(items[i].obj = treeobj_create_val (buf, strlen (buf))))
+                BAIL_OUT ("treeobj_create_val failed");
+        }
+        else {
+            if (!(items[i].obj = json_string ("aGVsbG8gd29ybGQ=")))
+                BAIL_OUT ("json_string failed");
+            items[i].is_raw = true;
+        }
+    }
+}
+
+static void destroy_items (struct hashpool_item *items, int count)
+{
+    for (int i = 0; i < count; i++) {
+        json_decref (items[i].obj);
+        free (items[i].data);
+    }
+}
+
+void basic (void)
+{
+    struct hashpool_item item;
+    char ref[BLOBREF_MAX_STRING_SIZE];
+    char *s;
+
+    memset (&item, 0, sizeof (item));
+    if (!(item.obj = treeobj_create_val ("foo", 3)))
+        BAIL_OUT ("treeobj_create_val failed");
+    ok (hashpool_item_encode (&item, "sha1") == 0,
+        "hashpool_item_encode works on a treeobj");
+    s = treeobj_encode (item.obj);
+    ok (s != NULL && item.len == strlen (s)
+        && !memcmp (item.data, s, item.len),
+        "hashpool_item_encode returned encoded treeobj");
+    ok (blobref_hash ("sha1", s, strlen (s), ref, sizeof (ref)) == 0
+        && !strcmp (ref, item.ref),
+        "hashpool_item_encode returned its blobref");
+    free (s);
+    json_decref (item.obj);
+    free (item.data);
+
+    memset (&item, 0, sizeof (item));
+    item.obj = json_string ("aGVsbG8=");
+    item.is_raw = true;
+    ok (hashpool_item_encode (&item, "sha1") == 0
+        && item.len == 5
+        && !memcmp (item.data, "hello", 5),
+        "hashpool_item_encode decodes raw data");
+    json_decref (item.obj);
+    free (item.data);
+
+    memset (&item, 0, sizeof (item));
+    item.obj = json_string ("not a treeobj");
+    errno = 0;
+    ok (hashpool_item_encode (&item, "sha1") < 0
+        && errno == EINVAL && item.errnum == EINVAL && item.data == NULL,
+        "hashpool_item_encode fails with EINVAL on invalid treeobj");
+    json_decref (item.obj);
+
+    memset (&item, 0, sizeof (item));
+    item.obj = json_string ("!!!!");
+    item.is_raw = true;
+    errno = 0;
+    ok (hashpool_item_encode (&item, "sha1") < 0
+        && errno == EPROTO && item.errnum == EPROTO,
+        "hashpool_item_encode fails with EPROTO on invalid base64");
+    json_decref (item.obj);
+
+    memset (&item, 0, sizeof (item));
+    item.obj = json_string ("aGVsbG8=");
+    item.is_raw = true;
+    errno = 0;
+    ok (hashpool_item_encode (&item, "nohash") < 0 && item.errnum != 0,
+        "hashpool_item_encode fails on unknown hash");
+    json_decref (item.obj);
+}
+
+void pool (void)
+{
+    flux_reactor_t *r;
+    struct hashpool *hp;
+    struct hashpool_item items[NITEMS];
+    struct hashpool_item more[NITEMS / 4];
+    struct hashpool_item expected;
+    int errors = 0;
+
+    if (!(r = flux_reactor_create (0)))
+        BAIL_OUT ("flux_reactor_create failed");
+
+    errno = 0;
+    ok (hashpool_create (r, "sha1", 0) == NULL && errno == EINVAL,
+        "hashpool_create nthreads=0 fails with EINVAL");
+    ok ((hp = hashpool_create (r, "sha1", 4)) != NULL,
+        "hashpool_create works");
+    ok (hashpool_get_nthreads (hp) == 4,
+        "hashpool_get_nthreads returns 4");
+
+    errno = 0;
+    ok (hashpool_run (hp, NULL, 1, done_cb, r) < 0 && errno == EINVAL,
+        "hashpool_run items=NULL fails with EINVAL");
+
+    create_items (items, NITEMS);
+    create_items (more, NITEMS / 4);
+    batches_done = 3;
+    ok (hashpool_run (hp, items, NITEMS, done_cb, r) == 0,
+        "hashpool_run works");
+    ok (hashpool_run (hp, more, NITEMS / 4, done_cb, r) == 0,
+        "hashpool_run works on a second batch");
+    ok (hashpool_run (hp, NULL, 0, done_cb, r) == 0,
+        "hashpool_run works on an empty batch");
+    ok (flux_reactor_run (r, 0) >= 0 && batches_done == 0,
+        "all batches were called back from the reactor");
+
+    for (int i = 0; i < NITEMS; i++) {
+        memset (&expected, 0, sizeof (expected));
+        expected.obj = items[i].obj;
+        expected.is_raw = items[i].is_raw;
+        if (hashpool_item_encode (&expected, "sha1") < 0)
+            BAIL_OUT ("hashpool_item_encode failed");
+        if (items[i].errnum != 0
+            || items[i].len != expected.len
+            || memcmp (items[i].data, expected.data, expected.len) != 0
+            || strcmp (items[i].ref, expected.ref) != 0)
+            errors++;
+        free (expected.data);
+    }
+    ok (errors == 0,
+        "worker results match hashpool_item_encode");
+
+    destroy_items (items, NITEMS);
+    destroy_items (more, NITEMS / 4);
+
+    /* destroy with a batch in flight, callback is never made */
+    create_items (items, NITEMS);
+    batches_done = 1;
+    ok (hashpool_run (hp, items, NITEMS, done_cb, r) == 0,
+        "hashpool_run works");
+    hashpool_destroy (hp);
+    ok (batches_done == 1,
+        "hashpool_destroy abandons batch in flight");
+    destroy_items (items, NITEMS);
+
+    flux_reactor_destroy (r);
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    basic ();
+    pool ();
+
+    done_testing ();
+    return (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -25,6 +25,7 @@
 #include "src/modules/kvs/kvstxn.h"
 #include "src/modules/kvs/kvsroot.h"
 #include "src/modules/kvs/lookup.h"
+#include "src/modules/kvs/hashpool.h"
 
 static int test_global = 5;
 
@@ -3364,6 +3365,115 @@ void kvstxn_process_fallback_merge (void)
     cache_destroy (cache);
 }
 
+static void hashing_ready_cb (void *arg)
+{
+    flux_reactor_t *r = arg;
+    flux_reactor_stop (r);
+}
+
+/* Store a transaction creating many directories, a large value, and a
+ * directory big enough to be sharded, and return the new root ref.
+ * If 'hp' is set, objects are stored on its workers.
+ */
+static void store_many_dirs (struct hashpool *hp, flux_reactor_t *r,
+                             char *newroot, int newroot_len, int *hashing)
+{
+    struct cache *cache;
+    kvstxn_mgr_t *ktm;
+    kvstxn_t *kt;
+    char rootref[BLOBREF_MAX_STRING_SIZE];
+    char bigstr[BLOBREF_MAX_STRING_SIZE * 2];
+    char key[64];
+    json_t *ops;
+    kvstxn_process_t ret;
+    int i;
+
+    cache = create_cache_with_empty_rootdir (rootref, sizeof (rootref));
+
+    ok ((ktm = kvstxn_mgr_create (cache,
+                                  KVS_PRIMARY_NAMESPACE,
+                                  "sha1",
+                                  NULL,
+                                  &test_global)) != NULL,
+        "kvstxn_mgr_create works");
+    kvstxn_mgr_set_shard_threshold (ktm, 8);
+    kvstxn_mgr_set_hashpool (ktm, hp);
+
+    memset (bigstr, 'a', sizeof (bigstr) - 1);
+    bigstr[sizeof (bigstr) - 1] = '\0';
+
+    ops = json_array ();
+    for (i = 0; i < 40; i++) {
+        snprintf (key, sizeof (key), "dir%d.a.b", i);
+        ops_append (ops, key, "x", 0);
+        snprintf (key, sizeof (key), "big.key%d", i);
+        ops_append (ops, key, "y", 0);
+    }
+    ops_append (ops, "dir0.bigval", bigstr, 0);
+
+    ok (kvstxn_mgr_add_transaction (ktm, "transaction1", ops, 0) == 0,
+        "kvstxn_mgr_add_transaction works");
+    json_decref (ops);
+
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+
+    *hashing = 0;
+    while ((ret = kvstxn_process (kt, 1, rootref)) != KVSTXN_PROCESS_FINISHED) {
+        if (ret == KVSTXN_PROCESS_HASHING) {
+            wait_t *wait = wait_create (hashing_ready_cb, r);
+            if (!wait || kvstxn_wait_hashing (kt, wait) < 0)
+                BAIL_OUT ("kvstxn_wait_hashing failed");
+            if (flux_reactor_run (r, 0) < 0)
+                BAIL_OUT ("flux_reactor_run failed");
+            (*hashing)++;
+        }
+        else if (ret == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES) {
+            if (kvstxn_iter_dirty_cache_entries (kt,
+                                                 cache_count_dirty_cb,
+                                                 NULL) < 0)
+                BAIL_OUT ("kvstxn_iter_dirty_cache_entries failed");
+        }
+        else
+            break;
+    }
+    ok (ret == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+
+    snprintf (newroot, newroot_len, "%s", kvstxn_get_newroot_ref (kt));
+
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+    kvstxn_mgr_destroy (ktm);
+    cache_destroy (cache);
+}
+
+void kvstxn_process_hashpool (void)
+{
+    flux_reactor_t *r;
+    struct hashpool *hp;
+    char serial[BLOBREF_MAX_STRING_SIZE];
+    char parallel[BLOBREF_MAX_STRING_SIZE];
+    int hashing;
+
+    if (!(r = flux_reactor_create (0)))
+        BAIL_OUT ("flux_reactor_create failed");
+    ok ((hp = hashpool_create (r, "sha1", 4)) != NULL,
+        "hashpool_create works");
+
+    store_many_dirs (NULL, r, serial, sizeof (serial), &hashing);
+    ok (hashing == 0,
+        "kvstxn_process never stalls for hashing without a hashpool");
+
+    store_many_dirs (hp, r, parallel, sizeof (parallel), &hashing);
+    ok (hashing > 0,
+        "kvstxn_process stalled for hashing with a hashpool");
+    ok (!strcmp (serial, parallel),
+        "root stored with a hashpool matches root stored without");
+
+    hashpool_destroy (hp);
+    flux_reactor_destroy (r);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -3403,6 +3513,7 @@ int main (int argc, char *argv[])
     kvstxn_process_append_errors ();
     kvstxn_process_append_no_duplicate ();
     kvstxn_process_fallback_merge ();
+    kvstxn_process_hashpool ();
 
     done_testing ();
     return (0);
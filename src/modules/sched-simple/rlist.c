@@ -28,6 +28,13 @@ void rlist_destroy (struct rlist *rl)
 {
     if (rl) {
         zlistx_destroy (&rl->nodes);
+        if (rl->by_avail) {
+            for (size_t i = 0; i < rl->by_avail_size; i++)
+                idset_destroy (rl->by_avail[i]);
+            free (rl->by_avail);
+        }
+        idset_destroy (rl->avail_ranks);
+        free (rl->rank_index);
         free (rl);
     }
 }
@@ -41,7 +48,10 @@ static void rn_free_fn (void **x)
 struct rlist *rlist_create (void)
 {
     struct rlist *rl = calloc (1, sizeof (*rl));
-    if (!(rl->nodes = zlistx_new ()))
+    if (!rl)
+        return NULL;
+    if (!(rl->nodes = zlistx_new ())
+        || !(rl->avail_ranks = idset_create (0, IDSET_FLAG_AUTOGROW)))
         goto err;
     zlistx_set_destructor (rl->nodes, rn_free_fn);
     return (rl);
@@ -50,6 +60,87 @@ err:
     return (NULL);
 }
 
+/*  Grow the by_avail index so that it has a bucket for `count` cores.
+ */
+static int rlist_by_avail_grow (struct rlist *rl, size_t count)
+{
+    struct idset **new;
+    size_t size = rl->by_avail_size ? rl->by_avail_size : 8;
+
+    while (size <= count)
+        size <<= 1;
+    if (size == rl->by_avail_size)
+        return 0;
+    if (!(new = realloc (rl->by_avail, size * sizeof (*new))))
+        return -1;
+    for (size_t i = rl->by_avail_size; i < size; i++) {
+        if (!(new[i] = idset_create (0, IDSET_FLAG_AUTOGROW))) {
+            rl->by_avail = new;
+            rl->by_avail_size = i;
+            return -1;
+        }
+    }
+    rl->by_avail = new;
+    rl->by_avail_size = size;
+    return 0;
+}
+
+/*  Move rank of node `n` from the by_avail bucket for `prev` available
+ *   cores to the bucket for its current number of available cores.
+ *   Nodes with no available cores (including down nodes) are not indexed.
+ */
+static int rlist_index_update (struct rlist *rl, struct rnode *n, size_t prev)
+{
+    size_t avail = rnode_avail (n);
+
+    if (prev > 0 && prev < rl->by_avail_size)
+        idset_clear (rl->by_avail[prev], n->rank);
+    if (avail > 0) {
+        if (rlist_by_avail_grow (rl, avail) < 0
+            || idset_set (rl->by_avail[avail], n->rank) < 0
+            || idset_set (rl->avail_ranks, n->rank) < 0)
+            return -1;
+    }
+    else
+        idset_clear (rl->avail_ranks, n->rank);
+    return 0;
+}
+
+/*  Append a new node `n` to rlist `rl`, adding it to the rank and
+ *   by_avail indexes. On success, `rl` takes ownership of `n`.
+ *   Does not adjust rl->total or rl->avail.
+ */
+static int rlist_add_node (struct rlist *rl, struct rnode *n)
+{
+    void *handle;
+
+    if (n->rank >= rl->rank_index_size) {
+        struct rnode **new;
+        size_t size = rl->rank_index_size ? rl->rank_index_size : 64;
+        while (size <= n->rank)
+            size <<= 1;
+        if (!(new = realloc (rl->rank_index, size * sizeof (*new))))
+            return -1;
+        memset (new + rl->rank_index_size,
+                0,
+                (size - rl->rank_index_size) * sizeof (*new));
+        rl->rank_index = new;
+        rl->rank_index_size = size;
+    }
+    if (rl->rank_index[n->rank]) {
+        errno = EEXIST;
+        return -1;
+    }
+    if (!(handle = zlistx_add_end (rl->nodes, n)))
+        return -1;
+    if (rlist_index_update (rl, n, 0) < 0) {
+        zlistx_detach (rl->nodes, handle);
+        return -1;
+    }
+    rl->rank_index[n->rank] = n;
+    return 0;
+}
+
 struct rlist *rlist_copy_empty (const struct rlist *orig)
 {
     struct rnode *n;
@@ -59,7 +150,7 @@ struct rlist *rlist_copy_empty (const struct rlist *orig)
     n = zlistx_first (orig->nodes);
     while (n) {
         n = rnode_create_idset (n->rank, n->ids);
-        if (!n || !zlistx_add_end (rl->nodes, n))
+        if (!n || rlist_add_node (rl, n) < 0)
             goto fail;
         rl->total += rnode_count (n);
         n = zlistx_next (orig->nodes);
@@ -81,7 +172,7 @@ struct rlist *rlist_copy_down (const struct rlist *orig)
     while (n) {
         if (!n->up) {
             n = rnode_create_idset (n->rank, n->ids);
-            if (!n || !zlistx_add_end (rl->nodes, n))
+            if (!n || rlist_add_node (rl, n) < 0)
                 goto fail;
             rl->total += rnode_count (n);
         }
@@ -94,26 +185,10 @@ fail:
     return NULL;
 }
 
-static struct idset *idset_subtract (const struct idset *orig, struct idset *x)
-{
-    struct idset *ids = idset_copy (orig);
-    unsigned int i;
-
-    if (!ids)
-        return NULL;
-
-    i = idset_first (x);
-    while (i != IDSET_INVALID_ID) {
-        idset_clear (ids, i);
-        i = idset_next (x, i);
-    }
-    return ids;
-}
-
 static struct rnode *rnode_create_alloc (const struct rnode *n)
 {
     struct rnode *result;
-    struct idset *ids = idset_subtract (n->ids, n->avail);
+    struct idset *ids = idset_difference (n->ids, n->avail);
     if (!ids)
         return NULL;
     result = rnode_create_idset (n->rank, ids);
@@ -132,7 +207,7 @@ struct rlist *rlist_copy_allocated (const struct rlist *orig)
         int nalloc = idset_count (n->ids) - idset_count (n->avail);
         if (nalloc > 0) {
             n = rnode_create_alloc (n);
-            if (!n || !zlistx_add_end (rl->nodes, n))
+            if (!n || rlist_add_node (rl, n) < 0)
                 goto fail;
             rl->total += nalloc;
         }
@@ -147,13 +222,9 @@ fail:
 
 static struct rnode *rlist_find_rank (struct rlist *rl, uint32_t rank)
 {
-    struct rnode *n = zlistx_first (rl->nodes);
-    while (n) {
-        if (n->rank == rank)
-            return (n);
-        n = zlistx_next (rl->nodes);
-    }
-    return NULL;
+    if (rank >= rl->rank_index_size)
+        return NULL;
+    return rl->rank_index[rank];
 }
 
 /*  Compare two values from idset_first()/idset_next():
@@ -194,46 +265,37 @@ static int idset_cmp (struct idset *set1, struct idset *set2)
 
 static int idset_add_set (struct idset *set, struct idset *new)
 {
-    unsigned int i = idset_first (new);
-    while (i != IDSET_INVALID_ID) {
-        if (idset_test (set, i)) {
-            errno = EEXIST;
-            return -1;
-        }
-        if (idset_set (set, i) < 0)
-            return -1;
-        i = idset_next (new, i);
+    if (idset_has_intersection (set, new)) {
+        errno = EEXIST;
+        return -1;
     }
-    return 0;
+    return idset_add (set, new);
 }
 
 static int idset_remove_set (struct idset *set, struct idset *remove)
 {
-    unsigned int i = idset_first (remove);
-    while (i != IDSET_INVALID_ID) {
-        if (!idset_test (set, i)) {
-            errno = ENOENT;
-            return -1;
-        }
-        if (idset_clear (set, i) < 0)
-            return -1;
-        i = idset_next (remove, i);
+    if (!idset_is_subset (remove, set)) {
+        errno = ENOENT;
+        return -1;
     }
-    return 0;
+    return idset_subtract (set, remove);
 }
 
 static int rlist_add_rnode (struct rlist *rl, struct rnode *n)
 {
     struct rnode *found = rlist_find_rank (rl, n->rank);
     if (found) {
+        size_t prev = rnode_avail (found);
         if (idset_add_set (found->ids, n->ids) < 0)
             return (-1);
         if (idset_add_set (found->avail, n->avail) < 0) {
             idset_remove_set (found->ids, n->ids);
             return (-1);
         }
+        if (rlist_index_update (rl, found, prev) < 0)
+            return (-1);
     }
-    else if (!zlistx_add_end (rl->nodes, n))
+    else if (rlist_add_node (rl, n) < 0)
         return -1;
     rl->total += rnode_count (n);
     if (n->up)
@@ -607,16 +669,6 @@ static int by_rank (const void *item1, const void *item2)
     return (x->rank - y->rank);
 }
 
-static int by_avail (const void *item1, const void *item2)
-{
-    int n;
-    const struct rnode *x = item1;
-    const struct rnode *y = item2;
-    if ((n = rnode_avail (x) - rnode_avail (y)) == 0)
-        n = by_rank (x, y);
-    return n;
-}
-
 static int by_used (const void *item1, const void *item2)
 {
     int n;
@@ -630,66 +682,103 @@ static int by_used (const void *item1, const void *item2)
 static int rlist_rnode_alloc (struct rlist *rl, struct rnode *n,
                               int count, struct idset **idsetp)
 {
-    if (!n || rnode_alloc (n, count, idsetp) < 0)
+    size_t prev;
+    if (!n)
+        return -1;
+    prev = rnode_avail (n);
+    if (rnode_alloc (n, count, idsetp) < 0)
         return -1;
     rl->avail -= idset_count (*idsetp);
-    return 0;
+    return rlist_index_update (rl, n, prev);
 }
 
-#if 0
-static uint32_t rlist_rnode_rank (struct rlist *rl)
-{
-    struct rnode *n = zlistx_item (rl->nodes);
-    if (n)
-        return n->rank;
-    else
-        return (uint32_t)-1;
-}
-#endif
+enum fit_mode {
+    FIT_FIRST,
+    FIT_BEST,
+    FIT_WORST,
+};
 
-static struct rnode *rlist_first (struct rlist *rl)
+/*  Return the lowest ranked node with at least `count` cores available
+ *   from the by_avail bucket selected by `mode`:
+ *
+ *   FIT_FIRST - first node in rank order after `prev` (or first if NULL)
+ *   FIT_BEST  - node with the fewest available cores (most used)
+ *   FIT_WORST - node with the most available cores (least used)
+ *
+ *  Since nodes are only visited once during an allocation, and a node
+ *   is only passed over when it can no longer fit a slot, this visits
+ *   nodes in the same order as sorting the full node list would.
+ */
+static struct rnode *rlist_next_fit (struct rlist *rl,
+                                     enum fit_mode mode,
+                                     size_t count,
+                                     struct rnode *prev)
 {
-    return zlistx_first (rl->nodes);
-}
+    unsigned int rank = IDSET_INVALID_ID;
+    struct rnode *n;
 
-static struct rnode *rlist_next (struct rlist *rl)
-{
-    return zlistx_next (rl->nodes);
+    switch (mode) {
+        case FIT_FIRST:
+            rank = prev ? idset_next (rl->avail_ranks, prev->rank)
+                        : idset_first (rl->avail_ranks);
+            while (rank != IDSET_INVALID_ID) {
+                if ((n = rlist_find_rank (rl, rank))
+                    && rnode_avail (n) >= count)
+                    return n;
+                rank = idset_next (rl->avail_ranks, rank);
+            }
+            break;
+        case FIT_BEST:
+            for (size_t i = count; i < rl->by_avail_size; i++) {
+                if ((rank = idset_first (rl->by_avail[i])) != IDSET_INVALID_ID)
+                    break;
+            }
+            break;
+        case FIT_WORST:
+            for (size_t i = rl->by_avail_size; i > count && i > 0; i--) {
+                rank = idset_first (rl->by_avail[i-1]);
+                if (rank != IDSET_INVALID_ID)
+                    break;
+            }
+            break;
+    }
+    if (rank == IDSET_INVALID_ID)
+        return NULL;
+    return rlist_find_rank (rl, rank);
 }
 
 /*
- *  Allocate the first available N slots of size cores_per_slot from
- *   resource list rl after sorting the nodes with the current sort strategy.
+ *  Allocate N slots of size cores_per_slot from resource list rl,
+ *   visiting nodes in the order given by `mode` (see rlist_next_fit()).
  */
-static struct rlist * rlist_alloc_first_fit (struct rlist *rl,
-                                             int cores_per_slot,
-                                             int slots)
+static struct rlist * rlist_alloc_fit (struct rlist *rl,
+                                       enum fit_mode mode,
+                                       int cores_per_slot,
+                                       int slots)
 {
     int rc;
     struct idset *ids = NULL;
     struct rnode *n = NULL;
     struct rlist *result = NULL;
 
-    zlistx_sort (rl->nodes);
-
-    if (!(n = rlist_first (rl)))
+    if (!(n = rlist_next_fit (rl, mode, cores_per_slot, NULL))) {
+        errno = ENOSPC;
         return NULL;
+    }
 
     if (!(result = rlist_create ()))
         return NULL;
 
-    /* 2. assign slots to first nodes where they fit
-     */
     while (n && slots) {
-        /*  Try to allocate a slot on this node. If we fail with ENOSPC,
-         *   then advance to the next node and try again.
+        /*  If this node can no longer fit a slot, advance to the next
+         *   candidate node.
          */
-        if ((rc = rlist_rnode_alloc (rl, n, cores_per_slot, &ids)) < 0) {
-            if (errno != ENOSPC)
-                goto unwind;
-            n = rlist_next (rl);
+        if (rnode_avail (n) < (size_t) cores_per_slot) {
+            n = rlist_next_fit (rl, mode, cores_per_slot, n);
             continue;
         }
+        if ((rc = rlist_rnode_alloc (rl, n, cores_per_slot, &ids)) < 0)
+            goto unwind;
         /*  Append the allocated cores to the result set and continue
          *   if needed
          */
@@ -709,51 +798,65 @@ unwind:
     return result;
 }
 
+/*
+ *  Allocate the first available N slots of size cores_per_slot from
+ *   resource list rl in rank order.
+ */
+static struct rlist * rlist_alloc_first_fit (struct rlist *rl,
+                                             int cores_per_slot,
+                                             int slots)
+{
+    return rlist_alloc_fit (rl, FIT_FIRST, cores_per_slot, slots);
+}
+
 /*
  *  Allocate `slots` of size cores_per_slot from rlist `rl` and return
- *   the result. Sorts the node list by smallest available first, so that
+ *   the result. Uses nodes with smallest available first, so that
  *   we get something like "best fit". (minimize nodes used)
  */
 static struct rlist * rlist_alloc_best_fit (struct rlist *rl,
                                             int cores_per_slot,
                                             int slots)
 {
-    zlistx_set_comparator (rl->nodes, by_avail);
-    return rlist_alloc_first_fit (rl, cores_per_slot, slots);
+    return rlist_alloc_fit (rl, FIT_BEST, cores_per_slot, slots);
 }
 
 /*
  *  Allocate `slots` of size cores_per_slot from rlist `rl` and return
- *   the result. Sorts the node list by least utilized first, so that
+ *   the result. Uses least utilized nodes first, so that
  *   we get something like "worst fit". (Spread jobs across nodes)
  */
 static struct rlist * rlist_alloc_worst_fit (struct rlist *rl,
                                              int cores_per_slot,
                                              int slots)
 {
-    zlistx_set_comparator (rl->nodes, by_used);
-    return rlist_alloc_first_fit (rl, cores_per_slot, slots);
+    return rlist_alloc_fit (rl, FIT_WORST, cores_per_slot, slots);
 }
 
-
+/*  Return a list of the `nnodes` least utilized nodes in rl, taken
+ *   from the by_avail index in order of most available cores, then rank.
+ */
 static zlistx_t *rlist_get_nnodes (struct rlist *rl, int nnodes)
 {
-    struct rnode *n;
     zlistx_t *l = zlistx_new ();
     if (!l)
         return NULL;
-    n = zlistx_first (rl->nodes);
-    while (nnodes > 0) {
-        if (n == NULL) {
-            errno = ENOSPC;
-            goto err;
-        }
-        if (n->up) {
-            if (zlistx_add_end (l, n) < 0)
-                goto err;
-            nnodes--;
+    for (size_t i = rl->by_avail_size; i > 0 && nnodes > 0; i--) {
+        struct idset *ranks = rl->by_avail[i-1];
+        unsigned int rank = idset_first (ranks);
+        while (rank != IDSET_INVALID_ID && nnodes > 0) {
+            struct rnode *n = rlist_find_rank (rl, rank);
+            if (n->up) {
+                if (!zlistx_add_end (l, n))
+                    goto err;
+                nnodes--;
+            }
+            rank = idset_next (ranks, rank);
         }
-        n = zlistx_next (rl->nodes);
+    }
+    if (nnodes > 0) {
+        errno = ENOSPC;
+        goto err;
     }
     return (l);
 err:
@@ -783,12 +886,7 @@ static struct rlist *rlist_alloc_nnodes (struct rlist *rl, int nnodes,
     if (!(result = rlist_create ()))
         return NULL;
 
-    /* 1. sort rank list by used cores ascending:
-     */
-    zlistx_set_comparator (rl->nodes, by_used);
-    zlistx_sort (rl->nodes);
-
-    /* 2. get a list of the first up n nodes
+    /* 1. get a list of the first n up nodes by used cores ascending
      */
     if (!(cl = rlist_get_nnodes (rl, nnodes)))
         goto unwind;
@@ -799,7 +897,7 @@ static struct rlist *rlist_alloc_nnodes (struct rlist *rl, int nnodes,
     zlistx_set_comparator (cl, by_used);
 
     /*
-     * 3. divide slots across all nodes, placing each slot
+     * 2. divide slots across all nodes, placing each slot
      *    on most empty node first
      */
     while (slots > 0) {
@@ -849,9 +947,6 @@ static struct rlist *rlist_try_alloc (struct rlist *rl, const char *mode,
         return NULL;
     }
 
-    /*  Reset default sort to order nodes by "rank" */
-    zlistx_set_comparator (rl->nodes, by_rank);
-
     if (nnodes > 0)
         result = rlist_alloc_nnodes (rl, nnodes, cores_per_slot, slots);
     else if (mode == NULL || strcmp (mode, "worst-fit") == 0)
@@ -919,29 +1014,33 @@ struct rlist *rlist_alloc (struct rlist *rl, const char *mode,
 
 static int rlist_free_rnode (struct rlist *rl, struct rnode *n)
 {
+    size_t prev;
     struct rnode *rnode = rlist_find_rank (rl, n->rank);
     if (!rnode) {
         errno = ENOENT;
         return -1;
     }
+    prev = rnode_avail (rnode);
     if (rnode_free_idset (rnode, n->ids) < 0)
         return -1;
     if (rnode->up)
         rl->avail += idset_count (n->ids);
-    return 0;
+    return rlist_index_update (rl, rnode, prev);
 }
 
 static int rlist_alloc_rnode (struct rlist *rl, struct rnode *n)
 {
+    size_t prev;
     struct rnode *rnode = rlist_find_rank (rl, n->rank);
     if (!rnode) {
         errno = ENOENT;
         return -1;
     }
+    prev = rnode_avail (rnode);
     if (rnode_alloc_idset (rnode, n->avail) < 0)
         return -1;
     rl->avail -= idset_count (n->avail);
-    return 0;
+    return rlist_index_update (rl, rnode, prev);
 }
 
 int rlist_free (struct rlist *rl, struct rlist *alloc)
@@ -1002,6 +1101,22 @@ size_t rlist_nnodes (struct rlist *rl)
     return zlistx_size (rl->nodes);
 }
 
+/* Set node 'n' to state 'up'. Return number of cores that changed
+ *  availability state.
+ */
+static int rlist_rnode_set_state (struct rlist *rl, struct rnode *n, bool up)
+{
+    int count = 0;
+    if (n->up != up) {
+        size_t prev = rnode_avail (n);
+        count = idset_count (n->avail);
+        n->up = up;
+        if (rlist_index_update (rl, n, prev) < 0)
+            return -1;
+    }
+    return count;
+}
+
 /* Mark all nodes in state 'up'. Count number of cores that changed
  *  availability state.
  */
@@ -1010,9 +1125,10 @@ static int rlist_mark_all (struct rlist *rl, bool up)
     int count = 0;
     struct rnode *n = zlistx_first (rl->nodes);
     while (n) {
-        if (n->up != up)
-            count += idset_count (n->avail);
-        n->up = up;
+        int rc = rlist_rnode_set_state (rl, n, up);
+        if (rc < 0)
+            return -1;
+        count += rc;
         n = zlistx_next (rl->nodes);
     }
     return count;
@@ -1028,9 +1144,12 @@ static int rlist_mark_state (struct rlist *rl, bool up, const char *ids)
     i = idset_first (idset);
     while (i != IDSET_INVALID_ID) {
         struct rnode *n = rlist_find_rank (rl, i);
-        if (n->up != up)
-            count += idset_count (n->avail);
-        n->up = up;
+        int rc = rlist_rnode_set_state (rl, n, up);
+        if (rc < 0) {
+            idset_destroy (idset);
+            return -1;
+        }
+        count += rc;
         i = idset_next (idset, i);
     }
     idset_destroy (idset);
@@ -1044,6 +1163,8 @@ int rlist_mark_down (struct rlist *rl, const char *ids)
         count = rlist_mark_all (rl, false);
     else
         count = rlist_mark_state (rl, false, ids);
+    if (count < 0)
+        return -1;
     rl->avail -= count;
     return 0;
 }
@@ -1055,6 +1176,8 @@ int rlist_mark_up (struct rlist *rl, const char *ids)
         count = rlist_mark_all (rl, true);
     else
         count = rlist_mark_state (rl, true, ids);
+    if (count < 0)
+        return -1;
     rl->avail += count;
     return 0;
 }
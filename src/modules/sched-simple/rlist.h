@@ -24,6 +24,15 @@ struct rlist {
     int total;
     int avail;
     zlistx_t *nodes;
+
+    /*  Index of nodes by rank, and of ranks by number of available
+     *   cores, kept up to date as resources are allocated and freed.
+     */
+    struct rnode **rank_index;
+    size_t rank_index_size;
+    struct idset *avail_ranks;  /* ranks with any cores available */
+    struct idset **by_avail;    /* by_avail[n]: ranks with n cores avail */
+    size_t by_avail_size;
 };
 
 /*  Create an empty rlist object */
@@ -109,36 +109,26 @@ int rnode_alloc (struct rnode *n, int count, struct idset **setp)
  */
 static bool alloc_ids_valid (struct rnode *n, struct idset *ids)
 {
-    unsigned int i = idset_first (ids);
-    while (i != IDSET_INVALID_ID) {
-        if (!idset_test (n->ids, i)) {
-            errno = ENOENT;
-            return false;
-        }
-        if (!idset_test (n->avail, i)) {
-            errno = EEXIST;
-            return false;
-        }
-        i = idset_next (ids, i);
+    if (!idset_is_subset (ids, n->ids)) {
+        errno = ENOENT;
+        return false;
+    }
+    if (!idset_is_subset (ids, n->avail)) {
+        errno = EEXIST;
+        return false;
     }
     return (true);
 }
 
 int rnode_alloc_idset (struct rnode *n, struct idset *ids)
 {
-    unsigned int i;
     if (!ids) {
         errno = EINVAL;
         return -1;
     }
     if (!alloc_ids_valid (n, ids))
         return -1;
-    i = idset_first (ids);
-    while (i != IDSET_INVALID_ID) {
-        idset_clear (n->avail, i);
-        i = idset_next (ids, i);
-    }
-    return 0;
+    return idset_subtract (n->avail, ids);
 }
 
 /*
@@ -147,36 +137,26 @@ int rnode_alloc_idset (struct rnode *n, struct idset *ids)
  */
 static bool free_ids_valid (struct rnode *n, struct idset *ids)
 {
-    unsigned int i = idset_first (ids);
-    while (i != IDSET_INVALID_ID) {
-        if (!idset_test (n->ids, i)) {
-            errno = ENOENT;
-            return false;
-        }
-        if (idset_test (n->avail, i)) {
-            errno = EEXIST;
-            return false;
-        }
-        i = idset_next (ids, i);
+    if (!idset_is_subset (ids, n->ids)) {
+        errno = ENOENT;
+        return false;
+    }
+    if (idset_has_intersection (ids, n->avail)) {
+        errno = EEXIST;
+        return false;
     }
     return (true);
 }
 
 int rnode_free_idset (struct rnode *n, struct idset *ids)
 {
-    unsigned int i;
     if (!ids) {
         errno = EINVAL;
         return -1;
     }
     if (!free_ids_valid (n, ids))
         return -1;
-    i = idset_first (ids);
-    while (i != IDSET_INVALID_ID) {
-        idset_set (n->avail, i);
-        i = idset_next (ids, i);
-    }
-    return 0;
+    return idset_add (n->avail, ids);
 }
 
 int rnode_free (struct rnode *n, const char *s)
@@ -11,6 +11,7 @@
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <limits.h>
 #include <czmq.h>
 #include <flux/core.h>
 #include <flux/idset.h>
@@ -37,6 +38,7 @@ struct simple_sched {
     flux_future_t *acquire_f; /* resource.acquire future */
 
     char *mode;             /* allocation mode */
+    int queue_depth;        /* max pending jobs considered per pass */
     bool single;
     bool sched_pus;         /* schedule PUs as cores */
     struct rlist *rlist;    /* list of resources */
@@ -136,6 +138,7 @@ static struct simple_sched * simple_sched_create (void)
 
     /* Single alloc request mode is default */
     ss->single = true;
+    ss->queue_depth = 1;
     return ss;
 }
 
@@ -177,19 +180,59 @@ out:
     return (s);
 }
 
-static int try_alloc (flux_t *h, struct simple_sched *ss)
+static int try_free (flux_t *h, struct simple_sched *ss, const char *R)
 {
     int rc = -1;
+    char *r = NULL;
+    struct rlist *alloc = rlist_from_R (R);
+    if (!alloc) {
+        flux_log_error (h, "hello: unable to parse R=%s", R);
+        return -1;
+    }
+    r = rlist_dumps (alloc);
+    if ((rc = rlist_free (ss->rlist, alloc)) < 0)
+        flux_log_error (h, "free: %s", r);
+    else
+        flux_log (h, LOG_DEBUG, "free: %s", r);
+    free (r);
+    rlist_destroy (alloc);
+    return rc;
+}
+
+/*  R for a batch of allocated jobs could not be committed, and the job's
+ *   alloc request has been answered with an error.  Return R to the pool.
+ */
+static void alloc_fail_cb (flux_t *h,
+                           const flux_msg_t *msg,
+                           const char *R,
+                           void *arg)
+{
+    struct simple_sched *ss = arg;
+
+    if (try_free (h, ss, R) < 0)
+        flux_log_error (h, "alloc: unable to return R after commit failure");
+    flux_watcher_start (ss->prep);
+}
+
+/*  Try to allocate resources for pending job `job`.  On success, R is
+ *   added to alloc batch `batch` (created on demand) and the job is removed
+ *   from the queue.  If the job cannot be allocated now, it is left in the
+ *   queue and -1 is returned with errno set to ENOSPC.  If R cannot be
+ *   added to the batch, the resources are returned, the job is left in
+ *   the queue, and -1 is returned.  Jobs that can never be satisfied are
+ *   denied and removed from the queue.
+ */
+static int try_alloc (flux_t *h,
+                      struct simple_sched *ss,
+                      struct jobreq *job,
+                      schedutil_alloc_batch_t **batch)
+{
     char *s = NULL;
     struct rlist *alloc = NULL;
-    struct jj_counts *jj = NULL;
+    struct jj_counts *jj = &job->jj;
     char *R = NULL;
-    struct jobreq *job = zlistx_first (ss->queue);
     double now = flux_reactor_now (flux_get_reactor (h));
 
-    if (!job)
-        return -1;
-    jj = &job->jj;
     alloc = rlist_alloc (ss->rlist, ss->mode,
                          jj->nnodes, jj->nslots, jj->slot_size);
     if (!alloc || !(R = Rstring_create (alloc, now, jj->duration))) {
@@ -203,7 +246,7 @@ static int try_alloc (flux_t *h, struct simple_sched *ss)
             rlist_destroy (alloc);
             alloc = NULL;
         } else if (errno == ENOSPC)
-            return rc;
+            return -1;
         else if (errno == EOVERFLOW)
             note = "unsatisfiable request";
         if (schedutil_alloc_respond_denied (ss->util_ctx,
@@ -214,18 +257,57 @@ static int try_alloc (flux_t *h, struct simple_sched *ss)
     }
     s = rlist_dumps (alloc);
 
-    if (schedutil_alloc_respond_R (ss->util_ctx, job->msg, R, s) < 0)
-        flux_log_error (h, "schedutil_alloc_respond_R");
+    if ((!*batch && !(*batch = schedutil_alloc_batch_create (ss->util_ctx,
+                                                            alloc_fail_cb,
+                                                            ss)))
+        || schedutil_alloc_batch_add_R (*batch, job->msg, R, s) < 0) {
+        flux_log_error (h, "alloc: %ju: schedutil_alloc_batch_add_R",
+                        (uintmax_t) job->id);
+        if (rlist_free (ss->rlist, alloc) < 0)
+            flux_log_error (h, "try_alloc: rlist_free");
+        rlist_destroy (alloc);
+        free (R);
+        free (s);
+        return -1;
+    }
 
     flux_log (h, LOG_DEBUG, "alloc: %ju: %s", (uintmax_t) job->id, s);
-    rc = 0;
 
 out:
     zlistx_delete (ss->queue, job->handle);
     rlist_destroy (alloc);
     free (R);
     free (s);
-    return rc;
+    return 0;
+}
+
+/*  Make one scheduling pass over at most queue_depth pending jobs in
+ *   queue order.  With a queue_depth of 1, only the head of the queue is
+ *   considered.  Otherwise, jobs that do not currently fit are skipped
+ *   so that smaller jobs behind them may be backfilled.  R for all jobs
+ *   allocated in this pass is committed to the KVS in one transaction.
+ *   If that commit fails, alloc_fail_cb() returns each job's resources.
+ *
+ *  Returns the number of jobs removed from the queue (allocated or denied).
+ */
+static int schedule_pass (flux_t *h, struct simple_sched *ss)
+{
+    schedutil_alloc_batch_t *batch = NULL;
+    struct jobreq *job = zlistx_first (ss->queue);
+    int tried = 0;
+    int count = 0;
+
+    while (job && tried++ < ss->queue_depth) {
+        /*  Advance cursor first, since try_alloc() may remove job
+         */
+        struct jobreq *next = zlistx_next (ss->queue);
+        if (try_alloc (h, ss, job, &batch) == 0)
+            count++;
+        job = next;
+    }
+    if (batch && schedutil_alloc_batch_commit (batch) < 0)
+        flux_log_error (h, "schedutil_alloc_batch_commit");
+    return count;
 }
 
 static void prep_cb (flux_reactor_t *r, flux_watcher_t *w,
@@ -246,35 +328,16 @@ static void check_cb (flux_reactor_t *r, flux_watcher_t *w,
     struct simple_sched *ss = arg;
     flux_watcher_stop (ss->idle);
 
-    /* See if we can fulfill alloc for a pending job
-     * If current head of queue can't be allocated, stop the prep
+    /* See if we can fulfill alloc for pending jobs.
+     * If no job in this pass could be allocated, stop the prep
      *  watcher, i.e. block. O/w, retry on next loop.
      */
-    if (try_alloc (ss->h, ss) < 0 && errno == ENOSPC) {
+    if (schedule_pass (ss->h, ss) == 0) {
         flux_watcher_stop (ss->prep);
         flux_watcher_stop (ss->check);
     }
 }
 
-static int try_free (flux_t *h, struct simple_sched *ss, const char *R)
-{
-    int rc = -1;
-    char *r = NULL;
-    struct rlist *alloc = rlist_from_R (R);
-    if (!alloc) {
-        flux_log_error (h, "hello: unable to parse R=%s", R);
-        return -1;
-    }
-    r = rlist_dumps (alloc);
-    if ((rc = rlist_free (ss->rlist, alloc)) < 0)
-        flux_log_error (h, "free: %s", r);
-    else
-        flux_log (h, LOG_DEBUG, "free: %s", r);
-    free (r);
-    rlist_destroy (alloc);
-    return rc;
-}
-
 void free_cb (flux_t *h, const flux_msg_t *msg, const char *R, void *arg)
 {
     struct simple_sched *ss = arg;
@@ -477,7 +540,7 @@ static void acquire_continuation (flux_future_t *f, void *arg)
         return;
     }
     if (ss_resource_update (ss, f) == 0)
-        try_alloc (ss->h, ss);
+        schedule_pass (ss->h, ss);
 }
 
 /*  Synchronously acquire resources from resource module.
@@ -593,6 +656,16 @@ static int process_args (flux_t *h, struct simple_sched *ss,
         else if (strcmp ("sched-PUs", argv[i]) == 0) {
             ss->sched_pus = true;
         }
+        else if (strncmp ("queue-depth=", argv[i], 12) == 0) {
+            char *endptr;
+            long n = strtol (argv[i]+12, &endptr, 10);
+            if (n <= 0 || n > INT_MAX || *endptr != '\0') {
+                flux_log (h, LOG_ERR, "invalid queue-depth: %s", argv[i]+12);
+                errno = EINVAL;
+                return -1;
+            }
+            ss->queue_depth = n;
+        }
         else {
             flux_log_error (h, "Unknown module option: '%s'", argv[i]);
             return -1;
@@ -0,0 +1,122 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* rlist-bench - time rlist_alloc()/rlist_free() for each allocation mode
+ *  as the number of nodes in the resource list grows.
+ *
+ * Usage: rlist-bench [MAX_NODES] [CORES_PER_NODE] [ITERATIONS]
+ *
+ * For each node count from 128 up to MAX_NODES (doubling), a resource
+ *  list is half filled with 1 core jobs, and then ITERATIONS allocations
+ *  of 1 slot of 1 core are made and freed again.  The time per
+ *  alloc/free pair is reported.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <czmq.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+#include "rlist.h"
+
+static const char *modes[] = { "first-fit", "best-fit", "worst-fit", NULL };
+
+static struct rlist *rlist_create_test (int nnodes, int cores)
+{
+    char ids[64];
+    struct rlist *rl = rlist_create ();
+
+    if (!rl)
+        log_err_exit ("rlist_create");
+    snprintf (ids, sizeof (ids), "0-%d", cores - 1);
+    for (int i = 0; i < nnodes; i++) {
+        if (rlist_append_rank (rl, i, ids) < 0)
+            log_err_exit ("rlist_append_rank");
+    }
+    return rl;
+}
+
+static double bench_mode (const char *mode, int nnodes, int cores, int iter)
+{
+    struct timespec t0;
+    struct rlist *rl = rlist_create_test (nnodes, cores);
+    zlistx_t *fill = zlistx_new ();
+    struct rlist *alloc;
+    double elapsed;
+
+    if (!fill)
+        log_err_exit ("zlistx_new");
+
+    /*  Half fill the instance so that best-fit and worst-fit have to
+     *   pick between partially used nodes.
+     */
+    while (rl->avail > rl->total / 2) {
+        if (!(alloc = rlist_alloc (rl, mode, 0, 1, 1)))
+            log_err_exit ("rlist_alloc: %s", mode);
+        if (!zlistx_add_end (fill, alloc))
+            log_err_exit ("zlistx_add_end");
+    }
+
+    monotime (&t0);
+    for (int i = 0; i < iter; i++) {
+        if (!(alloc = rlist_alloc (rl, mode, 0, 1, 1)))
+            log_err_exit ("rlist_alloc: %s", mode);
+        if (rlist_free (rl, alloc) < 0)
+            log_err_exit ("rlist_free: %s", mode);
+        rlist_destroy (alloc);
+    }
+    elapsed = monotime_since (t0);
+
+    alloc = zlistx_first (fill);
+    while (alloc) {
+        rlist_destroy (alloc);
+        alloc = zlistx_next (fill);
+    }
+    zlistx_destroy (&fill);
+    rlist_destroy (rl);
+
+    return (elapsed * 1000.) / iter;
+}
+
+int main (int argc, char *argv[])
+{
+    int max_nodes = argc > 1 ? strtol (argv[1], NULL, 10) : 8192;
+    int cores = argc > 2 ? strtol (argv[2], NULL, 10) : 32;
+    int iter = argc > 3 ? strtol (argv[3], NULL, 10) : 1000;
+
+    log_init ("rlist-bench");
+
+    if (max_nodes <= 0 || cores <= 0 || iter <= 0)
+        log_msg_exit ("Usage: rlist-bench [MAX_NODES] [CORES] [ITERATIONS]");
+
+    printf ("%8s", "NNODES");
+    for (int i = 0; modes[i] != NULL; i++)
+        printf (" %12s", modes[i]);
+    printf ("  (usec per alloc/free)\n");
+
+    for (int nnodes = 128; nnodes <= max_nodes; nnodes *= 2) {
+        printf ("%8d", nnodes);
+        for (int i = 0; modes[i] != NULL; i++)
+            printf (" %12.2f", bench_mode (modes[i], nnodes, cores, iter));
+        printf ("\n");
+        fflush (stdout);
+    }
+    log_fini ();
+    return 0;
+}
+
+/* vi: ts=4 sw=4 expandtab
+ */
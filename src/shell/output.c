@@ -16,12 +16,17 @@
  * If output goes to terminal, stdout/stderr is written to the KVS, or
  * stdout/stderr if written directly to a file, the leader shell
  * implements an "shell-<id>.output" service that all ranks send task
- * output to.  Output objects accumulate in a json array on the
- * leader.  Depending on settings, output is written directly to
+ * output to.  Depending on settings, output is written directly to
  * stdout/stderr, output objects are written to the "output" key in
  * the job's guest KVS namespace per RFC24, or output is written to a
  * configured file.
  *
+ * Shells send output to the leader's "write-raw" method as binary
+ * ioencode_raw() frames, so terminal and file output is written from
+ * the request payload without base64 or JSON decoding.  Only output
+ * bound for the KVS is converted to an RFC24 object.  The "write"
+ * method accepting RFC24 objects is retained for compatibility.
+ *
  * Notes:
  * - leader takes a completion reference which it gives up once each
  *   task sends an EOF for both stdout and stderr.
@@ -38,6 +43,13 @@
  * - In standalone mode, output is written to the shell's stdout/stderr not KVS
  * - The number of in-flight write requests on each shell is limited to
  *   shell_output_hwm, to avoid matchtag exhaustion, etc. for chatty tasks.
+ * - Each shell buffers output frames and sends them in one write-raw
+ *   request once output.flush-size bytes are pending, output.flush-timeout
+ *   seconds have passed, or a stream reaches EOF.
+ * - The leader merges consecutive KVS output from the same rank and
+ *   stream into one data event, and emits pending events in write order
+ *   every output.flush-timeout seconds (or output.flush-size bytes).
+ *   A flush-timeout of 0 disables both.
  */
 
 #if HAVE_CONFIG_H
@@ -45,6 +57,7 @@
 #endif
 #include <stdio.h>
 #include <string.h>
+#include <arpa/inet.h>
 #include <jansson.h>
 #include <flux/core.h>
 
@@ -74,14 +87,34 @@ struct shell_output_type_file {
     int label;
 };
 
+/* Consecutive output from one rank and stream awaiting a data event
+ * (leader only).
+ */
+struct output_chunk {
+    char *stream;
+    char *rank;
+    char *data;
+    int len;
+    int size;
+    bool eof;
+};
+
 struct shell_output {
     flux_shell_t *shell;
     struct eventlogger *ev;
     double batch_timeout;
+    double flush_timeout;
+    int flush_size;
+    flux_watcher_t *flush_w;
+    bool flush_armed;
+    char *batch;            // length prefixed frames not yet sent
+    int batch_len;
+    int batch_size;
+    zlistx_t *chunks;       // struct output_chunk, in write order
+    int chunks_len;         // total bytes in chunks
     int refcount;
     int eof_pending;
     zlist_t *pending_writes;
-    json_t *output;
     bool stopped;
     int stdout_type;
     int stderr_type;
@@ -93,6 +126,9 @@ struct shell_output {
 static const int shell_output_lwm = 100;
 static const int shell_output_hwm = 1000;
 
+static const double default_flush_timeout = 0.05;
+static const int default_flush_size = 65536;
+
 /* Pause/resume output on 'stream' of 'task'.
  */
 static void shell_output_control_task (struct shell_task *task,
@@ -132,45 +168,18 @@ static int shell_output_term_init (struct shell_output *out, json_t *header)
     return 0;
 }
 
-static int shell_output_term (struct shell_output *out)
+static void shell_output_term (struct shell_output *out,
+                               const char *stream,
+                               const char *rank,
+                               const char *data,
+                               int len)
 {
-    json_t *entry;
-    size_t index;
+    FILE *f = !strcmp (stream, "stdout") ? stdout : stderr;
 
-    json_array_foreach (out->output, index, entry) {
-        json_t *context;
-        const char *name;
-        if (eventlog_entry_parse (entry, NULL, &name, &context) < 0) {
-            shell_log_errno ("eventlog_entry_parse");
-            return -1;
-        }
-        if (!strcmp (name, "data")) {
-            int output_type;
-            FILE *f;
-            const char *stream = NULL;
-            const char *rank = NULL;
-            char *data = NULL;
-            int len = 0;
-            if (iodecode (context, &stream, &rank, &data, &len, NULL) < 0) {
-                shell_log_errno ("iodecode");
-                return -1;
-            }
-            if (!strcmp (stream, "stdout")) {
-                output_type = out->stdout_type;
-                f = stdout;
-            }
-            else {
-                output_type = out->stderr_type;
-                f = stderr;
-            }
-            if ((output_type == FLUX_OUTPUT_TYPE_TERM) && len > 0) {
-                fprintf (f, "%s: ", rank);
-                fwrite (data, len, 1, f);
-            }
-            free (data);
-        }
+    if (len > 0) {
+        fprintf (f, "%s: ", rank);
+        fwrite (data, len, 1, f);
     }
-    return 0;
 }
 
 static int shell_output_redirect_stream (struct shell_output *out,
@@ -288,38 +297,169 @@ error:
     return rc;
 }
 
-static int entry_output_is_kvs (struct shell_output *out, json_t *entry)
+/* Append an RFC 24 data event to the output eventlog.  If 'context'
+ * is NULL, it is created from the raw fields, so that the eventlog
+ * format is unchanged by the raw write protocol.
+ */
+static int shell_output_kvs_append (struct shell_output *out,
+                                    json_t *context,
+                                    const char *stream,
+                                    const char *rank,
+                                    const char *data,
+                                    int len,
+                                    bool eof)
 {
-    json_t *context;
-    const char *name;
-    const char *stream;
-    if (eventlog_entry_parse (entry, NULL, &name, &context) < 0) {
-        shell_log_errno ("eventlog_entry_parse");
-        return 0;
+    json_t *o = NULL;
+    json_t *entry = NULL;
+    int rc = -1;
+
+    if (!context) {
+        if (!(o = ioencode (stream, rank, data, len, eof)))
+            return shell_log_errno ("ioencode");
+        context = o;
     }
-    if (!strcmp (name, "data")) {
-        if (iodecode (context, &stream, NULL, NULL, NULL, NULL) < 0) {
-            shell_log_errno ("iodecode");
-            return 0;
-        }
-        if (!strcmp (stream, "stdout"))
-            return (out->stdout_type == FLUX_OUTPUT_TYPE_KVS);
-        else
-            return (out->stderr_type == FLUX_OUTPUT_TYPE_KVS);
+    if (!(entry = eventlog_entry_pack (0., "data", "O", context))) {
+        shell_log_errno ("eventlog_entry_pack");
+        goto out;
+    }
+    if (eventlogger_append_entry (out->ev, 0, "output", entry) < 0) {
+        shell_log_errno ("eventlogger_append");
+        goto out;
+    }
+    rc = 0;
+out:
+    json_decref (entry);
+    json_decref (o);
+    return rc;
+}
+
+static void output_chunk_destroy (void **item)
+{
+    if (item && *item) {
+        struct output_chunk *chunk = *item;
+        int saved_errno = errno;
+        free (chunk->stream);
+        free (chunk->rank);
+        free (chunk->data);
+        free (chunk);
+        errno = saved_errno;
+        *item = NULL;
+    }
+}
+
+static struct output_chunk *output_chunk_create (const char *stream,
+                                                 const char *rank)
+{
+    struct output_chunk *chunk;
+
+    if (!(chunk = calloc (1, sizeof (*chunk)))
+        || !(chunk->stream = strdup (stream))
+        || !(chunk->rank = strdup (rank))) {
+        output_chunk_destroy ((void **)&chunk);
+        return NULL;
+    }
+    return chunk;
+}
+
+static int output_chunk_append (struct output_chunk *chunk,
+                                const char *data,
+                                int len)
+{
+    if (chunk->len + len > chunk->size) {
+        int size = chunk->size ? chunk->size : 256;
+        char *p;
+
+        while (size < chunk->len + len)
+            size *= 2;
+        if (!(p = realloc (chunk->data, size)))
+            return -1;
+        chunk->data = p;
+        chunk->size = size;
     }
+    memcpy (chunk->data + chunk->len, data, len);
+    chunk->len += len;
     return 0;
 }
 
-static int shell_output_kvs (struct shell_output *out)
+/* Emit data events for pending chunks in the order they were written.
+ */
+static int shell_output_chunks_flush (struct shell_output *out)
+{
+    struct output_chunk *chunk;
+    int rc = 0;
+
+    if (!out->chunks)
+        return 0;
+    chunk = zlistx_first (out->chunks);
+    while (chunk) {
+        if (chunk->len > 0 || chunk->eof) {
+            if (shell_output_kvs_append (out,
+                                         NULL,
+                                         chunk->stream,
+                                         chunk->rank,
+                                         chunk->len > 0 ? chunk->data : NULL,
+                                         chunk->len,
+                                         chunk->eof) < 0)
+                rc = -1;
+        }
+        chunk = zlistx_next (out->chunks);
+    }
+    zlistx_purge (out->chunks);
+    out->chunks_len = 0;
+    return rc;
+}
+
+static void shell_output_flush_start (struct shell_output *out)
+{
+    if (out->flush_w && !out->flush_armed) {
+        flux_timer_watcher_reset (out->flush_w, out->flush_timeout, 0.);
+        flux_watcher_start (out->flush_w);
+        out->flush_armed = true;
+    }
+}
+
+/* Merge output into the last pending data event if it is for the same
+ * rank and stream, otherwise start a new one, so that events keep the
+ * order in which output was written.  Output is appended directly if
+ * coalescing is disabled.
+ */
+static int shell_output_kvs (struct shell_output *out,
+                             json_t *context,
+                             const char *stream,
+                             const char *rank,
+                             const char *data,
+                             int len,
+                             bool eof)
 {
-    json_t *entry;
-    size_t index;
-    json_array_foreach (out->output, index, entry) {
-        if (entry_output_is_kvs (out, entry) &&
-            eventlogger_append_entry (out->ev, 0, "output", entry) < 0) {
-            return shell_log_errno ("eventlogger_append");
+    struct output_chunk *chunk;
+
+    if (!out->chunks)
+        return shell_output_kvs_append (out, context, stream, rank,
+                                        data, len, eof);
+
+    chunk = zlistx_last (out->chunks);
+    if (!chunk
+        || chunk->eof
+        || strcmp (chunk->stream, stream) != 0
+        || strcmp (chunk->rank, rank) != 0) {
+        if (!(chunk = output_chunk_create (stream, rank)))
+            return -1;
+        if (!zlistx_add_end (out->chunks, chunk)) {
+            output_chunk_destroy ((void **)&chunk);
+            errno = ENOMEM;
+            return -1;
         }
     }
+    if (len > 0) {
+        if (output_chunk_append (chunk, data, len) < 0)
+            return -1;
+        out->chunks_len += len;
+    }
+    if (eof)
+        chunk->eof = true;
+    if (eof || out->chunks_len >= out->flush_size)
+        return shell_output_chunks_flush (out);
+    shell_output_flush_start (out);
     return 0;
 }
 
@@ -338,60 +478,90 @@ static int shell_output_write_fd (int fd, const void *buf, size_t len)
     return n;
 }
 
-static int shell_output_file (struct shell_output *out)
+static int shell_output_file (struct shell_output *out,
+                              struct shell_output_type_file *ofp,
+                              const char *rank,
+                              const char *data,
+                              int len)
 {
-    json_t *entry;
-    size_t index;
-
-    json_array_foreach (out->output, index, entry) {
-        json_t *context;
-        const char *name;
-        if (eventlog_entry_parse (entry, NULL, &name, &context) < 0) {
-            shell_log_errno ("eventlog_entry_parse");
-            return -1;
-        }
-        if (!strcmp (name, "data")) {
-            struct shell_output_type_file *ofp;
-            int output_type;
-            const char *stream = NULL;
-            const char *rank = NULL;
-            char *data = NULL;
-            int len = 0;
-            if (iodecode (context, &stream, &rank, &data, &len, NULL) < 0) {
-                shell_log_errno ("iodecode");
+    if (len > 0) {
+        if (ofp->label) {
+            char *buf = NULL;
+            int buflen;
+            if ((buflen = asprintf (&buf, "%s: ", rank)) < 0)
+                return -1;
+            if (shell_output_write_fd (ofp->fdp->fd, buf, buflen) < 0) {
+                free (buf);
                 return -1;
             }
-            if (!strcmp (stream, "stdout")) {
-                output_type = out->stdout_type;
-                ofp = &out->stdout_file;
-            }
-            else {
-                output_type = out->stderr_type;
-                ofp = &out->stderr_file;
-            }
-            if ((output_type == FLUX_OUTPUT_TYPE_FILE) && len > 0) {
-                if (ofp->label) {
-                    char *buf = NULL;
-                    int buflen;
-                    if ((buflen = asprintf (&buf, "%s: ", rank)) < 0)
-                        return -1;
-                    if (shell_output_write_fd (ofp->fdp->fd, buf, buflen) < 0) {
-                        free (buf);
-                        return -1;
-                    }
-                    free (buf);
-                }
-                if (shell_output_write_fd (ofp->fdp->fd, data, len) < 0)
-                    return -1;
-            }
-            free (data);
+            free (buf);
         }
+        if (shell_output_write_fd (ofp->fdp->fd, data, len) < 0)
+            return -1;
     }
     return 0;
 }
 
-/* Convert 'iodecode' object to an valid RFC 24 data event.
- * N.B. the iodecode object is a valid "context" for the event.
+/* Dispose of one decoded write according to the output type of 'stream'.
+ * 'context' is the original RFC 24 object if there is one.
+ */
+static void shell_output_data (struct shell_output *out,
+                               json_t *context,
+                               const char *stream,
+                               const char *rank,
+                               const char *data,
+                               int len,
+                               bool eof)
+{
+    struct shell_output_type_file *ofp;
+    int output_type;
+
+    if (!strcmp (stream, "stdout")) {
+        output_type = out->stdout_type;
+        ofp = &out->stdout_file;
+    }
+    else {
+        output_type = out->stderr_type;
+        ofp = &out->stderr_file;
+    }
+    /* Error failing to commit is a fatal error.  Should be cleaner in
+     * future. Issue #2378 */
+    if (output_type == FLUX_OUTPUT_TYPE_TERM)
+        shell_output_term (out, stream, rank, data, len);
+    else if (output_type == FLUX_OUTPUT_TYPE_KVS) {
+        if (shell_output_kvs (out, context, stream, rank, data, len, eof) < 0)
+            shell_die_errno (1, "shell_output_kvs");
+    }
+    else if (output_type == FLUX_OUTPUT_TYPE_FILE) {
+        if (shell_output_file (out, ofp, rank, data, len) < 0)
+            shell_log_errno ("shell_output_file");
+    }
+}
+
+/* Stop the handler that received the last EOF.  Later requests to
+ * either write handler are failed with ENOSYS, as if it were stopped too.
+ */
+static void shell_output_eof (struct shell_output *out,
+                              flux_msg_handler_t *mh)
+{
+    if (out->eof_pending > 0 && --out->eof_pending == 0) {
+        flux_msg_handler_stop (mh);
+        if (shell_output_chunks_flush (out) < 0)
+            shell_log_errno ("shell_output_kvs");
+        if (flux_shell_remove_completion_ref (out->shell, "output.write") < 0)
+            shell_log_errno ("flux_shell_remove_completion_ref");
+        /* no more output is coming, flush the last batch of
+         * output */
+        if ((out->stdout_type == FLUX_OUTPUT_TYPE_KVS
+             || (out->stderr_type == FLUX_OUTPUT_TYPE_KVS))) {
+            if (eventlogger_flush (out->ev) < 0)
+                shell_log_errno ("eventlogger_flush");
+        }
+    }
+}
+
+/* Handle a write request carrying an RFC 24 'iodecode' object.
+ * N.B. the iodecode object is a valid "context" for the data event.
  */
 static void shell_output_write_cb (flux_t *h,
                                    flux_msg_handler_t *mh,
@@ -399,59 +569,86 @@ static void shell_output_write_cb (flux_t *h,
                                    void *arg)
 {
     struct shell_output *out = arg;
+    const char *stream;
+    const char *rank;
+    char *data = NULL;
+    int len;
     bool eof = false;
     json_t *o;
-    json_t *entry;
 
-    if (flux_request_unpack (msg, NULL, "o", &o) < 0)
+    if (out->eof_pending == 0) {
+        flux_msg_handler_stop (mh);
+        errno = ENOSYS;
         goto error;
-    if (iodecode (o, NULL, NULL, NULL, NULL, &eof) < 0)
+    }
+    if (flux_request_unpack (msg, NULL, "o", &o) < 0)
         goto error;
-    if (!(entry = eventlog_entry_pack (0., "data", "O", o))) // increfs 'o'
+    if (iodecode (o, &stream, &rank, &data, &len, &eof) < 0)
         goto error;
-    if (json_array_append_new (out->output, entry) < 0) {
-        json_decref (entry);
-        errno = ENOMEM;
+    shell_output_data (out, o, stream, rank, data, len, eof);
+    free (data);
+    if (eof)
+        shell_output_eof (out, mh);
+    if (flux_respond (out->shell->h, msg, NULL) < 0)
+        shell_log_errno ("flux_respond");
+    return;
+error:
+    if (flux_respond_error (out->shell->h, msg, errno, NULL) < 0)
+        shell_log_errno ("flux_respond");
+}
+
+/* Handle a write request carrying a batch of ioencode_raw() frames,
+ * each preceded by its length as a 32 bit network order integer.
+ * Data is written to the terminal or file straight from the request
+ * payload, and only converted to an RFC 24 object if it goes to the KVS.
+ */
+static void shell_output_write_raw_cb (flux_t *h,
+                                       flux_msg_handler_t *mh,
+                                       const flux_msg_t *msg,
+                                       void *arg)
+{
+    struct shell_output *out = arg;
+    const void *buf;
+    int size;
+    const char *p;
+    const char *stream;
+    const char *rank;
+    const char *data;
+    int len;
+    bool eof;
+
+    if (out->eof_pending == 0) {
+        flux_msg_handler_stop (mh);
+        errno = ENOSYS;
         goto error;
     }
-    /* Error failing to commit is a fatal error.  Should be cleaner in
-     * future. Issue #2378 */
-    if ((out->stdout_type == FLUX_OUTPUT_TYPE_TERM
-         || (out->stderr_type == FLUX_OUTPUT_TYPE_TERM))) {
-        if (shell_output_term (out) < 0)
-            shell_die_errno (1, "shell_output_term");
-    }
-    if ((out->stdout_type == FLUX_OUTPUT_TYPE_KVS
-         || (out->stderr_type == FLUX_OUTPUT_TYPE_KVS))) {
-        if (shell_output_kvs (out) < 0)
-            shell_die_errno (1, "shell_output_kvs");
-    }
-    if ((out->stdout_type == FLUX_OUTPUT_TYPE_FILE
-         || (out->stderr_type == FLUX_OUTPUT_TYPE_FILE))) {
-        if (shell_output_file (out) < 0)
-            shell_log_errno ("shell_output_file");
-    }
-    if (json_array_clear (out->output) < 0) {
-        shell_log_error ("json_array_clear failed");
+    if (flux_request_decode_raw (msg, NULL, &buf, &size) < 0)
         goto error;
-    }
-    if (eof) {
-        if (--out->eof_pending == 0) {
-            flux_msg_handler_stop (mh);
-            if (flux_shell_remove_completion_ref (out->shell, "output.write") < 0)
-                shell_log_errno ("flux_shell_remove_completion_ref");
-            /* no more output is coming, flush the last batch of
-             * output */
-            if ((out->stdout_type == FLUX_OUTPUT_TYPE_KVS
-                 || (out->stderr_type == FLUX_OUTPUT_TYPE_KVS))) {
-                if (eventlogger_flush (out->ev) < 0)
-                    shell_log_errno ("eventlogger_flush");
-            }
-        }
+    p = buf;
+    while (size > 0) {
+        uint32_t framelen;
+
+        if (size < sizeof (framelen))
+            goto eproto;
+        memcpy (&framelen, p, sizeof (framelen));
+        framelen = ntohl (framelen);
+        p += sizeof (framelen);
+        size -= sizeof (framelen);
+        if (framelen > size)
+            goto eproto;
+        if (iodecode_raw (p, framelen, &stream, &rank, &data, &len, &eof) < 0)
+            goto error;
+        shell_output_data (out, NULL, stream, rank, data, len, eof);
+        if (eof)
+            shell_output_eof (out, mh);
+        p += framelen;
+        size -= framelen;
     }
     if (flux_respond (out->shell->h, msg, NULL) < 0)
         shell_log_errno ("flux_respond");
     return;
+eproto:
+    errno = EPROTO;
 error:
     if (flux_respond_error (out->shell->h, msg, errno, NULL) < 0)
         shell_log_errno ("flux_respond");
@@ -470,41 +667,101 @@ static void shell_output_write_completion (flux_future_t *f, void *arg)
         shell_output_control (out, false);
 }
 
-static int shell_output_write (struct shell_output *out,
-                               int rank,
-                               const char *stream,
-                               const char *data,
-                               int len,
-                               bool eof)
+/* Send buffered frames to the leader in one request.
+ */
+static int shell_output_batch_flush (struct shell_output *out)
 {
     flux_future_t *f = NULL;
-    json_t *o = NULL;
-    char rankstr[64];
-
-    snprintf (rankstr, sizeof (rankstr), "%d", rank);
-    if (!(o = ioencode (stream, rankstr, data, len, eof))) {
-        shell_log_errno ("ioencode");
-        return -1;
-    }
 
-    if (!(f = flux_shell_rpc_pack (out->shell, "write", 0, 0, "O", o)))
+    if (out->batch_len == 0)
+        return 0;
+    if (!(f = shell_svc_raw (out->shell->svc,
+                             "write-raw",
+                             0,
+                             0,
+                             out->batch,
+                             out->batch_len)))
         goto error;
     if (flux_future_then (f, -1, shell_output_write_completion, out) < 0)
         goto error;
     if (zlist_append (out->pending_writes, f) < 0)
         shell_log_error ("zlist_append failed");
-    json_decref (o);
+    out->batch_len = 0;
 
     if (zlist_size (out->pending_writes) >= shell_output_hwm)
         shell_output_control (out, true);
     return 0;
-
 error:
     flux_future_destroy (f);
-    json_decref (o);
+    out->batch_len = 0;
     return -1;
 }
 
+static int shell_output_batch_append (struct shell_output *out,
+                                      const void *frame,
+                                      int framelen)
+{
+    uint32_t prefix = htonl (framelen);
+    int need = out->batch_len + sizeof (prefix) + framelen;
+
+    if (need > out->batch_size) {
+        int size = out->batch_size ? out->batch_size : 4096;
+        char *p;
+
+        while (size < need)
+            size *= 2;
+        if (!(p = realloc (out->batch, size)))
+            return -1;
+        out->batch = p;
+        out->batch_size = size;
+    }
+    memcpy (out->batch + out->batch_len, &prefix, sizeof (prefix));
+    memcpy (out->batch + out->batch_len + sizeof (prefix), frame, framelen);
+    out->batch_len = need;
+    return 0;
+}
+
+static int shell_output_write (struct shell_output *out,
+                               int rank,
+                               const char *stream,
+                               const char *data,
+                               int len,
+                               bool eof)
+{
+    void *buf;
+    int size;
+    char rankstr[64];
+    int rc;
+
+    snprintf (rankstr, sizeof (rankstr), "%d", rank);
+    if (!(buf = ioencode_raw (stream, rankstr, data, len, eof, &size))) {
+        shell_log_errno ("ioencode_raw");
+        return -1;
+    }
+    rc = shell_output_batch_append (out, buf, size);
+    free (buf);
+    if (rc < 0)
+        return -1;
+    if (eof || out->batch_len >= out->flush_size || !out->flush_w)
+        return shell_output_batch_flush (out);
+    shell_output_flush_start (out);
+    return 0;
+}
+
+static void shell_output_flush_cb (flux_reactor_t *r,
+                                   flux_watcher_t *w,
+                                   int revents,
+                                   void *arg)
+{
+    struct shell_output *out = arg;
+
+    out->flush_armed = false;
+    if (shell_output_batch_flush (out) < 0)
+        shell_log_errno ("shell_output_write");
+    if (shell_output_chunks_flush (out) < 0)
+        shell_die_errno (1, "shell_output_kvs");
+}
+
 static void shell_output_type_file_cleanup (struct shell_output_type_file *ofp)
 {
     if (ofp->path)
@@ -515,6 +772,9 @@ void shell_output_destroy (struct shell_output *out)
 {
     if (out) {
         int saved_errno = errno;
+        flux_watcher_destroy (out->flush_w);
+        if (out->pending_writes && shell_output_batch_flush (out) < 0)
+            shell_log_errno ("shell_output_write");
         if (out->pending_writes) {
             flux_future_t *f;
 
@@ -525,24 +785,10 @@ void shell_output_destroy (struct shell_output *out)
             }
             zlist_destroy (&out->pending_writes);
         }
-        if (out->output && json_array_size (out->output) > 0) { // leader only
-            if ((out->stdout_type == FLUX_OUTPUT_TYPE_TERM)
-                || (out->stderr_type == FLUX_OUTPUT_TYPE_TERM)) {
-                if (shell_output_term (out) < 0)
-                    shell_log_errno ("shell_output_term");
-            }
-            if ((out->stdout_type == FLUX_OUTPUT_TYPE_KVS)
-                || (out->stderr_type == FLUX_OUTPUT_TYPE_KVS)) {
-                if (shell_output_kvs (out) < 0)
-                    shell_log_errno ("shell_output_kvs");
-            }
-            if ((out->stdout_type == FLUX_OUTPUT_TYPE_FILE
-                 || (out->stderr_type == FLUX_OUTPUT_TYPE_FILE))) {
-                if (shell_output_file (out) < 0)
-                    shell_log_errno ("shell_output_file");
-            }
-        }
-        json_decref (out->output);
+        if (shell_output_chunks_flush (out) < 0) // leader only
+            shell_log_errno ("shell_output_kvs");
+        zlistx_destroy (&out->chunks);
+        free (out->batch);
         shell_output_type_file_cleanup (&out->stdout_file);
         shell_output_type_file_cleanup (&out->stderr_file);
         if (out->fds) { // leader only
@@ -874,6 +1120,37 @@ static int output_eventlogger_start (struct shell_output *out)
     return 0;
 }
 
+static int shell_output_flush_init (struct shell_output *out)
+{
+    flux_reactor_t *r = flux_get_reactor (out->shell->h);
+
+    out->flush_timeout = default_flush_timeout;
+    out->flush_size = default_flush_size;
+
+    if (flux_shell_getopt_unpack (out->shell,
+                                  "output",
+                                  "{s?F s?i}",
+                                  "flush-timeout", &out->flush_timeout,
+                                  "flush-size", &out->flush_size) < 0)
+        return shell_log_errno ("invalid output.flush-timeout/size option");
+    if (out->flush_timeout < 0. || out->flush_size <= 0)
+        return shell_log_errn (EINVAL, "invalid output.flush-timeout/size");
+
+    shell_debug ("flush timeout = %.3fs size = %d",
+                 out->flush_timeout,
+                 out->flush_size);
+
+    if (out->flush_timeout > 0.) {
+        if (!(out->flush_w = flux_timer_watcher_create (r,
+                                                        out->flush_timeout,
+                                                        0.,
+                                                        shell_output_flush_cb,
+                                                        out)))
+            return -1;
+    }
+    return 0;
+}
+
 struct shell_output *shell_output_create (flux_shell_t *shell)
 {
     struct shell_output *out;
@@ -895,13 +1172,19 @@ struct shell_output *shell_output_create (flux_shell_t *shell)
 
     if (!(out->pending_writes = zlist_new ()))
         goto error;
+    if (shell_output_flush_init (out) < 0)
+        goto error;
     if (shell->info->shell_rank == 0) {
         if (output_type_requires_service (out->stdout_type)
             || output_type_requires_service (out->stderr_type)) {
             if (flux_shell_service_register (shell,
                                              "write",
                                              shell_output_write_cb,
-                                             out) < 0)
+                                             out) < 0
+                || flux_shell_service_register (shell,
+                                                "write-raw",
+                                                shell_output_write_raw_cb,
+                                                out) < 0)
                 goto error;
             if (output_type_requires_service (out->stdout_type))
                 out->eof_pending += shell->info->total_ntasks;
@@ -909,9 +1192,14 @@ struct shell_output *shell_output_create (flux_shell_t *shell)
                 out->eof_pending += shell->info->total_ntasks;
             if (flux_shell_add_completion_ref (shell, "output.write") < 0)
                 goto error;
-            if (!(out->output = json_array ())) {
-                errno = ENOMEM;
-                goto error;
+            if ((out->stdout_type == FLUX_OUTPUT_TYPE_KVS
+                 || out->stderr_type == FLUX_OUTPUT_TYPE_KVS)
+                && out->flush_w) {
+                if (!(out->chunks = zlistx_new ())) {
+                    errno = ENOMEM;
+                    goto error;
+                }
+                zlistx_set_destructor (out->chunks, output_chunk_destroy);
             }
         }
         if (out->stdout_type == FLUX_OUTPUT_TYPE_FILE
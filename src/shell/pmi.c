@@ -42,10 +42,20 @@
  * distributes KVS data that was "put" so that it is available to "get".
  * A local hash captures key-value pairs as they are put.  If the entire
  * job runs under one shell, the barrier is a no-op, and the gets are
- * serviced only from the cache.  Otherwise, the barrier dumps the hash
- * into a Flux KVS txn and commits it with a flux_kvs_fence(), using
- * the number of shells as "nprocs".  Gets are serviced from the cache,
- * with fall-through to a flux_kvs_lookup().
+ * serviced only from the cache.  Otherwise, data is distributed in one
+ * of two ways, selected with the "pmi.kvs" shell option:
+ *
+ * exchange (default)
+ *   The barrier contributes the keys put since the last barrier to an
+ *   allgather over a k-ary tree of shells (see pmi_exchange.c), where k
+ *   is set with the "pmi.exchange.k" shell option.  On completion the
+ *   full set of keys is added to the local hash, so all gets are
+ *   serviced from the cache without contacting the Flux KVS.
+ *
+ * native
+ *   The barrier dumps the hash into a Flux KVS txn and commits it with
+ *   a flux_kvs_fence(), using the number of shells as "nprocs".  Gets are
+ *   serviced from the cache, with fall-through to a flux_kvs_lookup().
  *
  * If shell->verbose is true (shell --verbose flag was provided), the
  * protocol engine emits client and server telemetry to stderr, and
@@ -57,7 +67,7 @@
  * - 64-bit Flux job id's are assigned to integer-typed PMI appnum
  * - PMI publish, unpublish, lookup, spawn are not implemented
  * - Although multiple cycles of put / barrier / get are supported, the
- *   the barrier rewrites data from previous cycles to the Flux KVS.
+ *   the native barrier rewrites data from previous cycles to the Flux KVS.
  * - PMI_Abort() is implemented as log message + exit in the client code.
  *   It does not reach this module.
  * - Teardown of the subprocess channel is deferred until task completion,
@@ -71,6 +81,7 @@
 #include <stdlib.h>
 #include <czmq.h>
 #include <assert.h>
+#include <jansson.h>
 #include <flux/core.h>
 
 #include "src/common/libpmi/simple_server.h"
@@ -79,15 +90,20 @@
 #include "builtins.h"
 #include "internal.h"
 #include "task.h"
+#include "pmi_exchange.h"
 
 #define FQ_KVS_KEY_MAX (SIMPLE_KVS_KEY_MAX + 128)
 
+static const int default_exchange_k = 2;
+
 struct shell_pmi {
     flux_shell_t *shell;
     struct pmi_simple_server *server;
     zhashx_t *kvs;
     zhashx_t *locals;
     int cycle;      // count cycles of put / barrier / get
+    struct pmi_exchange *exchange; // NULL unless pmi.kvs=exchange
+    json_t *pending;               // keys put since last exchange
 };
 
 static void shell_pmi_abort (void *arg,
@@ -110,6 +126,16 @@ static int shell_pmi_kvs_put (void *arg,
     struct shell_pmi *pmi = arg;
 
     zhashx_update (pmi->kvs, key, (char *)val);
+    if (pmi->exchange) {
+        json_t *o;
+
+        if (!(o = json_string (val))
+            || json_object_set_new (pmi->pending, key, o) < 0) {
+            json_decref (o);
+            shell_log_error ("error saving %s for pmi exchange", key);
+            return -1;
+        }
+    }
     return 0;
 }
 
@@ -152,6 +178,7 @@ static int shell_pmi_kvs_key (char *buf,
 /* Lookup a key: first try the local hash.   If that fails and the
  * job spans multiple shells, do a KVS lookup in the job's private
  * KVS namespace and handle the response in kvs_lookup_continuation().
+ * After an exchange, the local hash holds every key, so a miss fails.
  */
 static int shell_pmi_kvs_get (void *arg,
                               void *cli,
@@ -166,7 +193,7 @@ static int shell_pmi_kvs_get (void *arg,
         pmi_simple_server_kvs_get_complete (pmi->server, cli, val);
         return 0;
     }
-    if (pmi->shell->info->shell_size > 1) {
+    if (pmi->shell->info->shell_size > 1 && !pmi->exchange) {
         char nkey[FQ_KVS_KEY_MAX];
         flux_future_t *f = NULL;
 
@@ -207,6 +234,39 @@ static void kvs_fence_continuation (flux_future_t *f, void *arg)
     flux_future_destroy (f);
 }
 
+static void exchange_cb (struct pmi_exchange *pex, void *arg)
+{
+    struct shell_pmi *pmi = arg;
+    const char *key;
+    json_t *o;
+    int rc = -1;
+
+    if (pmi_exchange_has_error (pex))
+        goto done;
+    json_object_foreach (pmi_exchange_get_dict (pex), key, o) {
+        const char *val = json_string_value (o);
+
+        if (!val) {
+            shell_log_error ("pmi exchange: %s is not a string", key);
+            goto done;
+        }
+        zhashx_update (pmi->kvs, key, (char *)val);
+    }
+    rc = 0;
+done:
+    pmi_simple_server_barrier_complete (pmi->server, rc);
+}
+
+static int shell_pmi_barrier_exchange (struct shell_pmi *pmi)
+{
+    if (pmi_exchange (pmi->exchange, pmi->pending, exchange_cb, pmi) < 0) {
+        shell_log_errno ("pmi_exchange");
+        return -1;
+    }
+    json_object_clear (pmi->pending);
+    return 0;
+}
+
 static int shell_pmi_barrier_enter (void *arg)
 {
     struct shell_pmi *pmi = arg;
@@ -222,6 +282,8 @@ static int shell_pmi_barrier_enter (void *arg)
         pmi_simple_server_barrier_complete (pmi->server, 0);
         return 0;
     }
+    if (pmi->exchange)
+        return shell_pmi_barrier_exchange (pmi);
     snprintf (name, sizeof (name), "pmi.%ju.%d",
              (uintmax_t)pmi->shell->jobid,
              pmi->cycle++);
@@ -397,6 +459,8 @@ static void pmi_destroy (struct shell_pmi *pmi)
 {
     if (pmi) {
         int saved_errno = errno;
+        pmi_exchange_destroy (pmi->exchange);
+        json_decref (pmi->pending);
         pmi_simple_server_destroy (pmi->server);
         zhashx_destroy (&pmi->kvs);
         zhashx_destroy (&pmi->locals);
@@ -433,6 +497,44 @@ static struct pmi_simple_ops shell_pmi_ops = {
 };
 
 
+/* Parse pmi shell options and create the exchange, if used.
+ */
+static int init_exchange (struct shell_pmi *pmi)
+{
+    const char *kvs = "exchange";
+    int k = default_exchange_k;
+
+    if (flux_shell_getopt_unpack (pmi->shell,
+                                  "pmi",
+                                  "{s?s s?{s?i}}",
+                                  "kvs", &kvs,
+                                  "exchange",
+                                    "k", &k) < 0)
+        return -1;
+    if (!strcmp (kvs, "native"))
+        return 0;
+    if (strcmp (kvs, "exchange") != 0) {
+        shell_log_error ("unknown pmi.kvs option: %s", kvs);
+        errno = EINVAL;
+        return -1;
+    }
+    if (k < 1) {
+        shell_log_error ("pmi.exchange.k must be >= 1");
+        errno = EINVAL;
+        return -1;
+    }
+    if (pmi->shell->info->shell_size > 1) {
+        if (!(pmi->pending = json_object ())) {
+            errno = ENOMEM;
+            return -1;
+        }
+        if (!(pmi->exchange = pmi_exchange_create (pmi->shell, k)))
+            return -1;
+        shell_debug ("pmi exchange k=%d", k);
+    }
+    return 0;
+}
+
 static struct shell_pmi *pmi_create (flux_shell_t *shell)
 {
     struct shell_pmi *pmi;
@@ -459,6 +561,8 @@ static struct shell_pmi *pmi_create (flux_shell_t *shell)
     }
     zhashx_set_destructor (pmi->kvs, kvs_value_destructor);
     zhashx_set_duplicator (pmi->kvs, kvs_value_duplicator);
+    if (init_exchange (pmi) < 0)
+        goto error;
     if (init_clique (pmi) < 0)
         goto error;
     if (!shell->standalone) {
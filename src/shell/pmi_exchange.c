@@ -0,0 +1,270 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* pmi_exchange.c - tree based allgather for the shell PMI KVS
+ *
+ * A round completes on a shell once its own contribution and those of
+ * all of its children have arrived, and (except on shell rank 0) the
+ * merged dict has been sent upstream and the full dict received in the
+ * response.  Child requests are held until then and answered with the
+ * full dict.
+ *
+ * A child cannot begin round N+1 until its parent has answered round N,
+ * and the parent resets its state before answering, so requests never
+ * need to be tagged with a round number.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <czmq.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/kary.h"
+
+#include "internal.h"
+#include "svc.h"
+#include "pmi_exchange.h"
+
+struct pmi_exchange {
+    flux_shell_t *shell;
+    int k;
+    uint32_t parent;        // KARY_NONE on shell rank 0
+    int nchildren;
+
+    json_t *dict;           // dicts received so far in this round
+    zlist_t *requests;      // child requests awaiting a response
+    bool local;             // local contribution has been made
+    flux_future_t *f;       // request to parent in flight
+
+    pmi_exchange_f cb;
+    void *cb_arg;
+
+    json_t *result;         // full dict of the last round
+    bool has_error;
+};
+
+bool pmi_exchange_has_error (struct pmi_exchange *pex)
+{
+    return pex->has_error;
+}
+
+json_t *pmi_exchange_get_dict (struct pmi_exchange *pex)
+{
+    return pex->result;
+}
+
+static void respond_all (struct pmi_exchange *pex)
+{
+    const flux_msg_t *msg;
+    flux_t *h = pex->shell->h;
+
+    while ((msg = zlist_pop (pex->requests))) {
+        if (pex->has_error) {
+            if (flux_respond_error (h, msg, EIO, NULL) < 0)
+                shell_log_errno ("error responding to pmi-exchange");
+        }
+        else {
+            if (flux_respond_pack (h, msg, "{s:O}", "dict", pex->result) < 0)
+                shell_log_errno ("error responding to pmi-exchange");
+        }
+        flux_msg_decref (msg);
+    }
+}
+
+/* Finish the round: reset for the next one, answer children with
+ * 'dict' (NULL on error), then notify the local caller.
+ */
+static void exchange_complete (struct pmi_exchange *pex, json_t *dict)
+{
+    json_decref (pex->result);
+    pex->result = json_incref (dict);
+    pex->has_error = dict ? false : true;
+
+    json_decref (pex->dict);
+    pex->dict = NULL;
+    pex->local = false;
+
+    respond_all (pex);
+
+    if (pex->cb)
+        pex->cb (pex, pex->cb_arg);
+}
+
+static void parent_continuation (flux_future_t *f, void *arg)
+{
+    struct pmi_exchange *pex = arg;
+    json_t *dict;
+
+    if (flux_rpc_get_unpack (f, "{s:o}", "dict", &dict) < 0) {
+        shell_log_errno ("pmi-exchange request to shell rank %u",
+                         pex->parent);
+        dict = NULL;
+    }
+    pex->f = NULL;
+    exchange_complete (pex, dict);
+    flux_future_destroy (f);
+}
+
+static int merge_dict (struct pmi_exchange *pex, json_t *dict)
+{
+    if (!pex->dict) {
+        if (!(pex->dict = json_object ()))
+            goto nomem;
+    }
+    if (json_object_update (pex->dict, dict) < 0)
+        goto nomem;
+    return 0;
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
+/* Forward upstream, or complete on rank 0, once all contributions
+ * for this round are in.
+ */
+static void exchange_try (struct pmi_exchange *pex)
+{
+    flux_future_t *f;
+
+    if (!pex->local
+        || zlist_size (pex->requests) < pex->nchildren
+        || pex->f != NULL)
+        return;
+    if (pex->parent == KARY_NONE) {
+        json_t *dict = json_incref (pex->dict);
+        exchange_complete (pex, dict);
+        json_decref (dict);
+        return;
+    }
+    if (!(f = flux_shell_rpc_pack (pex->shell,
+                                   "pmi-exchange",
+                                   pex->parent,
+                                   0,
+                                   "{s:O}",
+                                   "dict", pex->dict))
+        || flux_future_then (f, -1., parent_continuation, pex) < 0) {
+        shell_log_errno ("pmi-exchange request to shell rank %u",
+                         pex->parent);
+        flux_future_destroy (f);
+        exchange_complete (pex, NULL);
+        return;
+    }
+    pex->f = f;
+}
+
+static void exchange_request_cb (flux_t *h,
+                                 flux_msg_handler_t *mh,
+                                 const flux_msg_t *msg,
+                                 void *arg)
+{
+    struct pmi_exchange *pex = arg;
+    json_t *dict;
+
+    if (shell_svc_allowed (pex->shell->svc, msg) < 0)
+        goto error;
+    if (flux_request_unpack (msg, NULL, "{s:o}", "dict", &dict) < 0)
+        goto error;
+    if (zlist_size (pex->requests) >= pex->nchildren) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (merge_dict (pex, dict) < 0)
+        goto error;
+    if (zlist_append (pex->requests, (void *)flux_msg_incref (msg)) < 0) {
+        flux_msg_decref (msg);
+        errno = ENOMEM;
+        goto error;
+    }
+    exchange_try (pex);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        shell_log_errno ("error responding to pmi-exchange");
+}
+
+int pmi_exchange (struct pmi_exchange *pex,
+                  json_t *dict,
+                  pmi_exchange_f cb,
+                  void *arg)
+{
+    if (!pex || !dict) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (pex->local) {
+        errno = EINPROGRESS;
+        return -1;
+    }
+    if (merge_dict (pex, dict) < 0)
+        return -1;
+    pex->local = true;
+    pex->cb = cb;
+    pex->cb_arg = arg;
+    exchange_try (pex);
+    return 0;
+}
+
+void pmi_exchange_destroy (struct pmi_exchange *pex)
+{
+    if (pex) {
+        int saved_errno = errno;
+        const flux_msg_t *msg;
+
+        flux_future_destroy (pex->f);
+        if (pex->requests) {
+            while ((msg = zlist_pop (pex->requests)))
+                flux_msg_decref (msg);
+            zlist_destroy (&pex->requests);
+        }
+        json_decref (pex->dict);
+        json_decref (pex->result);
+        free (pex);
+        errno = saved_errno;
+    }
+}
+
+struct pmi_exchange *pmi_exchange_create (flux_shell_t *shell, int k)
+{
+    struct pmi_exchange *pex;
+    uint32_t rank = shell->info->shell_rank;
+    uint32_t size = shell->info->shell_size;
+
+    if (k < 1) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(pex = calloc (1, sizeof (*pex))))
+        return NULL;
+    pex->shell = shell;
+    pex->k = k;
+    pex->parent = kary_parentof (k, rank);
+    while (kary_childof (k, size, rank, pex->nchildren) != KARY_NONE)
+        pex->nchildren++;
+    if (!(pex->requests = zlist_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (flux_shell_service_register (shell,
+                                     "pmi-exchange",
+                                     exchange_request_cb,
+                                     pex) < 0)
+        goto error;
+    return pex;
+error:
+    pmi_exchange_destroy (pex);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,53 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef SHELL_PMI_EXCHANGE_H
+#define SHELL_PMI_EXCHANGE_H
+
+#include <stdbool.h>
+#include <jansson.h>
+#include <flux/shell.h>
+
+/* Allgather of JSON objects across all shells of a job.
+ *
+ * Shells form a k-ary tree by shell rank.  Each shell merges its own
+ * dict with those of its children and sends the result to its parent
+ * in a "pmi-exchange" shell service request.  Shell rank 0 ends up
+ * with the union of all dicts, which flows back down the tree in the
+ * responses.  Every shell must call pmi_exchange() once per round.
+ */
+
+struct pmi_exchange;
+
+typedef void (*pmi_exchange_f)(struct pmi_exchange *pex, void *arg);
+
+struct pmi_exchange *pmi_exchange_create (flux_shell_t *shell, int k);
+void pmi_exchange_destroy (struct pmi_exchange *pex);
+
+/* Contribute 'dict' to a new round (the caller retains ownership).
+ * 'cb' is called once the round is complete.  Fails with EINPROGRESS
+ * if this shell's contribution to the current round was already made.
+ */
+int pmi_exchange (struct pmi_exchange *pex,
+                  json_t *dict,
+                  pmi_exchange_f cb,
+                  void *arg);
+
+/* Accessors valid during the completion callback.
+ * The returned dict is valid until the next round begins.
+ */
+bool pmi_exchange_has_error (struct pmi_exchange *pex);
+json_t *pmi_exchange_get_dict (struct pmi_exchange *pex);
+
+#endif /* !SHELL_PMI_EXCHANGE_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -107,6 +107,24 @@ flux_future_t *shell_svc_pack (struct shell_svc *svc,
     return f;
 }
 
+flux_future_t *shell_svc_raw (struct shell_svc *svc,
+                              const char *method,
+                              int shell_rank,
+                              int flags,
+                              const void *data,
+                              int len)
+{
+    char topic[TOPIC_STRING_SIZE];
+    int rank;
+
+    if (lookup_rank (svc, shell_rank, &rank) < 0)
+        return NULL;
+    if (build_topic (svc, method, topic, sizeof (topic)) < 0)
+        return NULL;
+
+    return flux_rpc_raw (svc->shell->h, topic, data, len, rank, flags);
+}
+
 int shell_svc_allowed (struct shell_svc *svc, const flux_msg_t *msg)
 {
     uint32_t rolemask;
@@ -19,6 +19,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdbool.h>
 #include <jansson.h>
 #include <flux/core.h>
 #include <flux/optparse.h>
@@ -29,6 +30,7 @@
 #include "src/common/libutil/fluid.h"
 #include "src/common/libjob/job.h"
 #include "src/common/libutil/read_all.h"
+#include "src/common/libutil/monotime.h"
 
 int cmd_submitbench (optparse_t *p, int argc, char **argv);
 
@@ -47,6 +49,12 @@ static struct optparse_option opts[] =  {
       .flags = OPTPARSE_OPT_AUTOSPLIT,
       .usage = "Set comma-separated flags (e.g. debug)",
     },
+    { .name = "quiet", .key = 'q', .has_arg = 0,
+      .usage = "Don't print job IDs",
+    },
+    { .name = "stats", .key = 'S', .has_arg = 0,
+      .usage = "Report sustained submission rate (jobs/s) on stderr",
+    },
 #if HAVE_FLUX_SECURITY
     { .name = "reuse-signature", .key = 'R', .has_arg = 0,
       .usage = "Sign jobspec once and reuse the result for multiple RPCs",
@@ -103,6 +111,7 @@ struct submitbench_ctx {
     int jobspecsz;
     const char *J;
     int priority;
+    bool quiet;
 };
 
 /* Read entire file 'name' ("-" for stdin).  Exit program on error.
@@ -142,7 +151,8 @@ void submitbench_continuation (flux_future_t *f, void *arg)
         else
             log_msg_exit ("submit: %s", future_strerror (f, errno));
     }
-    printf ("%ju\n", (uintmax_t)id);
+    if (!ctx->quiet)
+        printf ("%ju\n", (uintmax_t)id);
     flux_future_destroy (f);
 
     ctx->rxcount++;
@@ -205,6 +215,7 @@ int cmd_submitbench (optparse_t *p, int argc, char **argv)
     flux_reactor_t *r;
     int optindex = optparse_option_index (p);
     struct submitbench_ctx ctx;
+    struct timespec t0;
 
     memset (&ctx, 0, sizeof (ctx));
 
@@ -244,6 +255,7 @@ int cmd_submitbench (optparse_t *p, int argc, char **argv)
     ctx.totcount = optparse_get_int (p, "repeat", 1);
     ctx.jobspecsz = read_jobspec (argv[optindex++], &ctx.jobspec);
     ctx.priority = optparse_get_int (p, "priority", FLUX_JOB_PRIORITY_DEFAULT);
+    ctx.quiet = optparse_hasopt (p, "quiet");
 
     /* Prep/check/idle watchers perform flow control, keeping
      * at most ctx.max_queue_depth RPCs outstanding.
@@ -256,8 +268,19 @@ int cmd_submitbench (optparse_t *p, int argc, char **argv)
     flux_watcher_start (ctx.prep);
     flux_watcher_start (ctx.check);
 
+    monotime (&t0);
     if (flux_reactor_run (r, 0) < 0)
         log_err_exit ("flux_reactor_run");
+    /* The reactor exits once the last response has been received,
+     * so the rate covers the whole run with fanout RPCs in flight.
+     */
+    if (optparse_hasopt (p, "stats")) {
+        double elapsed = monotime_since (t0) / 1000.;
+        fprintf (stderr, "%d jobs in %.3fs: %.1f jobs/s (fanout %d)\n",
+                 ctx.rxcount, elapsed,
+                 elapsed > 0. ? ctx.rxcount / elapsed : 0.,
+                 ctx.max_queue_depth);
+    }
 #if HAVE_FLUX_SECURITY
     flux_security_destroy (ctx.sec); // invalidates ctx.J
 #endif
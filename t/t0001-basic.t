@@ -61,6 +61,12 @@ test_expect_success 'flux-start with size 2 has a peer' "
 	flux start ${ARGS} --size=2 'flux comms lspeer' > idle.out &&
         grep 'idle' idle.out
 "
+test_expect_success 'flux-start with broker.iothreads=1 works (size 2)' '
+	flux start -o,-Sbroker.iothreads=1 --size=2 \
+		"flux kvs put iothreads=42 && \
+		 flux exec -n -r 1 flux kvs get iothreads" >iothreads.out &&
+	test "$(cat iothreads.out)" = "42"
+'
 test_expect_success 'flux-start --size=1 --bootstrap=selfpmi works' "
 	flux start ${ARGS} --size=1 --bootstrap=selfpmi /bin/true
 "
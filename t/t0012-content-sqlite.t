@@ -112,6 +112,109 @@ test_expect_success 'exercise batching of synchronous flush to backing store' '
 	test ${NDIRTY} -eq 0
 '
 
+test_expect_success 'store blobs while no backing store is loaded' '
+	flux setattr content.flush-batch-limit 256 &&
+	flux module remove content-sqlite &&
+	store_junk batch 300 &&
+	NDIRTY=`flux module stats --type int --parse dirty content` &&
+	test ${NDIRTY} -ge 300
+'
+
+test_expect_success 'loading backing store flushes dirty blobs in batches' '
+	flux module load content-sqlite &&
+	flux content flush &&
+	NDIRTY=`flux module stats --type int --parse dirty content` &&
+	test ${NDIRTY} -eq 0
+'
+
+test_expect_success 'batch stored blobs can be loaded from backing store' '
+	for i in 1 150 300; do \
+		HASHSTR=`echo batch:$i | $BLOBREF $HASHFUN` &&
+		flux content load --bypass-cache $HASHSTR >batch.$i.out &&
+		echo batch:$i >batch.$i.expect &&
+		test_cmp batch.$i.expect batch.$i.out || return 1
+	done
+'
+
+test_expect_success 'content-sqlite fails to load with unknown codec' '
+	flux module remove content-sqlite &&
+	test_must_fail flux module load content-sqlite codec=nosuch
+'
+
+test_expect_success 'content-sqlite fails to load with bad threshold' '
+	test_must_fail flux module load content-sqlite compression-threshold=-1
+'
+
+test_expect_success 'store 4k blob with codec=none' '
+	flux module load content-sqlite codec=none &&
+	dd if=/dev/zero count=1 bs=4096 >4k.none.store 2>/dev/null &&
+	flux content store --bypass-cache <4k.none.store >4k.none.hash
+'
+
+test_expect_success 'store 4k blob with codec=lz4 compression-threshold=0' '
+	flux module reload content-sqlite codec=lz4 compression-threshold=0 &&
+	echo lz4 | dd bs=4096 conv=sync >4k.lz4.store 2>/dev/null &&
+	flux content store --bypass-cache <4k.lz4.store >4k.lz4.hash
+'
+
+test_expect_success 'blobs stored with either codec can be loaded' '
+	flux content load --bypass-cache `cat 4k.none.hash` >4k.none.load &&
+	test_cmp 4k.none.store 4k.none.load &&
+	flux content load --bypass-cache `cat 4k.lz4.hash` >4k.lz4.load &&
+	test_cmp 4k.lz4.store 4k.lz4.load
+'
+
+# zstd is optional, so tests that need it are skipped if it is missing
+test_expect_success 'reload content-sqlite with codec=zstd if available' '
+	flux module remove content-sqlite &&
+	if flux module load content-sqlite codec=zstd compression-threshold=0
+	then
+		test_set_prereq ZSTD
+	else
+		flux module load content-sqlite
+	fi
+'
+
+test_expect_success ZSTD 'blob stored with codec=zstd can be loaded' '
+	echo zstd | dd bs=4096 conv=sync >4k.zstd.store 2>/dev/null &&
+	flux content store --bypass-cache <4k.zstd.store >4k.zstd.hash &&
+	flux content load --bypass-cache `cat 4k.zstd.hash` >4k.zstd.load &&
+	test_cmp 4k.zstd.store 4k.zstd.load
+'
+
+which zstd >/dev/null 2>&1 && test_set_prereq HAVE_ZSTD_CMD
+
+test_expect_success ZSTD,HAVE_ZSTD_CMD 'train a zstd dictionary' '
+	mkdir -p samples &&
+	for i in `seq 1 500`; do \
+		seq -f "dict sample $i line %g" 1 $((i % 20 + 5)) >samples/$i \
+		    || return 1
+	done &&
+	zstd -q --train samples/* --maxdict=4096 -o test.dict
+'
+
+test_expect_success ZSTD,HAVE_ZSTD_CMD 'store blob with codec=zstd and a dictionary' '
+	flux module reload content-sqlite codec=zstd compression-threshold=0 \
+		zstd-dict=$(pwd)/test.dict &&
+	cat samples/42 >dict.store &&
+	flux content store --bypass-cache <dict.store >dict.hash &&
+	flux content load --bypass-cache `cat dict.hash` >dict.load &&
+	test_cmp dict.store dict.load
+'
+
+test_expect_success ZSTD,HAVE_ZSTD_CMD 'content-sqlite refuses to load without the dictionary' '
+	flux module remove content-sqlite &&
+	test_must_fail flux module load content-sqlite codec=zstd
+'
+
+test_expect_success ZSTD,HAVE_ZSTD_CMD 'blobs load after reloading with the dictionary' '
+	flux module load content-sqlite zstd-dict=$(pwd)/test.dict &&
+	flux content load --bypass-cache `cat dict.hash` >dict.load2 &&
+	test_cmp dict.store dict.load2 &&
+	flux content load --bypass-cache `cat 4k.zstd.hash` >4k.zstd.load2 &&
+	test_cmp 4k.zstd.store 4k.zstd.load2
+'
+
 test_expect_success 'remove content-sqlite module on rank 0' '
 	flux module remove content-sqlite
 '
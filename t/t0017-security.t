@@ -281,6 +281,16 @@ test_expect_success HAVE_JQ 'guests may not add non-userid-prefixed services' '
 
 # kvs.namespace-<NS>-setroot is a "private" event
 
+test_expect_success 'kvs module fails to load with invalid hash-threads' '
+	test_must_fail flux module load kvs hash-threads=foo &&
+	test_must_fail flux module load kvs hash-threads=-1
+'
+
+test_expect_success 'kvs module fails to load with invalid dir-shard-threshold' '
+	test_must_fail flux module load kvs dir-shard-threshold=1k &&
+	test_must_fail flux module load kvs dir-shard-threshold=-1
+'
+
 test_expect_success 'loaded kvs module' '
 	flux module load kvs
 '
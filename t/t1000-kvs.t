@@ -117,6 +117,32 @@ true
 EOF
 	test_cmp expected output
 '
+test_expect_success 'kvs: get (multiple) with --label and --treeobj' '
+	flux kvs get --label $KEY.a $KEY.c >output.label &&
+	cat >expected.label <<EOF &&
+$KEY.a=42
+$KEY.c=foo
+EOF
+	test_cmp expected.label output.label &&
+	flux kvs get --treeobj $KEY.a $KEY.c >output.treeobj &&
+	test $(grep -c "\"type\":\"val\"" output.treeobj) -eq 2
+'
+test_expect_success 'kvs: get (multiple) fails on first missing key' '
+	test_must_fail flux kvs get $KEY.a $KEY.nokey $KEY.c >output.missing \
+		2>err.missing &&
+	echo 42 >expected.missing &&
+	test_cmp expected.missing output.missing &&
+	grep "$KEY.nokey" err.missing
+'
+test_expect_success 'kvs: get (multiple) on rank 1' '
+	flux exec -n -r 1 flux kvs get $KEY.a $KEY.b $KEY.f >output.rank1 &&
+	cat >expected.rank1 <<EOF &&
+42
+3.14
+{"a":42}
+EOF
+	test_cmp expected.rank1 output.rank1
+'
 test_expect_success 'kvs: unlink (multiple)' '
 	flux kvs unlink $KEY.a $KEY.b $KEY.c $KEY.d $KEY.e $KEY.f &&
           test_must_fail flux kvs get $KEY.a &&
@@ -1229,6 +1255,9 @@ test_expect_success 'lookup request with empty payload fails with EPROTO(71)' '
 test_expect_success 'lookup-plus request with empty payload fails with EPROTO(71)' '
 	${RPC} kvs.lookup-plus 71 </dev/null
 '
+test_expect_success 'lookup-batch request with empty payload fails with EPROTO(71)' '
+	${RPC} kvs.lookup-batch 71 </dev/null
+'
 test_expect_success 'commit request with empty payload fails with EPROTO(71)' '
 	${RPC} kvs.commit 71 </dev/null
 '
@@ -494,6 +494,55 @@ test_expect_success 'kvs: test fence returns identical root info on all response
         ${FLUX_BUILD_DIR}/t/kvs/fence_api 8 apitest
 '
 
+#
+# large directory sharding
+#
+
+test_expect_success 'kvs: enable sharding of directories over 1024 entries' '
+	flux module reload kvs dir-shard-threshold=1024
+'
+test_expect_success 'kvs: put a directory larger than the shard threshold' '
+	flux kvs unlink -Rf $DIR &&
+	for i in $(seq 1 1100); do echo "$DIR.k$i=$i"; done >keys &&
+	flux kvs put $(cat keys)
+'
+test_expect_success 'kvs: large directory is stored as an hdir' '
+	flux kvs get --treeobj $DIR >dirref.out &&
+	ref=$(sed "s/.*\"data\":\[\"\([^\"]*\)\".*/\1/" dirref.out) &&
+	flux content load $ref | grep "\"type\":\"hdir\""
+'
+test_expect_success 'kvs: keys in sharded directory can be read' '
+	test_kvs_key $DIR.k1 1 &&
+	test_kvs_key $DIR.k550 550 &&
+	test_kvs_key $DIR.k1100 1100 &&
+	test_must_fail flux kvs get $DIR.k1101
+'
+test_expect_success 'kvs: keys in sharded directory can be read on rank 1' '
+	flux exec -n -r 1 flux kvs get $DIR.k777 >output.rank1 &&
+	echo 777 >expected.rank1 &&
+	test_cmp expected.rank1 output.rank1
+'
+test_expect_success 'kvs: sharded directory lists all keys' '
+	flux kvs ls -1 $DIR | sort >ls.out &&
+	sed -e "s/^$DIR\.//" -e "s/=.*//" keys | sort >ls.expected &&
+	test_cmp ls.expected ls.out
+'
+test_expect_success 'kvs: keys in sharded directory can be updated and removed' '
+	flux kvs put $DIR.k2=foo &&
+	flux kvs unlink $DIR.k3 &&
+	test_kvs_key $DIR.k2 foo &&
+	test_must_fail flux kvs get $DIR.k3 &&
+	test $(flux kvs ls -1 $DIR | wc -l) -eq 1099
+'
+test_expect_success 'kvs: subdirectories in sharded directory work' '
+	flux kvs put $DIR.sub.a=1 &&
+	test_kvs_key $DIR.sub.a 1 &&
+	flux kvs ls -1 $DIR.sub >sub.out &&
+	echo a >sub.expected &&
+	test_cmp sub.expected sub.out &&
+	flux kvs unlink -Rf $DIR
+'
+
 #
 # test invalid fence arguments
 #
@@ -173,6 +173,31 @@ test_expect_success 'submit request with empty payload fails with EPROTO(71)' '
 	${RPC} job-ingest.submit 71 </dev/null
 '
 
+test_expect_success 'job-ingest: reload with in-process validator' '
+	ingest_module reload
+'
+
+test_expect_success 'job-ingest: valid jobspecs accepted by in-process validator' '
+	test_valid ${JOBSPEC}/valid/*
+'
+
+test_expect_success 'job-ingest: invalid jobs rejected by in-process validator' '
+	test_invalid ${JOBSPEC}/invalid/*
+'
+
+test_expect_success 'job-ingest: in-process validator reports reason' '
+	sed "s/\"version\":[0-9]*/\"version\":0/" basic.json >badversion.json &&
+	test_must_fail flux job submit badversion.json 2>badversion.out &&
+	grep "version must be >= 1" badversion.out
+'
+
+test_expect_success 'job-ingest: submitbench --stats reports jobs/s' '
+	${SUBMITBENCH} --quiet --stats -r 100 use_case_2.6.json \
+		>stats.out 2>stats.err &&
+	test_must_be_empty stats.out &&
+	grep "^100 jobs in .* jobs/s" stats.err
+'
+
 test_expect_success 'job-ingest: test validator with version 1 enforced' '
 	ingest_module reload \
 		validator=${BINDINGS_VALIDATOR} validator-args="--require-version,1"
@@ -12,6 +12,19 @@ DRAIN_CANCEL="flux python ${FLUX_SOURCE_DIR}/t/job-manager/drain-cancel.py"
 RPC=${FLUX_BUILD_DIR}/t/request/rpc
 LIST_JOBS=${FLUX_BUILD_DIR}/t/job-manager/list-jobs
 
+wait_jobid_state() {
+	local jobid=$1
+	local state=$2
+	local i=0
+	while ! flux job list --states=${state} | grep $jobid > /dev/null \
+	       && [ $i -lt 50 ]
+	do
+		sleep 0.1
+		i=$((i + 1))
+	done
+	test "$i" -lt "50"
+}
+
 test_expect_success 'job-manager: generate jobspec for simple test job' '
         flux jobspec srun -n1 hostname >basic.json
 '
@@ -254,6 +267,26 @@ test_expect_success 'job-manager: still no jobs in the queue' '
 	test $(${LIST_JOBS} | wc -l) -eq 0
 '
 
+test_expect_success 'job-manager: load with invalid state-format fails' '
+	flux module remove job-manager &&
+	test_must_fail flux module load job-manager state-format=foo
+'
+
+test_expect_success 'job-manager: load with state-format=binary' '
+	flux module load job-manager state-format=binary
+'
+
+test_expect_success 'job-manager: job-info tracks states from binary events' '
+	jobid=$(flux job submit basic.json) &&
+	wait_jobid_state ${jobid} pending &&
+	flux job cancel ${jobid} &&
+	wait_jobid_state ${jobid} inactive
+'
+
+test_expect_success 'job-manager: reload with default state-format' '
+	flux module reload job-manager
+'
+
 test_expect_success 'job-manager: flux queue disable works' '
 	flux queue disable system is fubar
 '
@@ -34,6 +34,23 @@ wait_jobid_state() {
         return 0
 }
 
+# job-info loads jobs from the KVS asynchronously after a reload,
+# wait until all have been loaded
+wait_restart() {
+        local i=0
+        while [ "$(flux module stats --parse restart job-info)" != "0" ] \
+               && [ $i -lt 50 ]
+        do
+                sleep 0.1
+                i=$((i + 1))
+        done
+        if [ "$i" -eq "50" ]
+        then
+            return 1
+        fi
+        return 0
+}
+
 test_expect_success 'job-info: generate jobspec for simple test job' '
         flux jobspec --format json srun -N1 hostname > hostname.json &&
         flux jobspec --format json srun -N1 sleep 300 > sleeplong.json
@@ -356,6 +373,7 @@ wait_inactive() {
 test_expect_success 'reload the job-info module' '
         flux job list -a > before_reload.out &&
         flux module reload job-info &&
+        wait_restart &&
         wait_inactive
 '
 
@@ -364,6 +382,20 @@ test_expect_success HAVE_JQ 'job-info: list successfully reconstructed' '
         test_cmp before_reload.out after_reload.out
 '
 
+test_expect_success 'job-info: load with invalid options fails' '
+        flux module remove job-info &&
+        test_must_fail flux module load job-info restart-window=0 &&
+        test_must_fail flux module load job-info restart-window=foo &&
+        test_must_fail flux module load job-info badopt
+'
+
+test_expect_success 'job-info: load with small restart-window' '
+        flux module load job-info restart-window=2 &&
+        wait_restart &&
+        flux job list -a > after_reload_window.out &&
+        test_cmp before_reload.out after_reload_window.out
+'
+
 test_expect_success HAVE_JQ 'job stats lists jobs in correct state (all inactive)' '
         flux job stats | jq -e ".job_states.depend == 0" &&
         flux job stats | jq -e ".job_states.sched == 0" &&
@@ -612,7 +644,8 @@ test_expect_success HAVE_JQ 'flux job lists full path for job name if basename f
 '
 
 test_expect_success 'reload the job-info module' '
-        flux module reload job-info
+        flux module reload job-info &&
+        wait_restart
 '
 
 test_expect_success HAVE_JQ 'verify job names preserved across restart' '
@@ -649,7 +682,8 @@ test_expect_success HAVE_JQ 'flux job list outputs ntasks correctly (4 tasks)' '
 '
 
 test_expect_success 'reload the job-info module' '
-        flux module reload job-info
+        flux module reload job-info &&
+        wait_restart
 '
 
 test_expect_success HAVE_JQ 'verify task count preserved across restart' '
@@ -761,7 +795,8 @@ test_expect_success HAVE_JQ 'flux job list outputs expiration time when set' '
 '
 
 test_expect_success 'reload the job-info module' '
-        flux module reload job-info
+        flux module reload job-info &&
+        wait_restart
 '
 
 test_expect_success HAVE_JQ 'verify nnodes preserved across restart' '
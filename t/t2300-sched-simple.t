@@ -226,6 +226,30 @@ test_expect_success 'sched-simple: there are no outstanding sched requests' '
 	grep "0 alloc requests pending to scheduler" queue_status.out &&
 	grep "0 free requests pending to scheduler" queue_status.out
 '
+test_expect_success 'sched-simple: invalid queue-depth fails to load' '
+	test_must_fail flux module load sched-simple unlimited queue-depth=0
+'
+test_expect_success 'sched-simple: reload in unlimited mode with queue-depth' '
+	flux module load sched-simple unlimited queue-depth=4 &&
+	flux dmesg | grep "scheduler: ready unlimited"
+'
+test_expect_success 'sched-simple: blocked job does not block smaller jobs' '
+	flux job submit basic.json >depth1.id &&
+	flux job wait-event --timeout=5.0 $(cat depth1.id) alloc &&
+	flux jobspec srun -n4 hostname | flux job submit >depth2.id &&
+	flux job submit basic.json >depth3.id &&
+	flux job wait-event --timeout=5.0 $(cat depth3.id) alloc &&
+	test_expect_code 1 flux kvs get $(kvs_job_dir $(cat depth2.id)).R
+'
+test_expect_success 'sched-simple: blocked job runs once resources are freed' '
+	flux job cancel $(cat depth1.id) &&
+	flux job cancel $(cat depth3.id) &&
+	flux job wait-event --timeout=5.0 $(cat depth2.id) alloc
+'
+test_expect_success 'sched-simple: remove sched-simple and cancel jobs' '
+	flux module remove sched-simple &&
+	flux job cancelall -f
+'
 
 test_expect_success 'sched-simple: load sched-simple and wait for queue drain' '
 	flux module load sched-simple &&
@@ -99,4 +99,58 @@ test_expect_success 'job-exec: exception while starting terminates job' '
 	     | flux job submit) &&
 	flux job wait-event -vt 5 $id clean
 '
+test_expect_success 'job-exec: launch service is loaded on all ranks' '
+	flux exec -r all flux module list | grep -c job-exec >nlaunch.out &&
+	test $(cat nlaunch.out) -eq 4
+'
+test_expect_success 'job-exec: invalid launch mode is rejected' '
+	test_must_fail flux module reload job-exec launch=foo &&
+	flux module load job-exec
+'
+test_expect_success 'job-exec: reload job-exec with launch=tree' '
+	flux module reload job-exec launch=tree
+'
+test_expect_success 'job-exec: tree launch runs job shell across all ranks' '
+	id=$(flux jobspec srun -N4 \
+	    "flux kvs put test2.\$BROKER_RANK=\$JOB_SHELL_RANK" \
+	    | flux job submit) &&
+	flux job wait-event $id clean &&
+	kvsdir=$(flux job id --to=kvs $id).guest &&
+	test $(flux kvs get ${kvsdir}.test2.0) = 0 &&
+	test $(flux kvs get ${kvsdir}.test2.1) = 1 &&
+	test $(flux kvs get ${kvsdir}.test2.2) = 2 &&
+	test $(flux kvs get ${kvsdir}.test2.3) = 3
+'
+test_expect_success 'job-exec: tree launch status is maximum exit code' '
+	id=$(flux jobspec srun -N4 "exit \$JOB_SHELL_RANK" | flux job submit) &&
+	flux job wait-event -vt 10 $id finish | grep status=768
+'
+test_expect_success 'job-exec: tree launch job exception kills job shells' '
+	id=$(flux jobspec srun -N4 sleep 300 | flux job submit) &&
+	flux job wait-event -vt 5 $id start &&
+	flux job cancel $id &&
+	flux job wait-event -vt 5 $id clean &&
+	flux job eventlog $id | grep status=15
+'
+test_expect_success 'job-exec: tree launch of invalid job shell raises exception' '
+	id=$(flux jobspec srun -N4 /bin/true \
+	     | $jq ".attributes.system.exec.job_shell = \"/notthere\"" \
+	     | flux job submit) &&
+	flux job wait-event -vt 5 $id exception &&
+	flux job wait-event -vt 5 $id clean
+'
+test_expect_success 'job-exec: tree launch fails ranks without launch service' '
+	flux exec -r 3 flux module remove job-exec &&
+	id=$(flux jobspec srun -N4 /bin/true | flux job submit) &&
+	flux job wait-event -vt 5 $id exception &&
+	flux job wait-event -vt 5 $id clean &&
+	flux exec -r 3 flux module load job-exec
+'
+test_expect_success 'job-exec: jobspec can override launch mode' '
+	id=$(flux jobspec srun -N4 /bin/true \
+	     | $jq ".attributes.system.exec.bulkexec.launch = \"direct\"" \
+	     | flux job submit) &&
+	flux job wait-event -vt 5 $id clean &&
+	flux module reload job-exec
+'
 test_done
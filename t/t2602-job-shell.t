@@ -103,6 +103,24 @@ test_expect_success 'job-shell: PMI KVS works' '
 	flux job attach $id >kvstest.out &&
 	grep "t phase" kvstest.out
 '
+test_expect_success 'job-shell: PMI KVS works with pmi.kvs=native' '
+	flux mini run -N4 -o pmi.kvs=native ${KVSTEST} >kvstest-native.out &&
+	grep "t phase" kvstest-native.out
+'
+test_expect_success 'job-shell: PMI KVS works with pmi.exchange.k=1' '
+	flux mini run -N4 -n8 -o pmi.exchange.k=1 ${KVSTEST} >kvstest-k1.out &&
+	grep "t phase" kvstest-k1.out
+'
+test_expect_success 'job-shell: PMI KVS works with pmi.exchange.k=3' '
+	flux mini run -N4 -o pmi.exchange.k=3 ${KVSTEST} >kvstest-k3.out &&
+	grep "t phase" kvstest-k3.out
+'
+test_expect_success 'job-shell: invalid pmi.kvs option fails' '
+	test_must_fail flux mini run -N2 -o pmi.kvs=badmode ${PMI_INFO}
+'
+test_expect_success 'job-shell: invalid pmi.exchange.k option fails' '
+	test_must_fail flux mini run -N2 -o pmi.exchange.k=0 ${PMI_INFO}
+'
 test_expect_success 'job-exec: decrease kill timeout for tests' '
 	flux module reload job-exec kill-timeout=0.1
 '
@@ -154,6 +172,43 @@ test_expect_success 'job-shell: verify output of 4-task lptest job on stderr' '
         sed -i -e "/stdin EOF could not be sent/d" lptest4.err &&
 	test_cmp lptest4.exp lptest4.err
 '
+test_expect_success 'job-shell: output from one rank is coalesced in the eventlog' '
+	id=$(flux mini submit -n1 ${LPTEST}) &&
+	flux job attach -l $id >lptest-coalesce.out &&
+	test_cmp lptest.exp lptest-coalesce.out &&
+	flux job eventlog -p guest.output $id >lptest-coalesce.eventlog &&
+	count=$(grep -c "\"stdout\"" lptest-coalesce.eventlog) &&
+	test $count -lt $(wc -l <lptest.exp)
+'
+test_expect_success 'job-shell: coalesced stdout and stderr keep their order' '
+	id=$(flux mini submit -n1 -o output.flush-timeout=5 \
+		bash -c "echo o1; sleep 0.2; echo e1 >&2; sleep 0.2; echo o2") &&
+	flux job attach $id &&
+	flux job eventlog -p guest.output $id \
+		| grep "\"data\":" \
+		| sed -e "s/.*\"stream\":\"\([a-z]*\)\".*/\1/" \
+		>interleave.out &&
+	printf "stdout\nstderr\nstdout\n" >interleave.exp &&
+	test_cmp interleave.exp interleave.out
+'
+test_expect_success 'job-shell: output.flush-timeout=0 disables coalescing' '
+	id=$(flux mini submit -n1 -o output.flush-timeout=0 ${LPTEST}) &&
+	flux job attach -l $id >lptest-nocoalesce.out &&
+	test_cmp lptest.exp lptest-nocoalesce.out &&
+	flux job eventlog -p guest.output $id >lptest-nocoalesce.eventlog &&
+	count=$(grep "\"stdout\"" lptest-nocoalesce.eventlog \
+		| grep -c "\"data\"") &&
+	test $count -eq $(wc -l <lptest.exp)
+'
+test_expect_success 'job-shell: small output.flush-size works' '
+	id=$(flux mini submit -N4 -o output.flush-size=100 ${LPTEST}) &&
+	flux job attach -l $id >lptest4-flushsize_raw.out &&
+	sort -snk1 <lptest4-flushsize_raw.out >lptest4-flushsize.out &&
+	test_cmp lptest4.exp lptest4-flushsize.out
+'
+test_expect_success 'job-shell: invalid output.flush-size fails' '
+	test_must_fail flux mini run -n1 -o output.flush-size=0 /bin/true
+'
 test_expect_success LONGTEST 'job-shell: verify 10K line lptest output works' '
 	${LPTEST} 79 10000 | sed -e "s/^/0: /" >lptestXXL.exp &&
         id=$(flux jobspec srun -n1 ${LPTEST} 79 10000 | flux job submit) &&